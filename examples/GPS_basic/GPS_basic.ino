@@ -50,7 +50,7 @@ signed char gps_data_valid;
 
 unsigned short redout_voltage;
 unsigned short redout_current;
-char  phone_number[15];      // array for the phone number string
+char  phone_number[20];      // array for the phone number string
 char  string[120];           // buffer for SMS with GPS data
 
 
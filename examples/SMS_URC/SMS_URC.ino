@@ -0,0 +1,96 @@
+/*
+    Event driven SMS reception with GSM Playground - GSM Shield for Arduino
+    (unsolicited result codes, URC_ENABLED must be defined in Setting.h)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+  Important:
+  ==========
+  This sketch reads and erases every incoming SMS so if there are 
+  some important SMSs stored in your SIM card please backup them up 
+  before inserting SIM card to the GSM Playground
+*/
+#include "GSM_GE863.h"  
+
+// max length for SMS buffer(including also string terminator 0x00)
+#define SMS_MAX_LEN 100
+
+// ---------------------------------------------------------------------------
+// Important:
+// ========== 
+// instance of GSM class("GSM gsm;") is already defined in the GSM.cpp module
+// so we cannot define this instance here
+// see explanation in the GSM.cpp module
+// ---------------------------------------------------------------------------
+
+char new_sms_position = 0;  // position of the new SMS (0 - no new SMS)
+byte ringing = 0;           // 1 - RING was received
+char phone_number[20];      // array for the phone number string
+char sms_text[SMS_MAX_LEN]; // array for the SMS text
+
+
+// called for the URC +CMTI: "SM",<position>
+void sms_arrived(const char *line)
+{
+  const char *p_char = strchr(line, ',');
+  
+  if (p_char != NULL) new_sms_position = atoi(p_char + 1);
+}
+
+// called for the URC RING
+void ring(const char *line)
+{
+  ringing = 1;
+}
+
+void setup()
+{
+  // initialization of serial line
+  gsm.InitSerLine(57600);		
+  // turn on GSM module
+  gsm.TurnOn();
+
+  // new SMS is indicated by the URC +CMTI: "SM",<position>
+  gsm.SendATCmdWaitRespF(PSTR("AT+CNMI=2,1"), 1000, 50, "OK", 3);
+
+  gsm.RegisterURCHandler(PSTR("+CMTI:"), sms_arrived);
+  gsm.RegisterURCHandler(PSTR("RING"), ring);
+}
+
+void loop()
+{
+  // there is no polling of the GSM module over the serial line,
+  // handlers are called only when something happens
+  gsm.PollURC();
+
+  if (new_sms_position > 0) {
+    if (gsm.GetSMS(new_sms_position, phone_number, sms_text, SMS_MAX_LEN) > 0) {
+      // SMS text is in the sms_text now => switch on LED in case 
+      // the SMS starts with "ON", switch it off otherwise
+      if (!strncmp(sms_text, "ON", 2)) gsm.TurnOnLED();
+      else gsm.TurnOffLED();
+    }
+    gsm.DeleteSMS(new_sms_position);
+    new_sms_position = 0;
+  }
+
+  if (ringing) {
+    // incoming call - just hang it up
+    ringing = 0;
+    gsm.HangUp();
+  }
+}
@@ -0,0 +1,411 @@
+/*
+  api_bench.cpp - latency and round trip benchmark of the public API
+  of the GSM Playground - GSM Shield for Arduino (Linux host build)
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    usage: gsm_api_bench [-s scale] [-a] [-o file.json] [script]
+
+    - every public method of the GSM (incl. GPRS) and GPS_GE863 classes
+      is called against the GE863 simulator on the pty, the script
+      (see GE863Sim.h) sets the baud rate, latencies, faults...
+    - for every method the JSON contains the wall time (min/mean/max)
+      and per call averages of the serial round trips, the characters
+      sent and received and the time the library spent by waiting
+      for the timeouts (see AT::GetLinkStats())
+    - setup and teardown of the method (e.g. opening of the socket
+      before CloseSocket()) are not measured
+    - -s multiplies the num. of iterations, the JSON is written
+      to stdout unless -o is given
+    - -a switches on the adaptive timeouts (AT_TMOUT_ADAPTIVE)
+      after the initialization
+*/
+
+#include "Arduino.h"
+#include "GSM_GE863.h"
+#include "GPS_GE863.h"
+#include "ATFdTransport.h"
+#include "GE863Sim.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static GE863Sim sim;
+static ATFdTransport tty;
+static GPS_GE863 gps;
+
+static char number[20];
+static char text[80];
+static byte *rx_data;
+
+
+static uint64_t NowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+
+/**********************************************************
+Setup and teardown of the methods
+**********************************************************/
+static void StoreSMS(void)
+{
+  sim.Directive("sms 1 unread +420111222333 Bench message");
+}
+
+static void IncomingCall(void)
+{
+  sim.Directive("call incoming +420999888777");
+}
+
+static void NoCall(void)
+{
+  sim.Directive("call none");
+}
+
+// remote side closes the connection so the library is in the command mode
+static void RemoteClose(void)
+{
+  sim.Directive("remote_close 0");
+  gsm.RcvData(1000, 50, &rx_data);
+  gsm.SetCommLineStatus(CLS_FREE);
+}
+
+static void OpenSocket(void)
+{
+  gsm.OpenSocket(TCP_SOCKET, 80, (char *)"www.example.com", 0, 0);
+}
+
+static void SendRequest(void)
+{
+  gsm.SendData("GET / HTTP/1.0\r\n\r\n");
+}
+
+static void OpenSocketAndSendRequest(void)
+{
+  OpenSocket();
+  SendRequest();
+}
+
+static void OpenExtSocket(void)
+{
+  gsm.IPEasyExt_OpenSocket(1, TCP_SOCKET, 80, (char *)"www.example.com", 0, 0);
+}
+
+static void OpenAndSuspendExtSocket(void)
+{
+  OpenExtSocket();
+  gsm.IPEasyExt_SuspendSocket(1);
+}
+
+static void CloseExtSocket(void)
+{
+  gsm.IPEasyExt_CloseSocket(1, 0);
+}
+
+static void SuspendAndCloseExtSocket(void)
+{
+  // <CR><LF> after CONNECT left by ResumeSocket() would shorten
+  // the guard time before "+++"
+  gsm.RcvData(500, 100, &rx_data);
+  gsm.IPEasyExt_SuspendSocket(1);
+  CloseExtSocket();
+}
+
+static void ListenExtSocket(void)
+{
+  gsm.IPEasyExt_OpenSocketInListenMode(1, 1, 5000);
+  // SRING is sent immediately
+  delay(20);
+  gsm.PollURC();
+}
+
+static void StopListening(void)
+{
+  gsm.IPEasyExt_OpenSocketInListenMode(1, 0, 5000);
+}
+
+
+/**********************************************************
+Measured methods
+**********************************************************/
+// GSM
+static long ApiTurnOn(void) {gsm.TurnOn(); return (1);}
+static long ApiCheckRegistration(void) {return (gsm.CheckRegistration());}
+static long ApiInitSMSMemory(void) {return (gsm.InitSMSMemory());}
+static long ApiSendSMS(void) {return (gsm.SendSMS((char *)"+420123456789", (char *)"Bench"));}
+static long ApiSendSMSPos(void) {return (gsm.SendSMS(1, (char *)"Bench"));}
+static long ApiIsSMSPresent(void) {return (gsm.IsSMSPresent(SMS_UNREAD));}
+static long ApiGetSMS(void) {return (gsm.GetSMS(1, number, text, sizeof(text)));}
+static long ApiGetAuthorizedSMS(void) {return (gsm.GetAuthorizedSMS(1, number, text, sizeof(text), 1, 3));}
+static long ApiDeleteSMS(void) {return (gsm.DeleteSMS(1));}
+static long ApiWritePhoneNumber(void) {return (gsm.WritePhoneNumber(1, (char *)"+420111222333"));}
+static long ApiGetPhoneNumber(void) {return (gsm.GetPhoneNumber(1, number));}
+static long ApiComparePhoneNumber(void) {return (gsm.ComparePhoneNumber(1, (char *)"+420111222333"));}
+static long ApiCallStatus(void) {return (gsm.CallStatus());}
+static long ApiCallStatusWithAuth(void) {return (gsm.CallStatusWithAuth(number, 1, 3));}
+static long ApiPickUp(void) {gsm.PickUp(); return (1);}
+static long ApiHangUp(void) {gsm.HangUp(); return (1);}
+static long ApiCall(void) {gsm.Call((char *)"+420999888777"); return (1);}
+static long ApiCallPos(void) {gsm.Call(1); return (1);}
+static long ApiSetSpeakerVolume(void) {return (gsm.SetSpeakerVolume(5));}
+static long ApiIncSpeakerVolume(void) {return (gsm.IncSpeakerVolume());}
+static long ApiDecSpeakerVolume(void) {return (gsm.DecSpeakerVolume());}
+static long ApiSendDTMFSignal(void) {return (gsm.SendDTMFSignal(5));}
+static long ApiIsUserButtonPushed(void) {return (gsm.IsUserButtonPushed());}
+static long ApiTurnOnLED(void) {gsm.TurnOnLED(); return (1);}
+static long ApiTurnOffLED(void) {gsm.TurnOffLED(); return (1);}
+static long ApiSetGPIODir(void) {return (gsm.SetGPIODir(10, 1));}
+static long ApiSetGPIOVal(void) {return (gsm.SetGPIOVal(10, 1));}
+static long ApiGetGPIOVal(void) {return (gsm.GetGPIOVal(11));}
+static long ApiGetTemp(void) {return (gsm.GetTemp());}
+
+// GPRS
+static long ApiInitGPRS(void) {return (gsm.InitGPRS((char *)"internet", (char *)"", (char *)""));}
+static long ApiEnableGPRS(void) {return (gsm.EnableGPRS(CHECK_AND_OPEN));}
+static long ApiReopenGPRS(void) {return (gsm.EnableGPRS(CLOSE_AND_REOPEN));}
+static long ApiOpenSocket(void) {return (gsm.OpenSocket(TCP_SOCKET, 80, (char *)"www.example.com", 0, 0));}
+static long ApiSendData(void) {SendRequest(); return (1);}
+static long ApiRcvData(void) {return (gsm.RcvData(1000, 20, &rx_data));}
+static long ApiCloseSocket(void) {return (gsm.CloseSocket());}
+static long ApiExtInitGPRS(void) {return (gsm.IPEasyExt_InitGPRS(1, (char *)"internet", (char *)"", (char *)""));}
+static long ApiExtEnableGPRS(void) {return (gsm.IPEasyExt_EnableOrDisableGPRS(1, 1));}
+static long ApiExtConfigSocket(void) {return (gsm.IPEasyExt_ConfigSocket(1, 1, 300, 90, 600, 50));}
+static long ApiExtOpenSocket(void) {OpenExtSocket(); return (gsm.GetCommLineStatus() == CLS_DATA);}
+static long ApiExtListen(void) {return (gsm.IPEasyExt_OpenSocketInListenMode(1, 1, 5000));}
+static long ApiExtAcceptSocket(void) {return (gsm.IPEasyExt_AcceptSocket(1));}
+static long ApiExtSuspendSocket(void) {return (gsm.IPEasyExt_SuspendSocket(1));}
+static long ApiExtResumeSocket(void) {return (gsm.IPEasyExt_ResumeSocket(1));}
+static long ApiExtGetSocketStatus(void) {return (gsm.IPEasyExt_GetSocketStatus(1));}
+static long ApiExtCloseSocket(void) {return (gsm.IPEasyExt_CloseSocket(1, 0));}
+
+// GPS
+static long ApiGPSPowerUp(void) {return (gps.GPSPowerUpOrDown(1));}
+static long ApiGetGPSSwVers(void) {return (gps.GetGPSSwVers(text));}
+static long ApiControlGPSAntenna(void) {return (gps.ControlGPSAntenna(1));}
+static long ApiGetGPSAntennaVoltage(void)
+{
+  unsigned short val;
+
+  return (gps.GetGPSAntennaSupplyVoltage(&val));
+}
+static long ApiGetGPSAntennaCurrent(void)
+{
+  unsigned short val;
+
+  return (gps.GetGPSAntennaCurrent(&val));
+}
+static long ApiGetGPSData(void)
+{
+  Position pos;
+  Time time;
+  Date date;
+
+  return (gps.GetGPSData(&pos, &time, &date));
+}
+static long ApiResetGPSModul(void) {return (gps.ResetGPSModul(GPS_RESET_HOTSTART));}
+
+
+struct ApiItem
+{
+  const char *name;
+  long (*func)(void);
+  void (*setup)(void);          // NULL - nothing to prepare
+  void (*teardown)(void);
+  unsigned long iterations;
+};
+
+static const ApiItem api_item[] = {
+  {"TurnOn",                          ApiTurnOn,              NULL,         NULL,         10},
+  {"CheckRegistration",               ApiCheckRegistration,   NULL,         NULL,         50},
+  {"InitSMSMemory",                   ApiInitSMSMemory,       NULL,         NULL,         20},
+  {"SendSMS",                         ApiSendSMS,             NULL,         NULL,         20},
+  {"SendSMS(position)",               ApiSendSMSPos,          NULL,         NULL,         20},
+  {"IsSMSPresent",                    ApiIsSMSPresent,        StoreSMS,     NULL,         20},
+  {"GetSMS",                          ApiGetSMS,              StoreSMS,     NULL,         50},
+  {"GetAuthorizedSMS",                ApiGetAuthorizedSMS,    StoreSMS,     NULL,         50},
+  {"DeleteSMS",                       ApiDeleteSMS,           StoreSMS,     NULL,         50},
+  {"WritePhoneNumber",                ApiWritePhoneNumber,    NULL,         NULL,         50},
+  {"GetPhoneNumber",                  ApiGetPhoneNumber,      NULL,         NULL,         50},
+  {"ComparePhoneNumber",              ApiComparePhoneNumber,  NULL,         NULL,         50},
+  {"CallStatus",                      ApiCallStatus,          NULL,         NULL,         50},
+  {"CallStatusWithAuth",              ApiCallStatusWithAuth,  IncomingCall, NoCall,       20},
+  {"PickUp",                          ApiPickUp,              IncomingCall, NoCall,       20},
+  {"HangUp",                          ApiHangUp,              IncomingCall, NoCall,       20},
+  {"Call",                            ApiCall,                NULL,         NoCall,       20},
+  {"Call(position)",                  ApiCallPos,             NULL,         NoCall,       20},
+  {"SetSpeakerVolume",                ApiSetSpeakerVolume,    NULL,         NULL,         50},
+  {"IncSpeakerVolume",                ApiIncSpeakerVolume,    NULL,         NULL,         50},
+  {"DecSpeakerVolume",                ApiDecSpeakerVolume,    NULL,         NULL,         50},
+  {"SendDTMFSignal",                  ApiSendDTMFSignal,      NULL,         NULL,         50},
+  {"IsUserButtonPushed",              ApiIsUserButtonPushed,  NULL,         NULL,         50},
+  {"TurnOnLED",                       ApiTurnOnLED,           NULL,         NULL,         50},
+  {"TurnOffLED",                      ApiTurnOffLED,          NULL,         NULL,         50},
+  {"SetGPIODir",                      ApiSetGPIODir,          NULL,         NULL,         50},
+  {"SetGPIOVal",                      ApiSetGPIOVal,          NULL,         NULL,         50},
+  {"GetGPIOVal",                      ApiGetGPIOVal,          NULL,         NULL,         50},
+  {"GetTemp",                         ApiGetTemp,             NULL,         NULL,         50},
+  {"InitGPRS",                        ApiInitGPRS,            NULL,         NULL,         20},
+  {"EnableGPRS",                      ApiEnableGPRS,          NULL,         NULL,         20},
+  {"EnableGPRS(CLOSE_AND_REOPEN)",    ApiReopenGPRS,          NULL,         NULL,         20},
+  {"OpenSocket",                      ApiOpenSocket,          NULL,         RemoteClose,  10},
+  {"SendData",                        ApiSendData,            OpenSocket,   RemoteClose,  10},
+  {"RcvData",                         ApiRcvData,             OpenSocketAndSendRequest, RemoteClose, 10},
+  {"CloseSocket",                     ApiCloseSocket,         OpenSocket,   NULL,         2},
+  {"IPEasyExt_InitGPRS",              ApiExtInitGPRS,         NULL,         NULL,         20},
+  {"IPEasyExt_EnableOrDisableGPRS",   ApiExtEnableGPRS,       NULL,         NULL,         5},
+  {"IPEasyExt_ConfigSocket",          ApiExtConfigSocket,     NULL,         NULL,         20},
+  {"IPEasyExt_OpenSocket",            ApiExtOpenSocket,       NULL,         RemoteClose,  10},
+  {"IPEasyExt_OpenSocketInListenMode",ApiExtListen,           NULL,         StopListening, 10},
+  {"IPEasyExt_AcceptSocket",          ApiExtAcceptSocket,     ListenExtSocket, RemoteClose, 10},
+  {"IPEasyExt_SuspendSocket",         ApiExtSuspendSocket,    OpenExtSocket, CloseExtSocket, 2},
+  {"IPEasyExt_ResumeSocket",          ApiExtResumeSocket,     OpenAndSuspendExtSocket, SuspendAndCloseExtSocket, 2},
+  {"IPEasyExt_GetSocketStatus",       ApiExtGetSocketStatus,  NULL,         NULL,         20},
+  {"IPEasyExt_CloseSocket",           ApiExtCloseSocket,      OpenAndSuspendExtSocket, NULL, 2},
+  {"GPSPowerUpOrDown",                ApiGPSPowerUp,          NULL,         NULL,         50},
+  {"GetGPSSwVers",                    ApiGetGPSSwVers,        NULL,         NULL,         50},
+  {"ControlGPSAntenna",               ApiControlGPSAntenna,   NULL,         NULL,         50},
+  {"GetGPSAntennaSupplyVoltage",      ApiGetGPSAntennaVoltage,NULL,         NULL,         50},
+  {"GetGPSAntennaCurrent",            ApiGetGPSAntennaCurrent,NULL,         NULL,         50},
+  {"GetGPSData",                      ApiGetGPSData,          NULL,         NULL,         50},
+  {"ResetGPSModul",                   ApiResetGPSModul,       NULL,         NULL,         50},
+  {NULL,                              NULL,                   NULL,         NULL,         0}
+};
+
+
+int main(int argc, char *argv[])
+{
+  const ApiItem *item;
+  const ATLinkStats *link;
+  ATLinkStats sum;
+  FILE *out = stdout;
+  const char *script = NULL;
+  double scale = 1.0;
+  unsigned long iterations;
+  unsigned long i;
+  uint64_t start_us;
+  uint64_t elapsed_us;
+  uint64_t min_us;
+  uint64_t max_us;
+  uint64_t total_us;
+  long result = 0;
+  byte adaptive = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "s:ao:h")) != -1) {
+    switch (opt) {
+      case 's': scale = atof(optarg); break;
+      case 'a': adaptive = 1; break;
+      case 'o':
+        out = fopen(optarg, "w");
+        if (out == NULL) {
+          perror(optarg);
+          return (1);
+        }
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-s scale] [-a] [-o file.json] [script]\n", argv[0]);
+        return (2);
+    }
+  }
+  if (scale <= 0) scale = 1.0;
+  if (optind < argc) script = argv[optind];
+
+  if (sim.Open() < 0) {
+    perror("pty");
+    return (1);
+  }
+  if ((script != NULL) && (sim.LoadScript(script) < 0)) return (1);
+  // the input pin read by GetGPIOVal()
+  sim.Directive("gpio 11 0 1");
+  sim.Directive("pb 1 +420111222333 Bench");
+  sim.Start();
+  if (tty.Open(sim.GetSlavePath()) < 0) {
+    perror(sim.GetSlavePath());
+    return (1);
+  }
+  gsm.SetTransport(&tty);
+  gsm.InitSerLine(115200);
+#ifdef GSM_CACHE_ENABLED
+  // every call is measured with the communication
+  gsm.SetCacheTTL(GSM_CACHE_ALL, 0);
+#endif
+  // initialization parameters are sent by the first registration
+  gsm.TurnOn();
+  gsm.CheckRegistration();
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+  if (adaptive) gsm.SetTmoutMode(AT_TMOUT_ADAPTIVE);
+#else
+  if (adaptive) fprintf(stderr, "adaptive timeouts are not compiled in (AT_ADAPTIVE_TMOUT_ENABLED)\n");
+  adaptive = 0;
+#endif
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"library\": {\"at\": %d, \"gsm\": %d, \"gprs\": %d, \"gps\": %d},\n",
+          AT_LIB_VERSION, gsm.GSMLibVer(), gsm.GPRSLibVer(), gps.GPSLibVer());
+  fprintf(out, "  \"script\": \"%s\",\n", (script != NULL) ? script : "");
+  fprintf(out, "  \"scale\": %g,\n", scale);
+  fprintf(out, "  \"tmout_mode\": \"%s\",\n", adaptive ? "adaptive" : "fixed");
+  fprintf(out, "  \"results\": [\n");
+  for (item = api_item; item->name != NULL; item++) {
+    iterations = (unsigned long)(item->iterations * scale);
+    if (iterations == 0) iterations = 1;
+    memset(&sum, 0, sizeof(sum));
+    min_us = (uint64_t)-1;
+    max_us = 0;
+    total_us = 0;
+    for (i = 0; i < iterations; i++) {
+      if (item->setup != NULL) item->setup();
+      gsm.ResetLinkStats();
+      start_us = NowUs();
+      result = item->func();
+      elapsed_us = NowUs() - start_us;
+      link = gsm.GetLinkStats();
+      sum.tx_bytes += link->tx_bytes;
+      sum.rx_bytes += link->rx_bytes;
+      sum.round_trips += link->round_trips;
+      sum.start_tmouts += link->start_tmouts;
+      sum.tmout_wait += link->tmout_wait;
+      if (item->teardown != NULL) item->teardown();
+      total_us += elapsed_us;
+      if (elapsed_us < min_us) min_us = elapsed_us;
+      if (elapsed_us > max_us) max_us = elapsed_us;
+    }
+    fprintf(out, "    {\"api\": \"%s\", \"iterations\": %lu, \"result\": %ld, "
+            "\"wall_us\": {\"min\": %llu, \"mean\": %.1f, \"max\": %llu}, "
+            "\"round_trips\": %.2f, \"tx_bytes\": %.1f, \"rx_bytes\": %.1f, "
+            "\"start_tmouts\": %.2f, \"tmout_wait_ms\": %.1f}%s\n",
+            item->name, iterations, result,
+            (unsigned long long)min_us, (double)total_us / iterations, (unsigned long long)max_us,
+            (double)sum.round_trips / iterations, (double)sum.tx_bytes / iterations,
+            (double)sum.rx_bytes / iterations, (double)sum.start_tmouts / iterations,
+            (double)sum.tmout_wait / iterations, (item[1].name != NULL) ? "," : "");
+    fflush(out);
+  }
+  fprintf(out, "  ]\n}\n");
+
+  sim.Stop();
+  tty.Close();
+  sim.Close();
+  if (out != stdout) fclose(out);
+  return (0);
+}
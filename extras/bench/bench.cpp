@@ -0,0 +1,268 @@
+/*
+  bench.cpp - benchmark of the parsers and of the AT command engine
+  for the GSM Playground - GSM Shield for Arduino (Linux host build)
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    usage: gsm_bench [iteration_scale]
+
+    - parser benchmarks run only on the CPU (no serial line)
+    - round trip benchmarks talk to the modem stand-in connected
+      by the ATLoopbackTransport which answers immediately so the
+      measured time is the time spent in the library
+*/
+
+#include "Arduino.h"
+#include "GSM_GE863.h"
+
+#include <stdio.h>
+#include <time.h>
+
+
+// stand-in of the GSM module - answers every command line
+// immediately when its <CR> is received
+class BenchModem : public ATLoopbackTransport
+{
+  public:
+    BenchModem(void) {line_len = 0;};
+    using ATLoopbackTransport::Write;
+    virtual size_t Write(byte ch);
+
+  private:
+    char line[64];
+    byte line_len;
+
+    void Answer(void);
+};
+
+struct BenchReply
+{
+  const char *cmd_prefix;
+  const char *reply;
+};
+
+static const BenchReply bench_reply[] = {
+  {"AT+CREG?",  "\r\n+CREG: 0,1\r\n\r\nOK\r\n"},
+  {"AT#ADC=",   "\r\n#ADC: 885\r\n\r\nOK\r\n"},
+  {"AT+CMGR=",  "\r\n+CMGR: \"REC UNREAD\",\"+420123456789\",,\"12/01/01,10:00:00+04\"\r\n"
+                "Hello from the bench\r\n\r\nOK\r\n"},
+  {"AT+CLCC",   "\r\n+CLCC: 1,1,4,0,0,\"+420777\",145\r\n\r\nOK\r\n"},
+  {"AT+CPBR=",  "\r\n+CPBR: 1,\"+420999888777\",145,\"Bench\"\r\n\r\nOK\r\n"},
+  {NULL,        "\r\nOK\r\n"}
+};
+
+size_t BenchModem::Write(byte ch)
+{
+  size_t ret = ATLoopbackTransport::Write(ch);
+
+  if (ch == 0x0d) {
+    line[line_len] = 0;
+    Answer();
+    line_len = 0;
+  }
+  else if ((ch != 0x0a) && (line_len < sizeof(line) - 1)) {
+    line[line_len++] = ch;
+  }
+  // command is not interesting for the bench
+  while (PeerAvailable()) PeerRead();
+  return (ret);
+}
+
+void BenchModem::Answer(void)
+{
+  const BenchReply *r;
+
+  for (r = bench_reply; r->cmd_prefix != NULL; r++) {
+    if (strncmp(line, r->cmd_prefix, strlen(r->cmd_prefix)) == 0) break;
+  }
+  PeerPrint(r->reply);
+}
+
+
+static BenchModem modem;
+static volatile long bench_sink; // results are stored here so they are not optimized out
+
+
+static uint64_t NowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+
+/**********************************************************
+Parser benchmarks
+**********************************************************/
+static const char cmgr_resp[] =
+  "\r\n+CMGR: \"REC UNREAD\",\"+420123456789\",,\"12/01/01,10:00:00+04\"\r\n"
+  "Hello from the bench\r\n\r\nOK\r\n";
+
+static const char cpas_resp[] = "\r\n+CPAS: 4\r\n\r\nOK\r\n";
+
+static const char data_chunk[] =
+  "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 64\r\n\r\n"
+  "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+  "\r\nNO CARRIER\r\n";
+
+static void BenchParseCMGR(void)
+{
+  StrView buf, line, field;
+  char number[20];
+  long sum = 0;
+
+  SVInit(&buf, cmgr_resp, sizeof(cmgr_resp) - 1);
+  if (SVFindLineF(&buf, PSTR("+CMGR:"), &line)) {
+    SVSkipPast(&line, ':');
+    SVNextField(&line, &field, ',');
+    SVNextField(&line, &field, ',');
+    SVUnquote(&field);
+    sum += SVCopy(&field, number, sizeof(number));
+    SVTakeLine(&buf, &line);
+    sum += line.len;
+  }
+  bench_sink += sum;
+}
+
+static void BenchClassifyCPAS(void)
+{
+  bench_sink += ATMatchFirst(&resp_match_cpas, cpas_resp, sizeof(cpas_resp) - 1);
+}
+
+static void BenchStreamSearch(void)
+{
+  StreamSearch search;
+
+  SSInitF(&search, PSTR("\r\nNO CARRIER\r\n"));
+  bench_sink += SSFind(&search, (const byte *)data_chunk, sizeof(data_chunk) - 1);
+}
+
+static void BenchItoa(void)
+{
+  char num_str[12];
+
+  bench_sink += itoa((int)bench_sink & 0x7fff, num_str, 10)[0];
+}
+
+
+/**********************************************************
+Round trip benchmarks
+**********************************************************/
+static void BenchSendAT(void)
+{
+  bench_sink += gsm.SendATCmdWaitResp("AT", 500, 20, "OK", 1);
+}
+
+static void BenchCheckRegistration(void)
+{
+  bench_sink += gsm.CheckRegistration();
+}
+
+static void BenchGetTemp(void)
+{
+  bench_sink += gsm.GetTemp();
+}
+
+#ifdef GSM_CACHE_ENABLED
+static void BenchCachedCheckRegistration(void)
+{
+  // round trip only when the cached value expires
+  gsm.SetCacheTTL(GSM_CACHE_REG, 60000);
+  bench_sink += gsm.CheckRegistration();
+  gsm.SetCacheTTL(GSM_CACHE_REG, 0);
+}
+#endif
+
+static void BenchGetSMS(void)
+{
+  char number[20];
+  char text[40];
+
+  bench_sink += gsm.GetSMS(1, number, text, sizeof(text));
+}
+
+static void BenchGetPhoneNumber(void)
+{
+  char number[20];
+
+  bench_sink += gsm.GetPhoneNumber(1, number);
+}
+
+
+struct BenchItem
+{
+  const char *name;
+  void (*func)(void);
+  unsigned long iterations;
+};
+
+static const BenchItem bench_item[] = {
+  {"parse_cmgr",          BenchParseCMGR,         1000000},
+  {"classify_cpas",       BenchClassifyCPAS,      1000000},
+  {"stream_search",       BenchStreamSearch,      200000},
+  {"itoa",                BenchItoa,              1000000},
+  {"rt_send_at",          BenchSendAT,            20000},
+  {"rt_check_reg",        BenchCheckRegistration, 20000},
+  {"rt_get_temp",         BenchGetTemp,           20000},
+#ifdef GSM_CACHE_ENABLED
+  {"cached_check_reg",    BenchCachedCheckRegistration, 1000000},
+#endif
+  {"rt_get_sms",          BenchGetSMS,            20000},
+  {"rt_get_phone_number", BenchGetPhoneNumber,    20000},
+  {NULL,                  NULL,                   0}
+};
+
+
+int main(int argc, char *argv[])
+{
+  const BenchItem *item;
+  double scale = 1.0;
+  unsigned long iterations;
+  unsigned long i;
+  uint64_t start_ns;
+  uint64_t elapsed_ns;
+
+  if (argc > 1) scale = atof(argv[1]);
+  if (scale <= 0) scale = 1.0;
+
+  gsm.SetTransport(&modem);
+  gsm.InitSerLine(115200);
+  gsm.SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  // round trip benchmarks measure the communication
+  gsm.SetCacheTTL(GSM_CACHE_ALL, 0);
+#endif
+  // first registration sends also the init. parameters
+  gsm.CheckRegistration();
+
+  printf("%-22s %12s %14s\n", "benchmark", "iterations", "ns/op");
+  for (item = bench_item; item->name != NULL; item++) {
+    iterations = (unsigned long)(item->iterations * scale);
+    if (iterations == 0) iterations = 1;
+    item->func(); // warm up
+    start_ns = NowNs();
+    for (i = 0; i < iterations; i++) item->func();
+    elapsed_ns = NowNs() - start_ns;
+    printf("%-22s %12lu %14.1f\n", item->name, iterations, (double)elapsed_ns / iterations);
+  }
+  if (modem.GetLostCnt()) {
+    printf("modem stand-in lost %u characters\n", modem.GetLostCnt());
+    return (1);
+  }
+  return (0);
+}
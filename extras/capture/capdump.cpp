@@ -0,0 +1,92 @@
+/*
+  capdump.cpp - prints the capture of the serial traffic recorded by
+  ATRecordTransport (GSM Playground - GSM Shield for Arduino, Linux host build)
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    usage: gsm_capdump capture
+
+    - one record per line: time in msec. from the start of the capture,
+      direction (rx - from the GSM module, tx - to the GSM module)
+      and the characters (<CR>, <LF> and <xx> for the other
+      non-printable characters)
+    - the exit code is 1 when the capture is damaged
+*/
+
+#include "Arduino.h"
+#include "ATCapture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+int main(int argc, char *argv[])
+{
+  FILE *f;
+  byte *capture;
+  long size;
+  ATCapReader reader;
+  ATCapRecord rec;
+  unsigned long cnt[AT_CAP_LAST_ITEM] = {0};
+  char ret_val;
+  byte i;
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s capture\n", argv[0]);
+    return (2);
+  }
+  f = fopen(argv[1], "rb");
+  if (f == NULL) {
+    perror(argv[1]);
+    return (1);
+  }
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  rewind(f);
+  capture = (byte *)malloc(size > 0 ? size : 1);
+  if ((capture == NULL) || (fread(capture, 1, size, f) != (size_t)size)
+      || (reader.Attach(capture, size) < 0)) {
+    fprintf(stderr, "%s: it is not the capture\n", argv[1]);
+    return (1);
+  }
+  fclose(f);
+
+  while ((ret_val = reader.Next(&rec)) == 1) {
+    cnt[rec.type] += rec.len;
+    if (rec.type == AT_CAP_BEGIN) {
+      printf("%12.3f begin %lu Bd\n", rec.time_us / 1000.0,
+             (unsigned long)rec.data[0] | ((unsigned long)rec.data[1] << 8)
+             | ((unsigned long)rec.data[2] << 16) | ((unsigned long)rec.data[3] << 24));
+      continue;
+    }
+    printf("%12.3f %s    ", rec.time_us / 1000.0, (rec.type == AT_CAP_RX) ? "rx" : "tx");
+    for (i = 0; i < rec.len; i++) {
+      if (rec.data[i] == '\r') printf("<CR>");
+      else if (rec.data[i] == '\n') printf("<LF>");
+      else if ((rec.data[i] < 0x20) || (rec.data[i] >= 0x7f)) printf("<%02x>", rec.data[i]);
+      else putchar(rec.data[i]);
+    }
+    putchar('\n');
+  }
+  printf("\n%lu characters rx, %lu characters tx\n", cnt[AT_CAP_RX], cnt[AT_CAP_TX]);
+  free(capture);
+  if (ret_val < 0) {
+    fprintf(stderr, "%s: capture is damaged\n", argv[1]);
+    return (1);
+  }
+  return (0);
+}
@@ -0,0 +1,236 @@
+/*
+  Arduino.cpp - minimal Arduino core for the Linux host build of the
+  GSM Playground - GSM Shield for Arduino library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+
+#include <errno.h>
+#include <time.h>
+
+
+HardwareSerial Serial;
+
+static byte pin_level[HOST_PIN_CNT];
+
+
+/**********************************************************
+Time
+- time starts at 0 like after the reset of the MCU
+**********************************************************/
+static uint64_t MonotonicUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+static uint64_t start_us = MonotonicUs();
+
+unsigned long millis(void)
+{
+  return ((unsigned long)((MonotonicUs() - start_us) / 1000));
+}
+
+unsigned long micros(void)
+{
+  return ((unsigned long)(MonotonicUs() - start_us));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  struct timespec ts;
+
+  ts.tv_sec = us / 1000000;
+  ts.tv_nsec = (long)(us % 1000000) * 1000;
+  while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR));
+}
+
+void delay(unsigned long ms)
+{
+  struct timespec ts;
+
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (long)(ms % 1000) * 1000000;
+  while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR));
+}
+
+
+/**********************************************************
+Digital pins
+**********************************************************/
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin >= HOST_PIN_CNT) return;
+  if (mode == INPUT_PULLUP) pin_level[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin >= HOST_PIN_CNT) return;
+  pin_level[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+  if (pin >= HOST_PIN_CNT) return (LOW);
+  return (pin_level[pin]);
+}
+
+void HostSetPin(uint8_t pin, uint8_t val)
+{
+  digitalWrite(pin, val);
+}
+
+
+/**********************************************************
+Random numbers
+**********************************************************/
+long random(long max_val)
+{
+  if (max_val <= 0) return (0);
+  return (rand() % max_val);
+}
+
+long random(long min_val, long max_val)
+{
+  if (min_val >= max_val) return (min_val);
+  return (min_val + random(max_val - min_val));
+}
+
+void randomSeed(unsigned long seed)
+{
+  if (seed != 0) srand(seed);
+}
+
+
+/**********************************************************
+Conversion of the numbers to the string (avr-libc functions)
+**********************************************************/
+char *ultoa(unsigned long value, char *str, int radix)
+{
+  char tmp[33];
+  byte len = 0;
+  byte digit;
+  char *out = str;
+
+  if ((radix < 2) || (radix > 36)) {
+    *str = 0;
+    return (str);
+  }
+  do {
+    digit = value % radix;
+    tmp[len++] = (digit < 10) ? ('0' + digit) : ('a' + digit - 10);
+    value /= radix;
+  } while (value);
+  while (len) *out++ = tmp[--len];
+  *out = 0;
+  return (str);
+}
+
+char *ltoa(long value, char *str, int radix)
+{
+  // only decimal numbers are signed
+  if ((radix == 10) && (value < 0)) {
+    *str = '-';
+    ultoa(0UL - (unsigned long)value, str + 1, radix);
+    return (str);
+  }
+  return (ultoa((unsigned long)value, str, radix));
+}
+
+char *utoa(unsigned int value, char *str, int radix)
+{
+  return (ultoa(value, str, radix));
+}
+
+char *itoa(int value, char *str, int radix)
+{
+  if (radix == 10) return (ltoa(value, str, radix));
+  // int is 16 bit on AVR so e.g. itoa(-1, str, 16) gives "ffff"
+  return (ultoa((uint16_t)value, str, radix));
+}
+
+
+/**********************************************************
+Print and Stream
+**********************************************************/
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+
+  while (size--) {
+    if (!write(*buffer++)) break;
+    n++;
+  }
+  return (n);
+}
+
+size_t Print::print(long value)
+{
+  char num_str[12];
+
+  return (write(ltoa(value, num_str, 10)));
+}
+
+size_t Print::print(unsigned long value)
+{
+  char num_str[12];
+
+  return (write(ultoa(value, num_str, 10)));
+}
+
+int Stream::timedRead(void)
+{
+  unsigned long start = millis();
+  int ch;
+
+  do {
+    ch = read();
+    if (ch >= 0) return (ch);
+  } while (millis() - start < timeout);
+  return (-1);
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  int ch;
+
+  while (count < length) {
+    ch = timedRead();
+    if (ch < 0) break;
+    *buffer++ = (char)ch;
+    count++;
+  }
+  return (count);
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+  size_t count = 0;
+  int ch;
+
+  while (count < length) {
+    ch = timedRead();
+    if ((ch < 0) || (ch == terminator)) break;
+    *buffer++ = (char)ch;
+    count++;
+  }
+  return (count);
+}
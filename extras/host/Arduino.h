@@ -0,0 +1,142 @@
+/*
+  Arduino.h - minimal Arduino core for the Linux host build of the
+  GSM Playground - GSM Shield for Arduino library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __HOST_ARDUINO_h
+#define __HOST_ARDUINO_h
+
+/*
+    Only the part of the Arduino core which is used by the library
+    is implemented here:
+    - millis(), micros(), delay() are based on CLOCK_MONOTONIC
+    - digital pins only remember the written level (digitalRead()
+      returns the last value written by digitalWrite() or the value
+      set by HostSetPin())
+    - Serial is not connected anywhere (nothing is received, written
+      characters are thrown away), the GSM module is connected through
+      other transport - see AT::SetTransport() and ATFdTransport.h
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "avr/pgmspace.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH            1
+#define LOW             0
+
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+
+// num. of simulated digital pins
+#ifndef HOST_PIN_CNT
+  #define HOST_PIN_CNT  64
+#endif // end of ifndef HOST_PIN_CNT
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+// sets the level of the input pin (e.g. simulated button)
+void HostSetPin(uint8_t pin, uint8_t val);
+
+long random(long max_val);
+long random(long min_val, long max_val);
+void randomSeed(unsigned long seed);
+
+char *itoa(int value, char *str, int radix);
+char *ltoa(long value, char *str, int radix);
+char *utoa(unsigned int value, char *str, int radix);
+char *ultoa(unsigned long value, char *str, int radix);
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
+
+
+class Print
+{
+  public:
+    virtual size_t write(uint8_t ch) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual void flush(void) {};
+
+    size_t write(const char *str) {return (write((const uint8_t *)str, strlen(str)));};
+    size_t print(const char *str) {return (write(str));};
+    size_t print(const __FlashStringHelper *str) {return (write((const char *)str));};
+    size_t print(char ch) {return (write((uint8_t)ch));};
+    size_t print(long value);
+    size_t print(int value) {return (print((long)value));};
+    size_t print(unsigned long value);
+    size_t print(unsigned int value) {return (print((unsigned long)value));};
+    size_t println(void) {return (write("\r\n"));};
+    size_t println(const char *str) {return (print(str) + println());};
+    size_t println(char ch) {return (print(ch) + println());};
+    size_t println(long value) {return (print(value) + println());};
+    size_t println(int value) {return (print(value) + println());};
+    size_t println(unsigned long value) {return (print(value) + println());};
+    size_t println(unsigned int value) {return (print(value) + println());};
+};
+
+
+class Stream : public Print
+{
+  public:
+    Stream(void) {timeout = 1000;};
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    virtual int peek(void) = 0;
+
+    void setTimeout(unsigned long tmout) {timeout = tmout;};
+    size_t readBytes(char *buffer, size_t length);
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+
+  protected:
+    unsigned long timeout;
+
+    int timedRead(void);
+};
+
+
+class HardwareSerial : public Stream
+{
+  public:
+    void begin(unsigned long baud) {(void)baud;};
+    void end(void) {};
+    virtual int available(void) {return (0);};
+    virtual int read(void) {return (-1);};
+    virtual int peek(void) {return (-1);};
+    virtual size_t write(uint8_t ch) {(void)ch; return (1);};
+    virtual size_t write(const uint8_t *buffer, size_t size) {(void)buffer; return (size);};
+    using Print::write;
+    operator bool() {return (true);};
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,80 @@
+/*
+  pgmspace.h - Flash memory access for the Linux host build of the
+  GSM Playground - GSM Shield for Arduino library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __HOST_PGMSPACE_h
+#define __HOST_PGMSPACE_h
+
+// there is only one address space on the host so the "Flash"
+// strings and tables are ordinary constants
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P                     const char *
+#define PSTR(s)                   (s)
+
+// the value is copied so the table can have any type of the same
+// width (e.g. int16_t read by pgm_read_word()) without aliasing it
+static inline uint8_t pgm_read_byte_host(const void *addr)
+{
+  uint8_t value;
+
+  memcpy(&value, addr, sizeof(value));
+  return (value);
+}
+
+static inline uint16_t pgm_read_word_host(const void *addr)
+{
+  uint16_t value;
+
+  memcpy(&value, addr, sizeof(value));
+  return (value);
+}
+
+static inline uint32_t pgm_read_dword_host(const void *addr)
+{
+  uint32_t value;
+
+  memcpy(&value, addr, sizeof(value));
+  return (value);
+}
+
+static inline void *pgm_read_ptr_host(const void *addr)
+{
+  void *value;
+
+  memcpy(&value, addr, sizeof(value));
+  return (value);
+}
+
+#define pgm_read_byte(addr)       pgm_read_byte_host(addr)
+#define pgm_read_word(addr)       pgm_read_word_host(addr)
+#define pgm_read_dword(addr)      pgm_read_dword_host(addr)
+#define pgm_read_ptr(addr)        pgm_read_ptr_host(addr)
+
+#define strlen_P                  strlen
+#define strcpy_P                  strcpy
+#define strncpy_P                 strncpy
+#define strcat_P                  strcat
+#define strcmp_P                  strcmp
+#define strncmp_P                 strncmp
+#define strstr_P                  strstr
+#define memcpy_P                  memcpy
+
+#endif
@@ -0,0 +1,1844 @@
+/*
+  GE863Sim.cpp - simulator of the Telit GE863-GPS module for the Linux
+  host build of the GSM Playground - GSM Shield for Arduino library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GE863Sim.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+
+// kinds of the scheduled events
+#define EVENT_FREE          0
+#define EVENT_URC           1   // unsolicited line (sent only in the command mode)
+#define EVENT_REMOTE        2   // data from the remote side (only in the data mode)
+#define EVENT_REMOTE_CLOSE  3   // remote side closes the connection
+#define EVENT_RING          4   // RING of the incoming call
+#define EVENT_SRING         5   // incoming connection of the listening socket
+
+// results of the commands
+#define CMD_ERROR           0   // "ERROR" is sent, rest of the line is not executed
+#define CMD_OK              1   // command was executed, "OK" is sent at the end of the line
+#define CMD_DONE            2   // command has already sent its final response (CONNECT, "> "...)
+
+#define SERVER_ECHO         0
+#define SERVER_DISCARD      1
+#define SERVER_REPLY        2
+
+#define ARG_CNT             8
+
+static const char default_gps_acp[] =
+  "120631.999,5433.9472N,00954.8768E,1.0,46.5,3,167.28,0.36,0.19,130707,11";
+
+
+static uint64_t NowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+/**********************************************************
+Function replaces the escape sequences \r \n \" \\ \xHH
+in place
+**********************************************************/
+static void Unescape(char *str)
+{
+  char *out = str;
+  char hex[3];
+
+  while (*str) {
+    if ((*str == '\\') && str[1]) {
+      str++;
+      switch (*str) {
+        case 'r': *out++ = '\r'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'x':
+          if (isxdigit((byte)str[1]) && isxdigit((byte)str[2])) {
+            hex[0] = str[1];
+            hex[1] = str[2];
+            hex[2] = 0;
+            *out++ = (char)strtol(hex, NULL, 16);
+            str += 2;
+          }
+          break;
+        default: *out++ = *str; break;
+      }
+      str++;
+    }
+    else *out++ = *str++;
+  }
+  *out = 0;
+}
+
+/**********************************************************
+Function returns next word of the directive (words are
+separated by the spaces) or NULL
+**********************************************************/
+static char *NextWord(char **pos)
+{
+  char *word;
+
+  while (**pos == ' ' || **pos == '\t') (*pos)++;
+  if (**pos == 0) return (NULL);
+  word = *pos;
+  while (**pos && (**pos != ' ') && (**pos != '\t')) (*pos)++;
+  if (**pos) *(*pos)++ = 0;
+  return (word);
+}
+
+/**********************************************************
+Function returns rest of the directive (text argument)
+**********************************************************/
+static char *RestText(char **pos)
+{
+  char *text;
+  size_t len;
+
+  while (**pos == ' ' || **pos == '\t') (*pos)++;
+  text = *pos;
+  len = strlen(text);
+  while (len && ((text[len - 1] == ' ') || (text[len - 1] == '\t'))) text[--len] = 0;
+  Unescape(text);
+  return (text);
+}
+
+static byte StartsWithNoCase(const char *str, const char *prefix)
+{
+  return (strncasecmp(str, prefix, strlen(prefix)) == 0);
+}
+
+/**********************************************************
+Function splits the parameters of the extended command
+into argv[] (quotes are removed)
+
+return: num. of parameters
+**********************************************************/
+static byte ParseArgs(char *args, char *argv[], byte max_args)
+{
+  byte argc = 0;
+  char *out;
+  byte quoted;
+
+  if ((args == NULL) || (*args == 0)) return (0);
+  while (argc < max_args) {
+    argv[argc++] = out = args;
+    quoted = 0;
+    while (*args && (quoted || (*args != ','))) {
+      if (*args == '"') quoted = !quoted;
+      else *out++ = *args;
+      args++;
+    }
+    if (*args == 0) {
+      *out = 0;
+      break;
+    }
+    *out = 0;
+    args++;
+  }
+  return (argc);
+}
+
+static void CopyStr(char *dst, const char *src, size_t size)
+{
+  snprintf(dst, size, "%s", src);
+}
+
+
+GE863Sim::GE863Sim(void)
+{
+  master_fd = -1;
+  slave_fd = -1;
+  slave_path[0] = 0;
+  running = 0;
+  pthread_mutex_init(&mutex, NULL);
+  out_head = 0;
+  out_used = 0;
+  tx_clock_ns = 0;
+  memset(&stats, 0, sizeof(stats));
+  Defaults();
+}
+
+GE863Sim::~GE863Sim(void)
+{
+  Stop();
+  Close();
+  pthread_mutex_destroy(&mutex);
+}
+
+/**********************************************************
+Method sets all settings and storages to the defaults
+(state of the module after the first switch on)
+**********************************************************/
+void GE863Sim::Defaults(void)
+{
+  baud = 0;
+  latency_ms = 0;
+  jitter_ms = 0;
+  connect_ms = 0;
+  seed = 1;
+  trace = 0;
+  line_max_rate = 0;
+  line_err_percent = 0;
+  memset(latency, 0, sizeof(latency));
+  memset(fault, 0, sizeof(fault));
+  server_mode = SERVER_ECHO;
+  server_reply[0] = 0;
+
+  ipr = 0;
+  ReadTtyRate();
+  echo = 1;
+  memset(s_reg, 0, sizeof(s_reg));
+  s_reg[2] = '+';
+  s_reg[3] = 13;
+  s_reg[4] = 10;
+  s_reg[12] = 50;                 // guard time 50 * 20 msec.
+  flow_ctrl = 3;
+  selint = 2;
+  cap = 0;
+  crsl = 3;
+  profile_stored = 0;
+  profile_echo = 1;
+  profile_ipr = 0;
+  profile_flow_ctrl = 3;
+  profile_cap = 0;
+  profile_crsl = 3;
+  creg = 1;
+  creg_urc = 0;
+  adc = 885;
+  memset(gpio_dir, 0, sizeof(gpio_dir));
+  memset(gpio_val, 0, sizeof(gpio_val));
+  CopyStr(gps_acp, default_gps_acp, sizeof(gps_acp));
+  gps_av = 3300;
+  gps_ai = 50;
+  CopyStr(ip_addr, "10.0.0.2", sizeof(ip_addr));
+  gprs_active = 0;
+  memset(sms, 0, sizeof(sms));
+  sms_mr = 0;
+  memset(pb, 0, sizeof(pb));
+  call_state = SIM_CALL_NONE;
+  call_number[0] = 0;
+  memset(socket, 0, sizeof(socket));
+  data_socket = 0;
+  memset(event, 0, sizeof(event));
+
+  mode = SIM_MODE_CMD;
+  cmd_line_len = 0;
+  sms_text_len = 0;
+  last_rx_us = NowUs();
+  skip_lf = 0;
+  esc_cnt = 0;
+  esc_due_us = 0;
+  data_in_len = 0;
+}
+
+/**********************************************************
+Method simulates the power cycle of the module, the stored
+profile (AT&W) is loaded, storages (SMS, phonebook) are kept
+**********************************************************/
+void GE863Sim::PowerCycle(void)
+{
+  echo = profile_stored ? profile_echo : 1;
+  ipr = profile_stored ? profile_ipr : 0;
+  if (baud && ipr) baud = ipr;
+  flow_ctrl = profile_stored ? profile_flow_ctrl : 3;
+  cap = profile_stored ? profile_cap : 0;
+  crsl = profile_stored ? profile_crsl : 3;
+  creg_urc = 0;
+  s_reg[12] = 50;
+  gprs_active = 0;
+  call_state = SIM_CALL_NONE;
+  call_number[0] = 0;
+  memset(socket, 0, sizeof(socket));
+  data_socket = 0;
+  mode = SIM_MODE_CMD;
+  cmd_line_len = 0;
+  sms_text_len = 0;
+  skip_lf = 0;
+  esc_cnt = 0;
+  esc_due_us = 0;
+  data_in_len = 0;
+}
+
+/**********************************************************
+Method creates the pty
+
+return:
+        -1 - pty can not be created
+         1 - pty is ready, the library opens GetSlavePath()
+**********************************************************/
+char GE863Sim::Open(void)
+{
+  struct termios tio;
+  const char *name;
+
+  Close();
+  master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master_fd < 0) return (-1);
+  if ((grantpt(master_fd) != 0) || (unlockpt(master_fd) != 0)
+      || ((name = ptsname(master_fd)) == NULL)) {
+    Close();
+    return (-1);
+  }
+  CopyStr(slave_path, name, sizeof(slave_path));
+  // slave side is kept open so the line discipline is in the raw
+  // mode from the beginning and the master does not get EIO
+  // when the library closes its side
+  slave_fd = open(slave_path, O_RDWR | O_NOCTTY);
+  if (slave_fd < 0) {
+    Close();
+    return (-1);
+  }
+  if (tcgetattr(slave_fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd, TCSANOW, &tio);
+  }
+  fcntl(master_fd, F_SETFL, fcntl(master_fd, F_GETFL) | O_NONBLOCK);
+  return (1);
+}
+
+void GE863Sim::Close(void)
+{
+  if (master_fd >= 0) close(master_fd);
+  if (slave_fd >= 0) close(slave_fd);
+  master_fd = -1;
+  slave_fd = -1;
+  slave_path[0] = 0;
+}
+
+const char *GE863Sim::GetSlavePath(void)
+{
+  return (slave_path);
+}
+
+/**********************************************************
+Method starts the thread which runs the simulator
+(simulator can be also run by calling Poll() in a loop)
+**********************************************************/
+char GE863Sim::Start(void)
+{
+  if (running) return (1);
+  if (master_fd < 0) return (-1);
+  running = 1;
+  if (pthread_create(&thread, NULL, ThreadMain, this) != 0) {
+    running = 0;
+    return (-1);
+  }
+  return (1);
+}
+
+void GE863Sim::Stop(void)
+{
+  if (!running) return;
+  running = 0;
+  pthread_join(thread, NULL);
+}
+
+void *GE863Sim::ThreadMain(void *arg)
+{
+  GE863Sim *sim = (GE863Sim *)arg;
+
+  while (sim->running) sim->Poll(5);
+  return (NULL);
+}
+
+void GE863Sim::GetStats(GE863SimStats *out_stats)
+{
+  pthread_mutex_lock(&mutex);
+  *out_stats = stats;
+  pthread_mutex_unlock(&mutex);
+}
+
+void GE863Sim::ClearStats(void)
+{
+  pthread_mutex_lock(&mutex);
+  memset(&stats, 0, sizeof(stats));
+  pthread_mutex_unlock(&mutex);
+}
+
+byte GE863Sim::GetMode(void)
+{
+  byte ret_val;
+
+  pthread_mutex_lock(&mutex);
+  ret_val = mode;
+  pthread_mutex_unlock(&mutex);
+  return (ret_val);
+}
+
+
+/**********************************************************
+Method receives the characters, processes the events and
+sends the responses
+
+wait_ms: max. waiting time for the next character
+**********************************************************/
+void GE863Sim::Poll(int wait_ms)
+{
+  struct pollfd pfd;
+  byte buf[256];
+  ssize_t n;
+  ssize_t i;
+  uint64_t now;
+  uint64_t next_us;
+  int tmout = wait_ms;
+  byte j;
+
+  if (master_fd < 0) return;
+
+  // do not sleep longer than until the next scheduled action
+  pthread_mutex_lock(&mutex);
+  now = NowUs();
+  next_us = now + (uint64_t)wait_ms * 1000;
+  if (out_used) {
+    if (out[out_head].due_us < next_us) next_us = out[out_head].due_us;
+    if (tx_clock_ns / 1000 < next_us) next_us = tx_clock_ns / 1000;
+  }
+  for (j = 0; j < SIM_EVENT_CNT; j++) {
+    if ((event[j].kind != EVENT_FREE) && (event[j].due_us < next_us)) next_us = event[j].due_us;
+  }
+  if (esc_due_us && (esc_due_us < next_us)) next_us = esc_due_us;
+  pthread_mutex_unlock(&mutex);
+  if (next_us <= now) tmout = 0;
+  else tmout = (int)((next_us - now + 999) / 1000);
+
+  pfd.fd = master_fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  poll(&pfd, 1, tmout);
+
+  pthread_mutex_lock(&mutex);
+  ReadTtyRate();
+  if (pfd.revents & POLLIN) {
+    n = read(master_fd, buf, sizeof(buf));
+    for (i = 0; i < n; i++) {
+      if (IsLineError(ipr)) buf[i] = 0;
+    }
+    if (trace && (n > 0)) Trace("rx", (const char *)buf, n);
+    for (i = 0; i < n; i++) Receive(buf[i]);
+    FlushDataIn();
+  }
+  now = NowUs();
+  if (esc_due_us && (now >= esc_due_us)) Escape();
+  ProcessEvents(now);
+  Transmit(now);
+  pthread_mutex_unlock(&mutex);
+}
+
+
+/**********************************************************
+Directives
+**********************************************************/
+char GE863Sim::Directive(const char *line)
+{
+  char buf[SIM_CMD_LINE_LEN + SIM_EVENT_TEXT_LEN];
+  char ret_val;
+
+  CopyStr(buf, line, sizeof(buf));
+  pthread_mutex_lock(&mutex);
+  ret_val = DirectiveLocked(buf);
+  pthread_mutex_unlock(&mutex);
+  return (ret_val);
+}
+
+/**********************************************************
+Method reads the directives from the file
+
+return:
+        -1 - file can not be opened or contains wrong directive
+         1 - all directives were applied
+**********************************************************/
+char GE863Sim::LoadScript(const char *path)
+{
+  FILE *f;
+  char line[SIM_CMD_LINE_LEN + SIM_EVENT_TEXT_LEN];
+  unsigned line_no = 0;
+  char ret_val = 1;
+
+  f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return (-1);
+  }
+  while (fgets(line, sizeof(line), f) != NULL) {
+    line_no++;
+    line[strcspn(line, "\r\n")] = 0;
+    if (Directive(line) < 0) {
+      fprintf(stderr, "%s:%u: wrong directive: %s\n", path, line_no, line);
+      ret_val = -1;
+    }
+  }
+  fclose(f);
+  return (ret_val);
+}
+
+static byte ParseFaultKind(const char *word, unsigned long *param)
+{
+  *param = 0;
+  if (strcmp(word, "drop") == 0) return (SIM_FAULT_DROP);
+  if (strcmp(word, "error") == 0) return (SIM_FAULT_ERROR);
+  if (strcmp(word, "garble") == 0) return (SIM_FAULT_GARBLE);
+  if (strcmp(word, "nocarrier") == 0) return (SIM_FAULT_NOCARRIER);
+  if (strncmp(word, "delay:", 6) == 0) {
+    *param = strtoul(word + 6, NULL, 10);
+    return (SIM_FAULT_DELAY);
+  }
+  if (strncmp(word, "cme:", 4) == 0) {
+    *param = strtoul(word + 4, NULL, 10);
+    return (SIM_FAULT_CME);
+  }
+  return (SIM_FAULT_NONE);
+}
+
+/**********************************************************
+Method applies one directive (mutex is locked)
+
+return:
+        -1 - unknown directive or wrong parameters
+         1 - directive was applied (also empty line or comment)
+**********************************************************/
+char GE863Sim::DirectiveLocked(char *line)
+{
+  char *pos = line;
+  char *word;
+  char *arg1;
+  char *arg2;
+  char *arg3;
+  char *text;
+  long idx;
+  byte i;
+  byte kind;
+  unsigned long delay_ms;
+
+  word = NextWord(&pos);
+  if ((word == NULL) || (word[0] == '#')) return (1);
+
+  if (strcmp(word, "reset") == 0) {
+    Defaults();
+    return (1);
+  }
+  if (strcmp(word, "power") == 0) {
+    PowerCycle();
+    return (1);
+  }
+  if (strcmp(word, "call") == 0) {
+    arg1 = NextWord(&pos);
+    if (arg1 == NULL) return (-1);
+    text = RestText(&pos);
+    if (strcmp(arg1, "none") == 0) call_state = SIM_CALL_NONE;
+    else if (strcmp(arg1, "active") == 0) call_state = SIM_CALL_ACTIVE;
+    else if (strcmp(arg1, "dialing") == 0) call_state = SIM_CALL_DIALING;
+    else if (strcmp(arg1, "incoming") == 0) {
+      call_state = SIM_CALL_INCOMING;
+      AddEvent(EVENT_RING, 0, 3000, "RING");
+    }
+    else return (-1);
+    CopyStr(call_number, text, sizeof(call_number));
+    return (1);
+  }
+  if ((strcmp(word, "sms") == 0) || (strcmp(word, "sms_arrive") == 0)) {
+    if (strcmp(word, "sms") == 0) {
+      arg1 = NextWord(&pos);
+      arg2 = NextWord(&pos);
+      if ((arg1 == NULL) || (arg2 == NULL)) return (-1);
+      idx = atol(arg1);
+    }
+    else {
+      // first free position
+      arg2 = (char *)"unread";
+      for (idx = 1; idx <= SIM_SMS_CNT; idx++) {
+        if (!sms[idx - 1].used) break;
+      }
+    }
+    arg3 = NextWord(&pos);
+    if ((arg3 == NULL) || (idx < 1) || (idx > SIM_SMS_CNT)) return (-1);
+    text = RestText(&pos);
+    sms[idx - 1].used = 1;
+    sms[idx - 1].unread = (strcmp(arg2, "read") != 0);
+    Unescape(arg3);
+    CopyStr(sms[idx - 1].number, arg3, sizeof(sms[idx - 1].number));
+    CopyStr(sms[idx - 1].text, text, sizeof(sms[idx - 1].text));
+    if (strcmp(word, "sms_arrive") == 0) {
+      char urc[32];
+
+      sprintf(urc, "+CMTI: \"SM\",%ld", idx);
+      AddEvent(EVENT_URC, 0, 0, urc);
+    }
+    return (1);
+  }
+  if (strcmp(word, "pb") == 0) {
+    arg1 = NextWord(&pos);
+    arg2 = NextWord(&pos);
+    if ((arg1 == NULL) || (arg2 == NULL)) return (-1);
+    idx = atol(arg1);
+    if ((idx < 1) || (idx > SIM_PB_CNT)) return (-1);
+    text = RestText(&pos);
+    pb[idx - 1].used = 1;
+    CopyStr(pb[idx - 1].number, arg2, sizeof(pb[idx - 1].number));
+    CopyStr(pb[idx - 1].name, text, sizeof(pb[idx - 1].name));
+    return (1);
+  }
+  if ((strcmp(word, "urc") == 0) || (strcmp(word, "urc_every") == 0)
+      || (strcmp(word, "remote") == 0)) {
+    arg1 = NextWord(&pos);
+    if (arg1 == NULL) return (-1);
+    text = RestText(&pos);
+    if (strcmp(word, "urc") == 0) AddEvent(EVENT_URC, strtoul(arg1, NULL, 10), 0, text);
+    else if (strcmp(word, "urc_every") == 0) {
+      delay_ms = strtoul(arg1, NULL, 10);
+      if (delay_ms == 0) return (-1);
+      AddEvent(EVENT_URC, delay_ms, delay_ms, text);
+    }
+    else AddEvent(EVENT_REMOTE, strtoul(arg1, NULL, 10), 0, text);
+    return (1);
+  }
+  if (strcmp(word, "server") == 0) {
+    arg1 = NextWord(&pos);
+    if (arg1 == NULL) return (-1);
+    text = RestText(&pos);
+    if (strcmp(arg1, "echo") == 0) server_mode = SERVER_ECHO;
+    else if (strcmp(arg1, "discard") == 0) server_mode = SERVER_DISCARD;
+    else if (strcmp(arg1, "reply") == 0) {
+      server_mode = SERVER_REPLY;
+      CopyStr(server_reply, text, sizeof(server_reply));
+    }
+    else return (-1);
+    return (1);
+  }
+  if ((strcmp(word, "fault") == 0) || (strcmp(word, "fault_next") == 0)) {
+    arg1 = NextWord(&pos);
+    arg2 = NextWord(&pos);
+    arg3 = NextWord(&pos);
+    if ((arg1 == NULL) || (arg2 == NULL)) return (-1);
+    kind = ParseFaultKind(arg1, &delay_ms);
+    if (kind == SIM_FAULT_NONE) return (-1);
+    for (i = 0; i < SIM_FAULT_CNT; i++) {
+      if (fault[i].kind == SIM_FAULT_NONE) break;
+    }
+    if (i == SIM_FAULT_CNT) return (-1);
+    fault[i].kind = kind;
+    fault[i].param = delay_ms;
+    if (strcmp(word, "fault") == 0) {
+      fault[i].percent = atof(arg2);
+      fault[i].count = 0;
+    }
+    else {
+      fault[i].percent = 0;
+      fault[i].count = strtoul(arg2, NULL, 10);
+    }
+    CopyStr(fault[i].prefix, ((arg3 == NULL) || (strcmp(arg3, "*") == 0)) ? "" : arg3,
+            sizeof(fault[i].prefix));
+    return (1);
+  }
+  if (strcmp(word, "fault_clear") == 0) {
+    memset(fault, 0, sizeof(fault));
+    return (1);
+  }
+  if (strcmp(word, "latency") == 0) {
+    arg1 = NextWord(&pos);
+    arg2 = NextWord(&pos);
+    if (arg1 == NULL) return (-1);
+    if (arg2 == NULL) {
+      latency_ms = strtoul(arg1, NULL, 10);
+      return (1);
+    }
+    for (i = 0; i < SIM_LATENCY_CNT; i++) {
+      if ((latency[i].prefix[0] == 0) || (strcasecmp(latency[i].prefix, arg2) == 0)) break;
+    }
+    if (i == SIM_LATENCY_CNT) return (-1);
+    CopyStr(latency[i].prefix, arg2, sizeof(latency[i].prefix));
+    latency[i].ms = strtoul(arg1, NULL, 10);
+    return (1);
+  }
+  if (strcmp(word, "gps") == 0) {
+    CopyStr(gps_acp, RestText(&pos), sizeof(gps_acp));
+    return (1);
+  }
+  if (strcmp(word, "ip") == 0) {
+    arg1 = NextWord(&pos);
+    if (arg1 == NULL) return (-1);
+    CopyStr(ip_addr, arg1, sizeof(ip_addr));
+    return (1);
+  }
+  if (strcmp(word, "gpio") == 0) {
+    arg1 = NextWord(&pos);
+    arg2 = NextWord(&pos);
+    arg3 = NextWord(&pos);
+    if ((arg1 == NULL) || (arg2 == NULL) || (arg3 == NULL)) return (-1);
+    idx = atol(arg1);
+    if ((idx < 0) || (idx >= SIM_GPIO_CNT)) return (-1);
+    gpio_dir[idx] = atoi(arg2);
+    gpio_val[idx] = atoi(arg3) ? 1 : 0;
+    return (1);
+  }
+  if (strcmp(word, "remote_close") == 0) {
+    arg1 = NextWord(&pos);
+    AddEvent(EVENT_REMOTE_CLOSE, arg1 ? strtoul(arg1, NULL, 10) : 0, 0, "");
+    return (1);
+  }
+
+  if (strcmp(word, "line") == 0) {
+    arg1 = NextWord(&pos);
+    arg2 = NextWord(&pos);
+    if ((arg1 == NULL) || (arg2 == NULL)) return (-1);
+    line_max_rate = strtoul(arg1, NULL, 10);
+    line_err_percent = atof(arg2);
+    return (1);
+  }
+
+  // directives with one numeric parameter
+  arg1 = NextWord(&pos);
+  if (arg1 == NULL) return (-1);
+  if (strcmp(word, "baud") == 0) baud = strtoul(arg1, NULL, 10);
+  else if (strcmp(word, "ipr") == 0) ipr = strtoul(arg1, NULL, 10);
+  else if (strcmp(word, "jitter") == 0) jitter_ms = strtoul(arg1, NULL, 10);
+  else if (strcmp(word, "connect") == 0) connect_ms = strtoul(arg1, NULL, 10);
+  else if (strcmp(word, "seed") == 0) seed = strtoul(arg1, NULL, 10) ? strtoul(arg1, NULL, 10) : 1;
+  else if (strcmp(word, "trace") == 0) trace = atoi(arg1) ? 1 : 0;
+  else if (strcmp(word, "echo") == 0) echo = atoi(arg1) ? 1 : 0;
+  else if (strcmp(word, "guard") == 0) s_reg[12] = (strtoul(arg1, NULL, 10) + 19) / 20;
+  else if (strcmp(word, "creg") == 0) creg = atoi(arg1);
+  else if (strcmp(word, "adc") == 0) adc = atol(arg1);
+  else if (strcmp(word, "gpsav") == 0) gps_av = atoi(arg1);
+  else if (strcmp(word, "gpsai") == 0) gps_ai = atoi(arg1);
+  else return (-1);
+  return (1);
+}
+
+
+/**********************************************************
+Random numbers (xorshift32) - the same seed gives the same
+sequence of the latencies and faults
+**********************************************************/
+uint32_t GE863Sim::Random(void)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return (seed);
+}
+
+unsigned long GE863Sim::GetLatency(const char *cmd)
+{
+  unsigned long ms = latency_ms;
+  byte i;
+
+  for (i = 0; i < SIM_LATENCY_CNT; i++) {
+    if (latency[i].prefix[0] == 0) break;
+    if (StartsWithNoCase(cmd, latency[i].prefix)) {
+      ms = latency[i].ms;
+      break;
+    }
+  }
+  if (jitter_ms) ms += Random() % (jitter_ms + 1);
+  return (ms);
+}
+
+/**********************************************************
+Method returns the fault which is applied to the response
+of the command line
+**********************************************************/
+byte GE863Sim::TakeFault(const char *cmd, unsigned long *param)
+{
+  Fault *f;
+  byte kind;
+  byte i;
+
+  for (i = 0; i < SIM_FAULT_CNT; i++) {
+    f = &fault[i];
+    if (f->kind == SIM_FAULT_NONE) continue;
+    if (f->prefix[0] && !StartsWithNoCase(cmd, f->prefix)) continue;
+    kind = f->kind;
+    if (f->percent > 0) {
+      if ((Random() % 10000) >= (uint32_t)(f->percent * 100)) continue;
+    }
+    else {
+      // slot is released after the last fault
+      if (f->count == 0) continue;
+      if (--f->count == 0) f->kind = SIM_FAULT_NONE;
+    }
+    *param = f->param;
+    stats.faults++;
+    return (kind);
+  }
+  return (SIM_FAULT_NONE);
+}
+
+
+/**********************************************************
+Baud rate
+**********************************************************/
+void GE863Sim::ReadTtyRate(void)
+{
+  struct termios tio;
+
+  tty_rate = 0;
+  if ((slave_fd < 0) || (tcgetattr(slave_fd, &tio) != 0)) return;
+  switch (cfgetospeed(&tio)) {
+    case B1200: tty_rate = 1200; break;
+    case B2400: tty_rate = 2400; break;
+    case B4800: tty_rate = 4800; break;
+    case B9600: tty_rate = 9600; break;
+    case B19200: tty_rate = 19200; break;
+    case B38400: tty_rate = 38400; break;
+    case B57600: tty_rate = 57600; break;
+    case B115200: tty_rate = 115200; break;
+  }
+}
+
+/**********************************************************
+Method returns 1 if the character which goes through
+the line is damaged
+
+rate: baud rate of the module (0 - autobaud)
+**********************************************************/
+byte GE863Sim::IsLineError(unsigned long rate)
+{
+  byte err = 0;
+
+  if (rate && tty_rate && (rate != tty_rate)) err = 1;
+  else if (line_max_rate && (tty_rate > line_max_rate)
+           && ((Random() % 10000) < line_err_percent * 100)) err = 1;
+  if (err) stats.line_errors++;
+  return (err);
+}
+
+
+/**********************************************************
+Reception
+**********************************************************/
+void GE863Sim::Receive(byte ch)
+{
+  uint64_t now = NowUs();
+
+  stats.rx_bytes++;
+  switch (mode) {
+    case SIM_MODE_CMD: ReceiveCmdChar(ch); break;
+    case SIM_MODE_SMS_TEXT: ReceiveSMSChar(ch); break;
+    case SIM_MODE_DATA: ReceiveDataChar(ch); break;
+  }
+  last_rx_us = now;
+}
+
+void GE863Sim::ReceiveCmdChar(byte ch)
+{
+  if (ch == 0) {
+    // framing error - the command line is thrown away
+    cmd_line_len = 0;
+    return;
+  }
+  if (echo) Send((const char *)&ch, 1, 0);
+  if (ch == s_reg[3]) {
+    cmd_line[cmd_line_len] = 0;
+    ExecuteLine(cmd_line);
+    cmd_line_len = 0;
+  }
+  else if (ch == 0x08) {
+    if (cmd_line_len) cmd_line_len--;
+  }
+  else if (ch == s_reg[4]) {
+    // <LF> is ignored
+  }
+  else if (cmd_line_len < SIM_CMD_LINE_LEN - 1) {
+    cmd_line[cmd_line_len++] = ch;
+  }
+}
+
+void GE863Sim::ReceiveSMSChar(byte ch)
+{
+  char text[32];
+
+  if (echo) Send((const char *)&ch, 1, 0);
+  if (ch == 0x1a) {
+    // SMS is sent
+    sms_text[sms_text_len] = 0;
+    mode = SIM_MODE_CMD;
+    resp_len = 0;
+    sprintf(text, "+CMGS: %u", ++sms_mr);
+    RespLine("%s", text);
+    Resp("\r\nOK\r\n");
+    Send(resp, resp_len, GetLatency("AT+CMGS"));
+  }
+  else if (ch == 0x1b) {
+    // sending is cancelled
+    mode = SIM_MODE_CMD;
+    SendLine("OK", GetLatency("AT+CMGS"));
+  }
+  else if (sms_text_len < SIM_SMS_TEXT_LEN - 1) {
+    sms_text[sms_text_len++] = ch;
+  }
+}
+
+/**********************************************************
+Method receives the socket data, "+++" is taken as the
+escape sequence only when it is surrounded by the guard time
+**********************************************************/
+void GE863Sim::ReceiveDataChar(byte ch)
+{
+  uint64_t now = NowUs();
+  uint64_t guard_us = (uint64_t)s_reg[12] * 20000;
+
+  // the command line is finished by <CR><LF> but the data mode
+  // starts already by <CR>
+  if (skip_lf) {
+    skip_lf = 0;
+    if (ch == s_reg[4]) return;
+  }
+  if ((ch == s_reg[2]) && (esc_cnt < 3)
+      && (esc_cnt || (now - last_rx_us >= guard_us))) {
+    esc_cnt++;
+    if (esc_cnt == 3) esc_due_us = now + guard_us;
+    return;
+  }
+  // it was not the escape sequence
+  while (esc_cnt) {
+    if (data_in_len < sizeof(data_in)) data_in[data_in_len++] = s_reg[2];
+    esc_cnt--;
+  }
+  esc_due_us = 0;
+  if (data_in_len < sizeof(data_in)) data_in[data_in_len++] = ch;
+}
+
+void GE863Sim::FlushDataIn(void)
+{
+  if (data_in_len == 0) return;
+  ServerData(data_in, data_in_len);
+  data_in_len = 0;
+}
+
+
+/**********************************************************
+Method executes the command line
+e.g. AT&F1E0;+IPR=115200;#SELINT=2
+**********************************************************/
+void GE863Sim::ExecuteLine(char *line)
+{
+  char *pos;
+  char *end;
+  char *cmd;
+  char result = CMD_OK;
+  byte kind;
+  unsigned long fault_param = 0;
+  unsigned long delay_ms;
+  unsigned long line_rate = ipr;
+  unsigned long new_rate;
+  byte quoted;
+  char *p;
+
+  while ((*line == ' ') || (*line == s_reg[4])) line++;
+  if (!StartsWithNoCase(line, "AT")) return; // not a command line
+  stats.cmd_lines++;
+  resp_len = 0;
+  resp_extra_ms = 0;
+  delay_ms = GetLatency(line);
+  kind = TakeFault(line, &fault_param);
+
+  pos = line + 2;
+  while (*pos && (result == CMD_OK)) {
+    if (*pos == ';' || *pos == ' ') {
+      pos++;
+      continue;
+    }
+    stats.commands++;
+    if ((*pos == '+') || (*pos == '#') || (*pos == '$')) {
+      // extended command finishes by ';' out of the quotes
+      cmd = pos;
+      quoted = 0;
+      for (end = pos; *end && (quoted || (*end != ';')); end++) {
+        if (*end == '"') quoted = !quoted;
+      }
+      pos = *end ? end + 1 : end;
+      *end = 0;
+      result = ExecuteExtended(cmd);
+    }
+    else result = ExecuteBasic(&pos);
+  }
+  if (result == CMD_OK) Resp("\r\nOK\r\n");
+  else if (result == CMD_ERROR) Resp("\r\nERROR\r\n");
+
+  switch (kind) {
+    case SIM_FAULT_DROP:
+      resp_len = 0;
+      if (mode == SIM_MODE_SMS_TEXT) mode = SIM_MODE_CMD;
+      break;
+    case SIM_FAULT_ERROR:
+      resp_len = 0;
+      Resp("\r\nERROR\r\n");
+      if (mode != SIM_MODE_CMD) mode = SIM_MODE_CMD;
+      break;
+    case SIM_FAULT_CME:
+      resp_len = 0;
+      RespLine("+CME ERROR: %lu", fault_param);
+      if (mode != SIM_MODE_CMD) mode = SIM_MODE_CMD;
+      break;
+    case SIM_FAULT_GARBLE:
+      if (resp_len > 2) {
+        p = &resp[2 + Random() % (resp_len - 2)];
+        *p = (*p == '~') ? '#' : '~';
+      }
+      break;
+    case SIM_FAULT_DELAY:
+      resp_extra_ms += fault_param;
+      break;
+    case SIM_FAULT_NOCARRIER:
+      if (mode == SIM_MODE_DATA) {
+        socket[data_socket].status = 0;
+        mode = SIM_MODE_CMD;
+        resp_len = 0;
+        Resp("\r\nNO CARRIER\r\n");
+      }
+      break;
+  }
+  if ((kind == SIM_FAULT_DROP) && (mode == SIM_MODE_DATA)) {
+    socket[data_socket].status = 0;
+    mode = SIM_MODE_CMD;
+  }
+  if (resp_len) {
+    // response is sent by the rate of the command line (e.g. "OK" of AT+IPR)
+    new_rate = ipr;
+    ipr = line_rate;
+    Send(resp, resp_len, delay_ms + resp_extra_ms);
+    ipr = new_rate;
+  }
+}
+
+/**********************************************************
+Method executes one basic command (e.g. E0, &F1, S12=20)
+and moves the position behind the command
+**********************************************************/
+char GE863Sim::ExecuteBasic(char **pos)
+{
+  char *p = *pos;
+  char ch = toupper(*p++);
+  long reg;
+  long val;
+  byte i;
+
+  switch (ch) {
+    case 'D':
+      // dial - the rest of the line is the number
+      i = 0;
+      if (*p == '>') {
+        // phonebook position
+        p++;
+        while (*p && !isdigit((byte)*p)) p++;
+        reg = strtol(p, &p, 10);
+        if ((reg >= 1) && (reg <= SIM_PB_CNT) && pb[reg - 1].used) {
+          CopyStr(call_number, pb[reg - 1].number, sizeof(call_number));
+        }
+        else call_number[0] = 0;
+      }
+      else {
+        while (*p && (*p != ';') && (i < SIM_NUMBER_LEN - 1)) call_number[i++] = *p++;
+        call_number[i] = 0;
+      }
+      while (*p) p++;
+      call_state = SIM_CALL_DIALING;
+      *pos = p;
+      return (CMD_OK);
+
+    case 'A':
+      *pos = p;
+      if (call_state != SIM_CALL_INCOMING) {
+        Resp("\r\nNO CARRIER\r\n");
+        return (CMD_DONE);
+      }
+      call_state = SIM_CALL_ACTIVE;
+      return (CMD_OK);
+
+    case 'H':
+      strtol(p, &p, 10);
+      *pos = p;
+      call_state = SIM_CALL_NONE;
+      return (CMD_OK);
+
+    case 'E':
+      val = strtol(p, &p, 10);
+      *pos = p;
+      echo = val ? 1 : 0;
+      return (CMD_OK);
+
+    case 'Q':
+    case 'V':
+    case 'X':
+    case 'L':
+    case 'M':
+      strtol(p, &p, 10);
+      *pos = p;
+      return (CMD_OK);
+
+    case 'Z':
+      strtol(p, &p, 10);
+      *pos = p;
+      echo = 1;
+      return (CMD_OK);
+
+    case 'S':
+      reg = strtol(p, &p, 10);
+      if ((reg < 0) || (reg >= (long)sizeof(s_reg))) return (CMD_ERROR);
+      if (*p == '=') {
+        p++;
+        val = strtol(p, &p, 10);
+        if ((val < 0) || (val > 255)) return (CMD_ERROR);
+        s_reg[reg] = val;
+      }
+      else if (*p == '?') {
+        p++;
+        RespLine("%03u", s_reg[reg]);
+      }
+      *pos = p;
+      return (CMD_OK);
+
+    case '&':
+      ch = toupper(*p++);
+      val = strtol(p, &p, 10);
+      *pos = p;
+      switch (ch) {
+        case 'F':
+          // factory settings
+          echo = 1;
+          s_reg[12] = 50;
+          flow_ctrl = 3;
+          cap = 0;
+          crsl = 3;
+          creg_urc = 0;
+          return (CMD_OK);
+        case 'W':
+          // profile loaded after the power on (see PowerCycle())
+          profile_stored = 1;
+          profile_echo = echo;
+          profile_ipr = ipr;
+          profile_flow_ctrl = flow_ctrl;
+          profile_cap = cap;
+          profile_crsl = crsl;
+          return (CMD_OK);
+        case 'V':
+          // base configuration, the listing of the module has
+          // several hundreds of characters
+          RespLine("COMMAND ECHO            : E%u", echo);
+          RespNextLine("RESULT MESSAGES         : Q0");
+          RespNextLine("VERBOSE MESSAGES        : V1");
+          RespNextLine("EXTENDED MESSAGES       : X=1");
+          RespNextLine("FLOW CONTROL OPTIONS    : &K=%u", flow_ctrl);
+          RespNextLine("CTS (C106) OPTIONS      : &B=1");
+          RespNextLine("DSR (C107) OPTIONS      : &S=3");
+          RespNextLine("DTR (C108) OPTIONS      : &D=0");
+          RespNextLine("DCD (C109) OPTIONS      : &C=1");
+          RespNextLine("RI  (C125) OPTIONS      : \\R=1");
+          RespNextLine("POWER SAVING ON DTR     : +CFUN=1");
+          RespNextLine("DEFAULT PROFILE         : &Y0");
+          RespNextLine("S0 : AUTOMATIC ANSWER   : %03u", s_reg[0]);
+          RespNextLine("S1 : RING COUNTER       : %03u", s_reg[1]);
+          RespNextLine("S2 : ESCAPE CHARACTER   : %03u", s_reg[2]);
+          RespNextLine("S3 : CARRIAGE RETURN    : %03u", s_reg[3]);
+          RespNextLine("S4 : LINE FEED          : %03u", s_reg[4]);
+          RespNextLine("S5 : BACKSPACE          : 008");
+          RespNextLine("S7 : CONNECTION TIMEOUT : 060");
+          RespNextLine("S12: ESC GUARD TIME     : %03u", s_reg[12]);
+          RespNextLine("S25: DELAY TO DTR OFF   : 005");
+          RespNextLine("S30: INACTIVITY TIMEOUT : 000");
+          RespNextLine("+IPR: BAUD RATE         : %lu", ipr);
+          RespNextLine("+IFC: FLOW CONTROL      : %u,%u", (flow_ctrl == 3) ? 2 : 0, (flow_ctrl == 3) ? 2 : 0);
+          RespNextLine("#SELINT: INTERFACE      : %u", selint);
+          return (CMD_OK);
+        case 'K':
+          flow_ctrl = val;
+          return (CMD_OK);
+        case 'P':
+        case 'Y':
+        case 'D':
+        case 'C':
+          return (CMD_OK);
+      }
+      return (CMD_ERROR);
+  }
+  return (CMD_ERROR);
+}
+
+// commands which are only acknowledged
+static const char * const ok_cmds[] = {
+  "+CMGF", "+CNMI", "+CSCS", "+CLVL", "+VTS", "+CGDCONT", "+CPBS",
+  "+CMEE", "+CLIP", "#CODEC", "#SHFEC", "#SRS", "#SRP",
+  "#HFMICG", "#USERID", "#PASSW", "#SCFG", "$GPSP", "$GPSAT", "$GPSR",
+  NULL
+};
+
+/**********************************************************
+Method executes one extended command e.g. +CREG?
+**********************************************************/
+char GE863Sim::ExecuteExtended(char *cmd)
+{
+  char name[16];
+  char *args;
+  char *argv[ARG_CNT];
+  byte argc;
+  byte query;
+  byte i;
+  long val;
+  long pin;
+
+  // name of the command
+  for (i = 0; cmd[i] && (cmd[i] != '=') && (cmd[i] != '?') && (i < sizeof(name) - 1); i++) {
+    name[i] = toupper(cmd[i]);
+  }
+  name[i] = 0;
+  query = (cmd[i] == '?') || ((cmd[i] == '=') && (cmd[i + 1] == '?'));
+  args = (cmd[i] == '=') ? &cmd[i + 1] : NULL;
+  if (query && args) return (CMD_OK); // test command "=?"
+
+  for (i = 0; ok_cmds[i] != NULL; i++) {
+    if (strcmp(name, ok_cmds[i]) == 0) return (CMD_OK);
+  }
+  if (name[0] == '$') return (ExecuteGPS(name));
+  if ((strncmp(name, "+CMG", 4) == 0) || (strcmp(name, "+CPMS") == 0)
+      || (strncmp(name, "+CPB", 4) == 0)) {
+    return (ExecuteSMS(cmd));
+  }
+  if (((strncmp(name, "#S", 2) == 0) && strcmp(name, "#SELINT")) || (strcmp(name, "#GPRS") == 0)) {
+    return (ExecuteSocket(cmd));
+  }
+
+  argc = ParseArgs(args, argv, ARG_CNT);
+  if (strcmp(name, "+CREG") == 0) {
+    if (query) RespLine("+CREG: %u,%u", creg_urc, creg);
+    else if (argc >= 1) {
+      if ((atoi(argv[0]) < 0) || (atoi(argv[0]) > 2)) return (CMD_ERROR);
+      creg_urc = atoi(argv[0]);
+    }
+    return (CMD_OK);
+  }
+  if (strcmp(name, "+CPAS") == 0) {
+    switch (call_state) {
+      case SIM_CALL_INCOMING: val = 3; break;
+      case SIM_CALL_ACTIVE:
+      case SIM_CALL_DIALING: val = 4; break;
+      default: val = 0; break;
+    }
+    RespLine("+CPAS: %ld", val);
+    return (CMD_OK);
+  }
+  if (strcmp(name, "+CLCC") == 0) {
+    switch (call_state) {
+      case SIM_CALL_INCOMING:
+        RespLine("+CLCC: 1,1,4,0,0,\"%s\",145", call_number);
+        break;
+      case SIM_CALL_ACTIVE:
+        RespLine("+CLCC: 1,1,0,0,0,\"%s\",145", call_number);
+        break;
+      case SIM_CALL_DIALING:
+        RespLine("+CLCC: 1,0,2,0,0,\"%s\",145", call_number);
+        break;
+    }
+    return (CMD_OK);
+  }
+  if (strcmp(name, "+IPR") == 0) {
+    if (query) {
+      RespLine("+IPR: %lu", ipr);
+      return (CMD_OK);
+    }
+    if (argc < 1) return (CMD_ERROR);
+    val = atol(argv[0]);
+    // pacing follows the new speed (autobaud 0 keeps the speed)
+    if (baud && val) baud = val;
+    // "OK" is still sent by the previous rate (see Send())
+    ipr = val;
+    return (CMD_OK);
+  }
+  if (strcmp(name, "+IFC") == 0) {
+    if (query) {
+      val = (flow_ctrl == 3) ? 2 : 0;
+      RespLine("+IFC: %ld,%ld", val, val);
+      return (CMD_OK);
+    }
+    if (argc < 1) return (CMD_ERROR);
+    flow_ctrl = (atol(argv[0]) == 2) ? 3 : 0;
+    return (CMD_OK);
+  }
+  // parameters of the profile
+  if ((strcmp(name, "#SELINT") == 0) || (strcmp(name, "#CAP") == 0)
+      || (strcmp(name, "+CRSL") == 0)) {
+    byte *param = &crsl;
+
+    if (strcmp(name, "#SELINT") == 0) param = &selint;
+    else if (strcmp(name, "#CAP") == 0) param = &cap;
+
+    if (query) {
+      RespLine("%s: %u", name, *param);
+      return (CMD_OK);
+    }
+    if (argc < 1) return (CMD_ERROR);
+    *param = atoi(argv[0]);
+    return (CMD_OK);
+  }
+  if (strcmp(name, "#GPIO") == 0) {
+    if (argc < 2) return (CMD_ERROR);
+    pin = atol(argv[0]);
+    val = atol(argv[1]);
+    if ((pin < 1) || (pin >= SIM_GPIO_CNT)) return (CMD_ERROR);
+    if ((argc == 2) && (val == 2)) {
+      // read the pin
+      RespLine("#GPIO: %u,%u", gpio_dir[pin], gpio_val[pin]);
+      return (CMD_OK);
+    }
+    if (argc < 3) return (CMD_ERROR);
+    gpio_dir[pin] = atoi(argv[2]);
+    if (gpio_dir[pin] == 1) gpio_val[pin] = val ? 1 : 0;
+    return (CMD_OK);
+  }
+  if (strcmp(name, "#ADC") == 0) {
+    RespLine("#ADC: %ld", adc);
+    return (CMD_OK);
+  }
+  return (CMD_ERROR);
+}
+
+/**********************************************************
+SMS and phonebook commands
+**********************************************************/
+char GE863Sim::ExecuteSMS(char *cmd)
+{
+  char *args = strchr(cmd, '=');
+  char *argv[ARG_CNT];
+  byte argc;
+  byte used = 0;
+  byte i;
+  long idx;
+  SMS *s;
+  byte unread_only;
+  byte read_only;
+
+  argc = ParseArgs(args ? args + 1 : NULL, argv, ARG_CNT);
+  idx = argc ? atol(argv[0]) : 0;
+
+  if (StartsWithNoCase(cmd, "+CPMS")) {
+    for (i = 0; i < SIM_SMS_CNT; i++) used += sms[i].used;
+    RespLine("+CPMS: %u,%u,%u,%u,%u,%u", used, SIM_SMS_CNT, used, SIM_SMS_CNT, used, SIM_SMS_CNT);
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "+CMGL")) {
+    unread_only = argc && (strcasecmp(argv[0], "REC UNREAD") == 0);
+    read_only = argc && (strcasecmp(argv[0], "REC READ") == 0);
+    for (i = 0; i < SIM_SMS_CNT; i++) {
+      s = &sms[i];
+      if (!s->used || (unread_only && !s->unread) || (read_only && s->unread)) continue;
+      RespLine("+CMGL: %u,\"%s\",\"%s\",,\"12/01/01,10:00:00+04\"", i + 1,
+               s->unread ? "REC UNREAD" : "REC READ", s->number);
+      Resp(s->text);
+      Resp("\r\n");
+      s->unread = 0;
+    }
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "+CMGR")) {
+    if ((idx < 1) || (idx > SIM_SMS_CNT)) {
+      RespLine("+CMS ERROR: 321");
+      return (CMD_DONE);
+    }
+    s = &sms[idx - 1];
+    if (s->used) {
+      RespLine("+CMGR: \"%s\",\"%s\",,\"12/01/01,10:00:00+04\"",
+               s->unread ? "REC UNREAD" : "REC READ", s->number);
+      Resp(s->text);
+      Resp("\r\n");
+      s->unread = 0;
+    }
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "+CMGD")) {
+    if ((idx < 1) || (idx > SIM_SMS_CNT)) {
+      RespLine("+CMS ERROR: 321");
+      return (CMD_DONE);
+    }
+    sms[idx - 1].used = 0;
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "+CMGS")) {
+    if (argc < 1) return (CMD_ERROR);
+    CopyStr(sms_number, argv[0], sizeof(sms_number));
+    sms_text_len = 0;
+    mode = SIM_MODE_SMS_TEXT;
+    Resp("\r\n> ");
+    return (CMD_DONE);
+  }
+  if (StartsWithNoCase(cmd, "+CPBR")) {
+    if ((idx < 1) || (idx > SIM_PB_CNT)) {
+      RespLine("+CME ERROR: 21");
+      return (CMD_DONE);
+    }
+    if (pb[idx - 1].used) {
+      RespLine("+CPBR: %ld,\"%s\",145,\"%s\"", idx, pb[idx - 1].number, pb[idx - 1].name);
+    }
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "+CPBW")) {
+    if ((idx < 1) || (idx > SIM_PB_CNT)) {
+      RespLine("+CME ERROR: 21");
+      return (CMD_DONE);
+    }
+    if ((argc < 2) || (argv[1][0] == 0)) {
+      pb[idx - 1].used = 0;
+      return (CMD_OK);
+    }
+    pb[idx - 1].used = 1;
+    CopyStr(pb[idx - 1].number, argv[1], sizeof(pb[idx - 1].number));
+    CopyStr(pb[idx - 1].name, (argc >= 4) ? argv[3] : "", sizeof(pb[idx - 1].name));
+    return (CMD_OK);
+  }
+  return (CMD_ERROR);
+}
+
+/**********************************************************
+GPRS and socket commands
+**********************************************************/
+char GE863Sim::ExecuteSocket(char *cmd)
+{
+  char *args = strchr(cmd, '=');
+  char *argv[ARG_CNT];
+  byte argc;
+  long id;
+  byte i;
+  byte first;
+  byte last;
+  Socket *s;
+  char text[8];
+
+  argc = ParseArgs(args ? args + 1 : NULL, argv, ARG_CNT);
+  id = argc ? atol(argv[0]) : 0;
+
+  if (StartsWithNoCase(cmd, "#GPRS")) {
+    if (args == NULL) {
+      RespLine("#GPRS: %u", gprs_active);
+      return (CMD_OK);
+    }
+    gprs_active = id ? 1 : 0;
+    if (gprs_active) RespLine("+IP: %s", ip_addr);
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "#SGACT")) {
+    if (argc < 2) return (CMD_ERROR);
+    gprs_active = atoi(argv[1]) ? 1 : 0;
+    if (gprs_active) RespLine("#SGACT: %s", ip_addr);
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "#SKTD")) {
+    // #SKTD=<type>,<port>,<addr>,<closure>,<local port>
+    if (argc < 3) return (CMD_ERROR);
+    if (!gprs_active) return (CMD_ERROR);
+    s = &socket[0];
+    CopyStr(s->remote_addr, argv[2], sizeof(s->remote_addr));
+    s->remote_port = atoi(argv[1]);
+    s->local_port = 1024;
+    Connect(0, connect_ms);
+    return (CMD_DONE);
+  }
+  if (StartsWithNoCase(cmd, "#SCFG")) return (CMD_OK);
+
+  // commands with <connId> 1..6
+  if (StartsWithNoCase(cmd, "#SS")) {
+    first = 1;
+    last = SIM_SOCKET_CNT - 1;
+    if ((id >= 1) && (id < SIM_SOCKET_CNT)) first = last = id;
+    for (i = first; i <= last; i++) {
+      s = &socket[i];
+      if (s->status == 0) RespLine("#SS: %u,0", i);
+      else RespLine("#SS: %u,%u,%s,%u,%s,%u", i, s->status, ip_addr, s->local_port,
+                    s->remote_addr, s->remote_port);
+    }
+    return (CMD_OK);
+  }
+  if ((id < 1) || (id >= SIM_SOCKET_CNT)) return (CMD_ERROR);
+  s = &socket[id];
+  if (StartsWithNoCase(cmd, "#SD")) {
+    // #SD=<connId>,<proto>,<port>,<addr>,<closure>,<local port>
+    if (argc < 4) return (CMD_ERROR);
+    if (!gprs_active || (s->status != 0)) return (CMD_ERROR);
+    CopyStr(s->remote_addr, argv[3], sizeof(s->remote_addr));
+    s->remote_port = atoi(argv[2]);
+    s->local_port = 1024 + id;
+    Connect(id, connect_ms);
+    return (CMD_DONE);
+  }
+  if (StartsWithNoCase(cmd, "#SL")) {
+    // #SL=<connId>,<listen state>,<port>
+    if (argc < 3) return (CMD_ERROR);
+    if (atoi(argv[1])) {
+      if (s->status != 0) return (CMD_ERROR);
+      s->status = 4;
+      s->local_port = atoi(argv[2]);
+      // remote side connects after the connect latency
+      sprintf(text, "%ld", id);
+      AddEvent(EVENT_SRING, connect_ms, 0, text);
+    }
+    else if ((s->status == 4) || (s->status == 5)) s->status = 0;
+    return (CMD_OK);
+  }
+  if (StartsWithNoCase(cmd, "#SA")) {
+    if (s->status != 5) return (CMD_ERROR);
+    Connect(id, 0);
+    return (CMD_DONE);
+  }
+  if (StartsWithNoCase(cmd, "#SO")) {
+    if ((s->status != 2) && (s->status != 3)) return (CMD_ERROR);
+    Connect(id, 0);
+    return (CMD_DONE);
+  }
+  if (StartsWithNoCase(cmd, "#SH")) {
+    s->status = 0;
+    return (CMD_OK);
+  }
+  return (CMD_ERROR);
+}
+
+/**********************************************************
+GPS commands
+**********************************************************/
+char GE863Sim::ExecuteGPS(char *name)
+{
+  if (strcmp(name, "$GPSACP") == 0) {
+    RespLine("$GPSACP: %s", gps_acp);
+    return (CMD_OK);
+  }
+  if (strcmp(name, "$GPSSW") == 0) {
+    RespLine("$GPSSW: GSW3.2.4_3.1.00.12-SDK003P1.00a");
+    return (CMD_OK);
+  }
+  if (strcmp(name, "$GPSAV") == 0) {
+    RespLine("$GPSAV: %u", gps_av);
+    return (CMD_OK);
+  }
+  if (strcmp(name, "$GPSAI") == 0) {
+    RespLine("$GPSAI: %u,1", gps_ai);
+    return (CMD_OK);
+  }
+  return (CMD_ERROR);
+}
+
+
+/**********************************************************
+Data mode
+**********************************************************/
+void GE863Sim::Connect(byte socket_id, unsigned long extra_ms)
+{
+  socket[socket_id].status = 1;
+  socket[socket_id].reply_sent = 0;
+  data_socket = socket_id;
+  mode = SIM_MODE_DATA;
+  skip_lf = 1;
+  esc_cnt = 0;
+  esc_due_us = 0;
+  Resp("\r\nCONNECT\r\n");
+  resp_extra_ms += extra_ms;
+}
+
+/**********************************************************
+Escape sequence was received
+- #SKTD connection is closed
+- #SD connection is suspended (resumed by #SO)
+**********************************************************/
+void GE863Sim::Escape(void)
+{
+  esc_cnt = 0;
+  esc_due_us = 0;
+  if (mode != SIM_MODE_DATA) return;
+  mode = SIM_MODE_CMD;
+  if (data_socket == 0) {
+    socket[0].status = 0;
+    SendLine("NO CARRIER", 0);
+  }
+  else {
+    socket[data_socket].status = 2;
+    SendLine("OK", 0);
+  }
+}
+
+void GE863Sim::ServerData(const char *data, uint16_t len)
+{
+  Socket *s = &socket[data_socket];
+
+  if (mode != SIM_MODE_DATA) return;
+  stats.data_rx_bytes += len;
+  switch (server_mode) {
+    case SERVER_ECHO:
+      stats.data_tx_bytes += len;
+      Send(data, len, GetLatency("DATA"));
+      break;
+    case SERVER_REPLY:
+      if (!s->reply_sent) {
+        s->reply_sent = 1;
+        stats.data_tx_bytes += strlen(server_reply);
+        Send(server_reply, strlen(server_reply), GetLatency("DATA"));
+      }
+      break;
+  }
+}
+
+void GE863Sim::RemoteClose(void)
+{
+  if (mode != SIM_MODE_DATA) return;
+  socket[data_socket].status = 0;
+  mode = SIM_MODE_CMD;
+  esc_cnt = 0;
+  esc_due_us = 0;
+  SendLine("NO CARRIER", 0);
+}
+
+
+/**********************************************************
+Output
+**********************************************************/
+void GE863Sim::Trace(const char *dir, const char *data, uint16_t len)
+{
+  uint16_t i;
+
+  fprintf(stderr, "%10.3f %s ", NowUs() / 1000.0, dir);
+  for (i = 0; i < len; i++) {
+    if (data[i] == '\r') fputs("<CR>", stderr);
+    else if (data[i] == '\n') fputs("<LF>", stderr);
+    else if (((byte)data[i] < 0x20) || ((byte)data[i] >= 0x7f)) fprintf(stderr, "<%02X>", (byte)data[i]);
+    else fputc(data[i], stderr);
+  }
+  fputc('\n', stderr);
+}
+
+void GE863Sim::Resp(const char *text)
+{
+  size_t len = strlen(text);
+
+  if (resp_len + len > sizeof(resp)) len = sizeof(resp) - resp_len;
+  memcpy(resp + resp_len, text, len);
+  resp_len += len;
+}
+
+/**********************************************************
+Method adds one information line <CR><LF>text<CR><LF>
+to the response
+**********************************************************/
+void GE863Sim::RespLine(const char *format, ...)
+{
+  char line[SIM_EVENT_TEXT_LEN + 64];
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  Resp("\r\n");
+  Resp(line);
+  Resp("\r\n");
+}
+
+/**********************************************************
+Method adds the next line text<CR><LF> of the multi-line
+information (the first line is added by RespLine())
+**********************************************************/
+void GE863Sim::RespNextLine(const char *format, ...)
+{
+  char line[SIM_EVENT_TEXT_LEN + 64];
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  Resp(line);
+  Resp("\r\n");
+}
+
+void GE863Sim::SendLine(const char *text, unsigned long delay_ms)
+{
+  char line[SIM_EVENT_TEXT_LEN + 4];
+
+  snprintf(line, sizeof(line), "\r\n%s\r\n", text);
+  Send(line, strlen(line), delay_ms);
+}
+
+/**********************************************************
+Method places the characters into the output queue
+- characters are sent after delay_ms, but not before
+  the characters which are already in the queue
+**********************************************************/
+void GE863Sim::Send(const char *data, uint16_t len, unsigned long delay_ms)
+{
+  uint64_t due = NowUs() + (uint64_t)delay_ms * 1000;
+  OutChunk *tail;
+  uint16_t part;
+
+  while (len) {
+    tail = out_used ? &out[(out_head + out_used - 1) % SIM_OUT_CHUNK_CNT] : NULL;
+    if (tail && (tail->due_us >= due) && (tail->len < SIM_OUT_CHUNK_LEN) && (tail->rate == ipr)) {
+      // it is sent together with the previous characters
+      part = SIM_OUT_CHUNK_LEN - tail->len;
+      if (part > len) part = len;
+      memcpy(tail->data + tail->len, data, part);
+      tail->len += part;
+    }
+    else {
+      if (out_used == SIM_OUT_CHUNK_CNT) {
+        stats.out_overflows++;
+        return;
+      }
+      if (tail && (tail->due_us > due)) due = tail->due_us;
+      tail = &out[(out_head + out_used) % SIM_OUT_CHUNK_CNT];
+      out_used++;
+      part = (len > SIM_OUT_CHUNK_LEN) ? SIM_OUT_CHUNK_LEN : len;
+      tail->due_us = due;
+      tail->rate = ipr;
+      tail->pos = 0;
+      tail->len = part;
+      memcpy(tail->data, data, part);
+    }
+    data += part;
+    len -= part;
+  }
+}
+
+/**********************************************************
+Method writes the characters which are due
+- in case the baud rate is set the characters are paced
+  (10 bits per character)
+- characters sent by other rate than the tty uses are
+  damaged (see IsLineError())
+**********************************************************/
+void GE863Sim::Transmit(uint64_t now_us)
+{
+  OutChunk *chunk;
+  uint64_t now_ns = now_us * 1000;
+  uint64_t char_ns = baud ? (10000000000ULL / baud) : 0;
+  uint64_t n;
+  uint64_t i;
+  ssize_t written;
+  char data[SIM_OUT_CHUNK_LEN];
+
+  while (out_used) {
+    chunk = &out[out_head];
+    if (chunk->due_us > now_us) break;
+    if (tx_clock_ns < chunk->due_us * 1000) tx_clock_ns = chunk->due_us * 1000;
+    n = chunk->len - chunk->pos;
+    if (char_ns) {
+      if (tx_clock_ns > now_ns) break;
+      if ((now_ns - tx_clock_ns) / char_ns + 1 < n) n = (now_ns - tx_clock_ns) / char_ns + 1;
+    }
+    memcpy(data, chunk->data + chunk->pos, n);
+    for (i = 0; i < n; i++) {
+      if (IsLineError(chunk->rate)) data[i] = 0;
+    }
+    written = write(master_fd, data, n);
+    if (written <= 0) break;
+    if (trace) Trace("tx", data, written);
+    chunk->pos += written;
+    stats.tx_bytes += written;
+    tx_clock_ns += written * char_ns;
+    if (chunk->pos >= chunk->len) {
+      out_head = (out_head + 1) % SIM_OUT_CHUNK_CNT;
+      out_used--;
+    }
+  }
+}
+
+
+/**********************************************************
+Scheduled events
+**********************************************************/
+void GE863Sim::AddEvent(byte kind, unsigned long delay_ms, unsigned long period_ms, const char *text)
+{
+  byte i;
+
+  for (i = 0; i < SIM_EVENT_CNT; i++) {
+    if (event[i].kind == EVENT_FREE) break;
+  }
+  if (i == SIM_EVENT_CNT) return;
+  event[i].kind = kind;
+  event[i].due_us = NowUs() + (uint64_t)delay_ms * 1000;
+  event[i].period_us = (uint64_t)period_ms * 1000;
+  CopyStr(event[i].text, text, sizeof(event[i].text));
+}
+
+void GE863Sim::ProcessEvents(uint64_t now_us)
+{
+  Event *e;
+  Socket *s;
+  char text[16];
+  byte i;
+  byte done;
+
+  for (i = 0; i < SIM_EVENT_CNT; i++) {
+    e = &event[i];
+    if ((e->kind == EVENT_FREE) || (e->due_us > now_us)) continue;
+    done = 1;
+    switch (e->kind) {
+      case EVENT_URC:
+        // unsolicited codes wait until the data mode is finished
+        if (mode != SIM_MODE_CMD) {
+          done = 0;
+          break;
+        }
+        SendLine(e->text, 0);
+        stats.urcs++;
+        break;
+
+      case EVENT_RING:
+        if (call_state != SIM_CALL_INCOMING) {
+          e->period_us = 0;
+          break;
+        }
+        if (mode == SIM_MODE_CMD) {
+          SendLine(e->text, 0);
+          stats.urcs++;
+        }
+        break;
+
+      case EVENT_REMOTE:
+        if (mode == SIM_MODE_DATA) {
+          stats.data_tx_bytes += strlen(e->text);
+          Send(e->text, strlen(e->text), 0);
+        }
+        break;
+
+      case EVENT_REMOTE_CLOSE:
+        RemoteClose();
+        break;
+
+      case EVENT_SRING:
+        s = &socket[atoi(e->text)];
+        if (s->status != 4) break;
+        if (mode != SIM_MODE_CMD) {
+          done = 0;
+          break;
+        }
+        s->status = 5;
+        CopyStr(s->remote_addr, "10.0.0.1", sizeof(s->remote_addr));
+        s->remote_port = 1024;
+        snprintf(text, sizeof(text), "SRING: %s", e->text);
+        SendLine(text, 0);
+        stats.urcs++;
+        break;
+    }
+    if (!done) continue;
+    if (e->period_us) e->due_us += e->period_us;
+    else e->kind = EVENT_FREE;
+  }
+}
@@ -0,0 +1,359 @@
+/*
+  GE863Sim.h - simulator of the Telit GE863-GPS module for the Linux
+  host build of the GSM Playground - GSM Shield for Arduino library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __GE863SIM_h
+#define __GE863SIM_h
+
+/*
+    The simulator answers the AT dialect used by the library on the master
+    side of a pty, the library opens the slave side by ATFdTransport.
+
+    supported commands:
+      basic:    AT, A, D, E, H, Q, V, Z, &F, &K, &W, Sn=, Sn?
+      GSM:      +CREG, +CPAS, +CLCC, +CMGF, +CNMI, +CPMS, +CMGL, +CMGR,
+                +CMGS, +CMGD, +CPBS, +CPBR, +CPBW, +CSCS, +CLVL, +CRSL,
+                +VTS, +IPR, +CGDCONT
+      Telit:    #SELINT, #GPIO, #ADC, #CODEC, #CAP, #SHFEC, #SRS, #SRP,
+                #HFMICG, #USERID, #PASSW, #GPRS, #SKTD, #SCFG, #SGACT,
+                #SD, #SL, #SA, #SO, #SH, #SS
+      GPS:      $GPSACP, $GPSSW, $GPSAV, $GPSAI?, $GPSP, $GPSAT, $GPSR
+      data mode: escape sequence +++ with the guard time (ATS12)
+
+    the behaviour is set by the directives - one directive per line
+    (script file, ge863_sim stdin or Directive()), '#' starts a comment,
+    text arguments can contain \r \n \" \\ \xHH escapes:
+
+      baud <rate>                 pacing of the sent characters (0 - no pacing)
+      ipr <rate>                  baud rate of the module (0 - autobaud), characters
+                                  at other tty speed are damaged (read as 0x00)
+      line <rate> <percent>       characters at the tty speed above the rate are
+                                  damaged with the probability (bad cable)
+      latency <ms> [<cmd>]        response latency (for all or for the command prefix)
+      jitter <ms>                 random 0..ms added to every latency
+      connect <ms>                latency of CONNECT
+      seed <n>                    seed of the random generator
+      trace <0|1>                 received and sent characters are printed on stderr
+      echo <0|1>                  echo of the command line (ATE)
+      guard <ms>                  guard time of +++ (ATS12 sets it too)
+      creg <stat>                 registration status (0..5)
+      adc <value>                 value returned by #ADC
+      gpio <pin> <dir> <value>    state of the GPIO (dir: 0-input, 1-output)
+      gps <text>                  $GPSACP: response (without "$GPSACP: ")
+      gpsav <mV>, gpsai <mA>      GPS antenna voltage and current
+      ip <addr>                   IP address given by #SGACT and #GPRS
+      sms <idx> <unread|read> <number> <text>
+      sms_arrive <number> <text>  new SMS is stored and +CMTI is sent
+      pb <idx> <number> [<name>]  SIM phonebook entry
+      call <none|incoming|active|dialing> [<number>]
+      urc <delay_ms> <text>       one unsolicited line after delay
+      urc_every <period_ms> <text>
+      server <echo|discard|reply> [<text>]   remote side of the sockets
+      remote <delay_ms> <text>    data from the remote side (data mode)
+      remote_close <delay_ms>     remote side closes the connection
+      fault <kind> <percent> [<cmd>]       random fault of the responses
+      fault_next <kind> <count> [<cmd>]    fault of the next <count> responses
+            kind: drop, error, garble, delay:<ms>, nocarrier, 
+                  cme:<err> (+CME ERROR: <err> instead of the response)
+      reset                       all settings and storages to the defaults
+      power                       power cycle: the profile stored by AT&W (or the
+                                  factory settings) is loaded, calls and
+                                  connections are ended
+*/
+
+#include "Arduino.h"
+
+#include <pthread.h>
+
+#ifndef SIM_CMD_LINE_LEN
+  #define SIM_CMD_LINE_LEN      256
+#endif
+#ifndef SIM_SMS_CNT
+  #define SIM_SMS_CNT           20
+#endif
+#ifndef SIM_SMS_TEXT_LEN
+  #define SIM_SMS_TEXT_LEN      161
+#endif
+#ifndef SIM_PB_CNT
+  #define SIM_PB_CNT            20
+#endif
+#ifndef SIM_NUMBER_LEN
+  #define SIM_NUMBER_LEN        24
+#endif
+#ifndef SIM_GPIO_CNT
+  #define SIM_GPIO_CNT          14
+#endif
+#ifndef SIM_EVENT_CNT
+  #define SIM_EVENT_CNT         16
+#endif
+#ifndef SIM_EVENT_TEXT_LEN
+  #define SIM_EVENT_TEXT_LEN    256
+#endif
+#ifndef SIM_LATENCY_CNT
+  #define SIM_LATENCY_CNT       16
+#endif
+#ifndef SIM_FAULT_CNT
+  #define SIM_FAULT_CNT         8
+#endif
+#ifndef SIM_OUT_CHUNK_CNT
+  #define SIM_OUT_CHUNK_CNT     32
+#endif
+#ifndef SIM_OUT_CHUNK_LEN
+  #define SIM_OUT_CHUNK_LEN     1024
+#endif
+#ifndef SIM_SOCKET_CNT
+  #define SIM_SOCKET_CNT        7  // 0 - #SKTD, 1..6 - #SD
+#endif
+#ifndef SIM_CMD_PREFIX_LEN
+  #define SIM_CMD_PREFIX_LEN    16
+#endif
+
+
+enum sim_fault_enum
+{
+  SIM_FAULT_NONE = 0,
+  SIM_FAULT_DROP,       // response is not sent at all
+  SIM_FAULT_ERROR,      // ERROR instead of the response
+  SIM_FAULT_GARBLE,     // one character of the response is damaged
+  SIM_FAULT_DELAY,      // response is delayed
+  SIM_FAULT_NOCARRIER,  // CONNECT is replaced by NO CARRIER
+  SIM_FAULT_CME,        // +CME ERROR: <err> instead of the response
+
+  SIM_FAULT_LAST_ITEM
+};
+
+enum sim_call_enum
+{
+  SIM_CALL_NONE = 0,
+  SIM_CALL_INCOMING,
+  SIM_CALL_ACTIVE,
+  SIM_CALL_DIALING,
+
+  SIM_CALL_LAST_ITEM
+};
+
+enum sim_mode_enum
+{
+  SIM_MODE_CMD = 0,     // AT commands
+  SIM_MODE_SMS_TEXT,    // text of the SMS after "> "
+  SIM_MODE_DATA,        // socket is connected
+
+  SIM_MODE_LAST_ITEM
+};
+
+
+struct GE863SimStats
+{
+  unsigned long cmd_lines;        // num. of received command lines
+  unsigned long commands;         // num. of executed commands
+  unsigned long rx_bytes;         // bytes received from the library
+  unsigned long tx_bytes;         // bytes sent to the library
+  unsigned long data_rx_bytes;    // socket data received from the library
+  unsigned long data_tx_bytes;    // socket data sent to the library
+  unsigned long urcs;             // num. of sent unsolicited lines
+  unsigned long faults;           // num. of injected faults
+  unsigned long out_overflows;    // responses which did not fit to the output queue
+  unsigned long line_errors;      // characters damaged by the baud rate mismatch or the bad line
+};
+
+
+class GE863Sim
+{
+  public:
+    GE863Sim(void);
+    ~GE863Sim(void);
+
+    char Open(void);
+    void Close(void);
+    const char *GetSlavePath(void);
+    inline int GetMasterFd(void) {return master_fd;};
+
+    char Start(void);
+    void Stop(void);
+    void Poll(int wait_ms);
+
+    char Directive(const char *line);
+    char LoadScript(const char *path);
+    void GetStats(GE863SimStats *stats);
+    void ClearStats(void);
+    byte GetMode(void);
+
+  private:
+    struct SMS {
+      byte used;
+      byte unread;
+      char number[SIM_NUMBER_LEN];
+      char text[SIM_SMS_TEXT_LEN];
+    };
+    struct PBEntry {
+      byte used;
+      char number[SIM_NUMBER_LEN];
+      char name[SIM_NUMBER_LEN];
+    };
+    struct Event {
+      byte kind;                      // EVENT_xxx
+      uint64_t due_us;
+      uint64_t period_us;             // 0 - one-shot
+      char text[SIM_EVENT_TEXT_LEN];
+    };
+    struct Latency {
+      char prefix[SIM_CMD_PREFIX_LEN];
+      unsigned long ms;
+    };
+    struct Fault {
+      byte kind;                      // sim_fault_enum
+      unsigned long param;            // delay in msec. or error code
+      float percent;                  // > 0 - random fault
+      unsigned long count;            // num. of next commands (percent == 0)
+      char prefix[SIM_CMD_PREFIX_LEN];
+    };
+    struct OutChunk {
+      uint64_t due_us;
+      unsigned long rate;             // baud rate of the module (0 - autobaud)
+      uint16_t pos;
+      uint16_t len;
+      char data[SIM_OUT_CHUNK_LEN];
+    };
+    struct Socket {
+      byte status;                    // #SS status
+      byte reply_sent;
+      char remote_addr[64];
+      unsigned remote_port;
+      unsigned local_port;
+    };
+
+    // pty
+    int master_fd;
+    int slave_fd;                     // kept open so the master does not get EIO
+    char slave_path[64];
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    volatile byte running;
+
+    // settings
+    unsigned long baud;
+    unsigned long latency_ms;
+    unsigned long jitter_ms;
+    unsigned long connect_ms;
+    uint32_t seed;
+    byte trace;
+    unsigned long line_max_rate;      // 0 - line is good at all rates
+    float line_err_percent;
+    Latency latency[SIM_LATENCY_CNT];
+    Fault fault[SIM_FAULT_CNT];
+    byte server_mode;
+    char server_reply[SIM_EVENT_TEXT_LEN];
+
+    // state of the module
+    unsigned long ipr;                // baud rate (0 - autobaud)
+    unsigned long tty_rate;           // speed of the tty set by the library
+    byte echo;
+    byte s_reg[32];
+    byte flow_ctrl;                   // &K (0 - none, 3 - RTS/CTS)
+    byte selint;                      // kept also without AT&W
+    byte cap;
+    byte crsl;
+    byte profile_stored;              // 1 - AT&W was received
+    byte profile_echo;
+    unsigned long profile_ipr;
+    byte profile_flow_ctrl;
+    byte profile_cap;
+    byte profile_crsl;
+    byte creg;
+    byte creg_urc;                  // <n> of AT+CREG (0 - no URC)
+    long adc;
+    byte gpio_dir[SIM_GPIO_CNT];
+    byte gpio_val[SIM_GPIO_CNT];
+    char gps_acp[128];
+    unsigned gps_av;
+    unsigned gps_ai;
+    char ip_addr[20];
+    byte gprs_active;
+    SMS sms[SIM_SMS_CNT];
+    byte sms_mr;
+    PBEntry pb[SIM_PB_CNT];
+    byte call_state;
+    char call_number[SIM_NUMBER_LEN];
+    Socket socket[SIM_SOCKET_CNT];
+    byte data_socket;                 // socket connected in the data mode
+    Event event[SIM_EVENT_CNT];
+
+    // line processing
+    byte mode;
+    char cmd_line[SIM_CMD_LINE_LEN];
+    uint16_t cmd_line_len;
+    char sms_number[SIM_NUMBER_LEN];
+    char sms_text[SIM_SMS_TEXT_LEN];
+    byte sms_text_len;
+    uint64_t last_rx_us;
+    byte skip_lf;                     // 1 - <LF> of the command line which opened the connection
+    byte esc_cnt;                     // num. of received '+' of the escape sequence
+    uint64_t esc_due_us;              // 0 - escape sequence is not pending
+    char data_in[SIM_OUT_CHUNK_LEN];  // socket data received by the last Poll()
+    uint16_t data_in_len;
+
+    // response of the currently executed command line
+    char resp[SIM_OUT_CHUNK_LEN];
+    uint16_t resp_len;
+    unsigned long resp_extra_ms;
+
+    // output
+    OutChunk out[SIM_OUT_CHUNK_CNT];
+    byte out_head;
+    byte out_used;
+    uint64_t tx_clock_ns;             // time when the next character can be sent
+
+    GE863SimStats stats;
+
+    static void *ThreadMain(void *arg);
+    void Defaults(void);
+    void PowerCycle(void);
+    char DirectiveLocked(char *line);
+    uint32_t Random(void);
+    unsigned long GetLatency(const char *cmd);
+    byte TakeFault(const char *cmd, unsigned long *param);
+
+    void ReadTtyRate(void);
+    byte IsLineError(unsigned long rate);
+    void Receive(byte ch);
+    void ReceiveCmdChar(byte ch);
+    void ReceiveSMSChar(byte ch);
+    void ReceiveDataChar(byte ch);
+    void ExecuteLine(char *line);
+    char ExecuteBasic(char **pos);
+    char ExecuteExtended(char *cmd);
+    char ExecuteSMS(char *cmd);
+    char ExecuteSocket(char *cmd);
+    char ExecuteGPS(char *cmd);
+    void Connect(byte socket_id, unsigned long extra_ms);
+    void Escape(void);
+    void FlushDataIn(void);
+    void ServerData(const char *data, uint16_t len);
+    void RemoteClose(void);
+
+    void Trace(const char *dir, const char *data, uint16_t len);
+    void Resp(const char *text);
+    void RespLine(const char *format, ...);
+    void RespNextLine(const char *format, ...);
+    void Send(const char *data, uint16_t len, unsigned long delay_ms);
+    void SendLine(const char *text, unsigned long delay_ms);
+    void AddEvent(byte kind, unsigned long delay_ms, unsigned long period_ms, const char *text);
+    void ProcessEvents(uint64_t now_us);
+    void Transmit(uint64_t now_us);
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+  ge863_sim_main.cpp - standalone simulator of the Telit GE863-GPS module
+  for the GSM Playground - GSM Shield for Arduino (Linux host build)
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    usage: ge863_sim [-l link] [script]
+
+    - the path of the pty slave is printed on stdout, the program
+      using the library (or minicom, screen...) opens it
+    - -l creates the symbolic link to the slave (e.g. /tmp/ge863)
+    - directives of the script are applied first, then the directives
+      read from stdin (see GE863Sim.h), the simulator runs until
+      the end of stdin
+*/
+
+#include "GE863Sim.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+
+int main(int argc, char *argv[])
+{
+  GE863Sim sim;
+  const char *link_path = NULL;
+  const char *script = NULL;
+  char line[SIM_CMD_LINE_LEN + SIM_EVENT_TEXT_LEN];
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:h")) != -1) {
+    switch (opt) {
+      case 'l': link_path = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-l link] [script]\n", argv[0]);
+        return (2);
+    }
+  }
+  if (optind < argc) script = argv[optind];
+
+  if (sim.Open() < 0) {
+    perror("pty");
+    return (1);
+  }
+  if ((script != NULL) && (sim.LoadScript(script) < 0)) return (1);
+  if (link_path != NULL) {
+    unlink(link_path);
+    if (symlink(sim.GetSlavePath(), link_path) != 0) {
+      perror(link_path);
+      return (1);
+    }
+  }
+  printf("%s\n", sim.GetSlavePath());
+  fflush(stdout);
+
+  sim.Start();
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    line[strcspn(line, "\r\n")] = 0;
+    if (sim.Directive(line) < 0) fprintf(stderr, "wrong directive: %s\n", line);
+  }
+  sim.Stop();
+  if (link_path != NULL) unlink(link_path);
+  return (0);
+}
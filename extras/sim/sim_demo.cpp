@@ -0,0 +1,487 @@
+/*
+  sim_demo.cpp - end to end session of the GSM Playground library against
+  the GE863-GPS simulator (Linux host build)
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    usage: gsm_sim_demo [-f] [-b] [-i] [-w] [-d ms] [-t] [-r capture] [-p capture | -P capture] [script]
+
+    - the simulator runs in its own thread on the pty, the library
+      talks to the slave side through ATFdTransport exactly as to
+      the real module connected to /dev/ttyUSBx
+    - the script (see GE863Sim.h) sets e.g. the baud rate pacing,
+      latencies or faults before the session is started
+    - every API call is printed with its result and wall time,
+      the exit code is 1 when some call did not return the expected value
+      (or when the replayed session sent other characters than recorded)
+    - -r records the session to the capture file (see ATCapture.h)
+    - -p replays the capture instead of the simulator at the recorded
+      timing, -P as fast as possible
+    - -f switches on the RTS/CTS flow control (AT&K3 and CRTSCTS)
+    - -b retries the failed commands by the exponential backoff
+      policy (at_retry_backoff), -d limits the duration of every
+      library operation (SetOpDeadline())
+    - -t writes the trace of the library (ATTrace.h) to stderr,
+      it is flushed between the calls so it does not affect the time
+    - -w keeps the fast boot record in the memory (see SetBootStore()),
+      after the session the module is power cycled and switched on
+      again with the stored profile
+*/
+
+#include "Arduino.h"
+#include "GSM_GE863.h"
+#include "GPS_GE863.h"
+#include "ATFdTransport.h"
+#include "ATCapture.h"
+#include "GE863Sim.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static GE863Sim sim;
+static ATFdTransport tty;
+static ATRecordTransport recorder(tty);
+static ATReplayTransport replay;
+static GPS_GE863 gps;
+#ifdef AT_TRACE_ENABLED
+static ATTrace trace;
+static ATTraceFileSink trace_sink(stderr);
+#endif
+
+
+// fast boot record in the memory (GSMBootEEPROMStore on the board)
+class MemBootStore : public GSMBootStore
+{
+  public:
+    MemBootStore(void) {valid = 0;};
+    virtual byte Load(GSMBootRecord *rec) {
+      if (valid) *rec = record;
+      return (valid);
+    };
+    virtual void Save(const GSMBootRecord *rec) {
+      record = *rec;
+      valid = 1;
+    };
+
+  private:
+    GSMBootRecord record;
+    byte valid;
+};
+static MemBootStore boot_store;
+
+
+#ifdef AT_CMD_STATS_ENABLED
+// statistics of the AT commands are printed to stdout
+class StdoutPrint : public Print
+{
+  public:
+    virtual size_t write(uint8_t ch) {return ((putchar(ch) == EOF) ? 0 : 1);};
+};
+static StdoutPrint stdout_print;
+#endif
+
+
+static uint64_t NowUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+
+/**********************************************************
+Steps of the session
+**********************************************************/
+static long StepTurnOn(void)
+{
+  byte ret_val;
+
+  // TurnOn() is the same without the limit of attempts
+  gsm.StartTurnOn(3);
+  while ((ret_val = gsm.PollTurnOn()) == TURNON_BUSY);
+  return (ret_val == TURNON_OK);
+}
+
+static long StepPowerCycle(void)
+{
+  // the library is not restarted, only the module
+  sim.Directive("power");
+  return (1);
+}
+
+static long StepIsFastBoot(void)
+{
+  return (gsm.IsFastBoot());
+}
+
+static long StepInitParam1(void)
+{
+  // PARAM_SET_1 is sent by CheckRegistration() only once
+  gsm.InitParam(PARAM_SET_1);
+  return (1);
+}
+
+static long StepCheckRegistration(void)
+{
+  // the first registration sends also PARAM_SET_1
+  return (gsm.CheckRegistration());
+}
+
+static long StepSendSMS(void)
+{
+  return (gsm.SendSMS((char *)"+420123456789", (char *)"Hello from the simulator"));
+}
+
+static long StepIsSMSPresent(void)
+{
+  sim.Directive("sms 3 unread +420111222333 Stored message");
+  return (gsm.IsSMSPresent(SMS_UNREAD));
+}
+
+static long StepGetSMS(void)
+{
+  char number[20];
+  char text[40];
+
+  return (gsm.GetSMS(3, number, text, sizeof(text)));
+}
+
+static long StepDeleteSMS(void)
+{
+  return (gsm.DeleteSMS(3));
+}
+
+static long StepWritePhoneNumber(void)
+{
+  return (gsm.WritePhoneNumber(1, (char *)"+420999888777"));
+}
+
+static long StepGetPhoneNumber(void)
+{
+  char number[20];
+
+  return (gsm.GetPhoneNumber(1, number));
+}
+
+static long StepCallStatus(void)
+{
+  char number[20];
+
+  sim.Directive("call incoming +420999888777");
+  return (gsm.CallStatusWithAuth(number, 1, 1));
+}
+
+static long StepPickUpHangUp(void)
+{
+  gsm.PickUp();
+  gsm.HangUp();
+  return (gsm.CallStatus());
+}
+
+static long StepSetGPIODir(void)
+{
+  return (gsm.SetGPIODir(10, 1));
+}
+
+static long StepSetGPIOVal(void)
+{
+  return (gsm.SetGPIOVal(10, 1));
+}
+
+static long StepGetGPIOVal(void)
+{
+  // input pin driven by the outside world
+  sim.Directive("gpio 11 0 1");
+  return (gsm.GetGPIOVal(11));
+}
+
+static long StepGetTemp(void)
+{
+  return (gsm.GetTemp());
+}
+
+static long StepGPSSwVers(void)
+{
+  char sw_ver[GPS_SW_VERS_LEN];
+
+  return (gps.GetGPSSwVers(sw_ver));
+}
+
+static long StepGPSAntennaVoltage(void)
+{
+  unsigned short voltage;
+
+  if (gps.GetGPSAntennaSupplyVoltage(&voltage) != 1) return (-1);
+  return (voltage);
+}
+
+static long StepGPSData(void)
+{
+  Position pos;
+  Time time;
+  Date date;
+
+  return (gps.GetGPSData(&pos, &time, &date));
+}
+
+static long StepEnableGPRS(void)
+{
+  return (gsm.EnableGPRS(CHECK_AND_OPEN));
+}
+
+static long StepOpenSocket(void)
+{
+  return (gsm.OpenSocket(TCP_SOCKET, 80, (char *)"www.example.com", 0, 0));
+}
+
+static long StepSendRcvData(void)
+{
+  byte *rx_data;
+
+  gsm.SendData("GET / HTTP/1.0\r\n\r\n");
+  return (gsm.RcvData(1000, 100, &rx_data));
+}
+
+static long StepCloseSocket(void)
+{
+  return (gsm.CloseSocket());
+}
+
+static long StepSGACT(void)
+{
+  return (gsm.IPEasyExt_EnableOrDisableGPRS(1, 1));
+}
+
+static long StepSDOpen(void)
+{
+  return (gsm.IPEasyExt_OpenSocket(1, TCP_SOCKET, 80, (char *)"www.example.com", 0, 0));
+}
+
+static long StepSuspendSocket(void)
+{
+  return (gsm.IPEasyExt_SuspendSocket(1));
+}
+
+static long StepSocketStatus(void)
+{
+  return (gsm.IPEasyExt_GetSocketStatus(1));
+}
+
+static long StepSDClose(void)
+{
+  return (gsm.IPEasyExt_CloseSocket(1, 0));
+}
+
+
+struct DemoStep
+{
+  const char *name;
+  long (*func)(void);
+  long expected;
+};
+
+static const DemoStep demo_step[] = {
+  {"TurnOn",              StepTurnOn,             1},
+  {"CheckRegistration",   StepCheckRegistration,  REG_REGISTERED},
+  {"SendSMS",             StepSendSMS,            1},
+  {"IsSMSPresent",        StepIsSMSPresent,       3},
+  // +CMGL has already marked the SMS as read
+  {"GetSMS",              StepGetSMS,             GETSMS_READ_SMS},
+  {"DeleteSMS",           StepDeleteSMS,          1},
+  {"WritePhoneNumber",    StepWritePhoneNumber,   1},
+  {"GetPhoneNumber",      StepGetPhoneNumber,     1},
+  {"CallStatusWithAuth",  StepCallStatus,         CALL_INCOM_VOICE_AUTH},
+  {"PickUp+HangUp",       StepPickUpHangUp,       CALL_NONE},
+  {"SetGPIODir",          StepSetGPIODir,         1},
+  {"SetGPIOVal",          StepSetGPIOVal,         1},
+  {"GetGPIOVal",          StepGetGPIOVal,         1},
+  {"GetTemp",             StepGetTemp,            285},  // #ADC: 885
+  {"GetGPSSwVers",        StepGPSSwVers,          1},
+  {"GPSAntennaVoltage",   StepGPSAntennaVoltage,  3300},
+  {"GetGPSData",          StepGPSData,            1},
+  {"EnableGPRS",          StepEnableGPRS,         1},
+  {"OpenSocket",          StepOpenSocket,         1},
+  {"SendData+RcvData",    StepSendRcvData,        18},
+  {"CloseSocket",         StepCloseSocket,        1},
+  {"IPEasyExt_SGACT",     StepSGACT,              1},
+  {"IPEasyExt_OpenSocket",StepSDOpen,             1},
+  {"IPEasyExt_Suspend",   StepSuspendSocket,      1},
+  {"IPEasyExt_SocketStat",StepSocketStatus,       2},
+  {"IPEasyExt_Close",     StepSDClose,            1},
+  {NULL,                  NULL,                   0}
+};
+
+// second switching on with the stored profile (-w)
+static const DemoStep warm_boot_step[] = {
+  {"PowerCycle",          StepPowerCycle,         1},
+  {"TurnOn",              StepTurnOn,             1},
+  {"IsFastBoot",          StepIsFastBoot,         1},
+  {"CheckRegistration",   StepCheckRegistration,  REG_REGISTERED},
+  {"InitParam(1)",        StepInitParam1,         1},
+  {NULL,                  NULL,                   0}
+};
+
+
+/**********************************************************
+Function runs the steps and prints the results
+
+return: num. of failed steps
+**********************************************************/
+static int RunSteps(const DemoStep *step)
+{
+  uint64_t start_us;
+  uint64_t elapsed_us;
+  long result;
+  int failed = 0;
+
+  for (; step->name != NULL; step++) {
+    start_us = NowUs();
+    result = step->func();
+    elapsed_us = NowUs() - start_us;
+    printf("%-22s %8ld %8ld %12.3f%s\n", step->name, result, step->expected,
+           elapsed_us / 1000.0, (result == step->expected) ? "" : "  FAILED");
+    if (result != step->expected) failed++;
+#ifdef AT_TRACE_ENABLED
+    while (trace.Flush(255)) ;
+#endif
+  }
+  return (failed);
+}
+
+
+int main(int argc, char *argv[])
+{
+  GE863SimStats stats;
+  int failed = 0;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  byte replay_mode = AT_REPLAY_REALTIME;
+  byte flow_control = 0;
+  byte backoff = 0;
+  uint16_t op_deadline = 0;
+  byte tracing = 0;
+  byte rx_thread = 0;
+  byte warm_boot = 0;
+  int opt;
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  while ((opt = getopt(argc, argv, "fbiwd:tr:p:P:h")) != -1) {
+    switch (opt) {
+      case 'f': flow_control = 1; break;
+      case 'b': backoff = 1; break;
+      case 'i': rx_thread = 1; break;
+      case 'w': warm_boot = 1; break;
+      case 'd': op_deadline = strtoul(optarg, NULL, 10); break;
+      case 't': tracing = 1; break;
+      case 'r': record_path = optarg; break;
+      case 'p': replay_path = optarg; replay_mode = AT_REPLAY_REALTIME; break;
+      case 'P': replay_path = optarg; replay_mode = AT_REPLAY_FAST; break;
+      default:
+        fprintf(stderr, "usage: %s [-f] [-b] [-i] [-w] [-d ms] [-t] [-r capture] [-p capture | -P capture] [script]\n", argv[0]);
+        return (2);
+    }
+  }
+
+  if (replay_path != NULL) {
+    // the simulator is not started, directives of the steps have no effect
+    if (replay.Open(replay_path, replay_mode) < 0) {
+      fprintf(stderr, "%s: can not read the capture\n", replay_path);
+      return (1);
+    }
+    gsm.SetTransport(&replay);
+  }
+  else {
+    if (sim.Open() < 0) {
+      perror("pty");
+      return (1);
+    }
+    if ((optind < argc) && (sim.LoadScript(argv[optind]) < 0)) return (1);
+    sim.Start();
+
+    if (tty.Open(sim.GetSlavePath()) < 0) {
+      perror(sim.GetSlavePath());
+      return (1);
+    }
+    // characters are read by the thread to the ring buffer
+    if (rx_thread && (tty.StartRxThread() < 0)) {
+      fprintf(stderr, "reader thread can not be started\n");
+      return (1);
+    }
+    gsm.SetTransport(&tty);
+    if (record_path != NULL) {
+      if (recorder.Open(record_path) < 0) {
+        perror(record_path);
+        return (1);
+      }
+      gsm.SetTransport(&recorder);
+    }
+  }
+#ifdef AT_TRACE_ENABLED
+  if (tracing) {
+    trace.SetSink(&trace_sink);
+    gsm.SetTrace(&trace);
+  }
+#endif
+  gsm.InitSerLine(115200);
+  if (flow_control && (gsm.SetFlowControl(1) < 0)) {
+    fprintf(stderr, "flow control is not supported\n");
+    return (1);
+  }
+  if (backoff) gsm.SetRetryPolicy(&at_retry_backoff);
+  gsm.SetOpDeadline(op_deadline);
+  if (warm_boot) gsm.SetBootStore(&boot_store);
+
+  printf("%-22s %8s %8s %12s\n", "call", "result", "expected", "ms");
+  failed = RunSteps(demo_step);
+  if (warm_boot) failed += RunSteps(warm_boot_step);
+#ifdef AT_TRACE_ENABLED
+  if (tracing && trace.GetLostCnt()) fprintf(stderr, "trace: %u records lost\n", trace.GetLostCnt());
+#endif
+
+#ifdef AT_CMD_STATS_ENABLED
+  printf("\n");
+  gsm.PrintCmdStats(stdout_print);
+#endif
+  if (replay_path != NULL) {
+    printf("\nreplay: %lu sent characters differ, %lu received characters skipped%s\n",
+           replay.GetTxMismatchCnt(), replay.GetRxSkippedCnt(),
+           replay.IsEnd() ? "" : ", capture is not finished");
+    if (replay.GetTxMismatchCnt()) failed++;
+    replay.Close();
+    return (failed ? 1 : 0);
+  }
+  sim.Stop();
+  sim.GetStats(&stats);
+  printf("\nsimulator: %lu command lines, %lu commands, %lu bytes rx, %lu bytes tx,"
+         " %lu URCs, %lu faults, %lu line errors\n", stats.cmd_lines, stats.commands,
+         stats.rx_bytes, stats.tx_bytes, stats.urcs, stats.faults, stats.line_errors);
+  printf("baud rate: %ld\n", gsm.GetBaudRate());
+  if (rx_thread) {
+    printf("rx ring: %u characters max., %u characters lost\n",
+           tty.GetRxRing()->GetHighWater(), tty.GetRxRing()->GetOverflowCnt());
+  }
+  if (record_path != NULL) {
+    recorder.Close();
+    printf("capture: %lu records\n", recorder.GetRecordCnt());
+  }
+  tty.Close();
+  sim.Close();
+  return (failed ? 1 : 0);
+}
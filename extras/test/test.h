@@ -0,0 +1,84 @@
+/*
+  test.h - assertions of the host tests of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __TEST_h
+#define __TEST_h
+
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    every test is a function registered in test_main.cpp, failed
+    assertion prints the file, the line and the values and the test
+    continues (all failures of the test are reported)
+*/
+
+extern unsigned long test_failed;
+
+void TestFail(const char *file, int line, const char *expr);
+void TestFailLong(const char *file, int line, const char *expr, long value, long expected);
+void TestFailStr(const char *file, int line, const char *expr, const char *value, const char *expected);
+
+#define TEST_ASSERT(cond) \
+  do { if (!(cond)) TestFail(__FILE__, __LINE__, #cond); } while (0)
+
+#define TEST_EQ(value, expected) \
+  do { \
+    long test_v = (long)(value); \
+    long test_e = (long)(expected); \
+    if (test_v != test_e) TestFailLong(__FILE__, __LINE__, #value, test_v, test_e); \
+  } while (0)
+
+#define TEST_EQ_STR(value, expected) \
+  do { \
+    const char *test_v = (value); \
+    const char *test_e = (expected); \
+    if (strcmp(test_v, test_e)) TestFailStr(__FILE__, __LINE__, #value, test_v, test_e); \
+  } while (0)
+
+// tests of the modules (test_*.cpp)
+void TestPgmRead(void);
+void TestQueue(void);
+void TestBatch(void);
+void TestURC(void);
+void TestStrView(void);
+void TestATMatch(void);
+void TestStreamSearch(void);
+void TestCmdLine(void);
+void TestCache(void);
+void TestRxRing(void);
+void TestRcvData(void);
+void TestFinalCode(void);
+void TestEngine(void);
+void TestCapture(void);
+void TestCmdStats(void);
+void TestAdaptTmout(void);
+void TestAutobaud(void);
+void TestFlowControl(void);
+void TestRetry(void);
+void TestTrace(void);
+void TestCmdDesc(void);
+void TestTurnOn(void);
+
+#ifdef GSM_TEST_SIM
+// tests against the GE863 simulator (scripts are in GSM_TEST_SIM_DIR)
+void TestSimSMS(void);
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+/*
+  test_adapt.cpp - host tests of the adaptive timeouts
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+/**********************************************************
+Adaptive timeouts
+**********************************************************/
+void TestAdaptTmout(void)
+{
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+  const ATTmoutEst *est;
+  ATCmd cmd;
+  uint16_t start_tmout;
+  uint16_t interchar_tmout;
+  unsigned long start;
+  byte i;
+
+  TestModemAttach();
+  gsm.ResetTmoutEst();
+  gsm.SetTmoutMode(AT_TMOUT_ADAPTIVE);
+
+  // fast query is learned after AT_ADAPT_MIN_SAMPLES responses
+  for (i = 0; i < AT_ADAPT_MIN_SAMPLES; i++) {
+    TEST_EQ(gsm.SendATCmdWaitResp("AT#GPRS?", 2000, 200, "OK", 1), AT_RESP_OK);
+  }
+  est = gsm.FindTmoutEst("#GPRS", AT_CMD_TYPE_QUERY);
+  TEST_ASSERT(est != NULL);
+  if (est == NULL) return;
+  TEST_EQ(est->samples, AT_ADAPT_MIN_SAMPLES);
+  start_tmout = 2000;
+  interchar_tmout = 200;
+  gsm.GetAdaptedTmouts(est, &start_tmout, &interchar_tmout);
+  TEST_EQ(start_tmout, AT_ADAPT_MIN_START_TMOUT);
+  TEST_ASSERT(interchar_tmout < 200);
+
+  // set command with the same tag is other class => full timeouts
+  TEST_ASSERT(gsm.FindTmoutEst("#GPRS", AT_CMD_TYPE_SET) == NULL);
+  test_modem.SetReply("AT#GPRS=1", "");
+  gsm.SetupATCmd(&cmd, "AT#GPRS=1", 0, 2000, 200, "OK", 1, NULL);
+  TEST_EQ(gsm.StartATCmd(&cmd), 1);
+  start = millis();
+  while (gsm.IsATCmdBusy() && (millis() - start < 3 * AT_ADAPT_MIN_START_TMOUT)) {
+    gsm.PollATCmd();
+  }
+  TEST_EQ(gsm.IsATCmdBusy(), 1);
+  test_modem.Send("\r\n#GPRS: 1\r\n\r\nOK\r\n");
+  while (gsm.IsATCmdBusy()) gsm.PollATCmd();
+  TEST_EQ(cmd.result, AT_RESP_OK);
+  est = gsm.FindTmoutEst("#GPRS", AT_CMD_TYPE_SET);
+  TEST_ASSERT(est != NULL);
+  if (est != NULL) TEST_EQ(est->samples, 1);
+  est = gsm.FindTmoutEst("#GPRS", AT_CMD_TYPE_QUERY);
+  TEST_ASSERT(est != NULL);
+  if (est != NULL) TEST_EQ(est->samples, AT_ADAPT_MIN_SAMPLES);
+
+  // test command is other class too
+  TEST_EQ(gsm.SendATCmdWaitResp("AT#GPRS=?", 2000, 200, "OK", 1), AT_RESP_OK);
+  TEST_ASSERT(gsm.FindTmoutEst("#GPRS", AT_CMD_TYPE_TEST) != NULL);
+
+  // adapted start tmout which elapsed starts the learning again
+  test_modem.SetReply("AT#GPRS?", "");
+  start = millis();
+  TEST_EQ(gsm.SendATCmdWaitResp("AT#GPRS?", 2000, 200, "OK", 1), AT_RESP_ERR_NO_RESP);
+  TEST_ASSERT(millis() - start < 1000);
+  TEST_ASSERT(gsm.FindTmoutEst("#GPRS", AT_CMD_TYPE_QUERY) == NULL);
+
+  gsm.SetTmoutMode(AT_TMOUT_FIXED);
+  gsm.ResetTmoutEst();
+#endif // end of ifdef AT_ADAPTIVE_TMOUT_ENABLED
+}
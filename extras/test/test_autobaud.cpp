@@ -0,0 +1,126 @@
+/*
+  test_autobaud.cpp - host tests of the baud rate autodetection
+  and of the return to the lower baud rate of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+#include <stdlib.h>
+
+#ifdef AT_AUTOBAUD_ENABLED
+
+// module which hears only the characters sent by its baud rate
+// and changes the rate by AT+IPR
+class TestBaudModem : public TestModem
+{
+  public:
+    TestBaudModem(void) {modem_rate = 9600; line_rate = 0;};
+    virtual void Begin(long baud_rate) {line_rate = baud_rate;};
+    virtual size_t Write(byte ch) {
+      const char *line;
+
+      if (line_rate != modem_rate) return (1);
+      TestModem::Write(ch);
+      if (ch == 0x0d) {
+        line = GetLine(GetLineCnt() - 1);
+        if (!strncmp(line, "AT+IPR=", 7)) modem_rate = atol(line + 7);
+      }
+      return (1);
+    };
+    using TestModem::Write;
+
+    long modem_rate;
+    long line_rate;
+};
+
+static TestBaudModem baud_modem;
+
+// commands which end the reception are counted when the comm. line
+// is acquired next time
+static void CheckFallback(void)
+{
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  gsm.SetCommLineStatus(CLS_FREE);
+}
+
+#endif // end of ifdef AT_AUTOBAUD_ENABLED
+
+
+/**********************************************************
+Baud rate autodetection and fallback
+**********************************************************/
+void TestAutobaud(void)
+{
+#ifdef AT_AUTOBAUD_ENABLED
+  byte i;
+
+  baud_modem.Reset();
+  baud_modem.modem_rate = 9600;
+  gsm.SetTransport(&baud_modem);
+  gsm.InitSerLine(115200);
+  gsm.SetCommLineStatus(CLS_FREE);
+
+  // module is found at its rate and raised to the max. rate
+  TEST_EQ(gsm.DetectBaudRate(), 9600);
+  TEST_EQ(gsm.GetBaudRate(), 9600);
+  gsm.SetMaxBaudRate(115200);
+  TEST_EQ(gsm.UpshiftBaudRate(), 115200);
+  TEST_EQ(baud_modem.modem_rate, 115200);
+  TEST_EQ(gsm.GetBaudFallbackCnt(), 0);
+
+  // missing responses are not the line errors
+  baud_modem.SetReply("AT+CSQ", "");
+  for (i = 0; i < 2 * AT_BAUD_FALLBACK_ERR_CNT; i++) {
+    TEST_EQ(gsm.SendATCmdWaitResp("AT+CSQ", 30, 20, "OK", 1), AT_RESP_ERR_NO_RESP);
+  }
+  CheckFallback();
+  TEST_EQ(gsm.GetBaudRate(), 115200);
+  TEST_EQ(gsm.GetBaudFallbackCnt(), 0);
+
+  // damaged responses are counted, the clean one clears the count
+  baud_modem.SetReply("AT+CGB", "\r\n+CGB: \xff\x01\r\n\r\nOK\r\n");
+  for (i = 0; i < AT_BAUD_FALLBACK_ERR_CNT - 1; i++) {
+    TEST_EQ(gsm.SendATCmdWaitResp("AT+CGB", 500, 20, "OK", 1), AT_RESP_OK);
+  }
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CGB", 500, 20, "OK", 1), AT_RESP_OK);
+  CheckFallback();
+  TEST_EQ(gsm.GetBaudRate(), 115200);
+
+  // missing response between the damaged ones does not clear the count
+  for (i = 0; i < AT_BAUD_FALLBACK_ERR_CNT - 2; i++) {
+    TEST_EQ(gsm.SendATCmdWaitResp("AT+CGB", 500, 20, "OK", 1), AT_RESP_OK);
+  }
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CSQ", 30, 20, "OK", 1), AT_RESP_ERR_NO_RESP);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CGB", 500, 20, "OK", 1), AT_RESP_OK);
+  CheckFallback();
+  TEST_EQ(gsm.GetBaudRate(), 57600);
+  TEST_EQ(baud_modem.modem_rate, 57600);
+  TEST_EQ(gsm.GetMaxBaudRate(), 57600);
+  TEST_EQ(gsm.GetBaudFallbackCnt(), 1);
+
+  // the rate is never lower than the detected one
+  for (i = 0; i < 10; i++) {
+    gsm.SendATCmdWaitResp("AT+CGB", 500, 20, "OK", 1);
+    if (i % AT_BAUD_FALLBACK_ERR_CNT == AT_BAUD_FALLBACK_ERR_CNT - 1) CheckFallback();
+  }
+  TEST_EQ(gsm.GetBaudRate(), 9600);
+
+  TestModemAttach();
+#endif // end of ifdef AT_AUTOBAUD_ENABLED
+}
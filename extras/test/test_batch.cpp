@@ -0,0 +1,63 @@
+/*
+  test_batch.cpp - host tests of the batched command lines
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+/**********************************************************
+ATBatch
+**********************************************************/
+void TestBatch(void)
+{
+  ATBatch batch;
+
+  TestModemAttach();
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+
+  // the whole batch is one command line
+  gsm.BatchInit(&batch);
+  TEST_EQ(gsm.BatchAddF(&batch, PSTR("AT&F1"), 500), 1);
+  TEST_EQ(gsm.BatchAddF(&batch, PSTR("ATE0"), 500), 1);
+  TEST_EQ(gsm.BatchAddF(&batch, PSTR("AT+CMGF=1"), 500), 1);
+  TEST_EQ(gsm.BatchAdd(&batch, "AT#CAP=1", 500), 1);
+  TEST_EQ(gsm.BatchRun(&batch, 20, 1), 0);
+  TEST_EQ(test_modem.GetLineCnt(), 1);
+  TEST_EQ_STR(test_modem.GetLine(0), "AT&F1E0;+CMGF=1;#CAP=1");
+
+  // failed line is sent again command by command
+  test_modem.ClearLog();
+  test_modem.SetReply("AT#CAP=1", "\r\nERROR\r\n");
+  test_modem.SetReply("ATE0;", "\r\nERROR\r\n");
+  gsm.BatchInit(&batch);
+  gsm.BatchAddF(&batch, PSTR("ATE0"), 500);
+  gsm.BatchAddF(&batch, PSTR("AT#CAP=1"), 500);
+  gsm.BatchAddF(&batch, PSTR("AT+CMGF=1"), 500);
+  TEST_EQ(gsm.BatchRun(&batch, 20, 2), 1);
+  TEST_EQ_STR(test_modem.GetLine(0), "ATE0;#CAP=1;+CMGF=1");
+  TEST_EQ_STR(test_modem.GetLine(1), "ATE0");
+  TEST_EQ(test_modem.CountLines("AT#CAP=1"), 2);
+  TEST_EQ(test_modem.CountLines("AT+CMGF=1"), 1);
+
+  // the batch is full
+  gsm.BatchInit(&batch);
+  for (byte i = 0; i < ATCMD_BATCH_LEN; i++) TEST_EQ(gsm.BatchAddF(&batch, PSTR("AT"), 500), 1);
+  TEST_EQ(gsm.BatchAddF(&batch, PSTR("AT"), 500), -1);
+  gsm.SetCommLineStatus(CLS_FREE);
+}
@@ -0,0 +1,124 @@
+/*
+  test_cache.cpp - host tests of the response cache
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+/**********************************************************
+Cache of the query results
+**********************************************************/
+void TestCache(void)
+{
+#ifdef GSM_CACHE_ENABLED
+  TestModemAttach();
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 0,1\r\n\r\nOK\r\n");
+  test_modem.SetReply("AT#ADC=", "\r\n#ADC: 885\r\n\r\nOK\r\n");
+  // the first registration sends also the init. parameters
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+
+  // the result is kept for the TTL
+  gsm.SetCacheTTL(GSM_CACHE_REG, 60000);
+  test_modem.ClearLog();
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  TEST_EQ(test_modem.CountLines("AT+CREG?"), 1);
+  TEST_EQ(gsm.GetCacheTTL(GSM_CACHE_REG), 60000);
+
+  // +CREG URC invalidates the registration
+  test_modem.Send("\r\n+CREG: 5\r\n");
+  gsm.PollURC();
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  TEST_EQ(test_modem.CountLines("AT+CREG?"), 2);
+  gsm.InvalidateCache(GSM_CACHE_REG);
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  TEST_EQ(test_modem.CountLines("AT+CREG?"), 3);
+
+  // expired value is read again
+  gsm.SetCacheTTL(GSM_CACHE_TEMP, 20);
+  TEST_EQ(gsm.GetTemp(), 285);
+  TEST_EQ(gsm.GetTemp(), 285);
+  TEST_EQ(test_modem.CountLines("AT#ADC="), 1);
+  delay(30);
+  TEST_EQ(gsm.GetTemp(), 285);
+  TEST_EQ(test_modem.CountLines("AT#ADC="), 2);
+
+  // TTL 0 - nothing is cached
+  gsm.SetCacheTTL(GSM_CACHE_ALL, 0);
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  TEST_EQ(test_modem.CountLines("AT+CREG?"), 4);
+
+#ifdef URC_ENABLED
+  // the URC is enabled by the init. parameters
+  test_modem.ClearLog();
+  gsm.InitParam(PARAM_SET_0);
+  TEST_ASSERT(strstr(test_modem.GetLine(0), ";+CREG=1") != NULL);
+#endif
+
+  // <stat> is read whatever <n> is set
+  test_modem.Reset();
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 1,5\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  test_modem.Reset();
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 2,1,\"00C3\",\"0F3A\"\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  test_modem.Reset();
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 1,2\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.CheckRegistration(), REG_NOT_REGISTERED);
+  // the URC received during the query is not the response
+  test_modem.Reset();
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 5\r\n\r\n+CREG: 1,3\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.CheckRegistration(), REG_NOT_REGISTERED);
+  test_modem.Reset();
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 2\r\n\r\n+CREG: 1,1\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+
+  // +CREG URC invalidates the registration read with <n> = 1
+  gsm.SetCacheTTL(GSM_CACHE_REG, 60000);
+  test_modem.Reset();
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 1,1\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 1,0\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.CheckRegistration(), REG_REGISTERED);
+  TEST_EQ(test_modem.CountLines("AT+CREG?"), 1);
+  test_modem.Send("\r\n+CREG: 0\r\n");
+  gsm.PollURC();
+  TEST_EQ(gsm.CheckRegistration(), REG_NOT_REGISTERED);
+  TEST_EQ(test_modem.CountLines("AT+CREG?"), 2);
+
+  // only the state of the button read from the module is cached
+  gsm.SetCacheTTL(GSM_CACHE_BUTTON, 60000);
+  test_modem.Reset();
+  test_modem.SetReply("AT#GPIO=9,2", "\r\nERROR\r\n");
+  TEST_EQ(gsm.IsUserButtonPushed(), 0);
+  TEST_EQ(gsm.IsUserButtonPushed(), 0);
+  TEST_EQ(test_modem.CountLines("AT#GPIO=9,2"), 2);
+  test_modem.SetReply("AT#GPIO=9,2", "\r\n#GPIO: 0,0\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.IsUserButtonPushed(), 1);
+  test_modem.SetReply("AT#GPIO=9,2", "\r\n#GPIO: 0,1\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.IsUserButtonPushed(), 1);
+  TEST_EQ(test_modem.CountLines("AT#GPIO=9,2"), 3);
+  gsm.InvalidateCache(GSM_CACHE_BUTTON);
+  TEST_EQ(gsm.IsUserButtonPushed(), 0);
+  TEST_EQ(gsm.IsUserButtonPushed(), 0);
+  TEST_EQ(test_modem.CountLines("AT#GPIO=9,2"), 4);
+
+  gsm.SetCacheTTL(GSM_CACHE_ALL, 0);
+#endif
+}
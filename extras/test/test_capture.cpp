@@ -0,0 +1,97 @@
+/*
+  test_capture.cpp - host tests of the recording of the serial traffic
+  (ATRecordTransport) of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+#include "ATCapture.h"
+
+
+// capture in the memory instead of the file on the SD card
+class TestCapSink : public Print
+{
+  public:
+    TestCapSink(void) {len = 0; flush_cnt = 0;};
+    virtual size_t write(uint8_t ch) {
+      if (len >= sizeof(buf)) return (0);
+      buf[len++] = ch;
+      return (1);
+    };
+    virtual void flush(void) {flush_cnt++;};
+    using Print::write;
+
+    byte buf[256];
+    size_t len;
+    byte flush_cnt;
+};
+
+
+/**********************************************************
+ATRecordTransport
+**********************************************************/
+void TestCapture(void)
+{
+  static TestCapSink sink;
+  ATRecordTransport rec(test_modem);
+  ATCapReader reader;
+  ATCapRecord record;
+  char tx[32];
+  char rx[32];
+  byte tx_len = 0;
+  byte rx_len = 0;
+  byte begin_cnt = 0;
+
+  TestModemAttach();
+  rec.Start(sink);
+  gsm.SetTransport(&rec);
+  gsm.InitSerLine(115200);
+  gsm.SetCommLineStatus(CLS_FREE);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 50, "OK", 1), AT_RESP_OK);
+  sink.flush_cnt = 0;
+  rec.Stop();
+  TEST_EQ(sink.flush_cnt, 1);
+  // nothing is written after Stop()
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 50, "OK", 1), AT_RESP_OK);
+  TestModemAttach();
+
+  TEST_EQ(reader.Attach(sink.buf, sink.len), 1);
+  while (reader.Next(&record) == 1) {
+    if (record.type == AT_CAP_BEGIN) {
+      begin_cnt++;
+      TEST_EQ(record.len, 4);
+      TEST_EQ(record.data[0] | ((long)record.data[1] << 8) | ((long)record.data[2] << 16), 115200);
+    }
+    else if (record.type == AT_CAP_TX) {
+      if (tx_len + record.len < (int)sizeof(tx)) memcpy(tx + tx_len, record.data, record.len);
+      tx_len += record.len;
+    }
+    else {
+      if (rx_len + record.len < (int)sizeof(rx)) memcpy(rx + rx_len, record.data, record.len);
+      rx_len += record.len;
+    }
+  }
+  TEST_EQ(reader.Next(&record), 0);
+  TEST_EQ(begin_cnt, 1);
+  TEST_EQ(tx_len, 4);
+  tx[tx_len < sizeof(tx) ? tx_len : 0] = 0;
+  TEST_EQ_STR(tx, "AT\r\n");
+  TEST_EQ(rx_len, 6);
+  rx[rx_len < sizeof(rx) ? rx_len : 0] = 0;
+  TEST_EQ_STR(rx, "\r\nOK\r\n");
+  TEST_EQ(rec.GetRecordCnt() >= 3, 1);
+}
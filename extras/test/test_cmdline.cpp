@@ -0,0 +1,51 @@
+/*
+  test_cmdline.cpp - host tests of the compile-time AT command builder
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+#include "ATCmdLine.h"
+
+
+/**********************************************************
+ATCmdLine
+**********************************************************/
+void TestCmdLine(void)
+{
+  char addr[] = "www.example.com";
+  auto line_sd = ATLine(ATF("AT#SD="), (byte)1, ATF(","), (byte)0, ATF(","),
+                        (unsigned short)80, ATF(","), ATQuote(addr), ATF(",0,0"));
+  auto line_num = ATLine(ATF("AT+X="), -12345L, ',', 4000000000UL, ',', (int)-1);
+
+  // max. length is known at the compile time (RAM strings have no length)
+  static_assert(decltype(line_sd)::max_len == 6 + 3 + 1 + 3 + 1 + 5 + 1 + 2 + 4,
+                "max_len of the command line");
+
+  TestModemAttach();
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  TEST_EQ(gsm.SendATCmdWaitResp(line_sd, 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ_STR(test_modem.GetLine(0), "AT#SD=1,0,80,\"www.example.com\",0,0");
+  TEST_EQ(gsm.SendATCmdWaitResp(line_num, 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ_STR(test_modem.GetLine(1), "AT+X=-12345,4000000000,-1");
+
+  // every attempt streams the command again
+  test_modem.SetReply("AT#SD=", "\r\nERROR\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp(line_sd, 500, 20, "OK", 3), AT_RESP_ERR_DIF_RESP);
+  TEST_EQ(test_modem.CountLines("AT#SD=1,0,80,\"www.example.com\",0,0"), 4);
+  gsm.SetCommLineStatus(CLS_FREE);
+}
@@ -0,0 +1,106 @@
+/*
+  test_desc.cpp - host tests of the AT commands described
+  in the Flash memory (ATCmdDesc) of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+static const char test_cmd_gpsav[] PROGMEM = "AT$GPSAV";
+static const char test_resp_gpsav[] PROGMEM = "$GPSAV:";
+static const char test_cmd_cmgf[] PROGMEM = "AT+CMGF=1";
+static const char test_cmd_cpbs[] PROGMEM = "AT+CPBS=\"SM\"";
+static const char test_cmd_cscs[] PROGMEM = "AT+CSCS=\"8859-1\"";
+static const char test_resp_ok[] PROGMEM = "OK";
+
+static const ATCmdDesc test_desc_gpsav PROGMEM =
+  {test_cmd_gpsav, test_resp_gpsav, AT_TMOUT_CLASS_XLONG, 1, AT::ParseDescNum};
+
+static const ATCmdDesc test_desc_seq[] PROGMEM = {
+  {test_cmd_cmgf, test_resp_ok, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  {test_cmd_cpbs, test_resp_ok, AT_TMOUT_CLASS_LONG, 2, NULL},
+  {test_cmd_cscs, test_resp_ok, AT_TMOUT_CLASS_LAST_ITEM, 1, NULL},
+};
+
+
+/**********************************************************
+AT commands described in the Flash memory
+**********************************************************/
+void TestCmdDesc(void)
+{
+  ATBatch batch;
+  ATCmd cmd;
+  long value;
+
+  TestModemAttach();
+
+  // timeouts of the class, invalid class is the long one
+  gsm.SetupATCmdDesc(&cmd, &test_desc_seq[0], NULL);
+  TEST_EQ(cmd.start_comm_tmout, START_SHORT_COMM_TMOUT);
+  TEST_EQ(cmd.max_interchar_tmout, MAX_INTERCHAR_TMOUT);
+  TEST_EQ(cmd.no_of_attempts, 1);
+  gsm.SetupATCmdDesc(&cmd, &test_desc_gpsav, NULL);
+  TEST_EQ(cmd.start_comm_tmout, START_XLONG_COMM_TMOUT);
+  TEST_EQ(cmd.max_interchar_tmout, MAX_MID_INTERCHAR_TMOUT);
+  gsm.SetupATCmdDesc(&cmd, &test_desc_seq[2], NULL);
+  TEST_EQ(cmd.start_comm_tmout, START_LONG_COMM_TMOUT);
+  TEST_EQ(cmd.max_interchar_tmout, MAX_MID_INTERCHAR_TMOUT);
+
+  // parsed number
+  test_modem.SetReply("AT$GPSAV", "\r\n$GPSAV: 3962\r\n\r\nOK\r\n");
+  value = 0;
+  TEST_EQ(gsm.RunATCmdDesc(&test_desc_gpsav, ATCMD_PRIO_NORMAL, &value), 1);
+  TEST_EQ(value, 3962);
+  TEST_EQ(gsm.GetCommLineStatus(), CLS_FREE);
+  test_modem.SetReply("AT$GPSAV", "\r\n$GPSAV: \r\n\r\nOK\r\n");
+  TEST_EQ(gsm.RunATCmdDesc(&test_desc_gpsav, ATCMD_PRIO_NORMAL, &value), 0);
+  test_modem.SetReply("AT$GPSAV", "\r\nERROR\r\n");
+  TEST_EQ(gsm.RunATCmdDesc(&test_desc_gpsav, ATCMD_PRIO_NORMAL, &value), 0);
+
+  // busy comm. line
+  gsm.SetCommLineStatus(CLS_ATCMD);
+  TEST_EQ(gsm.RunATCmdDesc(&test_desc_gpsav, ATCMD_PRIO_NORMAL, &value), -1);
+  gsm.SetCommLineStatus(CLS_FREE);
+
+  // sequence is stopped by the first failed command
+  test_modem.ClearLog();
+  TEST_EQ(gsm.RunATCmdSeq(test_desc_seq, 3, ATCMD_PRIO_NORMAL, NULL), 1);
+  TEST_EQ(test_modem.GetLineCnt(), 3);
+  TEST_EQ_STR(test_modem.GetLine(2), "AT+CSCS=\"8859-1\"");
+  test_modem.ClearLog();
+  test_modem.SetReply("AT+CPBS", "\r\nERROR\r\n");
+  TEST_EQ(gsm.RunATCmdSeq(test_desc_seq, 3, ATCMD_PRIO_NORMAL, NULL), 0);
+  TEST_EQ(test_modem.CountLines("AT+CPBS"), 2);
+  TEST_EQ(test_modem.CountLines("AT+CSCS"), 0);
+  TEST_EQ(gsm.GetCommLineStatus(), CLS_FREE);
+
+  // descriptions in the batch are concatenated
+  TestModemAttach();
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  gsm.BatchInit(&batch);
+  TEST_EQ(gsm.BatchAddDesc(&batch, &test_desc_seq[0]), 1);
+  TEST_EQ(gsm.BatchAddDesc(&batch, &test_desc_seq[1]), 1);
+  TEST_EQ(gsm.BatchAddDesc(&batch, &test_desc_seq[2]), 1);
+  TEST_EQ(batch.item[0].start_comm_tmout, START_SHORT_COMM_TMOUT);
+  TEST_EQ(batch.item[1].start_comm_tmout, START_LONG_COMM_TMOUT);
+  TEST_EQ(batch.item[2].start_comm_tmout, START_LONG_COMM_TMOUT);
+  TEST_EQ(gsm.BatchRun(&batch, 20, 1), 0);
+  TEST_EQ(test_modem.GetLineCnt(), 1);
+  TEST_EQ_STR(test_modem.GetLine(0), "AT+CMGF=1;+CPBS=\"SM\";+CSCS=\"8859-1\"");
+  gsm.SetCommLineStatus(CLS_FREE);
+}
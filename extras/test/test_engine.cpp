@@ -0,0 +1,103 @@
+/*
+  test_engine.cpp - host tests of the non-blocking AT command engine
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+/**********************************************************
+Non-blocking AT command engine
+**********************************************************/
+static ATCmd *engine_done;
+static byte engine_done_cnt;
+
+static void EngineDone(ATCmd *cmd)
+{
+  engine_done = cmd;
+  engine_done_cnt++;
+}
+
+// the command can be finished already by StartATCmd()
+static void EnginePoll(uint16_t max_ms)
+{
+  unsigned long start = millis();
+
+  while (gsm.IsATCmdBusy() && (millis() - start < max_ms)) gsm.PollATCmd();
+}
+
+void TestEngine(void)
+{
+  ATCmd cmd;
+  ATCmd other;
+  byte i;
+
+  TestModemAttach();
+  engine_done_cnt = 0;
+  TEST_EQ(gsm.PollATCmd(), ATCMD_IDLE);
+
+  // the call returns before the response is received
+  test_modem.SetReply("AT+SLOW", "");
+  gsm.SetupATCmd(&cmd, "AT+SLOW", 0, 500, 20, "OK", 1, EngineDone);
+  TEST_EQ(gsm.StartATCmd(&cmd), 1);
+  TEST_EQ(cmd.state, ATCMD_BUSY);
+  TEST_EQ(gsm.IsATCmdBusy(), 1);
+  for (i = 0; i < 10; i++) TEST_EQ(gsm.PollATCmd(), ATCMD_BUSY);
+  // only one command at once
+  gsm.SetupATCmd(&other, "AT", 0, 500, 20, "OK", 1, EngineDone);
+  TEST_EQ(gsm.StartATCmd(&other), -1);
+  TEST_EQ(engine_done_cnt, 0);
+  test_modem.Send("\r\nOK\r\n");
+  TEST_EQ(gsm.PollATCmd(), ATCMD_FINISHED);
+  TEST_EQ(engine_done_cnt, 1);
+  TEST_ASSERT(engine_done == &cmd);
+  TEST_EQ(cmd.state, ATCMD_FINISHED);
+  TEST_EQ(cmd.result, AT_RESP_OK);
+  TEST_EQ(cmd.rx_status, RX_FINISHED_STR_RECV);
+  TEST_EQ(gsm.IsATCmdBusy(), 0);
+  TEST_EQ(gsm.PollATCmd(), ATCMD_IDLE);
+
+  // no response - every attempt is sent
+  gsm.SetupATCmd(&cmd, "AT+SLOW", 0, 30, 20, "OK", 2, EngineDone);
+  TEST_EQ(gsm.StartATCmd(&cmd), 1);
+  EnginePoll(1000);
+  TEST_EQ(cmd.state, ATCMD_FINISHED);
+  TEST_EQ(cmd.result, AT_RESP_ERR_NO_RESP);
+  TEST_EQ(cmd.rx_status, RX_TMOUT_ERR);
+  TEST_EQ(test_modem.CountLines("AT+SLOW"), 3);
+  TEST_EQ(engine_done_cnt, 2);
+
+  // other response than expected
+  test_modem.SetReply("AT+CPAS", "\r\n+CPAS: 0\r\n\r\nOK\r\n");
+  gsm.SetupATCmd(&cmd, "AT+CPAS", 0, 500, 20, "+CPAS: 4", 1, NULL);
+  TEST_EQ(gsm.StartATCmd(&cmd), 1);
+  EnginePoll(1000);
+  TEST_EQ(cmd.state, ATCMD_FINISHED);
+  TEST_EQ(cmd.result, AT_RESP_ERR_DIF_RESP);
+  // response is not checked
+  gsm.SetupATCmd(&cmd, "AT+CPAS", 0, 500, 20, NULL, 1, NULL);
+  TEST_EQ(gsm.StartATCmd(&cmd), 1);
+  EnginePoll(1000);
+  TEST_EQ(cmd.state, ATCMD_FINISHED);
+  TEST_EQ(cmd.result, AT_RESP_OK);
+  TEST_EQ(engine_done_cnt, 2);
+
+  // blocking wrapper
+  TEST_EQ(gsm.RunATCmd(&other), AT_RESP_OK);
+  TEST_EQ(engine_done_cnt, 3);
+}
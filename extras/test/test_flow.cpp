@@ -0,0 +1,134 @@
+/*
+  test_flow.cpp - host tests of the RTS/CTS hardware flow control
+  (ATFlowSerialTransport) of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+#define TEST_RTS_PIN    8
+#define TEST_CTS_PIN    9
+
+
+// serial port with the module which sends only while RTS is asserted
+class TestFlowPort
+{
+  public:
+    TestFlowPort(void) {Clear();};
+    void begin(long) {};
+    void flush(void) {};
+    size_t write(byte ch) {
+      if (ch == 0x0d) Send("\r\nOK\r\n");
+      return (1);
+    };
+    size_t write(const byte *data, size_t size) {
+      size_t i;
+
+      for (i = 0; i < size; i++) write(data[i]);
+      return (size);
+    };
+    int available(void) {
+      // module sends the pending characters when RTS is asserted (LOW)
+      while ((digitalRead(TEST_RTS_PIN) == LOW) && (pending_pos < pending_len)
+             && (rx_len < sizeof(rx))) {
+        rx[rx_len++] = pending[pending_pos++];
+      }
+      return (rx_len - rx_pos);
+    };
+    int read(void) {
+      if (!available()) return (-1);
+      return (rx[rx_pos++]);
+    };
+
+    // characters the module wants to send
+    void Send(const char *text) {
+      while (*text && (pending_len < sizeof(pending))) pending[pending_len++] = *text++;
+    };
+    inline size_t GetPendingCnt(void) {return (pending_len - pending_pos);};
+    void Clear(void) {
+      rx_len = 0;
+      rx_pos = 0;
+      pending_len = 0;
+      pending_pos = 0;
+    };
+
+  private:
+    byte rx[256];                   // receive buffer of the port
+    size_t rx_len;
+    size_t rx_pos;
+    char pending[256];
+    size_t pending_len;
+    size_t pending_pos;
+};
+
+
+/**********************************************************
+RTS/CTS flow control
+**********************************************************/
+void TestFlowControl(void)
+{
+  static TestFlowPort port;
+  static ATFlowSerialTransport<TestFlowPort> flow(port, TEST_RTS_PIN, TEST_CTS_PIN);
+  char buf[8];
+  byte i;
+
+  port.Clear();
+  gsm.SetTransport(&flow);
+  gsm.InitSerLine(115200);
+  gsm.SetCommLineStatus(CLS_FREE);
+  digitalWrite(TEST_CTS_PIN, LOW);
+  TEST_EQ(gsm.SetFlowControl(1), 1);
+  TEST_EQ(gsm.GetFlowControl(), 1);
+  // nobody reads => RTS is deasserted
+  TEST_EQ(digitalRead(TEST_RTS_PIN), HIGH);
+
+  // RTS is asserted only during the reception
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ(digitalRead(TEST_RTS_PIN), HIGH);
+
+  // module keeps the characters while the program does something else
+  port.Send("\r\nRING\r\n");
+  delay(10);
+  gsm.GetTransport()->Available();
+  TEST_EQ(port.GetPendingCnt(), 8);
+  TEST_EQ(digitalRead(TEST_RTS_PIN), HIGH);
+
+  // reading by FindUntil() and ReadBytesUntil()
+  port.Clear();
+  port.Send("xx#SGACT: 10.0.0.1\r\n");
+  TEST_EQ(gsm.FindUntil("#SGACT: ", "ERROR", 100), true);
+  TEST_EQ(digitalRead(TEST_RTS_PIN), HIGH);
+  TEST_EQ(gsm.ReadBytesUntil('\r', buf, sizeof(buf) - 1), 7);
+  TEST_EQ(digitalRead(TEST_RTS_PIN), HIGH);
+
+  // almost full receive buffer deasserts RTS also during the reading
+  port.Clear();
+  gsm.HoldRx(0);
+  for (i = 0; i < AT_FLOW_RX_HIGH; i++) port.Send("x");
+  TEST_EQ(gsm.GetTransport()->Available(), AT_FLOW_RX_HIGH);
+  TEST_EQ(digitalRead(TEST_RTS_PIN), HIGH);
+  gsm.GetTransport()->Read();
+  TEST_EQ(digitalRead(TEST_RTS_PIN), LOW);
+  gsm.HoldRx(1);
+  TEST_EQ(digitalRead(TEST_RTS_PIN), HIGH);
+
+  // without the flow control RTS is always asserted
+  TEST_EQ(gsm.SetFlowControl(0), 1);
+  TEST_EQ(digitalRead(TEST_RTS_PIN), LOW);
+
+  TestModemAttach();
+}
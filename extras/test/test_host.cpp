@@ -0,0 +1,47 @@
+/*
+  test_host.cpp - host tests of the minimal Arduino core (extras/host)
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+
+
+/**********************************************************
+Flash memory shims (avr/pgmspace.h)
+**********************************************************/
+static const char pgm_str_1[] PROGMEM = "AT+CREG?";
+static const char pgm_str_2[] PROGMEM = "AT+CSQ";
+static const char * const pgm_strs[] PROGMEM = {pgm_str_1, pgm_str_2};
+static const uint16_t pgm_words[] PROGMEM = {500, 10000};
+static const uint32_t pgm_dwords[] PROGMEM = {9600, 115200};
+static const byte pgm_bytes[] PROGMEM = {0x12, 0x34, 0x56, 0x78, 0x9a};
+
+void TestPgmRead(void)
+{
+  uint32_t dword;
+
+  TEST_EQ(pgm_read_byte(&pgm_str_1[2]), '+');
+  TEST_EQ(pgm_read_word(&pgm_words[1]), 10000);
+  TEST_EQ(pgm_read_dword(&pgm_dwords[1]), 115200UL);
+  TEST_ASSERT(pgm_read_ptr(&pgm_strs[1]) == pgm_str_2);
+  TEST_EQ(strlen_P((PGM_P)pgm_read_ptr(&pgm_strs[0])), 8);
+
+  // unaligned address is read as well
+  memcpy(&dword, &pgm_bytes[1], sizeof(dword));
+  TEST_ASSERT(pgm_read_dword(&pgm_bytes[1]) == dword);
+  TEST_EQ(pgm_read_byte(&pgm_bytes[4]), 0x9a);
+}
@@ -0,0 +1,108 @@
+/*
+  test_main.cpp - host tests of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    usage: gsm_test [test_name]
+
+    - all tests are run when no name is given
+    - the exit code is 1 when some assertion failed (see test.h)
+*/
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+unsigned long test_failed = 0;
+
+void TestFail(const char *file, int line, const char *expr)
+{
+  printf("%s:%d: FAILED %s\n", file, line, expr);
+  test_failed++;
+}
+
+void TestFailLong(const char *file, int line, const char *expr, long value, long expected)
+{
+  printf("%s:%d: FAILED %s is %ld, expected %ld\n", file, line, expr, value, expected);
+  test_failed++;
+}
+
+void TestFailStr(const char *file, int line, const char *expr, const char *value, const char *expected)
+{
+  printf("%s:%d: FAILED %s is \"%s\", expected \"%s\"\n", file, line, expr, value, expected);
+  test_failed++;
+}
+
+
+struct TestItem
+{
+  const char *name;
+  void (*func)(void);
+};
+
+static const TestItem test_item[] = {
+  {"pgmread",       TestPgmRead},
+  {"queue",        TestQueue},
+  {"batch",        TestBatch},
+  {"urc",          TestURC},
+  {"strview",      TestStrView},
+  {"atmatch",      TestATMatch},
+  {"streamsearch", TestStreamSearch},
+  {"cmdline",      TestCmdLine},
+  {"cache",        TestCache},
+  {"rxring",       TestRxRing},
+  {"rcvdata",      TestRcvData},
+  {"finalcode",    TestFinalCode},
+  {"engine",       TestEngine},
+  {"capture",      TestCapture},
+  {"cmdstats",     TestCmdStats},
+  {"adapttmout",   TestAdaptTmout},
+  {"autobaud",     TestAutobaud},
+  {"flow",         TestFlowControl},
+  {"retry",        TestRetry},
+  {"trace",        TestTrace},
+  {"desc",         TestCmdDesc},
+  {"turnon",       TestTurnOn},
+#ifdef GSM_TEST_SIM
+  {"sim_sms",       TestSimSMS},
+#endif
+  {NULL,            NULL}
+};
+
+
+int main(int argc, char *argv[])
+{
+  const TestItem *item;
+  unsigned long failed;
+  int run = 0;
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  for (item = test_item; item->name != NULL; item++) {
+    if ((argc > 1) && strcmp(argv[1], item->name)) continue;
+    failed = test_failed;
+    item->func();
+    printf("%-14s %s\n", item->name, (test_failed == failed) ? "ok" : "FAILED");
+    run++;
+  }
+  if (run == 0) {
+    fprintf(stderr, "%s: unknown test\n", argv[1]);
+    return (2);
+  }
+  return (test_failed ? 1 : 0);
+}
@@ -0,0 +1,76 @@
+/*
+  test_match.cpp - host tests of the response classifier (ATMatch)
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "ATMatch.h"
+#include "ATRespMatch.h"
+
+
+/**********************************************************
+ATMatch and the generated tables
+**********************************************************/
+// response of AT+CMGR=1
+static const char cmgr_resp[] =
+  "\r\n+CMGR: \"REC UNREAD\",\"+420123456789\",,\"12/01/01,10:00:00+04\"\r\n"
+  "Hello, world\r\n\r\nOK\r\n";
+
+static char Classify(const ATMatchSet *set, const char *text)
+{
+  return (ATMatchFirst(set, text, strlen(text)));
+}
+
+void TestATMatch(void)
+{
+  ATMatcher matcher;
+  ATMatchHit hits[4];
+  const char *text;
+  byte i;
+
+  TEST_EQ(Classify(&resp_match_cpas, "\r\n+CPAS: 3\r\n\r\nOK\r\n"), CPAS_RINGING);
+  TEST_EQ(Classify(&resp_match_cpas, "\r\n+CPAS: 2\r\n\r\nOK\r\n"), -1);
+  TEST_EQ(Classify(&resp_match_gpio, "\r\n#GPIO: 0,0\r\n\r\nOK\r\n"), GPIO_LOW);
+  TEST_EQ(Classify(&resp_match_gpio, "\r\n#GPIO: 0,1\r\n\r\nOK\r\n"), GPIO_HIGH);
+  // the first pattern of the set has the highest priority
+  TEST_EQ(Classify(&resp_match_clcc, "\r\n+CLCC: 1,1,4,0,0,\"+420777\",145\r\n\r\nOK\r\n"), CLCC_INCOM_VOICE);
+  TEST_EQ(Classify(&resp_match_clcc, "\r\n+CLCC: 2,1,5,0,0\r\n\r\nOK\r\n"), CLCC_OTHERS);
+  TEST_EQ(Classify(&resp_match_clcc, "\r\nOK\r\n"), CLCC_NONE);
+  TEST_EQ(Classify(&resp_match_cmgr, cmgr_resp), CMGR_UNREAD);
+  // characters above 0x7f are not classified
+  TEST_EQ(Classify(&resp_match_cmgr, "\r\n\xe9\xff" "ERROR\r\n"), CMGR_ERROR);
+
+  // the matcher fed character by character gives the same result
+  ATMatchInit(&matcher, &resp_match_cmgr);
+  for (i = 0; cmgr_resp[i]; i++) ATMatchFeed(&matcher, cmgr_resp[i]);
+  TEST_EQ(ATMatchBest(&matcher), CMGR_UNREAD);
+  TEST_ASSERT(matcher.st.matched & (1U << CMGR_OK));
+  ATMatchReset(&matcher);
+  TEST_EQ(ATMatchBest(&matcher), -1);
+
+  // all occurrences in the order of their end
+  text = "OK +CLCC: 1,0,0,0,0 OK";
+  TEST_EQ(ATMatchAll(&resp_match_clcc, text, strlen(text), hits, 4), 4);
+  TEST_EQ(hits[0].pattern, CLCC_NONE);
+  TEST_EQ(hits[0].offset, 0);
+  TEST_EQ(hits[1].pattern, CLCC_OTHERS);
+  TEST_EQ(hits[1].offset, 3);
+  TEST_EQ(hits[2].pattern, CLCC_ACTIVE_VOICE_CALLER);
+  TEST_EQ(hits[3].pattern, CLCC_NONE);
+  TEST_EQ(hits[3].offset, 20);
+  TEST_EQ(ATMatchAll(&resp_match_clcc, text, strlen(text), hits, 1), 1);
+}
@@ -0,0 +1,111 @@
+/*
+  test_modem.cpp - stand-in of the GSM module for the host tests
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test_modem.h"
+
+#include <string.h>
+
+
+TestModem test_modem;
+
+
+void TestModem::Reset(void)
+{
+  Clear();
+  reply_cnt = 0;
+  line_len = 0;
+  line_cnt = 0;
+}
+
+void TestModem::SetReply(const char *cmd_prefix, const char *reply_text)
+{
+  if (reply_cnt >= TEST_MODEM_REPLY_CNT) return;
+  reply[reply_cnt].cmd_prefix = cmd_prefix;
+  reply[reply_cnt].reply = reply_text;
+  reply_cnt++;
+}
+
+/**********************************************************
+Method returns the received command line (0 - the first
+one since Reset()), only the last TEST_MODEM_LOG_CNT lines
+are kept
+**********************************************************/
+const char *TestModem::GetLine(unsigned long index)
+{
+  if ((index >= line_cnt) || (index + TEST_MODEM_LOG_CNT < line_cnt)) return ("");
+  return (log[index % TEST_MODEM_LOG_CNT]);
+}
+
+unsigned long TestModem::CountLines(const char *cmd_prefix)
+{
+  unsigned long cnt = 0;
+  unsigned long i;
+
+  i = (line_cnt > TEST_MODEM_LOG_CNT) ? line_cnt - TEST_MODEM_LOG_CNT : 0;
+  for (; i < line_cnt; i++) {
+    if (!strncmp(GetLine(i), cmd_prefix, strlen(cmd_prefix))) cnt++;
+  }
+  return (cnt);
+}
+
+size_t TestModem::Write(byte ch)
+{
+  size_t ret = ATLoopbackTransport::Write(ch);
+
+  if (ch == 0x0d) {
+    line[line_len] = 0;
+    Answer();
+    line_len = 0;
+  }
+  else if ((ch != 0x0a) && (line_len < sizeof(line) - 1)) {
+    line[line_len++] = ch;
+  }
+  // the line is already copied
+  while (PeerAvailable()) PeerRead();
+  return (ret);
+}
+
+void TestModem::Answer(void)
+{
+  const char *text = "\r\nOK\r\n";
+  byte i = reply_cnt;
+
+  strcpy(log[line_cnt % TEST_MODEM_LOG_CNT], line);
+  line_cnt++;
+  while (i--) {
+    if (!strncmp(line, reply[i].cmd_prefix, strlen(reply[i].cmd_prefix))) {
+      text = reply[i].reply;
+      break;
+    }
+  }
+  PeerPrint(text);
+}
+
+
+void TestModemAttach(void)
+{
+  test_modem.Reset();
+  gsm.SetTransport(&test_modem);
+  gsm.InitSerLine(115200);
+  gsm.SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  gsm.SetCacheTTL(GSM_CACHE_ALL, 0);
+  gsm.InvalidateCache(GSM_CACHE_ALL);
+#endif
+}
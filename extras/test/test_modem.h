@@ -0,0 +1,76 @@
+/*
+  test_modem.h - stand-in of the GSM module for the host tests
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __TEST_MODEM_h
+#define __TEST_MODEM_h
+
+#include "Arduino.h"
+#include "GSM_GE863.h"
+
+#define TEST_MODEM_REPLY_CNT    16
+#define TEST_MODEM_LINE_LEN     96
+#define TEST_MODEM_LOG_CNT      32
+
+/*
+    TestModem answers every command line immediately when its <CR>
+    is received, the reply is chosen by the prefix of the line
+    (the last set reply with the matching prefix wins, "OK" when
+    nothing matches), received command lines are logged
+*/
+
+class TestModem : public ATLoopbackTransport
+{
+  public:
+    TestModem(void) {Reset();};
+    using ATLoopbackTransport::Write;
+    virtual size_t Write(byte ch);
+
+    // replies and the log are cleared
+    void Reset(void);
+    // strings must be valid until Reset()
+    void SetReply(const char *cmd_prefix, const char *reply);
+    // characters sent by the module without the command (e.g. URC)
+    inline void Send(const char *text) {PeerPrint(text);};
+
+    // num. of command lines received since Reset() and the last ones
+    inline unsigned long GetLineCnt(void) {return line_cnt;};
+    inline void ClearLog(void) {line_cnt = 0;};
+    const char *GetLine(unsigned long index);
+    unsigned long CountLines(const char *cmd_prefix);
+
+  private:
+    struct Reply {
+      const char *cmd_prefix;
+      const char *reply;
+    };
+    Reply reply[TEST_MODEM_REPLY_CNT];
+    byte reply_cnt;
+    char line[TEST_MODEM_LINE_LEN];
+    byte line_len;
+    char log[TEST_MODEM_LOG_CNT][TEST_MODEM_LINE_LEN];
+    unsigned long line_cnt;
+
+    void Answer(void);
+};
+
+extern TestModem test_modem;
+
+// gsm talks to the test_modem, nothing is cached
+void TestModemAttach(void);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+  test_queue.cpp - host tests of the priority queue of the AT commands
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+/**********************************************************
+Queue of the non-blocking engine
+**********************************************************/
+static ATCmd *queue_done[8];
+static byte queue_done_cnt;
+
+static void QueueDone(ATCmd *cmd)
+{
+  if (queue_done_cnt < 8) queue_done[queue_done_cnt++] = cmd;
+}
+
+void TestQueue(void)
+{
+  ATCmd cmd_low, cmd_normal, cmd_high, cmd_high2, cmd_expire;
+  unsigned long start;
+
+  TestModemAttach();
+  gsm.ResetATCmdQueueStats();
+  queue_done_cnt = 0;
+
+  gsm.SetupATCmd(&cmd_low, "AT+LOW", 0, 500, 20, "OK", 1, QueueDone);
+  gsm.SetATCmdPriority(&cmd_low, ATCMD_PRIO_LOW, 0);
+  gsm.SetupATCmd(&cmd_normal, "AT+NORMAL", 0, 500, 20, "OK", 1, QueueDone);
+  gsm.SetupATCmd(&cmd_high, "AT+HIGH", 0, 500, 20, "OK", 1, QueueDone);
+  gsm.SetATCmdPriority(&cmd_high, ATCMD_PRIO_HIGH, 0);
+  gsm.SetupATCmd(&cmd_high2, "AT+HIGH2", 0, 500, 20, "OK", 1, QueueDone);
+  gsm.SetATCmdPriority(&cmd_high2, ATCMD_PRIO_HIGH, 0);
+  gsm.SetupATCmd(&cmd_expire, "AT+EXPIRE", 0, 500, 20, "OK", 1, QueueDone);
+  gsm.SetATCmdPriority(&cmd_expire, ATCMD_PRIO_LOW, 5);
+
+  // the comm. line is occupied so all commands wait
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  TEST_EQ(gsm.SubmitATCmd(&cmd_low), 0);
+  TEST_EQ(gsm.SubmitATCmd(&cmd_normal), 0);
+  TEST_EQ(gsm.SubmitATCmd(&cmd_high), 0);
+  TEST_EQ(gsm.SubmitATCmd(&cmd_high), -1);
+  TEST_EQ(gsm.SubmitATCmd(&cmd_high2), 0);
+  TEST_EQ(cmd_low.state, ATCMD_QUEUED);
+  TEST_EQ(gsm.GetATCmdQueueLen(), 4);
+  // the queue is full
+  TEST_EQ(gsm.SubmitATCmd(&cmd_expire), -1);
+  TEST_EQ(gsm.GetATCmdQueueStats(ATCMD_PRIO_LOW)->rejected, 1);
+  gsm.SetCommLineStatus(CLS_FREE);
+
+  // by priority, FIFO inside of one priority
+  start = millis();
+  while ((queue_done_cnt < 4) && (millis() - start < 1000)) gsm.PollATCmd();
+  TEST_EQ(queue_done_cnt, 4);
+  TEST_ASSERT(queue_done[0] == &cmd_high);
+  TEST_ASSERT(queue_done[1] == &cmd_high2);
+  TEST_ASSERT(queue_done[2] == &cmd_normal);
+  TEST_ASSERT(queue_done[3] == &cmd_low);
+  TEST_EQ(cmd_low.result, AT_RESP_OK);
+  TEST_EQ(cmd_low.state, ATCMD_FINISHED);
+  TEST_EQ_STR(test_modem.GetLine(0), "AT+HIGH");
+  TEST_EQ_STR(test_modem.GetLine(3), "AT+LOW");
+  TEST_EQ(gsm.GetATCmdQueueStats(ATCMD_PRIO_HIGH)->served, 2);
+  TEST_EQ(gsm.GetATCmdQueueMaxLen(), 4);
+
+  // the deadline expires in the queue
+  queue_done_cnt = 0;
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  TEST_EQ(gsm.SubmitATCmd(&cmd_expire), 0);
+  delay(10);
+  gsm.SetCommLineStatus(CLS_FREE);
+  gsm.PollATCmd();
+  TEST_EQ(queue_done_cnt, 1);
+  TEST_EQ(cmd_expire.result, AT_RESP_ERR_QUEUE_TMOUT);
+  TEST_EQ(gsm.GetATCmdQueueStats(ATCMD_PRIO_LOW)->expired, 1);
+  TEST_EQ(test_modem.CountLines("AT+EXPIRE"), 0);
+
+  // free line - the command is started immediately
+  TEST_EQ(gsm.SubmitATCmd(&cmd_normal), 1);
+  start = millis();
+  while (gsm.IsATCmdBusy() && (millis() - start < 1000)) gsm.PollATCmd();
+  TEST_EQ(cmd_normal.result, AT_RESP_OK);
+  TEST_EQ(gsm.GetCommLineStatus(), CLS_FREE);
+}
@@ -0,0 +1,84 @@
+/*
+  test_resp.cpp - host tests of the reception of the responses
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+/**********************************************************
+Final result codes
+**********************************************************/
+void TestFinalCode(void)
+{
+  char number[20];
+  char text[40];
+  unsigned long start;
+  StrView resp;
+  StrView line;
+
+  TestModemAttach();
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+
+  // reception is finished by "OK", the inter-character tmout is not awaited
+  start = millis();
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 300, "OK", 1), AT_RESP_OK);
+  TEST_ASSERT(millis() - start < 200);
+  TEST_EQ(gsm.GetFinalResultCode(), FRC_OK);
+
+  test_modem.SetReply("AT+CPIN?", "\r\n+CME ERROR: 10\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CPIN?", 500, 20, "READY", 1), AT_RESP_ERR_DIF_RESP);
+  TEST_EQ(gsm.GetFinalResultCode(), FRC_CME_ERROR);
+  test_modem.SetReply("AT+CSQ", "\r\nERROR\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CSQ", 500, 20, "OK", 1), AT_RESP_ERR_DIF_RESP);
+  TEST_EQ(gsm.GetFinalResultCode(), FRC_ERROR);
+  // in the middle of the line it is not the final result code
+  test_modem.SetReply("AT+COPS?", "\r\n+COPS: 0,0,\"OK\"\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+COPS?", 500, 20, "+COPS: 0,0,\"OK\"", 1), AT_RESP_OK);
+  gsm.SetCommLineStatus(CLS_FREE);
+
+  // SMS text which is the same as the final result code
+  test_modem.SetReply("AT+CMGR=1", "\r\n+CMGR: \"REC READ\",\"+420111\",,\"12/01/01,10:00:00+04\"\r\n"
+                                   "OK\r\n\r\nOK\r\n");
+  test_modem.SetReply("AT+CMGR=2", "\r\n+CMGR: \"REC UNREAD\",\"+420111\",,\"12/01/01,10:00:00+04\"\r\n"
+                                   "ERROR\r\n\r\nOK\r\n");
+  test_modem.SetReply("AT+CMGR=3", "\r\n+CMGR: \"REC READ\",\"+420111\",,\"12/01/01,10:00:00+04\"\r\n"
+                                   "\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.GetSMS(1, number, text, sizeof(text)), GETSMS_READ_SMS);
+  TEST_EQ_STR(text, "OK");
+  TEST_EQ(gsm.GetSMS(2, number, text, sizeof(text)), GETSMS_UNREAD_SMS);
+  TEST_EQ_STR(text, "ERROR");
+  TEST_EQ(gsm.GetFinalResultCode(), FRC_OK);
+  // empty text
+  TEST_EQ(gsm.GetSMS(3, number, text, sizeof(text)), GETSMS_READ_SMS);
+  TEST_EQ_STR(text, "");
+
+  // the whole listing is received
+  test_modem.SetReply("AT+CMGL=", "\r\n+CMGL: 1,\"REC UNREAD\",\"+420111\",,\"12/01/01,10:00:00+04\"\r\n"
+                                  "OK\r\n"
+                                  "+CMGL: 4,\"REC UNREAD\",\"+420111\",,\"12/01/01,10:01:00+04\"\r\n"
+                                  "ERROR\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.IsSMSPresent(SMS_UNREAD), 1);
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CMGL=\"ALL\"", 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ(gsm.GetFinalResultCode(), FRC_OK);
+  gsm.GetRespView(&resp);
+  TEST_ASSERT(SVFindLineF(&resp, PSTR("+CMGL: 4,"), &line));
+  TEST_ASSERT(SVFindLineF(&resp, PSTR("OK"), &line));
+  gsm.SetCommLineStatus(CLS_FREE);
+}
@@ -0,0 +1,110 @@
+/*
+  test_retry.cpp - host tests of the retry policies and of the
+  classification of the failures of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+// short delays so the test is fast, permanent errors are not retried
+static const ATRetryPolicy retry_fast =
+  {5, 20, 2, 0, ATRETRY_ON_TMOUT | ATRETRY_ON_DIF_RESP | ATRETRY_ON_ERROR};
+static const ATRetryPolicy retry_fast_tmout =
+  {5, 20, 2, 0, ATRETRY_ON_TMOUT};
+
+// num. of attempts of the command with the reply
+static unsigned long CountAttempts(const char *cmd, const char *reply)
+{
+  test_modem.Reset();
+  test_modem.SetReply(cmd, reply);
+  gsm.SendATCmdWaitResp(cmd, 50, 20, "OK", 3);
+  return (test_modem.CountLines(cmd));
+}
+
+// permanent error of the reply
+static byte IsPermanent(const char *reply)
+{
+  test_modem.Reset();
+  test_modem.SetReply("AT+CERR", reply);
+  gsm.SendATCmdWaitResp("AT+CERR", 500, 20, "OK", 1);
+  return (gsm.IsPermanentError());
+}
+
+
+/**********************************************************
+Retry policies and permanent errors
+**********************************************************/
+void TestRetry(void)
+{
+  ATCmd cmd;
+
+  TestModemAttach();
+
+  // error codes
+  test_modem.SetReply("AT+CPIN", "\r\n+CME ERROR: 10\r\n");
+  gsm.SendATCmdWaitResp("AT+CPIN?", 500, 20, "OK", 1);
+  TEST_EQ(gsm.GetErrorCode(), 10);
+  test_modem.SetReply("AT+CMGS", "\r\n+CMS ERROR: 330\r\n");
+  gsm.SendATCmdWaitResp("AT+CMGS", 500, 20, "OK", 1);
+  TEST_EQ(gsm.GetErrorCode(), 330);
+  test_modem.SetReply("AT+CPIN", "\r\n+CME ERROR: SIM not inserted\r\n");
+  gsm.SendATCmdWaitResp("AT+CPIN?", 500, 20, "OK", 1);
+  TEST_EQ(gsm.GetErrorCode(), -1);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ(gsm.GetErrorCode(), -1);
+
+  // +CME and +CMS codes have different meanings
+  TEST_EQ(IsPermanent("\r\n+CME ERROR: 10\r\n"), 1);   // SIM not inserted
+  TEST_EQ(IsPermanent("\r\n+CMS ERROR: 10\r\n"), 1);   // call barred
+  TEST_EQ(IsPermanent("\r\n+CME ERROR: 27\r\n"), 1);   // invalid characters in dial string
+  TEST_EQ(IsPermanent("\r\n+CMS ERROR: 27\r\n"), 0);   // destination out of service
+  TEST_EQ(IsPermanent("\r\n+CME ERROR: 22\r\n"), 1);   // not found
+  TEST_EQ(IsPermanent("\r\n+CMS ERROR: 22\r\n"), 0);   // memory capacity exceeded
+  TEST_EQ(IsPermanent("\r\n+CME ERROR: 1\r\n"), 0);    // no connection to phone
+  TEST_EQ(IsPermanent("\r\n+CMS ERROR: 1\r\n"), 1);    // unassigned number
+  TEST_EQ(IsPermanent("\r\n+CME ERROR: 100\r\n"), 0);  // unknown
+  TEST_EQ(IsPermanent("\r\n+CMS ERROR: 330\r\n"), 1);  // SMSC address unknown
+  TEST_EQ(IsPermanent("\r\n+CMS ERROR: 500\r\n"), 0);  // unknown error
+  TEST_EQ(IsPermanent("\r\nERROR\r\n"), 0);
+
+  // classification of the failures by the policy
+  gsm.SetRetryPolicy(&retry_fast);
+  TEST_EQ(CountAttempts("AT+CPIN?", "\r\n+CME ERROR: 10\r\n"), 1);
+  TEST_EQ(CountAttempts("AT+CPIN?", "\r\n+CME ERROR: 100\r\n"), 3);
+  TEST_EQ(CountAttempts("AT+CMGS", "\r\n+CMS ERROR: 27\r\n"), 3);
+  TEST_EQ(CountAttempts("AT+CMGS", "\r\n+CMS ERROR: 330\r\n"), 1);
+  TEST_EQ(CountAttempts("AT+COPS?", "\r\nERROR\r\n"), 3);
+  TEST_EQ(CountAttempts("AT+CSQ", ""), 3);
+  TEST_EQ(CountAttempts("AT+CREG?", "\r\n+CREG: 0,2\r\n\r\nOK\r\n"), 1);
+  gsm.SetRetryPolicy(&retry_fast_tmout);
+  TEST_EQ(CountAttempts("AT+COPS?", "\r\nERROR\r\n"), 1);
+  TEST_EQ(CountAttempts("AT+CSQ", ""), 3);
+  // "OK" is received so the response is right
+  TEST_EQ(CountAttempts("AT+CREG?", "\r\n+CREG: 0,2\r\n\r\nOK\r\n"), 1);
+
+  // policy of the command takes precedence over the policy of the class
+  test_modem.Reset();
+  test_modem.SetReply("AT+COPS", "\r\nERROR\r\n");
+  gsm.SetupATCmd(&cmd, "AT+COPS?", 0, 50, 20, "OK", 3, NULL);
+  gsm.SetATCmdRetry(&cmd, &retry_fast);
+  TEST_EQ(gsm.RunATCmd(&cmd), AT_RESP_ERR_DIF_RESP);
+  TEST_EQ(test_modem.CountLines("AT+COPS"), 3);
+
+  gsm.SetRetryPolicy(&at_retry_fixed);
+  TestModemAttach();
+}
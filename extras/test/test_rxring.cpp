@@ -0,0 +1,64 @@
+/*
+  test_rxring.cpp - host tests of the RX ring buffer
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "ATRxRing.h"
+
+
+/**********************************************************
+ATRxRing
+**********************************************************/
+void TestRxRing(void)
+{
+  static ATRxRing ring;
+  uint16_t i;
+  int ch;
+
+  TEST_EQ(ring.Available(), 0);
+  TEST_EQ(ring.Get(), -1);
+  TEST_EQ(ring.Free(), AT_RX_RING_LEN - 1);
+
+  // one byte is always free
+  for (i = 0; i < AT_RX_RING_LEN - 1; i++) TEST_EQ(ring.Put(i & 0xff), 1);
+  TEST_EQ(ring.Put(0xaa), 0);
+  TEST_EQ(ring.GetOverflowCnt(), 1);
+  TEST_EQ(ring.GetHighWater(), AT_RX_RING_LEN - 1);
+  TEST_EQ(ring.Free(), 0);
+
+  // FIFO order across the wrap around
+  for (i = 0; i < 10; i++) TEST_EQ(ring.Get(), i);
+  for (i = 0; i < 10; i++) TEST_EQ(ring.Put(0x80 + i), 1);
+  TEST_EQ(ring.Available(), AT_RX_RING_LEN - 1);
+  for (i = 10; i < AT_RX_RING_LEN - 1; i++) {
+    ch = ring.Get();
+    if (ch != (i & 0xff)) break;
+  }
+  TEST_EQ(i, AT_RX_RING_LEN - 1);
+  for (i = 0; i < 10; i++) TEST_EQ(ring.Get(), 0x80 + i);
+  TEST_EQ(ring.Get(), -1);
+
+  // statistics are kept until they are reset
+  ring.Put('x');
+  ring.Clear();
+  TEST_EQ(ring.Available(), 0);
+  TEST_EQ(ring.GetHighWater(), AT_RX_RING_LEN - 1);
+  ring.ResetStats();
+  TEST_EQ(ring.GetOverflowCnt(), 0);
+  TEST_EQ(ring.GetHighWater(), 0);
+}
@@ -0,0 +1,112 @@
+/*
+  test_search.cpp - host tests of the stream search (StreamSearch)
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+#include "StreamSearch.h"
+
+
+/**********************************************************
+StreamSearch
+**********************************************************/
+void TestStreamSearch(void)
+{
+  StreamSearch search;
+  static const byte chunk1[] = "data\r\nNO CAR";
+  static const byte chunk2[] = "RIER\r\nrest";
+  static const byte twice[] = "abab-abab";
+  signed short pos;
+
+  TEST_EQ(SSInitF(&search, PSTR("\r\nNO CARRIER\r\n")), 1);
+  // the string is split between the chunks
+  TEST_EQ(SSFind(&search, chunk1, sizeof(chunk1) - 1), -1);
+  TEST_EQ(SSFind(&search, chunk2, sizeof(chunk2) - 1), 6);
+
+  // search stops behind the first occurrence and continues from there
+  TEST_EQ(SSInit(&search, "abab"), 1);
+  pos = SSFind(&search, twice, sizeof(twice) - 1);
+  TEST_EQ(pos, 4);
+  TEST_EQ(SSFind(&search, twice + pos, sizeof(twice) - 1 - pos), 5);
+
+  // overlapping occurrences (KMP failure function)
+  TEST_EQ(SSInit(&search, "aab"), 1);
+  TEST_EQ(SSFind(&search, (const byte *)"aaab", 4), 4);
+  SSReset(&search);
+  TEST_EQ(SSFeed(&search, 'a'), 0);
+  TEST_EQ(SSFeed(&search, 'a'), 0);
+  TEST_EQ(SSFeed(&search, 'b'), 1);
+
+  // too long or empty string disables the search
+  TEST_EQ(SSInit(&search, "0123456789abcdefg"), -1);
+  TEST_EQ(SSFind(&search, (const byte *)"0123456789abcdefg", 17), -1);
+  TEST_EQ(SSInit(&search, ""), -1);
+
+  // longer string with the failure function table of the caller
+  uint16_t fail[20];
+  TEST_EQ(SSInitExt(&search, "0123456789abcdefg", fail, 16), -1);
+  TEST_EQ(SSInitExt(&search, "0123456789abcdefg", fail, 20), 1);
+  TEST_EQ(SSFind(&search, (const byte *)"xx0123456789", 12), -1);
+  TEST_EQ(SSFind(&search, (const byte *)"abcdefgyy", 9), 7);
+}
+
+
+/**********************************************************
+Data received by RcvData()
+**********************************************************/
+void TestRcvData(void)
+{
+  byte *data;
+  char text[] = "GET / HTTP/1.1\r\nHost: www.example.com\r\n\r\n";
+
+  TestModemAttach();
+  TEST_EQ(gsm.SetRcvDataDelimiterF(PSTR("\r\n\r\n")), 1);
+
+  // the first delimiter is reported, the rest of the chunk is searched too
+  test_modem.Send("A\r\n\r\nB\r\n\r\nC\r\n\r");
+  TEST_EQ(gsm.RcvData(500, 20, &data), 14);
+  TEST_ASSERT(data != NULL);
+  TEST_EQ(gsm.GetRcvDataDelimiterPos(), 5);
+  // the delimiter is split between the chunks
+  test_modem.Send("\nD");
+  TEST_EQ(gsm.RcvData(500, 20, &data), 2);
+  TEST_EQ(gsm.GetRcvDataDelimiterPos(), 1);
+  TEST_EQ(gsm.RcvData(50, 20, &data), 0);
+  TEST_ASSERT(data == NULL);
+  TEST_EQ(gsm.GetRcvDataDelimiterPos(), -1);
+
+  // NO CARRIER frees the comm. line
+  gsm.SetCommLineStatus(CLS_DATA);
+  test_modem.Send("last\r\nNO CARRIER\r\n");
+  gsm.RcvData(500, 20, &data);
+  TEST_EQ(gsm.GetCommLineStatus(), CLS_FREE);
+
+  // strings in the binary buffer
+  TEST_EQ(gsm.StrInBin((byte *)text, (char *)"\r\n\r\n", sizeof(text) - 1), 37);
+  TEST_EQ(gsm.StrInBin((byte *)text, (char *)"Host", sizeof(text) - 1), 16);
+  TEST_EQ(gsm.StrInBin((byte *)text, (char *)"Hosts", sizeof(text) - 1), -1);
+  TEST_EQ(gsm.StrInBin((byte *)text, (char *)"", sizeof(text) - 1), -1);
+  // longer than STREAM_SEARCH_LEN
+  TEST_EQ(gsm.StrInBin((byte *)text, (char *)"Host: www.example.com", sizeof(text) - 1), 16);
+  TEST_EQ(gsm.StrInBin((byte *)text, (char *)"Host: www.example.org", sizeof(text) - 1), -1);
+  // partial match of the long string continues by the failure function
+  TEST_EQ(gsm.StrInBin((byte *)"aaaaaaaaaaaaaaaaaaab", (char *)"aaaaaaaaaaaaaaaaab", 20), 2);
+  TEST_EQ(gsm.StrInBin((byte *)"abcabcabcabcabcabcabd", (char *)"abcabcabcabcabcabd", 21), 3);
+  // longer than the buffer
+  TEST_EQ(gsm.StrInBin((byte *)text, (char *)"Host: www.example.com", 20), -1);
+}
@@ -0,0 +1,99 @@
+/*
+  test_sim.cpp - host tests of the GSM Playground library against
+  the GE863 simulator
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "GSM_GE863.h"
+#include "ATFdTransport.h"
+#include "GE863Sim.h"
+
+
+static GE863Sim sim;
+static ATFdTransport tty;
+
+/**********************************************************
+Method starts the simulator with the script and attaches
+gsm to it
+
+return: 0 - simulator can not be started
+        1 - OK
+**********************************************************/
+static byte SimAttach(const char *script)
+{
+  if ((sim.Open() < 0) || (sim.LoadScript(script) < 0)) return (0);
+  sim.Start();
+  if (tty.Open(sim.GetSlavePath()) < 0) {
+    sim.Stop();
+    return (0);
+  }
+  gsm.SetTransport(&tty);
+  gsm.InitSerLine(115200);
+  gsm.SetCommLineStatus(CLS_FREE);
+  return (1);
+}
+
+static void SimDetach(void)
+{
+  tty.Close();
+  sim.Stop();
+  sim.Close();
+}
+
+
+/**********************************************************
+SMS text which looks like URC
+**********************************************************/
+static const char urc_ring[] PROGMEM = "RING";
+static const char urc_sring[] PROGMEM = "SRING:";
+
+static byte ring_cnt;
+
+static void RingHandler(const char *)
+{
+  ring_cnt++;
+}
+
+void TestSimSMS(void)
+{
+  char number[20];
+  char text[40];
+
+  if (!SimAttach(GSM_TEST_SIM_DIR "/sms_ring.sim")) {
+    TEST_ASSERT(!"simulator is started");
+    return;
+  }
+  ring_cnt = 0;
+  gsm.RegisterURCHandler(urc_ring, RingHandler);
+  gsm.RegisterURCHandler(urc_sring, RingHandler);
+
+  // +CMGR
+  TEST_EQ(gsm.GetSMS(1, number, text, sizeof(text)), GETSMS_UNREAD_SMS);
+  TEST_EQ_STR(text, "RING me back");
+  // +CMGL listing (SMS 2 is still unread)
+  TEST_EQ(gsm.IsSMSPresent(SMS_UNREAD), 2);
+  TEST_EQ(gsm.GetSMS(2, number, text, sizeof(text)), GETSMS_READ_SMS);
+  TEST_EQ_STR(text, "SRING: 1");
+
+  // no fake event was dispatched
+  while (gsm.PollURC()) ;
+  TEST_EQ(ring_cnt, 0);
+
+  gsm.RegisterURCHandler(urc_ring, NULL);
+  gsm.RegisterURCHandler(urc_sring, NULL);
+  SimDetach();
+}
@@ -0,0 +1,141 @@
+/*
+  test_stats.cpp - host tests of the statistics of the AT commands
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+#ifdef AT_CMD_STATS_ENABLED
+
+// printed statistics
+class TestStatsOut : public Print
+{
+  public:
+    TestStatsOut(void) {len = 0; text[0] = 0;};
+    virtual size_t write(uint8_t ch) {
+      if (len >= sizeof(text) - 1) return (0);
+      text[len++] = ch;
+      text[len] = 0;
+      return (1);
+    };
+    using Print::write;
+
+    char text[512];
+    size_t len;
+};
+
+static unsigned long HistSum(const uint16_t *hist)
+{
+  unsigned long sum = 0;
+  byte i;
+
+  for (i = 0; i < AT_CMD_HIST_LEN; i++) sum += hist[i];
+  return (sum);
+}
+
+#endif // end of ifdef AT_CMD_STATS_ENABLED
+
+
+/**********************************************************
+Statistics of the AT commands
+**********************************************************/
+void TestCmdStats(void)
+{
+#ifdef AT_CMD_STATS_ENABLED
+  static TestStatsOut out;
+  const ATCmdClassStats *stats;
+  static const uint16_t hist[AT_CMD_HIST_LEN] = {0, 0, 0, 0, 1, 1, 1, 1};
+  char buf[64];
+  char cmd[16];
+  byte i;
+
+  TestModemAttach();
+  gsm.ResetCmdStats();
+  TEST_EQ(gsm.GetCmdStatsCnt(), 0);
+  TEST_ASSERT(gsm.FindCmdStats("+CREG") == NULL);
+
+  // two commands of the same class, one plain AT
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CREG?", 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CREG=1", 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 20, "OK", 1), AT_RESP_OK);
+  TEST_EQ(gsm.GetCmdStatsCnt(), 2);
+  stats = gsm.FindCmdStats("+CREG");
+  TEST_ASSERT(stats != NULL);
+  if (stats == NULL) return;
+  TEST_EQ(stats->count, 2);
+  TEST_EQ(stats->retries, 0);
+  TEST_EQ(HistSum(stats->first_hist), 2);
+  TEST_EQ(HistSum(stats->done_hist), 2);
+  TEST_ASSERT(gsm.FindCmdStats("") != NULL);
+
+  // timeouts are counted per attempt, repeated attempts are retries
+  test_modem.SetReply("AT+CSQ", "");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CSQ", 50, 20, "OK", 2), AT_RESP_ERR_NO_RESP);
+  stats = gsm.FindCmdStats("+CSQ");
+  TEST_ASSERT(stats != NULL);
+  if (stats == NULL) return;
+  TEST_EQ(stats->count, 1);
+  TEST_EQ(stats->retries, 1);
+  TEST_EQ(stats->tmouts, 2);
+  TEST_EQ(HistSum(stats->first_hist), 0);
+  TEST_EQ(HistSum(stats->done_hist), 2);
+
+  // different response
+  test_modem.SetReply("AT+CPIN", "\r\n+CPIN: SIM PIN\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CPIN?", 500, 20, "READY", 1), AT_RESP_ERR_DIF_RESP);
+  stats = gsm.FindCmdStats("+CPIN");
+  TEST_ASSERT(stats != NULL);
+  if (stats != NULL) TEST_EQ(stats->dif_resps, 1);
+
+  // printed and formatted statistics
+  gsm.PrintCmdStats(out);
+  TEST_ASSERT(strstr(out.text, "AT+CREG n=2 retry=0 tmout=0 dif=0 p50=<") != NULL);
+  TEST_ASSERT(strstr(out.text, "AT+CSQ n=1 retry=1 tmout=2 dif=0") != NULL);
+  TEST_ASSERT(strstr(out.text, "  first:") != NULL);
+  TEST_EQ(gsm.FormatCmdStats(buf, sizeof(buf), 0), 3);
+  TEST_ASSERT(strncmp(buf, "+CREG:2,0,0,0,", 14) == 0);
+  TEST_ASSERT(strstr(buf, "\nAT:1,0,0,0,") != NULL);
+  i = gsm.FormatCmdStats(buf, sizeof(buf), 3);
+  TEST_EQ(i, AT_CMD_STATS_LEN);
+  TEST_ASSERT(strncmp(buf, "+CPIN:1,0,0,1,", 14) == 0);
+
+  // percentiles of the histogram
+  TEST_EQ(AT::CmdHistPercentile(hist, 50), 5);
+  TEST_EQ(AT::CmdHistPercentile(hist, 100), 7);
+  TEST_EQ(AT::CmdHistLimit(5), 32);
+  TEST_EQ(AT::CmdHistLimit(AT_CMD_HIST_LEN - 1), 1L << (AT_CMD_HIST_LEN - 2));
+
+  // commands which do not fit to the table are in the last class
+  for (i = 0; i < AT_CMD_STATS_LEN; i++) {
+    sprintf(cmd, "AT+T%u", i);
+    gsm.SendATCmdWaitResp(cmd, 500, 20, "OK", 1);
+  }
+  TEST_EQ(gsm.GetCmdStatsCnt(), AT_CMD_STATS_LEN - 1);
+  stats = gsm.GetCmdStats(AT_CMD_STATS_LEN - 1);
+  TEST_ASSERT(stats != NULL);
+  if (stats != NULL) {
+    TEST_EQ_STR(stats->tag, "*");
+    TEST_EQ(stats->count, 5);
+  }
+  TEST_ASSERT(gsm.GetCmdStats(AT_CMD_STATS_LEN - 2) != NULL);
+
+  gsm.ResetCmdStats();
+  TEST_EQ(gsm.GetCmdStatsCnt(), 0);
+  TEST_ASSERT(gsm.FindCmdStats("+CREG") == NULL);
+#endif // end of ifdef AT_CMD_STATS_ENABLED
+}
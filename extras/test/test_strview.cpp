@@ -0,0 +1,100 @@
+/*
+  test_strview.cpp - host tests of the StrView tokenizer
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "StrView.h"
+
+
+/**********************************************************
+StrView
+**********************************************************/
+static const char cmgr_resp[] =
+  "\r\n+CMGR: \"REC UNREAD\",\"+420123456789\",,\"12/01/01,10:00:00+04\"\r\n"
+  "Hello, world\r\n\r\nOK\r\n";
+
+void TestStrView(void)
+{
+  StrView buf;
+  StrView line;
+  StrView field;
+  char str[32];
+  long value;
+
+  // lines
+  SVInit(&buf, cmgr_resp, sizeof(cmgr_resp) - 1);
+  TEST_ASSERT(SVNextLine(&buf, &line));
+  TEST_ASSERT(SVStartsWithF(&line, PSTR("+CMGR:")));
+  TEST_ASSERT(SVNextLine(&buf, &line));
+  SVCopy(&line, str, sizeof(str));
+  TEST_EQ_STR(str, "Hello, world");
+  TEST_ASSERT(SVNextLine(&buf, &line));
+  SVCopy(&line, str, sizeof(str));
+  TEST_EQ_STR(str, "OK");
+  TEST_ASSERT(!SVNextLine(&buf, &line));
+
+  // fields - the quoted comma does not split the field
+  SVInit(&buf, cmgr_resp, sizeof(cmgr_resp) - 1);
+  TEST_ASSERT(SVFindLineF(&buf, PSTR("+CMGR:"), &line));
+  TEST_ASSERT(SVSkipPast(&line, ':'));
+  TEST_ASSERT(SVNextField(&line, &field, ','));
+  TEST_ASSERT(SVUnquote(&field));
+  SVCopy(&field, str, sizeof(str));
+  TEST_EQ_STR(str, "REC UNREAD");
+  TEST_ASSERT(SVNextField(&line, &field, ','));
+  TEST_ASSERT(SVNextField(&line, &field, ','));
+  TEST_EQ(field.len, 0);
+  TEST_ASSERT(SVNextField(&line, &field, ','));
+  TEST_ASSERT(SVUnquote(&field));
+  SVCopy(&field, str, sizeof(str));
+  TEST_EQ_STR(str, "12/01/01,10:00:00+04");
+  TEST_ASSERT(!SVNextField(&line, &field, ','));
+
+  // the text line follows the header (as in GetSMS())
+  TEST_ASSERT(SVTakeLine(&buf, &line));
+  TEST_EQ(line.len, 0);
+  TEST_ASSERT(SVTakeLine(&buf, &line));
+  SVCopy(&line, str, sizeof(str));
+  TEST_EQ_STR(str, "Hello, world");
+  TEST_ASSERT(!SVFindLineF(&buf, PSTR("+CMGR:"), &line));
+
+  // the copy is truncated to the buffer
+  SVInit(&field, "0123456789", 10);
+  TEST_EQ(SVCopy(&field, str, 5), 4);
+  TEST_EQ_STR(str, "0123");
+
+  // numbers
+  SVInit(&field, " -285 ", 6);
+  SVTrim(&field);
+  TEST_ASSERT(SVToLong(&field, &value));
+  TEST_EQ(value, -285);
+  SVInit(&field, "12a", 3);
+  value = 7;
+  TEST_ASSERT(!SVToLong(&field, &value));
+  TEST_EQ(value, 7);
+  SVInit(&field, "4916.4536", 9);
+  TEST_ASSERT(SVToFixed(&field, 2, &value));
+  TEST_EQ(value, 491645);
+  SVInit(&field, "3.3", 3);
+  TEST_ASSERT(SVToFixed(&field, 3, &value));
+  TEST_EQ(value, 3300);
+  SVInit(&field, "99999999999", 11);
+  TEST_ASSERT(!SVToFixed(&field, 0, &value));
+  SVInit(&field, "", 0);
+  TEST_ASSERT(!SVToLong(&field, &value));
+}
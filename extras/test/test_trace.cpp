@@ -0,0 +1,148 @@
+/*
+  test_trace.cpp - host tests of the trace of the library events
+  (ATTrace) of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+#ifdef AT_TRACE_ENABLED
+
+#define TEST_TRACE_LINES    16
+
+// formatted records without the time
+class TestTraceSink : public ATTraceSink
+{
+  public:
+    TestTraceSink(void) {Clear();};
+    virtual void Write(const ATTraceRecord *record) {
+      char line[AT_TRACE_LINE_LEN + 1];
+
+      if (cnt >= TEST_TRACE_LINES) return;
+      ATTrace::Format(record, line);
+      strcpy(text[cnt], strchr(line, ' ') + 1);
+      time[cnt] = record->time;
+      cnt++;
+    };
+    void Clear(void) {cnt = 0;};
+
+    char text[TEST_TRACE_LINES][AT_TRACE_LINE_LEN + 1];
+    unsigned long time[TEST_TRACE_LINES];
+    byte cnt;
+};
+
+static ATTrace trace;
+static TestTraceSink trace_sink;
+
+#endif // end of ifdef AT_TRACE_ENABLED
+
+
+/**********************************************************
+Trace of the library events
+**********************************************************/
+void TestTrace(void)
+{
+#ifdef AT_TRACE_ENABLED
+  static const char long_text[] = "0123456789012345678901234567890123456789";
+  char data[AT_TRACE_DATA_LEN];
+  uint16_t cnt;
+  uint16_t i;
+
+  TestModemAttach();
+  trace.Clear();
+  trace.SetSink(&trace_sink);
+  trace_sink.Clear();
+  gsm.SetTrace(&trace);
+
+  // command, its result and the URC
+  test_modem.SetReply("AT+CSQ", "\r\n+CSQ: 20,0\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CSQ", 500, 20, "OK", 1), AT_RESP_OK);
+  test_modem.Send("\r\nRING\r\n");
+  delay(10);
+  gsm.PollURC();
+  TEST_EQ(trace.Flush(10), 3);
+  TEST_EQ(trace.GetUsed(), 0);
+  TEST_EQ(trace_sink.cnt, 3);
+  TEST_EQ_STR(trace_sink.text[0], "CMD AT+CSQ");
+  TEST_ASSERT(strncmp(trace_sink.text[1], "RESULT res=1 rx=", 16) == 0);
+  TEST_ASSERT(strstr(trace_sink.text[1], " att=1 ") != NULL);
+  TEST_EQ_STR(trace_sink.text[2], "URC RING");
+  TEST_ASSERT(trace_sink.time[0] <= trace_sink.time[1]);
+  TEST_ASSERT(trace_sink.time[1] <= trace_sink.time[2]);
+  TEST_ASSERT(trace_sink.time[2] <= millis());
+
+#ifdef DEBUG_PRINT
+  // debug print, long texts are cut
+  trace_sink.Clear();
+  gsm.DebugPrint("DEBUG: ", 0);
+  gsm.DebugPrint(-1234, 0);
+  gsm.DebugPrintF(PSTR("flash"), 1);
+  gsm.DebugPrint(long_text, 1);
+  TEST_EQ(trace.Flush(10), 4);
+  TEST_EQ_STR(trace_sink.text[0], "TEXT DEBUG: ");
+  TEST_EQ_STR(trace_sink.text[1], "NUM -1234");
+  TEST_EQ_STR(trace_sink.text[2], "TEXT flash");
+  TEST_EQ(strlen(trace_sink.text[3]), 5 + AT_TRACE_DATA_LEN);
+  TEST_ASSERT(strncmp(trace_sink.text[3] + 5, long_text, AT_TRACE_DATA_LEN) == 0);
+#endif // end of ifdef DEBUG_PRINT
+
+  // events of the program, non-printable characters
+  trace_sink.Clear();
+  trace.Add(AT_TRACE_USER + 2, "a\r\nb", 4);
+  trace.AddNum(AT_TRACE_BAUD, 115200);
+  TEST_EQ(trace.Flush(1), 1);
+  TEST_EQ(trace.Flush(1), 1);
+  TEST_EQ(trace.Flush(1), 0);
+  TEST_EQ_STR(trace_sink.text[0], "USER2 a..b");
+  TEST_EQ_STR(trace_sink.text[1], "BAUD 115200");
+
+  // full ring buffer loses the new records, the old ones are kept
+  trace_sink.Clear();
+  memset(data, 'x', sizeof(data));
+  for (i = 0; i < AT_TRACE_BUF_LEN; i++) trace.Add(AT_TRACE_USER, data, sizeof(data));
+  trace.AddStr(AT_TRACE_TEXT, "lost");
+  TEST_ASSERT(trace.GetLostCnt() > 0);
+  TEST_ASSERT(trace.GetUsed() <= AT_TRACE_BUF_LEN);
+  TEST_ASSERT(AT_TRACE_BUF_LEN - trace.GetUsed() < 2 + 5 + AT_TRACE_DATA_LEN);
+  cnt = 0;
+  do {
+    trace_sink.Clear();
+    cnt += trace.Flush(TEST_TRACE_LINES);
+  } while (trace_sink.cnt);
+  TEST_EQ(cnt, AT_TRACE_BUF_LEN + 1 - trace.GetLostCnt());
+  TEST_EQ(trace.GetUsed(), 0);
+
+  // records which wrap around the end of the ring buffer
+  for (i = 0; i < TEST_TRACE_LINES; i++) trace.AddNum(AT_TRACE_NUM, i);
+  TEST_EQ(trace.Flush(TEST_TRACE_LINES), TEST_TRACE_LINES);
+  for (i = 0; i < TEST_TRACE_LINES; i++) {
+    sprintf(data, "NUM %u", i);
+    TEST_EQ_STR(trace_sink.text[i], data);
+  }
+
+  // commands are not traced in the data mode
+  trace.Clear();
+  TEST_EQ(trace.GetLostCnt(), 0);
+  gsm.SetCommLineStatus(CLS_DATA);
+  gsm.Print("data\r");
+  gsm.SetCommLineStatus(CLS_FREE);
+  TEST_EQ(trace.GetUsed(), 0);
+
+  gsm.SetTrace(NULL);
+  TestModemAttach();
+#endif // end of ifdef AT_TRACE_ENABLED
+}
@@ -0,0 +1,148 @@
+/*
+  test_turnon.cpp - host tests of the non-blocking switching on
+  of the module (StartTurnOn(), PollTurnOn()) of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+// module which hears nothing while it is off
+class TestOffModem : public TestModem
+{
+  public:
+    TestOffModem(void) {on = 0;};
+    virtual size_t Write(byte ch) {
+      if (!on) return (1);
+      return (TestModem::Write(ch));
+    };
+    using TestModem::Write;
+
+    byte on;
+};
+
+static TestOffModem off_modem;
+
+// the check "AT" is not repeated so the missing module is found soon
+static const ATRetryPolicy retry_none = {0, 0, 1, 0, 0};
+
+// steps of the sequence and the levels of the pins in the steps
+struct TestTurnOnTrace
+{
+  byte step[TURNON_STEP_LAST_ITEM * 2];
+  byte on_pin[TURNON_STEP_LAST_ITEM * 2];
+  byte reset_pin[TURNON_STEP_LAST_ITEM * 2];
+  byte cnt;
+};
+
+// polls the switching on until it is finished, the module is
+// switched on in the step (TURNON_STEP_LAST_ITEM - never)
+static byte PollUntilDone(TestTurnOnTrace *trace, byte on_step)
+{
+  byte last_step = 0xff;
+  byte ret_val;
+
+  trace->cnt = 0;
+  while ((ret_val = gsm.PollTurnOn()) == TURNON_BUSY) {
+    if (gsm.GetTurnOnStep() == last_step) continue;
+    last_step = gsm.GetTurnOnStep();
+    if (last_step == on_step) off_modem.on = 1;
+    if (trace->cnt < sizeof(trace->step)) {
+      trace->step[trace->cnt] = last_step;
+      trace->on_pin[trace->cnt] = digitalRead(GSM_ON);
+      trace->reset_pin[trace->cnt] = digitalRead(GSM_RESET);
+      trace->cnt++;
+    }
+  }
+  return (ret_val);
+}
+
+
+/**********************************************************
+Non-blocking switching on
+**********************************************************/
+void TestTurnOn(void)
+{
+  static const byte steps[] = {
+    TURNON_STEP_CHECK, TURNON_STEP_ON_PULSE, TURNON_STEP_ON_PAUSE,
+#ifndef GE836_GPS
+    TURNON_STEP_RESET_PULSE, TURNON_STEP_RESET_PAUSE,
+#endif
+    TURNON_STEP_WAIT, TURNON_STEP_CHECK
+  };
+  TestTurnOnTrace trace;
+  unsigned long start;
+  byte i;
+
+  TestModemAttach();
+  off_modem.Reset();
+  off_modem.on = 1;
+  gsm.SetTransport(&off_modem);
+  gsm.InitSerLine(115200);
+  gsm.SetCommLineStatus(CLS_FREE);
+  gsm.SetRetryPolicy(&retry_none);
+  TEST_EQ(gsm.PollTurnOn(), TURNON_IDLE);
+
+  // module is on => only the init. parameters are sent
+  gsm.StartTurnOn(1);
+  TEST_EQ(gsm.GetCommLineStatus(), CLS_ATCMD);
+  TEST_EQ(gsm.CheckRegistration(), REG_COMM_LINE_BUSY);
+  TEST_EQ(PollUntilDone(&trace, TURNON_STEP_LAST_ITEM), TURNON_OK);
+  TEST_EQ(gsm.GetTurnOnStep(), TURNON_STEP_IDLE);
+  TEST_EQ(gsm.GetTurnOnAttempt(), 0);
+  TEST_EQ(gsm.GetCommLineStatus(), CLS_FREE);
+  TEST_EQ_STR(off_modem.GetLine(0), "AT");
+  TEST_EQ(off_modem.CountLines("AT&F1"), 1);
+  TEST_EQ(gsm.PollTurnOn(), TURNON_IDLE);
+
+  // module is off => it is switched on by the pulse
+  off_modem.Reset();
+  off_modem.on = 0;
+  gsm.StartTurnOn(2);
+  TEST_EQ(PollUntilDone(&trace, TURNON_STEP_WAIT), TURNON_OK);
+  TEST_EQ(gsm.GetTurnOnAttempt(), 1);
+  TEST_EQ(trace.cnt, sizeof(steps));
+  for (i = 0; (i < trace.cnt) && (i < sizeof(steps)); i++) TEST_EQ(trace.step[i], steps[i]);
+  TEST_EQ(trace.on_pin[0], LOW);
+  TEST_EQ(trace.on_pin[1], HIGH);
+  TEST_EQ(trace.on_pin[2], LOW);
+#ifndef GE836_GPS
+  TEST_EQ(trace.reset_pin[2], LOW);
+  TEST_EQ(trace.reset_pin[3], HIGH);
+  TEST_EQ(trace.reset_pin[4], LOW);
+#endif
+  TEST_EQ(digitalRead(GSM_ON), LOW);
+  TEST_EQ(digitalRead(GSM_RESET), LOW);
+  TEST_EQ(off_modem.CountLines("AT&F1"), 1);
+
+  // module does not respond => failed after the max. num. of attempts
+  off_modem.Reset();
+  off_modem.on = 0;
+  start = millis();
+  gsm.StartTurnOn(1);
+  TEST_EQ(PollUntilDone(&trace, TURNON_STEP_LAST_ITEM), TURNON_FAILED);
+  TEST_ASSERT(millis() - start >= TURNON_ON_PULSE + TURNON_ON_PAUSE + TURNON_NEXT_CHECK);
+  TEST_EQ(gsm.GetTurnOnAttempt(), 1);
+  TEST_EQ(gsm.GetTurnOnStep(), TURNON_STEP_IDLE);
+  TEST_EQ(gsm.GetCommLineStatus(), CLS_FREE);
+  TEST_EQ(trace.step[trace.cnt - 1], TURNON_STEP_CHECK);
+  TEST_EQ(digitalRead(GSM_ON), LOW);
+  TEST_EQ(gsm.PollTurnOn(), TURNON_IDLE);
+
+  gsm.SetRetryPolicy(&at_retry_fixed);
+  TestModemAttach();
+}
@@ -0,0 +1,103 @@
+/*
+  test_urc.cpp - host tests of the URC dispatcher
+  of the GSM Playground library
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "test.h"
+#include "test_modem.h"
+
+
+/**********************************************************
+Unsolicited result codes
+**********************************************************/
+// handlers are unregistered by the same pointer
+static const char urc_cmti[] PROGMEM = "+CMTI:";
+static const char urc_ring[] PROGMEM = "RING";
+static const char urc_creg[] PROGMEM = "+CREG:";
+
+static char urc_last[URC_LINE_LEN + 1];
+static byte urc_cnt;
+
+static void URCHandler(const char *line)
+{
+  strncpy(urc_last, line, URC_LINE_LEN);
+  urc_last[URC_LINE_LEN] = 0;
+  urc_cnt++;
+}
+
+void TestURC(void)
+{
+  StrView resp;
+  StrView line;
+  char text[64];
+
+  TestModemAttach();
+  urc_cnt = 0;
+  TEST_EQ(gsm.RegisterURCHandler(urc_cmti, URCHandler), 1);
+  TEST_EQ(gsm.RegisterURCHandler(urc_ring, URCHandler), 1);
+  TEST_EQ(gsm.RegisterURCHandler(urc_creg, URCHandler), 1);
+
+  // URC in the middle of the response is removed from it
+  test_modem.SetReply("AT+CSQ", "\r\n+CMTI: \"SM\",3\r\n\r\n+CSQ: 15,0\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CSQ", 500, 20, "+CSQ: 15", 1), AT_RESP_OK);
+  gsm.GetRespView(&resp);
+  SVCopy(&resp, text, sizeof(text));
+  TEST_EQ_STR(text, "\r\n+CSQ: 15,0\r\n\r\nOK\r\n");
+
+  // the response of the command with the same name is not URC
+  test_modem.SetReply("AT+CREG?", "\r\n+CREG: 0,1\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CREG?", 500, 20, "+CREG: 0,1", 1), AT_RESP_OK);
+  gsm.SetCommLineStatus(CLS_FREE);
+
+  TEST_EQ(gsm.PollURC(), 1);
+  TEST_EQ_STR(urc_last, "+CMTI: \"SM\",3");
+
+  // URC outside of the response
+  test_modem.Send("\r\nRING\r\n");
+  TEST_EQ(gsm.PollURC(), 1);
+  TEST_EQ_STR(urc_last, "RING");
+  TEST_EQ(gsm.PollURC(), 0);
+  TEST_EQ(urc_cnt, 2);
+
+  // handlers are not called while the comm. line is occupied
+  test_modem.Send("\r\nRING\r\n");
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  TEST_EQ(gsm.PollURC(), 0);
+  gsm.SetCommLineStatus(CLS_FREE);
+  TEST_EQ(gsm.PollURC(), 1);
+
+  // text of the SMS is not URC even when it looks like one
+  test_modem.SetReply("AT+CMGR=", "\r\n+CMGR: \"REC READ\",\"+420111\",,\"12/01/01,10:00:00+04\"\r\n"
+                                  "RING me back\r\n\r\nOK\r\n");
+  TEST_EQ(gsm.AcquireCommLine(ATCMD_PRIO_NORMAL), 1);
+  TEST_EQ(gsm.SendATCmdWaitResp("AT+CMGR=1", 500, 20, "OK", 1), AT_RESP_OK);
+  gsm.GetRespView(&resp);
+  TEST_ASSERT(SVFindLineF(&resp, PSTR("RING me back"), &line));
+  // but the URC behind the response is
+  test_modem.Send("\r\nRING\r\n");
+  TEST_EQ(gsm.SendATCmdWaitResp("AT", 500, 20, "OK", 1), AT_RESP_OK);
+  gsm.SetCommLineStatus(CLS_FREE);
+  urc_cnt = 0;
+  TEST_EQ(gsm.PollURC(), 1);
+  TEST_EQ(gsm.PollURC(), 0);
+  TEST_EQ(urc_cnt, 1);
+
+  gsm.RegisterURCHandler(urc_cmti, NULL);
+  gsm.RegisterURCHandler(urc_ring, NULL);
+  gsm.RegisterURCHandler(urc_creg, NULL);
+}
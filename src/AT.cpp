@@ -22,8 +22,17 @@
 
 extern "C" {
   #include <string.h>
+  #include <stdlib.h>
 }
 
+// transport used by default
+#ifdef AT_UART_ISR_ENABLED
+  // own receive interrupt of USART0, see ATUartTransport.h
+  #define at_default_transport at_uart_transport
+#else
+static ATSerialTransport<decltype(AT_SERIAL_PORT)> at_default_transport(AT_SERIAL_PORT);
+#endif
+
 
 
 #ifdef DEBUG_LED_ENABLED
@@ -45,56 +54,36 @@ void  AT::BlinkDebugLED (byte num_of_blink)
 
 #ifdef DEBUG_PRINT
 /**********************************************************
-Two methods print out debug information to the standard output
-- it means to the serial line.
-First method prints string.
-Second method prints integer numbers.
+Methods add debug information to the trace (see SetTrace())
+First method adds string.
+Second method adds integer numbers.
 
 Note:
 =====
-The serial line is connected to the GSM module and is 
-used for sending AT commands. There is used "trick" that GSM
-module accepts not valid AT command strings because it doesn't
-understand them and still waits for some valid AT command.
-So after all debug strings are sent we send just AT<CR> as
-a valid AT command and GSM module responds by OK. So previous 
-debug strings are overwritten and GSM module is not influenced
-by these debug texts 
-
+Nothing is sent to the GSM module (the serial line belongs
+to the module), records are written to the sink of the trace
+only when the program calls ATTrace::Flush() so the debug 
+print does not change the timing of the library.
+Strings longer than AT_TRACE_DATA_LEN are cut.
 
 string_to_print:  pointer to the string to be print out
-last_debug_print: 0 - this is not last debug info, we will
-                      continue with sending... so don't send
-                      AT<CR>(see explanation above)
-                  1 - we are finished with sending debug info 
-                      for this time and finished AT<CR> 
-                      will be sent(see explanation above)
+last_debug_print: not used (the GSM module does not need 
+                  to be resynchronized by AT<CR> any more)
 
 **********************************************************/
-void AT::DebugPrint(const char *string_to_print, byte last_debug_print)
+void AT::DebugPrint(const char *string_to_print, byte)
 {
-  if (last_debug_print) {
-    Println(string_to_print);
-    SendATCmdWaitRespF(PSTR("AT"), START_SHORT_COMM_TMOUT, MAX_INTERCHAR_TMOUT, "OK", 1);
-  }
-  else Print(string_to_print);
+  if (trace != NULL) trace->AddStr(AT_TRACE_TEXT, string_to_print);
 }
 
-void AT::DebugPrintF(PGM_P string_to_print, byte last_debug_print)
+void AT::DebugPrintF(PGM_P string_to_print, byte)
 {
-  if (last_debug_print) {
-    PrintlnF(string_to_print);
-    SendATCmdWaitRespF(PSTR("AT"), START_SHORT_COMM_TMOUT, MAX_INTERCHAR_TMOUT, "OK", 1);
-  }
-  else PrintF(string_to_print);
+  if (trace != NULL) trace->AddStrF(AT_TRACE_TEXT, string_to_print);
 }
 
-void AT::DebugPrint(int number_to_print, byte last_debug_print)
+void AT::DebugPrint(int number_to_print, byte)
 {
-  Println(number_to_print);
-  if (last_debug_print) {
-    SendATCmdWaitRespF(PSTR("AT"), START_SHORT_COMM_TMOUT, MAX_INTERCHAR_TMOUT, "OK", 1);
-  }
+  if (trace != NULL) trace->AddNum(AT_TRACE_NUM, number_to_print);
 }
 #endif
 
@@ -114,6 +103,69 @@ AT::AT(void)
 {
   //default
   actual_baud_rate = 115200;
+#ifdef AT_AUTOBAUD_ENABLED
+  max_baud_rate = actual_baud_rate;
+  base_baud_rate = actual_baud_rate;
+  rx_err_cnt = 0;
+  line_err_cnt = 0;
+  baud_fallback_cnt = 0;
+  rx_line_check = 0;
+#endif
+  // the default transport can be constructed later (other module)
+  // so its ring is looked for by InitSerLine()
+  transport = &at_default_transport;
+  rx_ring = NULL;
+#ifdef AT_TRACE_ENABLED
+  trace = NULL;
+  tx_trace_len = 0;
+#endif
+  flow_control = 0;
+  read_tmout = AT_READ_TMOUT;
+  tx_line_start = 1;
+  rx_drained = 0;
+  resp_finish_mode = RESP_FINISH_DEFAULT_MODE;
+  rx_final_code = FRC_NONE;
+  // response is not classified
+  ATMatchInit(&rx_match, NULL);
+  // AT command engine is free
+  p_at_cmd = NULL;
+  at_cmd_free_line = 0;
+  at_cmd_delay = AT_DELAY;
+  retry_policy = &at_retry_fixed;
+  op_deadline = 0;
+  op_active = 0;
+  // queue of AT commands is empty
+  at_cmd_queue_len = 0;
+  ResetATCmdQueueStats();
+  ResetLinkStats();
+#ifdef URC_ENABLED
+  // no URC is pending and no handler is registered
+  rx_cmd_mode = 0;
+  urc_line_len = 0;
+  urc_buf_head = 0;
+  urc_buf_tail = 0;
+  urc_buf_used = 0;
+  urc_lost_cnt = 0;
+  for (byte i = 0; i < URC_HANDLERS_LEN; i++) urc_handlers[i].prefix = NULL;
+#endif
+#ifdef AT_CMD_TAG_ENABLED
+  tx_tag_pos = 0;
+  tx_cmd_line = 0;
+  tx_cmd_type = AT_CMD_TYPE_EXEC;
+  tx_cmd_tag[0] = 0x00;
+#endif
+#ifdef AT_CMD_TIMING_ENABLED
+  cmd_new_line = 0;
+  cmd_first_ok = 0;
+#endif
+#ifdef AT_CMD_STATS_ENABLED
+  ResetCmdStats();
+#endif
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+  tmout_mode = AT_TMOUT_FIXED;
+  tmout_shortened = 0;
+  ResetTmoutEst();
+#endif
 }
 
 /**********************************************************
@@ -122,8 +174,19 @@ AT::AT(void)
 void AT::InitSerLine(long baud_rate)
 {
   // open the serial line for the communication
-  Serial.begin(baud_rate);
+  transport->Begin(baud_rate);
+  // ring could be created by Begin() or by the reader thread
+  rx_ring = transport->GetRxRing();
   actual_baud_rate = baud_rate;
+#ifdef AT_TRACE_ENABLED
+  if (trace != NULL) trace->AddNum(AT_TRACE_BAUD, baud_rate);
+#endif
+#ifdef AT_AUTOBAUD_ENABLED
+  max_baud_rate = baud_rate;
+  base_baud_rate = baud_rate;
+  rx_err_cnt = transport->GetRxErrCnt();
+  line_err_cnt = 0;
+#endif
   // communication line is not used yet = free
   SetCommLineStatus(CLS_FREE);
   // pointer is initialized to the first item of comm. buffer
@@ -132,96 +195,581 @@ void AT::InitSerLine(long baud_rate)
 }
 
 
+#ifdef AT_AUTOBAUD_ENABLED
+/**********************************************************
+  Baud rate autodetection
+  - DetectBaudRate() tries "AT" at all baud rates supported
+    by the module (the current one first)
+  - ChangeBaudRate() sends AT+IPR, changes the rate of the
+    transport and checks that AT_BAUD_CHECK_CNT "AT" are
+    answered by the clean "OK", otherwise the previous rate
+    is set back
+  - UpshiftBaudRate() tries the rates from the max. one
+    (SetMaxBaudRate()) down to the current one
+  - AT_BAUD_FALLBACK_ERR_CNT consecutive commands with the 
+    line errors return the raised rate to the next lower one
+    (it becomes the new max. rate), it is made when the comm. 
+    line is acquired next time
+**********************************************************/
+
+// baud rates supported by the module (AT+IPR) from the highest one
+// 32-bit entries for pgm_read_dword()
+static const uint32_t baud_rates[] PROGMEM = {115200, 57600, 38400, 19200, 9600, 4800, 2400, 1200};
+#define BAUD_RATES_CNT  (sizeof(baud_rates) / sizeof(baud_rates[0]))
+
+void AT::SetTransportBaudRate(long baud_rate)
+{
+  // everything must be sent by the previous rate
+  transport->Flush();
+  transport->Begin(baud_rate);
+  actual_baud_rate = baud_rate;
+#ifdef AT_TRACE_ENABLED
+  if (trace != NULL) trace->AddNum(AT_TRACE_BAUD, baud_rate);
+#endif
+  rx_err_cnt = transport->GetRxErrCnt();
+  line_err_cnt = 0;
+}
+
+/**********************************************************
+Method sends "AT" cnt times, every response must be "OK"
+without the damaged characters
+- comm. line must be acquired
+
+return: 0 - check failed, 1 - OK
+**********************************************************/
+byte AT::CheckBaudRate(byte cnt)
+{
+  uint16_t i;
+
+  while (cnt--) {
+    if (AT_RESP_OK != SendATCmdWaitRespF(PSTR("AT"), AT_AUTOBAUD_PROBE_TMOUT,
+                                         MAX_INTERCHAR_TMOUT, "OK", 1)) return (0);
+    for (i = 0; i < comm_buf_len; i++) {
+      if ((comm_buf[i] != '\r') && (comm_buf[i] != '\n')
+          && ((comm_buf[i] < ' ') || (comm_buf[i] > '~'))) return (0);
+    }
+  }
+  return (1);
+}
+
+/**********************************************************
+Method looks for the baud rate of the module
+- comm. line must be acquired
+
+return: 0 - module does not respond (previous rate is set back)
+        baud rate of the module
+**********************************************************/
+long AT::ProbeBaudRate(void)
+{
+  long old_baud_rate = actual_baud_rate;
+  long baud_rate;
+  byte i;
+
+  for (i = 0; i <= BAUD_RATES_CNT; i++) {
+    if (i == 0) baud_rate = old_baud_rate;
+    else {
+      baud_rate = pgm_read_dword(&baud_rates[i - 1]);
+      if (baud_rate == old_baud_rate) continue;
+    }
+    SetTransportBaudRate(baud_rate);
+    if (CheckBaudRate(1)) {
+      base_baud_rate = baud_rate;
+      return (baud_rate);
+    }
+  }
+  SetTransportBaudRate(old_baud_rate);
+  return (0);
+}
+
+/**********************************************************
+Method changes the baud rate of the module and of the
+transport
+- comm. line must be acquired
+
+return: -1 - module was lost (it does not respond at any rate)
+         0 - new rate does not work, previous rate is used
+         1 - new rate is used
+**********************************************************/
+char AT::SwitchBaudRate(long baud_rate)
+{
+  char string[20];
+  long old_baud_rate = actual_baud_rate;
+  char resp;
+
+  if (baud_rate == old_baud_rate) return (1);
+  // module answers by the previous rate and changes the rate after that
+  sprintf(string, "AT+IPR=%li", baud_rate);
+  resp = SendATCmdWaitResp(string, START_SHORT_COMM_TMOUT, MAX_INTERCHAR_TMOUT, "OK", 1);
+  // rate is not supported
+  if ((resp == AT_RESP_ERR_DIF_RESP) && IsStringReceived("ERROR")) return (0);
+  // but "OK" can be damaged by the line, the rate could be changed anyway
+  SetTransportBaudRate(baud_rate);
+  if (CheckBaudRate(AT_BAUD_CHECK_CNT)) return (1);
+  if (resp != AT_RESP_OK) {
+    // module probably did not receive the command
+    SetTransportBaudRate(old_baud_rate);
+    if (CheckBaudRate(1)) return (0);
+    SetTransportBaudRate(baud_rate);
+  }
+
+  // back to the previous rate, the command can pass also 
+  // through the bad line
+  sprintf(string, "AT+IPR=%li", old_baud_rate);
+  SendATCmdWaitResp(string, START_SHORT_COMM_TMOUT, MAX_INTERCHAR_TMOUT, "OK", 3);
+  SetTransportBaudRate(old_baud_rate);
+  if (CheckBaudRate(1) || (ProbeBaudRate() > 0)) return (0);
+  return (-1);
+}
+
+/**********************************************************
+Method looks for the baud rate of the module (e.g. when
+the module was left at other rate than InitSerLine() set)
+
+return: -1 - comm. line is not free
+         0 - module does not respond
+        baud rate of the module (the transport uses it)
+**********************************************************/
+long AT::DetectBaudRate(void)
+{
+  long ret_val;
+
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return (-1);
+  ret_val = ProbeBaudRate();
+  SetCommLineStatus(CLS_FREE);
+  return (ret_val);
+}
+
+/**********************************************************
+Method changes the baud rate of the module
+
+baud_rate: one of 1200, 2400, 4800, 9600, 19200, 38400, 
+           57600, 115200
+
+return: -2 - comm. line is not free
+        -1 - module was lost (it does not respond at any rate)
+         0 - new rate does not work, previous rate is used
+         1 - new rate is used
+**********************************************************/
+char AT::ChangeBaudRate(long baud_rate)
+{
+  char ret_val;
+
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return (-2);
+  ret_val = SwitchBaudRate(baud_rate);
+  SetCommLineStatus(CLS_FREE);
+  return (ret_val);
+}
+
+/**********************************************************
+Method raises the baud rate to the highest one (up to 
+the max. baud rate) which passes the check
+- in case the rate is raised and the line errors repeat
+  the rate is returned to the next lower one automatically
+
+return: baud rate which is used
+**********************************************************/
+long AT::UpshiftBaudRate(void)
+{
+  long baud_rate;
+  byte i;
+
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return (actual_baud_rate);
+  for (i = 0; i < BAUD_RATES_CNT; i++) {
+    baud_rate = pgm_read_dword(&baud_rates[i]);
+    if (baud_rate > max_baud_rate) continue;
+    if ((baud_rate <= actual_baud_rate) || (SwitchBaudRate(baud_rate) != 0)) break;
+  }
+  SetCommLineStatus(CLS_FREE);
+  return (actual_baud_rate);
+}
+
+/**********************************************************
+Method counts the consecutive AT commands with the line 
+errors, it is called when the reception of the response
+is finished
+- line errors are the receive errors reported by the transport
+  and the characters damaged by the wrong baud rate (0x00, 0xff
+  and control characters which are never part of the response)
+- missing response is not the line error (e.g. the module is
+  busy or switched off), it does not change the count
+
+rx_status: RX_FINISHED or RX_TMOUT_ERR
+**********************************************************/
+void AT::CountLineErrors(byte rx_status)
+{
+  unsigned long err_cnt = transport->GetRxErrCnt();
+  byte line_err = (err_cnt != rx_err_cnt);
+  uint16_t i;
+  byte ch;
+
+  // character with the framing error is read as 0x00 or 0xff
+  for (i = 0; i < comm_buf_len; i++) {
+    ch = comm_buf[i];
+    if ((ch == 0x00) || (ch == 0xff) 
+        || ((ch < 0x20) && (ch != 0x0d) && (ch != 0x0a) && (ch != 0x1a))) line_err = 1;
+  }
+  rx_err_cnt = err_cnt;
+  if (line_err) {
+    if (line_err_cnt < 0xff) line_err_cnt++;
+  }
+  else if (rx_status != RX_TMOUT_ERR) line_err_cnt = 0;
+}
+
+/**********************************************************
+Method returns the raised baud rate to the next lower one
+- comm. line must be acquired
+**********************************************************/
+void AT::BaudFallback(void)
+{
+  long baud_rate;
+  byte i;
+
+  line_err_cnt = 0;
+  for (i = 0; i < BAUD_RATES_CNT; i++) {
+    baud_rate = pgm_read_dword(&baud_rates[i]);
+    if (baud_rate >= actual_baud_rate) continue;
+    if (baud_rate < base_baud_rate) return;
+    if (SwitchBaudRate(baud_rate) > 0) {
+      // the higher rate is not tried again by UpshiftBaudRate()
+      max_baud_rate = baud_rate;
+      baud_fallback_cnt++;
+    }
+    return;
+  }
+}
+#endif // end of ifdef AT_AUTOBAUD_ENABLED
+
+
+/**********************************************************
+Method switches the RTS/CTS hardware flow control of the
+transport, TurnOn() (InitParam()) sets the module 
+accordingly (AT&K3 or AT&K0)
+- RTS of the module must be connected to CTS of the host 
+  and vice versa (see ATFlowSerialTransport, ATFdTransport)
+
+return: -1 - transport does not support the flow control
+         1 - OK
+**********************************************************/
+char AT::SetFlowControl(byte on)
+{
+  char ret_val = transport->SetFlowControl(on);
+
+  if (ret_val > 0) flow_control = on;
+  return (ret_val);
+}
+
+
 /**********************************************************
   Methods for sending and receiving characters through
-  HW Serial port but can be redefined for using of SW serial
-  port in the GPS module if necessary
+  the transport (HW Serial port by default, see SetTransport())
 **********************************************************/
 void AT::Write(byte send_as_binary)
 {
-  Serial.write(send_as_binary);
+  TxWrite(send_as_binary);
 }
 
 void AT::Write(byte* data_buffer, unsigned short size)
 {
-  Serial.write(data_buffer, size);
+  TxWrite(data_buffer, size);
 }
 
 void AT::Print(char const *string)
 {
-  Serial.print(string);
+  size_t len = strlen(string);
+
+  StartTx();
+#ifdef AT_CMD_TAG_ENABLED
+  TrackCmdTag(string, 0);
+#endif
+  TxWrite((const byte *)string, len);
+  if (len && (string[len - 1] == 0x0d)) tx_line_start = 1;
 }
 
 void AT::PrintChar(char ch)
 {
-  Serial.print(ch);
+  StartTx();
+#ifdef AT_CMD_TAG_ENABLED
+  TrackCmdTag(ch);
+#endif
+  TxWrite(ch);
+  if (ch == 0x0d) tx_line_start = 1;
 }
 
 void AT::PrintF(PGM_P string)
 {
   char c;
+  char last_c = 0;
   
-  while ((c = pgm_read_byte(string++)) != 0)
-    Serial.print( c );
+  StartTx();
+#ifdef AT_CMD_TAG_ENABLED
+  TrackCmdTag(string, 1);
+#endif
+  while ((c = pgm_read_byte(string++)) != 0) {
+    TxWrite(c);
+    last_c = c;
+  }
+  if (last_c == 0x0d) tx_line_start = 1;
 }
 
 void AT::Println(char const *string)
 {
-  Serial.println(string);
+  StartTx();
+#ifdef AT_CMD_TAG_ENABLED
+  TrackCmdTag(string, 0);
+  TrackCmdTag(0x0d);
+#endif
+  TxWrite((const byte *)string, strlen(string));
+  TxWrite((const byte *)"\r\n", 2);
+  tx_line_start = 1;
 }
 
 void AT::PrintlnF(PGM_P string)
 {
   char c;
   
+  StartTx();
+#ifdef AT_CMD_TAG_ENABLED
+  TrackCmdTag(string, 1);
+  TrackCmdTag(0x0d);
+#endif
   while ((c = pgm_read_byte(string++)) != 0)
-    Serial.print( c );
-  Serial.println("");
+    TxWrite(c);
+  TxWrite((const byte *)"\r\n", 2);
+  tx_line_start = 1;
 }
 
 void AT::Print(long long_value)
 {
-  Serial.print(long_value);
+  char num_str[12]; // "-2147483648"
+
+  StartTx();
+  ltoa(long_value, num_str, 10);
+  TxWrite((const byte *)num_str, strlen(num_str));
+}
+
+/**********************************************************
+Method sends the AT command composed of its fragments and
+parameters (see ATCmdLine.h) followed by <CR><LF>
+**********************************************************/
+void AT::Println(const ATCmdBuilder &line)
+{
+  line.Send(this);
+  Println("");
 }
 
 void AT::Println(long long_value)
 {
-  Serial.println(long_value);
+#ifdef AT_CMD_TAG_ENABLED
+  TrackCmdTag(0x0d);
+#endif
+  Print(long_value);
+  TxWrite((const byte *)"\r\n", 2);
+  tx_line_start = 1;
 }
 
-int  AT::Read(void)
+/**********************************************************
+Method is called before the characters are sent
+
+Everything what was received before the new command line
+starts is the rest of the previous response (or URC) so it is 
+read out here and not in the RxInit() - the response to the 
+command can arrive before RxInit() is called (fast transports
+like pty) and it must not be read out as an old one
+In the data state nothing is read out (received data is kept
+for RcvData())
+Once something was sent the RxInit() does not read out anything,
+the response can be already received
+**********************************************************/
+void AT::StartTx(void)
+{
+#ifdef AT_CMD_TIMING_ENABLED
+  if (tx_line_start) {
+    // latency of the command is measured from here
+    cmd_start_us = micros();
+    cmd_new_line = 1;
+  }
+#endif
+  if (tx_line_start && (comm_line_status != CLS_DATA)) {
+    // module can send again only when the response is read (RxInit())
+    transport->HoldRx(0);
+    DrainRx();
+    transport->HoldRx(1);
+  }
+  tx_line_start = 0;
+  rx_drained = 1;
+}
+
+/**********************************************************
+Methods send the characters through the transport
+and count them
+**********************************************************/
+void AT::TxWrite(byte ch)
 {
-  return (Serial.read());
+  link_stats.tx_bytes += transport->Write(ch);
+#ifdef AT_TRACE_ENABLED
+  TraceTx(&ch, 1);
+#endif
 }
 
+void AT::TxWrite(const byte *data, size_t size)
+{
+  link_stats.tx_bytes += transport->Write(data, size);
+#ifdef AT_TRACE_ENABLED
+  TraceTx(data, size);
+#endif
+}
 
-int  AT::ReadBytesUntil(char terminator, char *buffer, size_t length)
+#ifdef AT_TRACE_ENABLED
+/**********************************************************
+Method collects the beginning of the sent line, the line
+is added to the trace when it is finished by <CR> 
+(or by <Ctrl-Z> after the SMS text), data of the sockets
+are not traced
+**********************************************************/
+void AT::TraceTx(const byte *data, size_t size)
+{
+  if ((trace == NULL) || (comm_line_status == CLS_DATA)) return;
+  while (size--) {
+    if ((*data == 0x0d) || (*data == 0x1a)) {
+      if (tx_trace_len) trace->Add(AT_TRACE_CMD, tx_trace_line, tx_trace_len);
+      tx_trace_len = 0;
+    }
+    else if ((*data != 0x0a) && (tx_trace_len < AT_TRACE_DATA_LEN)) {
+      tx_trace_line[tx_trace_len++] = *data;
+    }
+    data++;
+  }
+}
+#endif
+
+/**********************************************************
+Method reads out the rest of the previous response
+**********************************************************/
+void AT::DrainRx(void)
 {
-  return (Serial.readBytesUntil(terminator, buffer, length));
+  Flush(); // erase rx circular buffer
+  // Flush() only waits for the transmission in the new Arduino versions
+  // so read out also rest of the previous response
+#ifdef URC_ENABLED
+  // but unsolicited result codes are kept for PollURC()
+  while (Available()) ParseURCChar(Read());
+  // unfinished line is not URC for sure
+  urc_line_len = 0;
+#else
+  while (Available()) Read();
+#endif
 }
 
+int  AT::Read(void)
+{
+  // characters of the ring are taken directly
+  // (except the flow control - the transport releases RTS by Read())
+  int ch = ((rx_ring != NULL) && !flow_control) ? rx_ring->Get() : transport->Read();
 
+  if (ch >= 0) link_stats.rx_bytes++;
+  return (ch);
+}
 
 void AT::Flush(void)
 {
-  Serial.flush();
+  transport->Flush();
 }
 
 int  AT::Available(void)
 {
-  return (Serial.available());
+  if (rx_ring != NULL) return (rx_ring->Available());
+  return (transport->Available());
+}
+
+/**********************************************************
+Method waits for the next character
+(the same like timedRead() in the Stream)
+
+return: -1 - no character in the timeout
+**********************************************************/
+int AT::TimedRead(unsigned long timeout)
+{
+  unsigned long start = millis();
+
+  do {
+    if (Available()) return (Read());
+  } while ((unsigned long)(millis() - start) < timeout);
+  link_stats.tmout_wait += timeout;
+  return (-1);
 }
 
+/**********************************************************
+Method reads characters until the target string is found
+(the same like findUntil() + setTimeout() in the Stream)
+
+target:     string which should be found
+terminator: string which finishes the searching (e.g. "ERROR")
+timeout:    max. time between characters in msec.
+            (it is used also by next ReadBytes() and ReadBytesUntil()
+            like setTimeout() in the Stream)
 
-bool AT::FindUntil(char *target, char *terminator, unsigned long timeout)
+return: true  - target was found
+        false - terminator was found or timeout occurred
+**********************************************************/
+bool AT::FindUntil(const char *target, const char *terminator, unsigned long timeout)
 {
-  Serial.setTimeout(timeout);
-  return (Serial.findUntil(target, terminator));
+  StreamSearch target_search;
+  StreamSearch term_search;
+  bool ret_val = false;
+  int ch;
+
+  read_tmout = timeout;
+  SSInit(&target_search, target);
+  SSInit(&term_search, terminator);
+  transport->HoldRx(0);
+  while ((ch = TimedRead(timeout)) >= 0) {
+    if (SSFeed(&target_search, ch)) {
+      ret_val = true;
+      break;
+    }
+    if (SSFeed(&term_search, ch)) break;
+  }
+  transport->HoldRx(1);
+  return (ret_val);
 }
 
+/**********************************************************
+Methods read characters into the buffer until the buffer 
+is full, terminator character is received (terminator is 
+not stored) or timeout between characters occurs
+(AT_READ_TMOUT or the last timeout of FindUntil())
+(the same like readBytes() and readBytesUntil() in the Stream)
+
+return: num. of characters placed into the buffer
+**********************************************************/
 size_t AT::ReadBytes(char *buffer, size_t length)
 {
-  return (Serial.readBytes(buffer, length));
+  size_t count = 0;
+  int ch;
+
+  transport->HoldRx(0);
+  while (count < length) {
+    ch = TimedRead(read_tmout);
+    if (ch < 0) break;
+    buffer[count++] = ch;
+  }
+  transport->HoldRx(1);
+  return (count);
+}
+
+int  AT::ReadBytesUntil(char terminator, char *buffer, size_t length)
+{
+  size_t count = 0;
+  int ch;
+
+  transport->HoldRx(0);
+  while (count < length) {
+    ch = TimedRead(read_tmout);
+    if ((ch < 0) || (ch == terminator)) break;
+    buffer[count++] = ch;
+  }
+  transport->HoldRx(1);
+  return (count);
 }
 
 
@@ -245,10 +793,16 @@ size_t AT::ReadBytes(char *buffer, size_t length)
       
   if there is no other incoming character longer then specified
   tmout(in msec) receiving process is considered as finished
+
+  in the RESP_FINISH_RESULT_CODE mode(see SetRespFinishMode()) the receiving 
+  process of the AT command response(flush_before_read = 1) is finished also 
+  immediately when the final result code is received
+  data(GPRS) reception is always finished by the tmout
 **********************************************************/
 void AT::RxInit(uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
                  byte flush_before_read, byte read_when_buffer_full)
 {
+  transport->HoldRx(0);
   rx_state = RX_NOT_STARTED;
   start_reception_tmout = start_comm_tmout;
   interchar_tmout = max_interchar_tmout;
@@ -257,14 +811,140 @@ void AT::RxInit(uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
   p_comm_buf = &comm_buf[0];
   comm_buf_len = 0;
   if (flush_before_read) {
-    Flush(); // erase rx circular buffer
+    // rest of the previous response was already read out 
+    // in case the command was sent (see StartTx())
+    if (!rx_drained) DrainRx();
+    rx_finish_mode = resp_finish_mode;
   }
+  else rx_finish_mode = RESP_FINISH_TMOUT;
+#ifdef URC_ENABLED
+  rx_cmd_mode = flush_before_read;
+#endif
+  rx_text_payload = RX_TEXT_NONE;
   flag_read_when_buffer_full = read_when_buffer_full; 
+  rx_prompt_expected = 0;
+  rx_final_code = FRC_NONE;
+  rx_line_len = 0;
+  rx_drained = 0;
+  link_stats.round_trips++;
+#ifdef AT_CMD_TIMING_ENABLED
+  // only response is awaited => latency is measured from here
+  if (!cmd_new_line) cmd_start_us = micros();
+  cmd_first_ok = 0;
+#endif
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+  rx_max_gap = 0;
+#endif
+#ifdef AT_AUTOBAUD_ENABLED
+  rx_line_check = flush_before_read;
+#endif
+  // the next sent character starts new command (e.g. AT after "+++"
+  // or after the text of the SMS)
+  tx_line_start = 1;
+  ATMatchReset(&rx_match);
+}
+
+/**********************************************************
+Method checks received character against final result codes
+Characters are collected line by line(at most RX_LINE_LEN
+characters from the beginning of the line) and every finished 
+line is compared with the final result codes
+In case URC_ENABLED is defined the finished line which is 
+recognized as unsolicited result code is removed from the 
+comm. buffer and stored for PollURC()
+- line behind the +CMGR: or +CMGL: header is the SMS text so
+  it is never taken as the final result code (e.g. "OK") nor
+  as URC (e.g. "RING me back"), other lines of the response
+  are not taken as URC until the final result code is received
+
+ch: received character
+
+return: FRC_NONE - final result code was not received
+        other final_result_code_enum value
+**********************************************************/
+byte AT::CheckRxLine(byte ch)
+{
+  byte ret_val = FRC_NONE;
+
+  if (ch == 0x0d) {
+    // <CR> is not part of the line
+  }
+  else if (ch == 0x0a) {
+    // <LF> = end of line => compare the line
+    // only beginning of the line is in the buffer so compare
+    // just prefixes and exact strings shorter than RX_LINE_LEN
+    rx_line[(rx_line_len < RX_LINE_LEN) ? rx_line_len : RX_LINE_LEN] = 0x00;
+    if (rx_text_payload == RX_TEXT_LINE) {
+      // text of the SMS (can be also empty) is the part of the response
+      rx_text_payload = RX_TEXT_LISTING;
+    }
+    else if (rx_line_len == 0) {
+      // empty line between <CR><LF> sequences
+    }
+    else if (!strcmp_P(rx_line, PSTR("OK"))) ret_val = FRC_OK;
+    else if (!strcmp_P(rx_line, PSTR("ERROR"))) ret_val = FRC_ERROR;
+    else if (!strncmp_P(rx_line, PSTR("+CME ERROR:"), 11)) ret_val = FRC_CME_ERROR;
+    else if (!strncmp_P(rx_line, PSTR("+CMS ERROR:"), 11)) ret_val = FRC_CMS_ERROR;
+    else if (!strcmp_P(rx_line, PSTR("NO CARRIER"))) ret_val = FRC_NO_CARRIER;
+    else if (!strncmp_P(rx_line, PSTR("CONNECT"), 7)) ret_val = FRC_CONNECT;
+    else if (!strcmp_P(rx_line, PSTR("BUSY"))) ret_val = FRC_BUSY;
+    else if (!strcmp_P(rx_line, PSTR("NO ANSWER"))) ret_val = FRC_NO_ANSWER;
+    else if (!strcmp_P(rx_line, PSTR("NO DIALTONE"))) ret_val = FRC_NO_DIALTONE;
+    else if (!strncmp_P(rx_line, PSTR("+CMGR:"), 6)
+             || !strncmp_P(rx_line, PSTR("+CMGL:"), 6)) {
+      // the next line is the text of the SMS
+      rx_text_payload = RX_TEXT_LINE;
+    }
+#ifdef URC_ENABLED
+    else if (!rx_text_payload && (comm_buf_len < COMM_BUF_LEN) && IsURCLine()) {
+      // whole line is in the comm. buffer and it is the last line
+      // so remove it including <CR><LF> before the line
+      uint16_t start = rx_line_start;
+      uint16_t len = comm_buf_len - start;
+
+      while (len && ((comm_buf[start + len - 1] == 0x0d) 
+                     || (comm_buf[start + len - 1] == 0x0a))) len--;
+      PushURC((char *)&comm_buf[start], (len > URC_LINE_LEN) ? URC_LINE_LEN : len);
+      // URC line is not part of the response for the classifier too
+      rx_match.st = rx_match_line;
+      if ((start >= 2) && (comm_buf[start - 2] == 0x0d) && (comm_buf[start - 1] == 0x0a)) {
+        start -= 2;
+      }
+      comm_buf_len = start;
+      p_comm_buf = &comm_buf[start];
+      comm_buf[start] = 0x00;
+      if (comm_buf_len == 0) {
+        // nothing but URC received so far => response has not started yet
+        // (tmout for the first character is started again)
+        rx_state = RX_NOT_STARTED;
+        prev_time = millis();
+      }
+    }
+#endif
+    // lines behind the final result code can be URC again
+    if (ret_val != FRC_NONE) rx_text_payload = RX_TEXT_NONE;
+    rx_line_len = 0;
+  }
+  else {
+#ifdef URC_ENABLED
+    // character is already in the comm. buffer
+    if (rx_line_len == 0) rx_line_start = comm_buf_len - 1;
+#endif
+    if (rx_line_len < RX_LINE_LEN) rx_line[rx_line_len] = ch;
+    if (rx_line_len < 0xff) rx_line_len++;
+    // prompt "> " is not finished by <CR><LF>
+    if (rx_prompt_expected && (rx_line_len == 2) 
+        && (rx_line[0] == '>') && (ch == ' ')) {
+      ret_val = FRC_PROMPT;
+    }
+  }
+  return (ret_val);
 }
 
 /**********************************************************
 Method checks if receiving process is finished or not.
 Rx process is finished if defined inter-character tmout is reached
+or final result code is received(RESP_FINISH_RESULT_CODE mode)
 
 returns:
         RX_NOT_FINISHED = 0,// not finished yet
@@ -273,7 +953,9 @@ returns:
 **********************************************************/
 byte AT::IsRxFinished(void)
 {
-  byte num_of_bytes;
+  uint16_t num_of_bytes;
+  byte ch;
+  byte final_code;
   byte ret_val = RX_NOT_FINISHED;  // default not finished
 
   // Rx state machine
@@ -288,6 +970,8 @@ byte AT::IsRxFinished(void)
         // so communication is takes as finished
         comm_buf[comm_buf_len] = 0x00;
         ret_val = RX_TMOUT_ERR;
+        link_stats.start_tmouts++;
+        link_stats.tmout_wait += start_reception_tmout;
       }
     }
     else {
@@ -295,6 +979,12 @@ byte AT::IsRxFinished(void)
       // counting process again and go to the next state
       prev_time = millis(); // init tmout for inter-character space
       rx_state = RX_ALREADY_STARTED;
+#ifdef AT_CMD_TIMING_ENABLED
+      if (!cmd_first_ok) {
+        cmd_first_us = micros();
+        cmd_first_ok = 1;
+      }
+#endif
     }
   }
 
@@ -303,6 +993,11 @@ byte AT::IsRxFinished(void)
     // check new received bytes
     // only in case we have place in the buffer
     num_of_bytes = Available();
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+    if (num_of_bytes && ((unsigned long)(millis() - prev_time) > rx_max_gap)) {
+      rx_max_gap = millis() - prev_time;
+    }
+#endif
     // if there are some received bytes postpone the timeout
     if (num_of_bytes) prev_time = millis();
       
@@ -314,11 +1009,20 @@ byte AT::IsRxFinished(void)
         // move available bytes from circular buffer 
         // to the rx buffer
         *p_comm_buf = Read();
+        ch = *p_comm_buf;
         p_comm_buf++;
         comm_buf_len++;
         comm_buf[comm_buf_len] = 0x00;  // and finish currently received characters
                                         // so after each character we have
                                         // valid string finished by the 0x00
+#ifdef URC_ENABLED
+        // beginning of the line which can be removed later as URC
+        if ((rx_line_len == 0) && (ch != 0x0d) && (ch != 0x0a)) {
+          rx_match_line = rx_match.st;
+        }
+#endif
+        // classification is ready when the last character is received
+        ATMatchFeed(&rx_match, ch);
       }
       else if (flag_read_when_buffer_full) {
         // comm buffer is full, other incoming characters
@@ -330,7 +1034,7 @@ byte AT::IsRxFinished(void)
         // so just readout character from circular RS232 buffer 
         // to find out when communication id finished(no more characters
         // are received in inter-char timeout)
-        Read();
+        ch = Read();
       }
       else {
         // buffer is full and we are in the data state => finish 
@@ -338,21 +1042,82 @@ byte AT::IsRxFinished(void)
         ret_val = RX_FINISHED;
         break;  
       }
+
+#ifdef URC_ENABLED
+      // every line of the response must be checked for URC
+      if (rx_cmd_mode) {
+#else
+      if (rx_finish_mode == RESP_FINISH_RESULT_CODE) {
+#endif
+        // check whether the final result code was received
+        final_code = CheckRxLine(ch);
+        if ((final_code != FRC_NONE) && (rx_finish_mode == RESP_FINISH_RESULT_CODE)) {
+          rx_final_code = final_code;
+          // response is complete => it is not necessary to wait
+          // for the inter-character tmout, next characters
+          // (if any) are left in the circular buffer
+          ret_val = RX_FINISHED;
+          break;
+        }
+      }
     }
 
     // finally check the inter-character timeout 
-    if ((unsigned long)(millis() - prev_time) >= interchar_tmout) {
+    if (ret_val == RX_FINISHED) {
+      // already finished
+    }
+    else if ((unsigned long)(millis() - prev_time) >= interchar_tmout) {
       // timeout between received character was reached
       // reception is finished
       // ---------------------------------------------
       comm_buf[comm_buf_len] = 0x00;  // for sure finish string again
                                       // but it is not necessary
       ret_val = RX_FINISHED;
+      link_stats.tmout_wait += interchar_tmout;
     }
   }
+#ifdef AT_AUTOBAUD_ENABLED
+  // data say nothing about the line errors
+  if ((ret_val != RX_NOT_FINISHED) && rx_line_check) CountLineErrors(ret_val);
+#endif
+  // nothing is read until the next reception
+  if (ret_val != RX_NOT_FINISHED) transport->HoldRx(1);
   return (ret_val);
 }
 
+/**********************************************************
+Method sets the pattern set which is used for the classification
+of the next responses
+- every received character of the response is passed to the 
+  classifier so the result is ready immediately when 
+  the response is received
+- URC lines removed from the response are not classified
+- classifier is switched off when the comm. line is released 
+  (SetCommLineStatus(CLS_FREE))
+
+set: pattern set placed in the Flash memory (see ATRespMatch.h)
+     e.g. &resp_match_cpas
+     NULL - classifier is switched off
+
+
+an example of usage:
+        if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (-1);
+        SetRespClassifier(&resp_match_gpio);
+        PrintF(PSTR("AT#GPIO=9,2\r"));
+        if (RX_TMOUT_ERR != WaitResp(100, 20)) {
+          switch (GetRespClass()) {
+            case GPIO_HIGH: ...
+            case GPIO_LOW: ...
+            default: // no pattern was received
+          }
+        }
+        SetCommLineStatus(CLS_FREE);
+**********************************************************/
+void AT::SetRespClassifier(const ATMatchSet *set)
+{
+  ATMatchInit(&rx_match, set);
+}
+
 /**********************************************************
 Method checks received bytes
 
@@ -376,6 +1141,19 @@ byte AT::IsStringReceived(char const *compare_string)
   return (ret_val);
 }
 
+/**********************************************************
+Method checks received bytes
+compare_string is placed in the Flash memory
+
+return: 0 - string was NOT received
+        1 - string was received
+**********************************************************/
+byte AT::IsStringReceivedF(PGM_P compare_string)
+{
+  if (comm_buf_len == 0) return (0);
+  return (strstr_P((char *)comm_buf, compare_string) != NULL);
+}
+
 /**********************************************************
 Method waits for response
 
@@ -391,14 +1169,12 @@ return:
 **********************************************************/
 byte AT::WaitResp(uint16_t start_comm_tmout, uint16_t max_interchar_tmout)
 {
-  byte status;
+  ATCmd cmd;
 
-  RxInit(start_comm_tmout, max_interchar_tmout, 1, 1);
+  SetupATCmd(&cmd, NULL, 0, start_comm_tmout, max_interchar_tmout, NULL, 1, NULL);
   // wait until response is not finished
-  do {
-    status = IsRxFinished();
-  } while (status == RX_NOT_FINISHED);
-  return (status);
+  RunATCmd(&cmd);
+  return (cmd.rx_status);
 }
 
 
@@ -419,31 +1195,13 @@ return:
 byte AT::WaitResp(uint16_t start_comm_tmout, uint16_t max_interchar_tmout, 
                    char const *expected_resp_string)
 {
-  byte status;
-  byte ret_val;
+  ATCmd cmd;
 
-  RxInit(start_comm_tmout, max_interchar_tmout, 1, 1);
+  SetupATCmd(&cmd, NULL, 0, start_comm_tmout, max_interchar_tmout, 
+             expected_resp_string, 1, NULL);
   // wait until response is not finished
-  do {
-    status = IsRxFinished();
-  } while (status == RX_NOT_FINISHED);
-
-  if (status == RX_FINISHED) {
-    // something was received but what was received?
-    // ---------------------------------------------
-    if(IsStringReceived(expected_resp_string)) {
-      // expected string was received
-      // ----------------------------
-      ret_val = RX_FINISHED_STR_RECV;      
-    }
-    else ret_val = RX_FINISHED_STR_NOT_RECV;
-  }
-  else {
-    // nothing was received
-    // --------------------
-    ret_val = RX_TMOUT_ERR;
-  }
-  return (ret_val);
+  RunATCmd(&cmd);
+  return (cmd.rx_status);
 }
 
 
@@ -460,36 +1218,11 @@ char AT::SendATCmdWaitResp(char const *AT_cmd_string,
                 char const *response_string,
                 byte no_of_attempts)
 {
-  byte status;
-  char ret_val = AT_RESP_ERR_NO_RESP;
-  byte i;
-
-  for (i = 0; i < no_of_attempts; i++) {
-    // delay 500 msec. before sending next repeated AT command 
-    // so if we have no_of_attempts=1 tmout will not occurred
-    if (i > 0) delay(AT_DELAY); 
-
-    Println(AT_cmd_string);
-    status = WaitResp(start_comm_tmout, max_interchar_tmout); 
-    if (status == RX_FINISHED) {
-      // something was received but what was received?
-      // ---------------------------------------------
-      if(IsStringReceived(response_string)) {
-        ret_val = AT_RESP_OK;      
-        break;  // response is OK => finish
-      }
-      else ret_val = AT_RESP_ERR_DIF_RESP;
-    }
-    else {
-      // nothing was received
-      // --------------------
-      ret_val = AT_RESP_ERR_NO_RESP;
-    }
-    
-  }
+  ATCmd cmd;
 
-
-  return (ret_val);
+  SetupATCmd(&cmd, AT_cmd_string, 0, start_comm_tmout, max_interchar_tmout, 
+             response_string, no_of_attempts, NULL);
+  return (RunATCmd(&cmd));
 }
 
 /**********************************************************
@@ -506,35 +1239,1850 @@ char AT::SendATCmdWaitRespF(PGM_P AT_cmd_string,
                 char const *response_string,
                 byte no_of_attempts)
 {
-  byte status;
-  char ret_val = AT_RESP_ERR_NO_RESP;
-  byte i;
+  ATCmd cmd;
 
-  for (i = 0; i < no_of_attempts; i++) {
-    // delay 500 msec. before sending next repeated AT command 
-    // so if we have no_of_attempts=1 tmout will not occurred
-    if (i > 0) delay(AT_DELAY); 
+  SetupATCmd(&cmd, AT_cmd_string, ATCMD_FLAG_PGM, start_comm_tmout, max_interchar_tmout, 
+             response_string, no_of_attempts, NULL);
+  return (RunATCmd(&cmd));
+}
 
-    PrintlnF(AT_cmd_string);
-    status = WaitResp(start_comm_tmout, max_interchar_tmout); 
-    if (status == RX_FINISHED) {
-      // something was received but what was received?
-      // ---------------------------------------------
-      if(IsStringReceived(response_string)) {
-        ret_val = AT_RESP_OK;      
-        break;  // response is OK => finish
+
+/**********************************************************
+Method sends AT command composed while it is sent
+(see ATCmdLine.h) and waits for response, the command is not
+built in any buffer
+
+return: 
+      AT_RESP_ERR_NO_RESP = -1,   // no response received
+      AT_RESP_ERR_DIF_RESP = 0,   // response_string is different from the response
+      AT_RESP_OK = 1,             // response_string was included in the response
+**********************************************************/
+char AT::SendATCmdWaitResp(const ATCmdBuilder &line,
+                uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
+                char const *response_string,
+                byte no_of_attempts)
+{
+  ATCmd cmd;
+
+  SetupATCmd(&cmd, NULL, 0, start_comm_tmout, max_interchar_tmout, 
+             response_string, no_of_attempts, NULL);
+  cmd.line = &line;
+  return (RunATCmd(&cmd));
+}
+
+
+/**********************************************************
+Method fills in the AT command descriptor for the
+non-blocking AT command engine
+
+cmd:                  pointer to the descriptor
+AT_cmd_string:        AT command string (without <CR><LF>)
+                      NULL - nothing is sent, only response is awaited
+flags:                ATCMD_FLAG_PGM - AT_cmd_string is placed in the Flash memory
+                      ATCMD_FLAG_DATA - data(GPRS) reception, see RxInit()
+                      ATCMD_FLAG_FINISH_ON_RESP - reception is finished as soon as
+                                                  response_string is received
+start_comm_tmout:     maximum waiting time for receiving the first response
+                      character (in msec.)
+max_interchar_tmout:  maximum tmout between incoming characters in msec.
+response_string:      expected string (NULL - response is not checked)
+no_of_attempts:       max. number of attempts in case response_string 
+                      is not received (the retry policy decides whether 
+                      the failed attempt is repeated, see SetATCmdRetry())
+callback:             function called when the command is finished (can be NULL)
+**********************************************************/
+void AT::SetupATCmd(ATCmd *cmd, const char *AT_cmd_string, byte flags,
+                    uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
+                    const char *response_string, byte no_of_attempts,
+                    at_cmd_callback callback)
+{
+  cmd->AT_cmd_string = AT_cmd_string;
+  cmd->response_string = response_string;
+  cmd->start_comm_tmout = start_comm_tmout;
+  cmd->max_interchar_tmout = max_interchar_tmout;
+  if (no_of_attempts == 0) no_of_attempts = 1;
+  cmd->no_of_attempts = no_of_attempts;
+  cmd->flags = flags;
+  cmd->callback = callback;
+  cmd->priority = ATCMD_PRIO_NORMAL;
+  cmd->deadline = 0;
+  cmd->retry = NULL;
+  cmd->line = NULL;
+  cmd->state = ATCMD_IDLE;
+  cmd->result = AT_RESP_ERR_NO_RESP;
+  cmd->rx_status = RX_NOT_FINISHED;
+}
+
+/**********************************************************
+Method submits AT command to the non-blocking engine
+- in case the communication line is free the command is 
+  started immediately, otherwise the command is put into
+  the queue and it is started as soon as the comm. line 
+  is released and all commands with the same or higher 
+  priority submitted before are finished
+- comm. line is occupied during processing of the command 
+  and released when the command is finished
+- in case the deadline of the command (see SetATCmdPriority())
+  expires before the command is started, the command is 
+  finished with the result AT_RESP_ERR_QUEUE_TMOUT
+- command is processed by the method PollATCmd() which 
+  must be called regularly (e.g. from the loop())
+
+return: 
+      -1 - queue is full or the command is already submitted
+       0 - command was put into the queue
+       1 - command was started
+
+
+an example of usage:
+        ATCmd cmd_creg;
+
+        void creg_finished(ATCmd *cmd)
+        {
+          if (cmd->result == AT_RESP_OK) {
+            // registered
+          }
+        }
+
+        void loop()
+        {
+          if ((cmd_creg.state != ATCMD_BUSY) && (cmd_creg.state != ATCMD_QUEUED)) {
+            gsm.SetupATCmd(&cmd_creg, PSTR("AT+CREG?"), ATCMD_FLAG_PGM, 
+                           5000, 100, "+CREG: 1,1", 1, creg_finished);
+            // housekeeping - it is not important if it waits max. 10 sec.
+            gsm.SetATCmdPriority(&cmd_creg, ATCMD_PRIO_LOW, 10000);
+            gsm.SubmitATCmd(&cmd_creg);
+          }
+          gsm.PollATCmd();
+          // ... other work is done here meanwhile
+        }
+**********************************************************/
+char AT::SubmitATCmd(ATCmd *cmd)
+{
+  byte i;
+
+  if ((cmd->state == ATCMD_BUSY) || (cmd->state == ATCMD_QUEUED)) return (-1);
+  if (cmd->priority >= ATCMD_PRIO_LAST_ITEM) cmd->priority = ATCMD_PRIO_LOW;
+
+  ExpireATCmdQueue();
+  if (at_cmd_queue_len >= ATCMD_QUEUE_LEN) {
+    at_cmd_stats[cmd->priority].rejected++;
+    return (-1);
+  }
+
+  // put the command behind all commands with the same or higher priority
+  i = at_cmd_queue_len;
+  while ((i > 0) && (at_cmd_queue[i-1]->priority > cmd->priority)) {
+    at_cmd_queue[i] = at_cmd_queue[i-1];
+    i--;
+  }
+  at_cmd_queue[i] = cmd;
+  at_cmd_queue_len++;
+  if (at_cmd_queue_len > at_cmd_queue_max_len) at_cmd_queue_max_len = at_cmd_queue_len;
+  cmd->state = ATCMD_QUEUED;
+  cmd->queue_time = millis();
+
+  // start it immediately if the comm. line is free
+  StartQueuedATCmd();
+  if (cmd->state == ATCMD_QUEUED) return (0);
+  return (1);
+}
+
+/**********************************************************
+Method starts the first command from the queue in case
+the comm. line is free and the engine is not busy
+**********************************************************/
+void AT::StartQueuedATCmd(void)
+{
+  ATCmd *cmd;
+  byte i;
+
+  if ((at_cmd_queue_len == 0) || (p_at_cmd != NULL)) return;
+  if (CLS_FREE != GetCommLineStatus()) return;
+
+  cmd = at_cmd_queue[0];
+  at_cmd_queue_len--;
+  for (i = 0; i < at_cmd_queue_len; i++) at_cmd_queue[i] = at_cmd_queue[i+1];
+  UpdateATCmdQueueStats(cmd->priority, millis() - cmd->queue_time);
+
+  SetCommLineStatus(CLS_ATCMD);
+  StartATCmd(cmd);
+  // must be set after start because command could be
+  // already finished by the PollATCmd() called from StartATCmd()
+  if (p_at_cmd == cmd) at_cmd_free_line = 1;
+  else SetCommLineStatus(CLS_FREE);
+}
+
+/**********************************************************
+Method removes commands with the expired deadline from 
+the queue, such commands are finished with the result
+AT_RESP_ERR_QUEUE_TMOUT
+**********************************************************/
+void AT::ExpireATCmdQueue(void)
+{
+  ATCmd *cmd;
+  byte i = 0;
+  byte j;
+
+  while (i < at_cmd_queue_len) {
+    cmd = at_cmd_queue[i];
+    if ((cmd->deadline == 0) 
+        || ((unsigned long)(millis() - cmd->queue_time) < cmd->deadline)) {
+      i++;
+      continue;
+    }
+
+    at_cmd_queue_len--;
+    for (j = i; j < at_cmd_queue_len; j++) at_cmd_queue[j] = at_cmd_queue[j+1];
+    at_cmd_stats[cmd->priority].expired++;
+    cmd->result = AT_RESP_ERR_QUEUE_TMOUT;
+    cmd->state = ATCMD_FINISHED;
+    if (cmd->callback != NULL) cmd->callback(cmd);
+  }
+}
+
+/**********************************************************
+Method acquires the comm. line for the blocking library
+methods (replacement of the CLS_FREE check)
+- in case the comm. line is occupied by the AT command 
+  engine the method processes the engine (and the queue)
+  until the comm. line is released and no command with
+  the same or higher priority waits in the queue
+- the method waits max. COMM_LINE_ACQUIRE_TMOUT msec.
+- comm. line occupied by other user (e.g. data connection
+  CLS_DATA) is not released by waiting so the request
+  is rejected immediately
+
+priority: ATCMD_PRIO_HIGH, ATCMD_PRIO_NORMAL, ATCMD_PRIO_LOW
+
+return: 
+      0 - comm. line was not acquired 
+      1 - comm. line was acquired (status is CLS_ATCMD) and
+          it must be released by SetCommLineStatus(CLS_FREE)
+**********************************************************/
+byte AT::AcquireCommLine(byte priority)
+{
+  unsigned long start_time = millis();
+
+  if (priority >= ATCMD_PRIO_LAST_ITEM) priority = ATCMD_PRIO_LOW;
+
+  while (1) {
+    ExpireATCmdQueue();
+    if ((CLS_FREE == GetCommLineStatus()) && (p_at_cmd == NULL)) {
+      if ((at_cmd_queue_len == 0) || (at_cmd_queue[0]->priority > priority)) {
+        // nobody is before us
+        break;
       }
-      else ret_val = AT_RESP_ERR_DIF_RESP;
+    }
+    else if ((CLS_ATCMD != GetCommLineStatus()) || (p_at_cmd == NULL)) {
+      // comm. line is not occupied by the engine so it will not be released 
+      at_cmd_stats[priority].rejected++;
+      return (0);
+    }
+
+    if ((unsigned long)(millis() - start_time) >= COMM_LINE_ACQUIRE_TMOUT) {
+      at_cmd_stats[priority].rejected++;
+      return (0);
+    }
+    PollATCmd();
+  }
+
+  SetCommLineStatus(CLS_ATCMD);
+  UpdateATCmdQueueStats(priority, millis() - start_time);
+#ifdef AT_AUTOBAUD_ENABLED
+  // raised baud rate does not work well
+  if ((line_err_cnt >= AT_BAUD_FALLBACK_ERR_CNT) && (actual_baud_rate > base_baud_rate)) {
+    BaudFallback();
+  }
+#endif
+  // operation of the caller starts now (see SetOpDeadline())
+  op_start = millis();
+  op_active = (op_deadline != 0);
+  return (1);
+}
+
+/**********************************************************
+Method updates statistics of the comm. line usage
+
+priority:   priority of the request
+wait_time:  how long the request waited for the comm. line 
+            in msec.
+**********************************************************/
+void AT::UpdateATCmdQueueStats(byte priority, unsigned long wait_time)
+{
+  ATCmdQueueStats *stats = &at_cmd_stats[priority];
+
+  stats->served++;
+  if (wait_time == 0) return;
+
+  stats->waited++;
+  stats->total_wait += wait_time;
+  if (wait_time > 0xFFFF) wait_time = 0xFFFF;
+  if (wait_time > stats->max_wait) stats->max_wait = wait_time;
+}
+
+/**********************************************************
+Method returns statistics of the comm. line usage
+for the specified priority
+
+e.g. average waiting time = total_wait / waited
+
+return: 
+      pointer to the statistics
+      NULL - priority is not valid
+**********************************************************/
+const ATCmdQueueStats *AT::GetATCmdQueueStats(byte priority)
+{
+  if (priority >= ATCMD_PRIO_LAST_ITEM) return (NULL);
+  return (&at_cmd_stats[priority]);
+}
+
+/**********************************************************
+Method clears statistics of the comm. line usage
+**********************************************************/
+void AT::ResetATCmdQueueStats(void)
+{
+  memset(at_cmd_stats, 0, sizeof(at_cmd_stats));
+  at_cmd_queue_max_len = at_cmd_queue_len;
+}
+
+/**********************************************************
+Method clears statistics of the serial line
+
+an example of usage:
+        const ATLinkStats *stats;
+
+        gsm.ResetLinkStats();
+        gsm.GetTemp();
+        stats = gsm.GetLinkStats();
+        // stats->round_trips, stats->tx_bytes, stats->rx_bytes,
+        // stats->tmout_wait (msec. spent by waiting for timeouts)
+**********************************************************/
+void AT::ResetLinkStats(void)
+{
+  memset(&link_stats, 0, sizeof(link_stats));
+}
+
+
+#ifdef AT_CMD_STATS_ENABLED
+/**********************************************************
+  Statistics of the AT commands
+  - commands are divided to the classes by the tag 
+    (e.g. "+CREG" for "AT+CREG?", "#SGACT" for "AT#SGACT=1,1")
+  - every attempt made by the AT command engine (incl. WaitResp()
+    after the command sent by Print()) is one sample
+  - fixed size tables, nothing is allocated
+**********************************************************/
+static void IncCnt(uint16_t *cnt)
+{
+  if (*cnt < 0xffff) (*cnt)++;
+}
+
+static void AppendNum(char *string, char separator, unsigned long value)
+{
+  string += strlen(string);
+  *string++ = separator;
+  ultoa(value, string, 10);
+}
+
+static byte CmdHistBucket(unsigned long time_us)
+{
+  unsigned long ms = time_us / 1000;
+  byte bucket = 0;
+
+  while (ms && (bucket < AT_CMD_HIST_LEN - 1)) {
+    ms >>= 1;
+    bucket++;
+  }
+  return (bucket);
+}
+
+/**********************************************************
+Method clears statistics of the AT commands
+**********************************************************/
+void AT::ResetCmdStats(void)
+{
+  memset(cmd_stats, 0, sizeof(cmd_stats));
+  cmd_stats_cnt = 0;
+  // the last class is for the commands which do not fit to the others
+  cmd_stats[AT_CMD_STATS_LEN - 1].tag[0] = '*';
+}
+
+/**********************************************************
+Method returns the class of the last sent command
+**********************************************************/
+ATCmdClassStats *AT::GetCmdClass(void)
+{
+  byte i;
+
+  for (i = 0; i < cmd_stats_cnt; i++) {
+    if (!strcmp(cmd_stats[i].tag, tx_cmd_tag)) return (&cmd_stats[i]);
+  }
+  if (cmd_stats_cnt < AT_CMD_STATS_LEN - 1) {
+    strcpy(cmd_stats[cmd_stats_cnt].tag, tx_cmd_tag);
+    return (&cmd_stats[cmd_stats_cnt++]);
+  }
+  return (&cmd_stats[AT_CMD_STATS_LEN - 1]);
+}
+
+/**********************************************************
+Method adds the finished attempt of the AT command 
+to the statistics
+
+attempt:    1 - first attempt, 2.. - repeated attempts
+rx_status:  rx_state_enum of the reception
+**********************************************************/
+void AT::AddCmdSample(byte attempt, byte rx_status)
+{
+  ATCmdClassStats *stats = GetCmdClass();
+  unsigned long now = micros();
+
+  if (attempt <= 1) IncCnt(&stats->count);
+  else IncCnt(&stats->retries);
+  if (rx_status == RX_TMOUT_ERR) IncCnt(&stats->tmouts);
+  else if (rx_status == RX_FINISHED_STR_NOT_RECV) IncCnt(&stats->dif_resps);
+  if (cmd_first_ok) {
+    IncCnt(&stats->first_hist[CmdHistBucket(cmd_first_us - cmd_start_us)]);
+  }
+  IncCnt(&stats->done_hist[CmdHistBucket(now - cmd_start_us)]);
+}
+
+/**********************************************************
+Method returns the statistics of one class
+
+index: 0 .. GetCmdStatsCnt() - 1
+       AT_CMD_STATS_LEN - 1 - commands which did not fit 
+                              to the other classes
+
+return: NULL - wrong index
+**********************************************************/
+const ATCmdClassStats *AT::GetCmdStats(byte index)
+{
+  if ((index < cmd_stats_cnt) || (index == AT_CMD_STATS_LEN - 1)) return (&cmd_stats[index]);
+  return (NULL);
+}
+
+/**********************************************************
+Method returns the statistics of the command class
+
+tag: e.g. "+CREG", "" - plain AT command
+
+return: NULL - command has not been sent yet
+**********************************************************/
+const ATCmdClassStats *AT::FindCmdStats(const char *tag)
+{
+  byte i;
+
+  for (i = 0; i < cmd_stats_cnt; i++) {
+    if (!strcmp(cmd_stats[i].tag, tag)) return (&cmd_stats[i]);
+  }
+  return (NULL);
+}
+
+/**********************************************************
+Method returns the bucket of the histogram which contains
+the percentile
+
+hist:     first_hist or done_hist
+percent:  e.g. 50 - median, 100 - maximum
+
+return: bucket (see CmdHistLimit())
+        0xff - histogram is empty
+**********************************************************/
+byte AT::CmdHistPercentile(const uint16_t *hist, byte percent)
+{
+  unsigned long total = 0;
+  unsigned long sum = 0;
+  byte i;
+
+  for (i = 0; i < AT_CMD_HIST_LEN; i++) total += hist[i];
+  if (total == 0) return (0xff);
+  for (i = 0; i < AT_CMD_HIST_LEN - 1; i++) {
+    sum += hist[i];
+    if (sum * 100 >= total * percent) break;
+  }
+  return (i);
+}
+
+/**********************************************************
+Method returns the upper limit of the histogram bucket in msec.
+(the last bucket has no limit, the lower limit is returned)
+**********************************************************/
+unsigned long AT::CmdHistLimit(byte bucket)
+{
+  if (bucket >= AT_CMD_HIST_LEN - 1) return (1UL << (AT_CMD_HIST_LEN - 2));
+  return (1UL << bucket);
+}
+
+/**********************************************************
+Method prints the statistics of the AT commands e.g. to the
+serial port used for debugging (everything what is Print)
+- one line per class with the counters and both histograms
+  (num. of samples in the buckets <1, <2, <4 ... msec.)
+
+an example of usage:
+        gsm.PrintCmdStats(Serial);
+
+        AT+CREG n=12 retry=0 tmout=0 dif=0 p50=<16ms p95=<32ms
+          first: 0 0 0 2 10 0 0 0 0 0 0 0 0 0
+          done:  0 0 0 0 11 1 0 0 0 0 0 0 0 0
+**********************************************************/
+void AT::PrintCmdStats(::Print &out)
+{
+  const ATCmdClassStats *stats;
+  byte i;
+  byte j;
+  byte bucket;
+
+  for (i = 0; i < AT_CMD_STATS_LEN; i++) {
+    stats = GetCmdStats(i);
+    if ((stats == NULL) || ((stats->count == 0) && (stats->retries == 0))) continue;
+    if (stats->tag[0] != '*') out.print(F("AT"));
+    out.print(stats->tag);
+    out.print(F(" n="));
+    out.print((unsigned int)stats->count);
+    out.print(F(" retry="));
+    out.print((unsigned int)stats->retries);
+    out.print(F(" tmout="));
+    out.print((unsigned int)stats->tmouts);
+    out.print(F(" dif="));
+    out.print((unsigned int)stats->dif_resps);
+    bucket = CmdHistPercentile(stats->done_hist, 50);
+    out.print(F(" p50="));
+    out.print((bucket == AT_CMD_HIST_LEN - 1) ? '>' : '<');
+    out.print(CmdHistLimit(bucket));
+    bucket = CmdHistPercentile(stats->done_hist, 95);
+    out.print(F("ms p95="));
+    out.print((bucket == AT_CMD_HIST_LEN - 1) ? '>' : '<');
+    out.print(CmdHistLimit(bucket));
+    out.print(F("ms"));
+    out.println();
+    out.print(F("  first:"));
+    for (j = 0; j < AT_CMD_HIST_LEN; j++) {
+      out.print(' ');
+      out.print((unsigned int)stats->first_hist[j]);
+    }
+    out.println();
+    out.print(F("  done: "));
+    for (j = 0; j < AT_CMD_HIST_LEN; j++) {
+      out.print(' ');
+      out.print((unsigned int)stats->done_hist[j]);
+    }
+    out.println();
+  }
+}
+
+/**********************************************************
+Method writes short form of the statistics to the buffer
+e.g. for the SMS (160 characters)
+- one line per class: 
+  <tag>:<count>,<retries>,<tmouts>,<dif_resps>,<p50>,<max>
+  p50 and max are upper limits of the completion time in msec.
+  e.g. "+CREG:12,0,0,0,16,32"
+- classes which do not fit to the buffer are left 
+  for the next call
+
+buffer:       output buffer (always finished by 0x00)
+size:         size of the buffer incl. 0x00
+first_index:  first class (0 for the first call)
+
+return: index of the first class which did not fit 
+        (AT_CMD_STATS_LEN - everything was written)
+
+an example of usage:
+        char sms_text[161];
+        byte index = 0;
+
+        do {
+          index = gsm.FormatCmdStats(sms_text, sizeof(sms_text), index);
+          gsm.SendSMS(phone_number, sms_text);
+        } while (index < AT_CMD_STATS_LEN);
+**********************************************************/
+byte AT::FormatCmdStats(char *buffer, uint16_t size, byte first_index)
+{
+  const ATCmdClassStats *stats;
+  char line[URC_CMD_TAG_LEN + 40];
+  uint16_t len = 0;
+  byte i;
+
+  if (size == 0) return (first_index);
+  buffer[0] = 0x00;
+  for (i = first_index; i < AT_CMD_STATS_LEN; i++) {
+    stats = GetCmdStats(i);
+    if ((stats == NULL) || ((stats->count == 0) && (stats->retries == 0))) continue;
+    if (stats->tag[0]) strcpy(line, stats->tag);
+    else strcpy_P(line, PSTR("AT"));
+    AppendNum(line, ':', stats->count);
+    AppendNum(line, ',', stats->retries);
+    AppendNum(line, ',', stats->tmouts);
+    AppendNum(line, ',', stats->dif_resps);
+    AppendNum(line, ',', CmdHistLimit(CmdHistPercentile(stats->done_hist, 50)));
+    AppendNum(line, ',', CmdHistLimit(CmdHistPercentile(stats->done_hist, 100)));
+    strcat_P(line, PSTR("\n"));
+    if (len + strlen(line) >= size) {
+      // line does not fit => it will be in the next buffer
+      // (but at least one line is always written)
+      if (len) return (i);
+      line[size - 1] = 0x00;
+    }
+    strcpy(buffer + len, line);
+    len += strlen(line);
+  }
+  return (AT_CMD_STATS_LEN);
+}
+#endif // end of ifdef AT_CMD_STATS_ENABLED
+
+
+#ifdef AT_CMD_TIMING_ENABLED
+/**********************************************************
+Method is called when one attempt of the AT command 
+is finished (the response was received or the tmout elapsed)
+**********************************************************/
+void AT::CmdAttemptDone(byte attempt, byte rx_status)
+{
+#ifdef AT_CMD_STATS_ENABLED
+  AddCmdSample(attempt, rx_status);
+#endif
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+  // data reception says nothing about the latency of the commands
+  if (!(p_at_cmd->flags & ATCMD_FLAG_DATA)) AddTmoutSample(rx_status);
+#endif
+  cmd_new_line = 0;
+}
+#endif // end of ifdef AT_CMD_TIMING_ENABLED
+
+
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+/**********************************************************
+  Adaptive timeouts
+  - time to the first character of the response and the max.
+    gap between the characters are learned for every command 
+    class (tag and type e.g. "+CREG" query) like the round trip 
+    time in TCP
+    (RFC 6298): SRTT = 7/8 SRTT + 1/8 R, 
+                RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+  - in the AT_TMOUT_ADAPTIVE mode the timeouts are 
+    SRTT + 4 x RTTVAR limited by AT_ADAPT_MIN_xxx from below
+    and by the timeouts given by the caller from above
+  - start tmout which elapsed because it was adapted clears
+    the learned values of the class so the next attempts
+    use full timeouts again
+  - fixed size table, nothing is allocated
+**********************************************************/
+
+/**********************************************************
+Method clears all learned timeouts
+**********************************************************/
+void AT::ResetTmoutEst(void)
+{
+  memset(tmout_est, 0, sizeof(tmout_est));
+}
+
+/**********************************************************
+Method returns learned values of the command class
+
+tag:  e.g. "+CREG", "" - plain AT command
+type: AT_CMD_TYPE_xxx e.g. AT_CMD_TYPE_QUERY for "AT+CREG?"
+
+return: NULL - nothing was learned about the class yet
+**********************************************************/
+const ATTmoutEst *AT::FindTmoutEst(const char *tag, byte type)
+{
+  byte i;
+
+  for (i = 0; i < AT_ADAPT_EST_LEN; i++) {
+    if (tmout_est[i].samples && (tmout_est[i].type == type)
+        && !strcmp(tmout_est[i].tag, tag)) return (&tmout_est[i]);
+  }
+  return (NULL);
+}
+
+/**********************************************************
+Method returns learned values of the class of the last
+sent command
+
+create: 1 - class is added in case it is not in the table 
+        (the class with the least samples is replaced)
+
+return: NULL - class is not in the table
+**********************************************************/
+ATTmoutEst *AT::GetTmoutEst(byte create)
+{
+  ATTmoutEst *est = (ATTmoutEst *)FindTmoutEst(tx_cmd_tag, tx_cmd_type);
+  byte i;
+
+  if ((est != NULL) || !create) return (est);
+  est = &tmout_est[0];
+  for (i = 1; i < AT_ADAPT_EST_LEN; i++) {
+    if (tmout_est[i].samples < est->samples) est = &tmout_est[i];
+  }
+  memset(est, 0, sizeof(ATTmoutEst));
+  strcpy(est->tag, tx_cmd_tag);
+  est->type = tx_cmd_type;
+  return (est);
+}
+
+/**********************************************************
+Method adapts the timeouts by the learned values
+
+est:                  learned values (NULL - timeouts are not changed)
+start_comm_tmout:     in: timeout given by the caller, out: adapted
+max_interchar_tmout:  in: timeout given by the caller, out: adapted
+
+an example of usage:
+        uint16_t start_tmout = START_XLONG_COMM_TMOUT;
+        uint16_t interchar_tmout = MAX_MID_INTERCHAR_TMOUT;
+
+        gsm.GetAdaptedTmouts(gsm.FindTmoutEst("+CREG", AT_CMD_TYPE_QUERY), 
+                             &start_tmout, &interchar_tmout);
+**********************************************************/
+void AT::GetAdaptedTmouts(const ATTmoutEst *est, uint16_t *start_comm_tmout,
+                          uint16_t *max_interchar_tmout)
+{
+  unsigned long tmout;
+
+  if ((est == NULL) || (est->samples < AT_ADAPT_MIN_SAMPLES)) return;
+  // SRTT + 4 x RTTVAR (+1 because of millis() resolution)
+  tmout = (est->srtt8 >> 3) + est->rttvar4 + 1;
+  if (tmout < AT_ADAPT_MIN_START_TMOUT) tmout = AT_ADAPT_MIN_START_TMOUT;
+  if (tmout < *start_comm_tmout) *start_comm_tmout = tmout;
+  tmout = (est->gap8 >> 3) + est->gapvar4 + 1;
+  if (tmout < AT_ADAPT_MIN_INTERCHAR_TMOUT) tmout = AT_ADAPT_MIN_INTERCHAR_TMOUT;
+  if (tmout < *max_interchar_tmout) *max_interchar_tmout = tmout;
+}
+
+/**********************************************************
+Method updates the estimator by one value
+(value x 8 and variation x 4 like in the TCP)
+**********************************************************/
+static void UpdateEst(unsigned long *smooth8, unsigned long *var4, unsigned long sample,
+                      byte first)
+{
+  unsigned long smooth = *smooth8 >> 3;
+  unsigned long delta;
+
+  if (first) {
+    *smooth8 = sample << 3;
+    *var4 = sample << 1;     // RTTVAR = R/2
+    return;
+  }
+  delta = (sample > smooth) ? sample - smooth : smooth - sample;
+  *var4 = *var4 - (*var4 >> 2) + delta;
+  *smooth8 = *smooth8 - (*smooth8 >> 3) + sample;
+}
+
+/**********************************************************
+Method adds the finished reception to the learned values
+of the class of the last sent command
+**********************************************************/
+void AT::AddTmoutSample(byte rx_status)
+{
+  ATTmoutEst *est;
+  unsigned long sample;
+  unsigned long gap8;
+  unsigned long gapvar4;
+
+  if (!cmd_new_line || !tx_cmd_line) return;
+  if (rx_status == RX_TMOUT_ERR) {
+    // adapted tmout was too short => start learning again 
+    // (full timeouts are used until then)
+    est = GetTmoutEst(0);
+    if (tmout_shortened && (est != NULL)) est->samples = 0;
+    return;
+  }
+  if (!cmd_first_ok) return;
+  est = GetTmoutEst(1);
+  // msec. rounded up
+  sample = (cmd_first_us - cmd_start_us + 999) / 1000;
+  UpdateEst(&est->srtt8, &est->rttvar4, sample, est->samples == 0);
+  gap8 = est->gap8;
+  gapvar4 = est->gapvar4;
+  UpdateEst(&gap8, &gapvar4, rx_max_gap, est->samples == 0);
+  est->gap8 = (gap8 > 0xffff) ? 0xffff : gap8;
+  est->gapvar4 = (gapvar4 > 0xffff) ? 0xffff : gapvar4;
+  if (est->samples < 0xff) est->samples++;
+}
+#endif // end of ifdef AT_ADAPTIVE_TMOUT_ENABLED
+
+/**********************************************************
+  Retry policies
+  - failed attempt of the AT command is repeated only when 
+    the failure is one of the retry_on failures of the policy
+    and the next attempt can be started before the deadline
+    of the operation (see SetOpDeadline())
+  - +CME/+CMS ERROR codes which are given by the state of 
+    the SIM, subscription or by the wrong parameters are 
+    permanent, repeated command ends with the same error
+**********************************************************/
+const ATRetryPolicy at_retry_fixed = 
+  {AT_DELAY, AT_DELAY, 1, 0, ATRETRY_ON_ALL};
+const ATRetryPolicy at_retry_backoff = 
+  {AT_RETRY_BACKOFF_DELAY, AT_RETRY_BACKOFF_MAX_DELAY, 2, 25, 
+   ATRETRY_ON_TMOUT | ATRETRY_ON_DIF_RESP | ATRETRY_ON_ERROR};
+const ATRetryPolicy at_retry_tmout = 
+  {AT_DELAY, AT_DELAY, 1, 0, ATRETRY_ON_TMOUT};
+
+// permanent +CME ERRORs (3GPP TS 27.007), sorted
+static const uint16_t cme_perm_errors[] PROGMEM = {
+  4,    // operation not supported
+  5,    // PH-SIM PIN required
+  10,   // SIM not inserted
+  11,   // SIM PIN required
+  12,   // SIM PUK required
+  13,   // SIM failure
+  15,   // SIM wrong
+  16,   // incorrect password
+  17,   // SIM PIN2 required
+  18,   // SIM PUK2 required
+  20,   // memory full
+  21,   // invalid index
+  22,   // not found
+  24,   // text string too long
+  25,   // invalid characters in text string
+  26,   // dial string too long
+  27,   // invalid characters in dial string
+  50,   // incorrect parameters
+  103,  // illegal MS
+  106,  // illegal ME
+  107,  // GPRS services not allowed
+  111,  // PLMN not allowed
+  112,  // location area not allowed
+  113,  // roaming not allowed in this location area
+  132,  // service option not supported
+  133,  // requested service option not subscribed
+};
+
+// permanent +CMS ERRORs (3GPP TS 27.005, codes below 128 are the RP causes
+// of TS 24.011 e.g. 27 - destination out of service is temporary), sorted
+static const uint16_t cms_perm_errors[] PROGMEM = {
+  1,    // unassigned (unallocated) number
+  8,    // operator determined barring
+  10,   // call barred
+  21,   // short message transfer rejected
+  29,   // facility rejected
+  30,   // unknown subscriber
+  50,   // requested facility not subscribed
+  69,   // requested facility not implemented
+  96,   // invalid mandatory information
+  97,   // message type non-existent or not implemented
+  301,  // SMS service of ME reserved
+  302,  // operation not allowed
+  303,  // operation not supported
+  304,  // invalid PDU mode parameter
+  305,  // invalid text mode parameter
+  310,  // SIM not inserted
+  311,  // SIM PIN required
+  313,  // SIM failure
+  316,  // SIM PUK required
+  321,  // invalid memory index
+  322,  // SIM memory full
+  330,  // SMSC address unknown
+};
+
+/**********************************************************
+Method looks for the code in the sorted table of the
+permanent errors placed in the Flash memory
+
+return: 1 - code is in the table
+**********************************************************/
+static byte IsInErrorTable(const uint16_t *table, byte len, int code)
+{
+  byte i;
+
+  for (i = 0; i < len; i++) {
+    uint16_t perm = pgm_read_word(&table[i]);
+
+    if (perm == code) return (1);
+    if (perm > code) break;
+  }
+  return (0);
+}
+
+/**********************************************************
+Method returns the code of the +CME ERROR or +CMS ERROR
+in the last response
+
+return: 
+        -1 - there is no error or it is in the verbose format
+             (AT+CMEE=2)
+        >= 0 - error code
+**********************************************************/
+int AT::GetErrorCode(void)
+{
+  char *p;
+
+  if (comm_buf_len == 0) return (-1);
+  p = strstr_P((char *)comm_buf, PSTR("+CME ERROR:"));
+  if (p == NULL) p = strstr_P((char *)comm_buf, PSTR("+CMS ERROR:"));
+  if (p == NULL) return (-1);
+  p += 11;
+  while (*p == ' ') p++;
+  if ((*p < '0') || (*p > '9')) return (-1);
+  return (atoi(p));
+}
+
+/**********************************************************
+Method returns 1 if the last response contains +CME/+CMS
+ERROR which is known as permanent (the same command
+would end with the same error)
+**********************************************************/
+byte AT::IsPermanentError(void)
+{
+  int code = GetErrorCode();
+
+  if (code < 0) return (0);
+  // the same code means other error in +CME and in +CMS
+  // (GetErrorCode() looks for +CME ERROR first)
+  if (strstr_P((char *)comm_buf, PSTR("+CME ERROR:")) != NULL) {
+    return (IsInErrorTable(cme_perm_errors, 
+                           sizeof(cme_perm_errors) / sizeof(cme_perm_errors[0]), code));
+  }
+  return (IsInErrorTable(cms_perm_errors, 
+                         sizeof(cms_perm_errors) / sizeof(cms_perm_errors[0]), code));
+}
+
+/**********************************************************
+Method returns the time in msec. to the deadline of the
+operation in progress (0 - deadline has expired, 
+0xffffffff - there is no deadline)
+**********************************************************/
+unsigned long AT::GetOpTimeLeft(void)
+{
+  unsigned long elapsed;
+
+  if (!op_active) return (0xffffffff);
+  elapsed = millis() - op_start;
+  if (elapsed >= op_deadline) return (0);
+  return (op_deadline - elapsed);
+}
+
+/**********************************************************
+Method returns the delay before the attempt + 1
+(attempt 1 is the first one)
+**********************************************************/
+uint16_t AT::GetRetryDelay(const ATRetryPolicy *policy, byte attempt)
+{
+  unsigned long delay_ms = policy->delay;
+
+  while ((--attempt > 0) && (delay_ms < policy->max_delay)) delay_ms *= policy->backoff;
+  if (delay_ms > policy->max_delay) delay_ms = policy->max_delay;
+  if (policy->jitter) {
+    // attempts of more devices are not synchronized
+    delay_ms += random(delay_ms * policy->jitter / 100 + 1);
+  }
+  return ((delay_ms > 0xffff) ? 0xffff : delay_ms);
+}
+
+/**********************************************************
+Method checks whether the response of the AT command 
+contains its response string (RAM or Flash)
+**********************************************************/
+byte AT::IsRespReceived(ATCmd *cmd)
+{
+  if (cmd->flags & ATCMD_FLAG_PGM_RESP) return (IsStringReceivedF(cmd->response_string));
+  return (IsStringReceived(cmd->response_string));
+}
+
+/**********************************************************
+Method decides whether the failed attempt of the AT command
+in progress is repeated, the delay before the next attempt 
+is prepared in at_cmd_delay
+**********************************************************/
+byte AT::IsRetryWanted(ATCmd *cmd)
+{
+  const ATRetryPolicy *policy = (cmd->retry != NULL) ? cmd->retry : retry_policy;
+  byte failure;
+
+  if (at_cmd_attempt >= cmd->no_of_attempts) return (0);
+  if (cmd->result == AT_RESP_ERR_NO_RESP) failure = ATRETRY_ON_TMOUT;
+  else if (IsPermanentError()) failure = ATRETRY_ON_PERM_ERROR;
+  else if ((rx_final_code != FRC_NONE) && (rx_final_code != FRC_OK) 
+           && (rx_final_code != FRC_CONNECT) && (rx_final_code != FRC_PROMPT)) {
+    failure = ATRETRY_ON_ERROR;
+  }
+  else if (IsStringReceived("ERROR")) {
+    // final result code is not detected in the RESP_FINISH_TMOUT mode
+    failure = ATRETRY_ON_ERROR;
+  }
+  else failure = ATRETRY_ON_DIF_RESP;
+  if (!(policy->retry_on & failure)) return (0);
+
+  at_cmd_delay = GetRetryDelay(policy, at_cmd_attempt);
+  // next attempt must start before the deadline
+  if (GetOpTimeLeft() <= at_cmd_delay) return (0);
+  return (1);
+}
+
+/**********************************************************
+Method starts AT command in the non-blocking engine
+- comm. line status is not checked nor changed so the caller
+  must own the comm. line (this is used inside of the library
+  methods which have already occupied the comm. line)
+
+return: 
+      -1 - engine is busy with other command
+       1 - command was started
+**********************************************************/
+char AT::StartATCmd(ATCmd *cmd)
+{
+  if (p_at_cmd != NULL) return (-1);
+
+  p_at_cmd = cmd;
+  at_cmd_step = ATCMD_STEP_SEND;
+  at_cmd_attempt = 0;
+  at_cmd_free_line = 0;
+  cmd->state = ATCMD_BUSY;
+  cmd->result = AT_RESP_ERR_NO_RESP;
+  cmd->rx_status = RX_NOT_FINISHED;
+  // send the command immediately
+  PollATCmd();
+  return (1);
+}
+
+/**********************************************************
+Method processes the AT command in progress
+- it never blocks so it must be called regularly 
+  until the command is finished
+
+return: 
+      ATCMD_IDLE      - there is no command in progress
+      ATCMD_BUSY      - command is in progress
+      ATCMD_FINISHED  - command has just been finished
+                        (result is in the descriptor)
+**********************************************************/
+byte AT::PollATCmd(void)
+{
+  ATCmd *cmd = p_at_cmd;
+  byte status;
+
+  ExpireATCmdQueue();
+  if (cmd == NULL) {
+    // engine is free => next command from the queue can be started
+    StartQueuedATCmd();
+    if (p_at_cmd != NULL) return (ATCMD_BUSY);
+    return (ATCMD_IDLE);
+  }
+
+  if (at_cmd_step == ATCMD_STEP_DELAY) {
+    // delay given by the retry policy before sending next repeated AT command 
+    if ((unsigned long)(millis() - at_cmd_time) < at_cmd_delay) return (ATCMD_BUSY);
+    at_cmd_step = ATCMD_STEP_SEND;
+  }
+
+  if (at_cmd_step == ATCMD_STEP_SEND) {
+    uint16_t start_tmout = cmd->start_comm_tmout;
+    uint16_t interchar_tmout = cmd->max_interchar_tmout;
+    unsigned long time_left = GetOpTimeLeft();
+
+    if (time_left == 0) {
+      // deadline of the operation has expired => command is not sent
+      FinishATCmd(AT_RESP_ERR_NO_RESP, RX_TMOUT_ERR);
+      return (ATCMD_FINISHED);
+    }
+    if (cmd->AT_cmd_string != NULL) {
+      if (cmd->flags & ATCMD_FLAG_PGM) PrintlnF(cmd->AT_cmd_string);
+      else Println(cmd->AT_cmd_string);
+    }
+    else if (cmd->line != NULL) Println(*cmd->line);
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+    // only response to the just sent command can be predicted
+    // (not e.g. the response to "+++" or to the text of the SMS)
+    tmout_shortened = 0;
+    if (!(cmd->flags & ATCMD_FLAG_DATA) 
+        && (tmout_mode == AT_TMOUT_ADAPTIVE) && cmd_new_line && tx_cmd_line) {
+      GetAdaptedTmouts(GetTmoutEst(0), &start_tmout, &interchar_tmout);
+      tmout_shortened = (start_tmout < cmd->start_comm_tmout);
+    }
+#endif
+    // response is not awaited after the deadline of the operation
+    if (start_tmout > time_left) start_tmout = time_left;
+    if (cmd->flags & ATCMD_FLAG_DATA) {
+      RxInit(start_tmout, interchar_tmout, 0, 0);
     }
     else {
-      // nothing was received
-      // --------------------
-      ret_val = AT_RESP_ERR_NO_RESP;
+      RxInit(start_tmout, interchar_tmout, 1, 1);
+    }
+    // "> " is final result code only in case it is expected
+    // e.g. after AT+CMGS command
+    if ((cmd->response_string != NULL) 
+        && (((cmd->flags & ATCMD_FLAG_PGM_RESP) ? pgm_read_byte(cmd->response_string) 
+                                                : cmd->response_string[0]) == '>')) {
+      rx_prompt_expected = 1;
+    }
+    at_cmd_attempt++;
+    at_cmd_step = ATCMD_STEP_WAIT;
+  }
+
+  // ATCMD_STEP_WAIT
+  status = IsRxFinished();
+  if ((status == RX_NOT_FINISHED) 
+      && (cmd->flags & ATCMD_FLAG_FINISH_ON_RESP)
+      && IsRespReceived(cmd)) {
+    // expected string is here => it is not necessary to wait longer
+    status = RX_FINISHED;
+  }
+  if (status == RX_NOT_FINISHED) return (ATCMD_BUSY);
+
+  if (status == RX_FINISHED) {
+    // something was received but what was received?
+    // ---------------------------------------------
+    if (cmd->response_string == NULL) {
+#ifdef AT_CMD_TIMING_ENABLED
+      CmdAttemptDone(at_cmd_attempt, RX_FINISHED);
+#endif
+      FinishATCmd(AT_RESP_OK, RX_FINISHED);
+      return (ATCMD_FINISHED);
+    }
+    if (IsRespReceived(cmd)) {
+      // response is OK => finish
+#ifdef AT_CMD_TIMING_ENABLED
+      CmdAttemptDone(at_cmd_attempt, RX_FINISHED_STR_RECV);
+#endif
+      FinishATCmd(AT_RESP_OK, RX_FINISHED_STR_RECV);
+      return (ATCMD_FINISHED);
+    }
+    cmd->result = AT_RESP_ERR_DIF_RESP;
+    cmd->rx_status = RX_FINISHED_STR_NOT_RECV;
+  }
+  else {
+    // nothing was received
+    // --------------------
+    cmd->result = AT_RESP_ERR_NO_RESP;
+    cmd->rx_status = RX_TMOUT_ERR;
+  }
+#ifdef AT_CMD_TIMING_ENABLED
+  CmdAttemptDone(at_cmd_attempt, cmd->rx_status);
+#endif
+
+  if (IsRetryWanted(cmd)) {
+    // try it again after the delay, nothing is read meanwhile
+    at_cmd_time = millis();
+    at_cmd_step = ATCMD_STEP_DELAY;
+    transport->HoldRx(1);
+    return (ATCMD_BUSY);
+  }
+  FinishATCmd(cmd->result, cmd->rx_status);
+  return (ATCMD_FINISHED);
+}
+
+/**********************************************************
+Method finishes the AT command in progress - the result
+is stored in the descriptor, comm. line is released (if
+it was occupied by SubmitATCmd()) and callback is called
+**********************************************************/
+void AT::FinishATCmd(char result, byte rx_status)
+{
+  ATCmd *cmd = p_at_cmd;
+
+  cmd->result = result;
+  cmd->rx_status = rx_status;
+  cmd->state = ATCMD_FINISHED;
+#ifdef AT_TRACE_ENABLED
+  if (trace != NULL) {
+    byte data[4];
+
+    data[0] = result;
+    data[1] = rx_status;
+    data[2] = at_cmd_attempt;
+    data[3] = rx_final_code;
+    trace->Add(AT_TRACE_RESULT, data, sizeof(data));
+  }
+#endif
+  // engine is free before callback so the callback can start next command
+  p_at_cmd = NULL;
+  if (at_cmd_free_line) {
+    at_cmd_free_line = 0;
+    SetCommLineStatus(CLS_FREE);
+  }
+  if (cmd->callback != NULL) cmd->callback(cmd);
+}
+
+/**********************************************************
+Method starts AT command and waits until it is finished
+(blocking usage of the engine)
+
+return: 
+      AT_RESP_ERR_NO_RESP = -1,   // no response received
+      AT_RESP_ERR_DIF_RESP = 0,   // response_string is different from the response
+      AT_RESP_OK = 1,             // response_string was included in the response
+**********************************************************/
+char AT::RunATCmd(ATCmd *cmd)
+{
+  // finish previous command first (if any)
+  while (PollATCmd() == ATCMD_BUSY);
+
+  StartATCmd(cmd);
+  while (PollATCmd() == ATCMD_BUSY);
+  return (cmd->result);
+}
+
+/**********************************************************
+Method returns character of the batch item at the position pos
+(item can be placed in the RAM or in the Flash memory)
+**********************************************************/
+static char BatchItemChar(ATBatchItem *item, byte pos)
+{
+  if (item->flags & ATCMD_FLAG_PGM) return (pgm_read_byte(item->AT_cmd_string + pos));
+  return (item->AT_cmd_string[pos]);
+}
+
+/**********************************************************
+Method returns 1 in case the character is the prefix 
+of the extended command (e.g. +CMGF, #GPIO, $GPSP)
+**********************************************************/
+static byte IsExtendedCmdPrefix(char ch)
+{
+  return ((ch == '+') || (ch == '#') || (ch == '$'));
+}
+
+// start_comm_tmout and max_interchar_tmout of the timeout classes (at_tmout_class_enum)
+static const uint16_t tmout_classes[AT_TMOUT_CLASS_LAST_ITEM][2] PROGMEM = {
+  {START_SHORT_COMM_TMOUT, MAX_INTERCHAR_TMOUT},
+  {START_LONG_COMM_TMOUT, MAX_MID_INTERCHAR_TMOUT},
+  {START_XLONG_COMM_TMOUT, MAX_MID_INTERCHAR_TMOUT},
+  {10000, 1000},
+};
+
+/**********************************************************
+Method initializes the batch of AT commands - batch is empty
+**********************************************************/
+void AT::BatchInit(ATBatch *batch)
+{
+  batch->len = 0;
+}
+
+/**********************************************************
+Method adds AT command placed in the RAM to the batch
+- string is not copied so it must be valid until
+  BatchRun() is finished
+
+AT_cmd_string:        whole AT command e.g. "AT+CMGF=1"
+start_comm_tmout:     maximum waiting time for receiving the first response
+                      character (in msec.)
+
+return: 
+      -1 - batch is full
+       1 - command was added
+**********************************************************/
+char AT::BatchAdd(ATBatch *batch, char const *AT_cmd_string, uint16_t start_comm_tmout)
+{
+  if (batch->len >= ATCMD_BATCH_LEN) return (-1);
+  batch->item[batch->len].AT_cmd_string = AT_cmd_string;
+  batch->item[batch->len].start_comm_tmout = start_comm_tmout;
+  batch->item[batch->len].flags = 0;
+  batch->len++;
+  return (1);
+}
+
+/**********************************************************
+Method adds AT command placed in the Flash memory to the batch
+(see BatchAdd())
+**********************************************************/
+char AT::BatchAddF(ATBatch *batch, PGM_P AT_cmd_string, uint16_t start_comm_tmout)
+{
+  if (BatchAdd(batch, AT_cmd_string, start_comm_tmout) < 0) return (-1);
+  batch->item[batch->len - 1].flags = ATCMD_FLAG_PGM;
+  return (1);
+}
+
+/**********************************************************
+Method adds AT command described in the Flash memory to 
+the batch (see BatchAdd(), RunATCmdDesc())
+- the batch expects "OK" so only descriptors with the response
+  string "OK" and without the parser make sense here
+**********************************************************/
+char AT::BatchAddDesc(ATBatch *batch, const ATCmdDesc *desc)
+{
+  byte tmout_class = pgm_read_byte(&desc->tmout_class);
+
+  if (tmout_class >= AT_TMOUT_CLASS_LAST_ITEM) tmout_class = AT_TMOUT_CLASS_LONG;
+  return (BatchAddF(batch, (PGM_P)pgm_read_ptr(&desc->AT_cmd_string), 
+                    pgm_read_word(&tmout_classes[tmout_class][0])));
+}
+
+/**********************************************************
+Method returns length of the batch item without "AT" prefix 
+
+return: 
+      0 - item can not be concatenated with other commands
+          (it does not start with "AT" or it is the basic
+          command which must be sent alone: D, A, H, O, Z)
+      length of the command behind "AT"
+**********************************************************/
+byte AT::BatchItemLen(ATBatchItem *item)
+{
+  byte len;
+  char ch;
+
+  if ((BatchItemChar(item, 0) != 'A') || (BatchItemChar(item, 1) != 'T')) return (0);
+  ch = BatchItemChar(item, 2);
+  switch (ch) {
+    case 0:
+    case 'D': case 'd':
+    case 'A': case 'a':
+    case 'H': case 'h':
+    case 'O': case 'o':
+    case 'Z': case 'z':
+      return (0);
+  }
+
+  if (item->flags & ATCMD_FLAG_PGM) len = strlen_P(item->AT_cmd_string);
+  else len = strlen(item->AT_cmd_string);
+  return (len - 2);
+}
+
+/**********************************************************
+Method sends batch items first..last as one command line
+e.g. AT&F1E0;+IPR=115200;#SELINT=1 and waits for "OK"
+- basic commands are concatenated directly, extended commands
+  are separated by ';'
+- start_comm_tmout is the sum of the items tmouts 
+
+return: 
+      AT_RESP_ERR_NO_RESP = -1,   // no response received
+      AT_RESP_ERR_DIF_RESP = 0,   // "OK" was not received
+      AT_RESP_OK = 1,             // all commands were executed
+**********************************************************/
+char AT::BatchSendLine(ATBatch *batch, byte first, byte last, uint16_t max_interchar_tmout)
+{
+  ATCmd cmd;
+  ATBatchItem *item;
+  unsigned long start_comm_tmout = 0;
+  char prev_prefix = 0;
+  char prefix;
+  byte i;
+
+  Print("AT");
+  for (i = first; i <= last; i++) {
+    item = &batch->item[i];
+    prefix = BatchItemChar(item, 2);
+    if ((i != first) 
+        && (IsExtendedCmdPrefix(prev_prefix) || IsExtendedCmdPrefix(prefix))) {
+      PrintChar(';');
+    }
+    if (item->flags & ATCMD_FLAG_PGM) PrintF(item->AT_cmd_string + 2);
+    else Print(item->AT_cmd_string + 2);
+    prev_prefix = prefix;
+    start_comm_tmout += item->start_comm_tmout;
+  }
+  Println("");
+  if (start_comm_tmout > 0xFFFF) start_comm_tmout = 0xFFFF;
+
+  // command line is already sent so only response is awaited
+  SetupATCmd(&cmd, NULL, 0, start_comm_tmout, max_interchar_tmout, "OK", 1, NULL);
+  return (RunATCmd(&cmd));
+}
+
+/**********************************************************
+Method executes the batch of AT commands - each command
+is expected to answer "OK"
+- consecutive commands are concatenated into command lines
+  (max. ATCMD_BATCH_LINE_LEN characters) so the whole batch
+  usually takes only one or two round trips
+- in case the concatenated line fails (the module stops 
+  execution of the line at the first error) all commands
+  of that line are sent again one by one with no_of_attempts
+  to isolate the failed command
+- caller must own the comm. line (like SendATCmdWaitResp())
+
+max_interchar_tmout:  maximum tmout between incoming characters in msec.
+no_of_attempts:       how many times each command is sent in case 
+                      it is sent alone
+
+return: 
+      num. of commands which failed (0 - all commands are OK)
+
+
+an example of usage:
+        ATBatch batch;
+
+        gsm.BatchInit(&batch);
+        gsm.BatchAddF(&batch, PSTR("ATE0"), 500);
+        gsm.BatchAddF(&batch, PSTR("AT+CMGF=1"), 500);
+        gsm.BatchAddF(&batch, PSTR("AT#CAP=1"), 500);
+        // sent as ATE0;+CMGF=1;#CAP=1
+        gsm.BatchRun(&batch, 20, 5);
+**********************************************************/
+byte AT::BatchRun(ATBatch *batch, uint16_t max_interchar_tmout, byte no_of_attempts)
+{
+  ATBatchItem *item;
+  byte first = 0;
+  byte last;
+  byte len;
+  uint16_t line_len;
+  byte failed = 0;
+  char ret;
+
+  while (first < batch->len) {
+    // collect as many commands as possible into one command line
+    last = first;
+    len = BatchItemLen(&batch->item[first]);
+    if (len != 0) {
+      line_len = 2 + len;
+      while ((byte)(last + 1) < batch->len) {
+        len = BatchItemLen(&batch->item[last + 1]);
+        if (len == 0) break;
+        // +1 for the possible ';' separator
+        if (line_len + len + 1 > ATCMD_BATCH_LINE_LEN) break;
+        line_len += len + 1;
+        last++;
+      }
+    }
+
+    if (last > first) {
+      if (AT_RESP_OK == BatchSendLine(batch, first, last, max_interchar_tmout)) {
+        first = last + 1;
+        continue;
+      }
+    }
+
+    // single command or the concatenated line failed 
+    // => commands are sent one by one
+    for (; first <= last; first++) {
+      item = &batch->item[first];
+      if (item->flags & ATCMD_FLAG_PGM) {
+        ret = SendATCmdWaitRespF(item->AT_cmd_string, item->start_comm_tmout, 
+                                 max_interchar_tmout, "OK", no_of_attempts);
+      }
+      else {
+        ret = SendATCmdWaitResp(item->AT_cmd_string, item->start_comm_tmout, 
+                                max_interchar_tmout, "OK", no_of_attempts);
+      }
+      if (ret != AT_RESP_OK) failed++;
+    }
+  }
+  return (failed);
+}
+
+
+/**********************************************************
+  AT commands described in the Flash memory (ATCmdDesc)
+  
+  the methods of the GSM and GPS classes describe their 
+  AT commands by the tables in the Flash memory and run them 
+  by this small interpreter so the pattern acquire comm. line -
+  send - check the response - parse - release comm. line 
+  is only here
+**********************************************************/
+
+/**********************************************************
+Method fills in the AT command descriptor of the non-blocking
+engine (see SetupATCmd()) from the description in the Flash memory
+so the command can be submitted to the queue (SubmitATCmd())
+
+desc:     description of the command in the Flash memory
+callback: function called when command is finished (can be NULL)
+**********************************************************/
+void AT::SetupATCmdDesc(ATCmd *cmd, const ATCmdDesc *desc, at_cmd_callback callback)
+{
+  ATCmdDesc d;
+  byte flags = ATCMD_FLAG_PGM;
+
+  memcpy_P(&d, desc, sizeof(d));
+  if (d.tmout_class >= AT_TMOUT_CLASS_LAST_ITEM) d.tmout_class = AT_TMOUT_CLASS_LONG;
+  if (d.response_string != NULL) flags |= ATCMD_FLAG_PGM_RESP;
+  SetupATCmd(cmd, d.AT_cmd_string, flags, 
+             pgm_read_word(&tmout_classes[d.tmout_class][0]),
+             pgm_read_word(&tmout_classes[d.tmout_class][1]),
+             d.response_string, d.no_of_attempts, callback);
+}
+
+/**********************************************************
+Method sends AT command described in the Flash memory,
+waits for the response and parses it
+- caller must own the comm. line (like SendATCmdWaitResp())
+
+desc: description of the command in the Flash memory
+ctx:  pointer passed to the parser (e.g. where the value is stored)
+
+return: 
+      0 - response was not received or it is different
+      result of the parser (1 in case there is no parser)
+**********************************************************/
+char AT::ExecATCmdDesc(const ATCmdDesc *desc, void *ctx)
+{
+  ATCmd cmd;
+  ATCmdDesc d;
+  StrView resp;
+
+  SetupATCmdDesc(&cmd, desc, NULL);
+  if (RunATCmd(&cmd) != AT_RESP_OK) return (0);
+  memcpy_P(&d, desc, sizeof(d));
+  if (d.parser == NULL) return (1);
+  GetRespView(&resp);
+  return (d.parser(&d, &resp, ctx));
+}
+
+/**********************************************************
+Method acquires the comm. line, runs AT command described in 
+the Flash memory (see ExecATCmdDesc()) and releases the line
+
+priority: at_cmd_prio_enum used to acquire the comm. line
+
+return: 
+     -1 - comm. line is not free
+      0 - response was not received or it is different
+      result of the parser (1 in case there is no parser)
+
+an example of usage:
+        static const char cmd_gpsav[] PROGMEM = "AT$GPSAV";
+        static const char resp_gpsav[] PROGMEM = "$GPSAV:";
+        static const ATCmdDesc desc_gpsav PROGMEM = 
+          {cmd_gpsav, resp_gpsav, AT_TMOUT_CLASS_XLONG, 1, AT::ParseDescNum};
+        long voltage;
+
+        if (gsm.RunATCmdDesc(&desc_gpsav, ATCMD_PRIO_NORMAL, &voltage) == 1) {
+          // voltage is valid
+        }
+**********************************************************/
+char AT::RunATCmdDesc(const ATCmdDesc *desc, byte priority, void *ctx)
+{
+  return (RunATCmdSeq(desc, 1, priority, ctx));
+}
+
+/**********************************************************
+Method acquires the comm. line, runs the sequence of AT commands 
+described in the array in the Flash memory and releases the line
+- the sequence is stopped by the first command whose
+  result is not 1
+
+seq:      array of the descriptions in the Flash memory
+cnt:      num. of the commands in the array
+priority: at_cmd_prio_enum used to acquire the comm. line
+ctx:      pointer passed to all parsers
+
+return: 
+     -1 - comm. line is not free
+      result of the last executed command (1 - all were OK)
+**********************************************************/
+char AT::RunATCmdSeq(const ATCmdDesc *seq, byte cnt, byte priority, void *ctx)
+{
+  char ret_val = -1;
+  byte i;
+
+  if (!AcquireCommLine(priority)) return (ret_val);
+  for (i = 0; i < cnt; i++) {
+    ret_val = ExecATCmdDesc(&seq[i], ctx);
+    if (ret_val != 1) break;
+  }
+  SetCommLineStatus(CLS_FREE);
+  return (ret_val);
+}
+
+/**********************************************************
+Parser of the numeric response e.g. "$GPSAV: 3962"
+- the number is the first field after ':' of the line
+  which starts with the response string of the description
+- ctx is the pointer to long where the number is stored
+
+return: 1 - number was stored, 0 - number was not found
+**********************************************************/
+char AT::ParseDescNum(const ATCmdDesc *desc, StrView *resp, void *ctx)
+{
+  StrView line;
+  StrView field;
+
+  if ((desc->response_string != NULL) 
+      && SVFindLineF(resp, desc->response_string, &line)
+      && SVSkipPast(&line, ':')
+      && SVNextField(&line, &field, ',')
+      && SVToLong(&field, (long *)ctx)) return (1);
+  return (0);
+}
+
+
+#ifdef URC_ENABLED
+/**********************************************************
+List of the well known unsolicited result codes 
+(prefixes finished by 0x00, the list is finished by 
+an empty string)
+**********************************************************/
+static const char urc_prefixes[] PROGMEM = 
+  "RING\0"
+  "SRING\0"
+  "+CRING:\0"
+  "+CLIP:\0"
+  "+CMTI:\0"
+  "+CDSI:\0"
+  "+CREG:\0"
+  "+CGREG:\0"
+  "#GPIO:\0";
+
+/**********************************************************
+Method registers handler of the unsolicited result code
+- handler is called from PollURC() for every URC line
+  which starts with the prefix
+- lines starting with the prefix are also removed from
+  the responses of the AT commands (except the response
+  of the command with the same name e.g. "+CREG: 0,1" 
+  for "AT+CREG?")
+- prefix must be shorter than RX_LINE_LEN characters
+- in case the prefix is already registered only handler
+  is changed, NULL handler removes the registration
+
+prefix:   prefix of the URC placed in the Flash memory 
+          e.g. PSTR("+CMTI:")
+handler:  function called with the whole URC line
+
+return: 
+      -1 - there is no place for the next handler
+       1 - handler was registered
+
+
+an example of usage:
+        void sms_arrived(const char *line)
+        {
+          // line is e.g. +CMTI: "SM",3
+          new_sms_position = atoi(strchr(line, ',') + 1);
+        }
+
+        void setup()
+        {
+          ...
+          gsm.RegisterURCHandler(PSTR("+CMTI:"), sms_arrived);
+        }
+
+        void loop()
+        {
+          gsm.PollURC();
+          ...
+        }
+**********************************************************/
+char AT::RegisterURCHandler(PGM_P prefix, urc_handler handler)
+{
+  byte i;
+  byte free_pos = URC_HANDLERS_LEN;
+
+  for (i = 0; i < URC_HANDLERS_LEN; i++) {
+    if (urc_handlers[i].prefix == NULL) {
+      if (free_pos == URC_HANDLERS_LEN) free_pos = i;
+    }
+    else if (urc_handlers[i].prefix == prefix) {
+      if (handler == NULL) urc_handlers[i].prefix = NULL;
+      else urc_handlers[i].handler = handler;
+      return (1);
     }
-    
   }
+  if (handler == NULL) return (1);
+  if (free_pos == URC_HANDLERS_LEN) return (-1);
+  urc_handlers[free_pos].prefix = prefix;
+  urc_handlers[free_pos].handler = handler;
+  return (1);
+}
+
+/**********************************************************
+Method dispatches pending unsolicited result codes 
+to the registered handlers
+- URC lines received outside of the responses are read 
+  out from the serial line only in case the comm. line
+  is free (in the data state bytes belong to the socket)
+- URC lines without registered handler are discarded
+- it must be called regularly (e.g. from the loop())
+
+return: 
+      num. of called handlers
+**********************************************************/
+byte AT::PollURC(void)
+{
+  char line[URC_LINE_LEN+1];
+  PGM_P prefix;
+  byte i;
+  byte ret_val = 0;
+
+  // handlers can use the comm. line so the line must be free 
+  if ((CLS_FREE != GetCommLineStatus()) || (p_at_cmd != NULL)) return (0);
 
+  transport->HoldRx(0);
+  while (Available()) ParseURCChar(Read());
+  transport->HoldRx(1);
 
+  while (PopURC(line)) {
+#ifdef AT_TRACE_ENABLED
+    if (trace != NULL) trace->AddStr(AT_TRACE_URC, line);
+#endif
+    for (i = 0; i < URC_HANDLERS_LEN; i++) {
+      prefix = urc_handlers[i].prefix;
+      if (prefix == NULL) continue;
+      if (strncmp_P(line, prefix, strlen_P(prefix))) continue;
+      urc_handlers[i].handler(line);
+      ret_val++;
+    }
+  }
   return (ret_val);
 }
 
+/**********************************************************
+Method checks whether the just finished line in the rx_line
+is unsolicited result code
+- line starting with the tag of the last sent command is
+  the response (e.g. "+CREG: 0,1" for "AT+CREG?")
+- line starting with the well known URC prefix or with the
+  prefix of the registered handler is URC
+
+return: 
+      0 - line is part of the response
+      1 - line is URC
+**********************************************************/
+byte AT::IsURCLine(void)
+{
+  PGM_P prefix;
+  byte len;
+  byte i;
+
+  len = strlen(tx_cmd_tag);
+  if (len && !strncmp(rx_line, tx_cmd_tag, len)) return (0);
+
+  prefix = urc_prefixes;
+  while ((len = strlen_P(prefix)) != 0) {
+    if (!strncmp_P(rx_line, prefix, len)) return (1);
+    prefix += len + 1;
+  }
+
+  for (i = 0; i < URC_HANDLERS_LEN; i++) {
+    prefix = urc_handlers[i].prefix;
+    if (prefix == NULL) continue;
+    if (!strncmp_P(rx_line, prefix, strlen_P(prefix))) return (1);
+  }
+  return (0);
+}
+
+/**********************************************************
+Method stores the URC line into the ring of pending lines
+- in case there is no place the oldest lines are discarded
+
+line: URC line (not finished by 0x00)
+len:  length of the line (max. URC_LINE_LEN)
+**********************************************************/
+void AT::PushURC(const char *line, byte len)
+{
+  byte ch;
+
+  URCReceived(line, len);
+  // discard the oldest lines to get the place for line + 0x00
+  while ((byte)(URC_BUF_LEN - urc_buf_used) < (byte)(len + 1)) {
+    do {
+      ch = urc_buf[urc_buf_tail];
+      if (++urc_buf_tail >= URC_BUF_LEN) urc_buf_tail = 0;
+      urc_buf_used--;
+    } while (ch != 0x00);
+    if (urc_lost_cnt < 0xff) urc_lost_cnt++;
+  }
+
+  while (1) {
+    urc_buf[urc_buf_head] = (len) ? *line++ : 0x00;
+    if (++urc_buf_head >= URC_BUF_LEN) urc_buf_head = 0;
+    urc_buf_used++;
+    if (len == 0) break;
+    len--;
+  }
+}
+
+/**********************************************************
+Method reads the oldest pending URC line from the ring
+
+line: buffer for the line (min. URC_LINE_LEN+1 characters)
+
+return: 
+      0 - there is no pending line
+      1 - line was read
+**********************************************************/
+byte AT::PopURC(char *line)
+{
+  if (urc_buf_used == 0) return (0);
+
+  do {
+    *line = urc_buf[urc_buf_tail];
+    if (++urc_buf_tail >= URC_BUF_LEN) urc_buf_tail = 0;
+    urc_buf_used--;
+  } while (*line++ != 0x00);
+  return (1);
+}
+
+/**********************************************************
+Method collects characters received outside of the response
+into lines - every finished non-empty line is URC
+**********************************************************/
+void AT::ParseURCChar(byte ch)
+{
+  if (ch == 0x0d) {
+    // <CR> is not part of the line
+  }
+  else if (ch == 0x0a) {
+    if (urc_line_len) PushURC(urc_line, urc_line_len);
+    urc_line_len = 0;
+  }
+  else if (urc_line_len < URC_LINE_LEN) {
+    urc_line[urc_line_len++] = ch;
+  }
+}
+
+#endif // end of ifdef URC_ENABLED
+
+
+#ifdef AT_CMD_TAG_ENABLED
+/**********************************************************
+Method tracks sent characters to find out the tag of 
+the last sent AT command (e.g. "+CREG" for "AT+CREG?")
+so the response of the command is not taken as URC
+and the command is counted in its class of the statistics
+- lines which do not start with "AT" (e.g. SMS text) 
+  do not change the tag
+- type of the command (e.g. AT_CMD_TYPE_QUERY) is given by
+  the characters behind the tag
+**********************************************************/
+void AT::TrackCmdTag(char ch)
+{
+  if ((ch == 0x0d) || (ch == 0x0a)) {
+    // new command line starts
+    tx_tag_pos = 0;
+  }
+  else if (tx_tag_pos == 0) {
+    tx_cmd_line = 0;
+    tx_tag_pos = ((ch == 'A') || (ch == 'a')) ? 1 : 0xff;
+  }
+  else if (tx_tag_pos == 1) {
+    if ((ch == 'T') || (ch == 't')) {
+      tx_cmd_tag[0] = 0x00;
+      tx_cmd_line = 1;
+      tx_cmd_type = AT_CMD_TYPE_EXEC;
+      tx_tag_pos = 2;
+    }
+    else tx_tag_pos = 0xff;
+  }
+  else if (tx_tag_pos == 0xfe) {
+    // "=" is followed by "?" in the test command
+    if (ch == '?') tx_cmd_type = AT_CMD_TYPE_TEST;
+    tx_tag_pos = 0xff;
+  }
+  else if (tx_tag_pos != 0xff) {
+    // tag is finished by the parameters, query or next command 
+    // (too long tag is cut, the rest is skipped up to the type)
+    if (ch == '=') {
+      tx_cmd_type = AT_CMD_TYPE_SET;
+      tx_tag_pos = 0xfe;
+    }
+    else if (ch == '?') {
+      tx_cmd_type = AT_CMD_TYPE_QUERY;
+      tx_tag_pos = 0xff;
+    }
+    else if (ch == ';') {
+      tx_tag_pos = 0xff;
+    }
+    else if (tx_tag_pos - 2 < URC_CMD_TAG_LEN) {
+      tx_cmd_tag[tx_tag_pos - 2] = ch;
+      tx_cmd_tag[tx_tag_pos - 1] = 0x00;
+      tx_tag_pos++;
+    }
+  }
+}
+
+void AT::TrackCmdTag(const char *string, byte pgm)
+{
+  char ch;
+
+  while ((ch = (pgm) ? pgm_read_byte(string) : *string) != 0x00) {
+    TrackCmdTag(ch);
+    string++;
+  }
+}
+#endif // end of ifdef AT_CMD_TAG_ENABLED
@@ -22,10 +22,16 @@
 #include "Arduino.h"
 
 #include "Setting.h"
+#include "StrView.h"
+#include "ATRespMatch.h"
+#include "ATTransport.h"
+#include "ATUartTransport.h"
+#include "StreamSearch.h"
+#include "ATTrace.h"
 
 
 
-#define AT_LIB_VERSION 104 // library version X.YY (e.g. 1.00) 100 means 1.00
+#define AT_LIB_VERSION 124 // library version X.YY (e.g. 1.00) 100 means 1.00
 /*
     Version
     -------------------------------------------------------------------------------
@@ -56,11 +62,139 @@
                           - FindUntil() added
                           - SendATCmdWaitRespF
     -------------------------------------------------------------------------------
+    105                   - reception of the response is finished immediately when
+                            a final result code (OK, ERROR, +CME ERROR, +CMS ERROR,
+                            NO CARRIER, CONNECT, "> " prompt...) is received
+                            so inter-character tmout is not waited any more
+                          - SetRespFinishMode(), GetRespFinishMode() added
+                            (RESP_FINISH_TMOUT keeps the old behaviour)
+                          - GetFinalResultCode() added
+    -------------------------------------------------------------------------------
+    106                   - non-blocking AT command engine: command is described
+                            by the ATCmd structure, started by SubmitATCmd() or
+                            StartATCmd() and processed by PollATCmd() called
+                            from the loop()
+                          - WaitResp(), SendATCmdWaitResp(), SendATCmdWaitRespF()
+                            are now blocking wrappers over the engine (RunATCmd())
+    -------------------------------------------------------------------------------
+    107                   - priority queue of AT commands: SubmitATCmd() enqueues
+                            the command in case the comm. line is busy
+                          - AcquireCommLine() waits until the comm. line is free
+                            instead of immediate rejection
+                          - queue statistics (GetATCmdQueueStats())
+    -------------------------------------------------------------------------------
+    108                   - batch of AT commands (ATBatch) - commands are 
+                            concatenated into one command line "AT...;...;..." 
+                            and sent separately only in case of error
+    -------------------------------------------------------------------------------
+    109                   - URC dispatcher (URC_ENABLED in Setting.h): unsolicited
+                            lines are removed from the response in comm_buf, 
+                            stored in the ring of pending events and passed to 
+                            the handlers registered by RegisterURCHandler() 
+                            from PollURC()
+    -------------------------------------------------------------------------------
+    110                   - zero-copy tokenizer of the responses (StrView.h),
+                            GetRespView() returns view of the comm. buffer
+    -------------------------------------------------------------------------------
+    111                   - multi-pattern response classifier (ATMatch.h), 
+                            SetRespClassifier() classifies the response while
+                            it is being received, GetRespClass() returns result
+    -------------------------------------------------------------------------------
+    112                   - all characters go through the ATTransport (ATTransport.h)
+                            so the GSM module can be connected also to other serial
+                            port or to the tty on Linux, see SetTransport()
+                          - FindUntil(), ReadBytes() and ReadBytesUntil() are 
+                            implemented by the AT class
+                          - rest of the previous response is read out before 
+                            the command is sent (not after), so the fast response
+                            is not lost - also after "+++" or the SMS text
+    -------------------------------------------------------------------------------
+    113                   - statistics of the serial line (GetLinkStats()):
+                            sent and received characters, round trips and
+                            time spent by waiting for the timeouts
+    -------------------------------------------------------------------------------
+    114                   - serial traffic can be recorded to the capture file
+                            (ATRecordTransport) and replayed to the library
+                            instead of the GSM module (ATReplayTransport),
+                            see ATCapture.h
+    -------------------------------------------------------------------------------
+    115                   - statistics of the AT commands by the command class
+                            (e.g. +CREG, #SGACT): counts, retries, timeouts,
+                            different responses and latency histograms,
+                            see GetCmdStats(), PrintCmdStats(), FormatCmdStats()
+                            (AT_CMD_STATS_ENABLED in Setting.h)
+    -------------------------------------------------------------------------------
+    116                   - adaptive timeouts: start and inter-character timeouts
+                            of the command class (tag and type e.g. "+CREG" query)
+                            are derived from the observed latency (smoothed 
+                            value + 4 x variation like TCP RTO),
+                            see SetTmoutMode() (AT_ADAPTIVE_TMOUT_ENABLED in Setting.h)
+    -------------------------------------------------------------------------------
+    117                   - baud rate autodetection: TurnOn() finds the baud rate
+                            of the module before it is switched off and on,
+                            UpshiftBaudRate() changes it to the highest rate
+                            which passes the check (see SetMaxBaudRate()),
+                            repeated line errors return it to the lower rate
+                            (AT_AUTOBAUD_ENABLED in Setting.h)
+    -------------------------------------------------------------------------------
+    118                   - RTS/CTS hardware flow control: SetFlowControl(),
+                            ATFlowSerialTransport (RTS/CTS on the digital pins),
+                            CRTSCTS of ATFdTransport, the module is set by AT&K
+                            in InitParam(), RTS is asserted only while the
+                            library reads (HoldRx()), ATUartTransport drives
+                            RTS from the receive interrupt
+    -------------------------------------------------------------------------------
+    119                   - retry policies of the AT commands (ATRetryPolicy):
+                            exponential backoff with jitter, retry only on timeout,
+                            permanent +CME/+CMS ERRORs are not retried
+                            (see SetRetryPolicy(), SetATCmdRetry(), IsPermanentError()),
+                            max. duration of the library operation (SetOpDeadline())
+    -------------------------------------------------------------------------------
+    120                   - trace of the library events (ATTrace.h): compact binary
+                            records in the RAM ring buffer passed to the sink
+                            (Print e.g. SoftwareSerial, EEPROM, file) only by
+                            ATTrace::Flush(), see SetTrace() (AT_TRACE_ENABLED 
+                            in Setting.h)
+                          - DebugPrint() adds the text to the trace instead of 
+                            sending it to the GSM module followed by "AT"
+    -------------------------------------------------------------------------------
+    121                   - AT commands with parameters are composed while they
+                            are sent (ATCmdLine.h): ATLine() of the Flash fragments
+                            ATF() and the typed parameters, SendATCmdWaitResp()
+                            and SetATCmdLine() accept it, the GSM and GPS methods
+                            do not build the commands in the buffers on the stack
+    -------------------------------------------------------------------------------
+    122                   - AT commands described in the Flash memory (ATCmdDesc:
+                            command, expected response, timeout class, attempts,
+                            parser) run by RunATCmdDesc(), RunATCmdSeq(), 
+                            ExecATCmdDesc(), SetupATCmdDesc() and BatchAddDesc()
+                          - ATCMD_FLAG_PGM_RESP - response string in the Flash memory
+    -------------------------------------------------------------------------------
+    123                   - URCReceived() - every URC line is passed to the derived
+                            class before it is queued (URC_ENABLED)
+    -------------------------------------------------------------------------------
+    124                   - ring buffer of the received characters filled by
+                            the interrupt or thread (ATRxRing.h) is read directly
+                            by the AT class (ATTransport::GetRxRing())
+                          - ATUartTransport - USART0 with own receive interrupt
+                            (AT_UART_ISR_ENABLED in Setting.h)
+                          - ATFdTransport::StartRxThread() - reader thread
+    -------------------------------------------------------------------------------
     
 */
 
 
 
+// serial port used by default (see also SetTransport())
+#ifndef AT_SERIAL_PORT
+  #define AT_SERIAL_PORT Serial
+#endif // end of ifndef AT_SERIAL_PORT
+
+// timeout for ReadBytes() and ReadBytesUntil() in msec.
+#ifndef AT_READ_TMOUT
+  #define AT_READ_TMOUT                 1000
+#endif // end of ifndef AT_READ_TMOUT
+
 // length for the internal communication buffer
 #ifndef COMM_BUF_LEN
 	#define COMM_BUF_LEN        200
@@ -104,11 +238,179 @@
 	#define AT_DELAY                        500
 #endif // end of ifndef AT_DELAY
 
+// retry policy at_retry_backoff: delay before the second attempt
+// and the limit of the growing delay in msec.
+#ifndef AT_RETRY_BACKOFF_DELAY
+	#define AT_RETRY_BACKOFF_DELAY          250
+#endif // end of ifndef AT_RETRY_BACKOFF_DELAY
+
+#ifndef AT_RETRY_BACKOFF_MAX_DELAY
+	#define AT_RETRY_BACKOFF_MAX_DELAY      4000
+#endif // end of ifndef AT_RETRY_BACKOFF_MAX_DELAY
+
+// max. number of AT commands waiting for the comm. line
+#ifndef ATCMD_QUEUE_LEN
+	#define ATCMD_QUEUE_LEN                 4
+#endif // end of ifndef ATCMD_QUEUE_LEN
+
+// max. number of AT commands in one batch (ATBatch)
+#ifndef ATCMD_BATCH_LEN
+	#define ATCMD_BATCH_LEN                 10
+#endif // end of ifndef ATCMD_BATCH_LEN
+
+// max. length of the concatenated command line (without <CR>)
+#ifndef ATCMD_BATCH_LINE_LEN
+	#define ATCMD_BATCH_LINE_LEN            80
+#endif // end of ifndef ATCMD_BATCH_LINE_LEN
+
+// max. length of the command line accepted by the module (without <CR>),
+// longer ATLine() commands are refused by the compiler (see ATCmdLine.h)
+#ifndef AT_CMD_LINE_MAX_LEN
+	#define AT_CMD_LINE_MAX_LEN             400
+#endif // end of ifndef AT_CMD_LINE_MAX_LEN
+
+#if ATCMD_BATCH_LINE_LEN > AT_CMD_LINE_MAX_LEN
+	#error "ATCMD_BATCH_LINE_LEN must not exceed AT_CMD_LINE_MAX_LEN"
+#endif
+
+// max. time in msec. AcquireCommLine() waits for the comm. line
+#ifndef COMM_LINE_ACQUIRE_TMOUT
+	#define COMM_LINE_ACQUIRE_TMOUT         20000
+#endif // end of ifndef COMM_LINE_ACQUIRE_TMOUT
+
 
 // some constants for the IsRxFinished() method
 #define RX_NOT_STARTED      0
 #define RX_ALREADY_STARTED  1
 
+// some constants for the PollATCmd() method
+#define ATCMD_STEP_SEND     0
+#define ATCMD_STEP_WAIT     1
+#define ATCMD_STEP_DELAY    2
+
+// flags of the AT command descriptor(ATCmd)
+#define ATCMD_FLAG_PGM            0x01  // AT command string is placed in the Flash memory
+#define ATCMD_FLAG_DATA           0x02  // data(GPRS) reception - rx buffer is not flushed
+                                        // and reading is stopped when comm. buffer is full
+#define ATCMD_FLAG_FINISH_ON_RESP 0x04  // reception is finished immediately when 
+                                        // the response string is received
+#define ATCMD_FLAG_PGM_RESP       0x08  // response string is placed in the Flash memory
+
+// failures which are retried by the retry policy (ATRetryPolicy)
+#define ATRETRY_ON_TMOUT          0x01  // nothing was received
+#define ATRETRY_ON_DIF_RESP       0x02  // different response without an error (e.g. "+CREG: 0,2")
+#define ATRETRY_ON_ERROR          0x04  // ERROR, NO CARRIER, BUSY... or +CME/+CMS ERROR
+                                        // which is not known as permanent
+#define ATRETRY_ON_PERM_ERROR     0x08  // +CME/+CMS ERROR known as permanent 
+                                        // (e.g. SIM not inserted, see IsPermanentError())
+#define ATRETRY_ON_ALL            0x0f
+
+
+// modes for finishing of the response reception
+#define RESP_FINISH_TMOUT         0 // reception is finished only by the inter-character tmout
+#define RESP_FINISH_RESULT_CODE   1 // reception is finished immediately when the final
+                                    // result code is received (or by the tmout as before)
+
+#ifndef RESP_FINISH_DEFAULT_MODE
+	#define RESP_FINISH_DEFAULT_MODE        RESP_FINISH_RESULT_CODE
+#endif // end of ifndef RESP_FINISH_DEFAULT_MODE
+
+// length of the line buffer used for the detection of final result codes
+// (the longest final result code "+CME ERROR:" has 11 characters)
+#ifndef RX_LINE_LEN
+	#define RX_LINE_LEN                     12
+#endif // end of ifndef RX_LINE_LEN
+
+// max. length of one URC line (longer lines are truncated)
+#ifndef URC_LINE_LEN
+	#define URC_LINE_LEN                    32
+#endif // end of ifndef URC_LINE_LEN
+
+// size of the ring buffer for pending URC lines
+#ifndef URC_BUF_LEN
+	#define URC_BUF_LEN                     48
+#endif // end of ifndef URC_BUF_LEN
+
+// one URC line incl. its 0x00 must fit into the ring, otherwise
+// PushURC() could never make room for it by discarding the oldest lines
+#if (URC_LINE_LEN + 1) > URC_BUF_LEN
+	#error "URC_BUF_LEN must be at least URC_LINE_LEN + 1"
+#endif
+
+// max. number of registered URC handlers
+#ifndef URC_HANDLERS_LEN
+	#define URC_HANDLERS_LEN                4
+#endif // end of ifndef URC_HANDLERS_LEN
+
+// max. length of the command tag (e.g. "+CREG" from "AT+CREG?")
+#ifndef URC_CMD_TAG_LEN
+	#define URC_CMD_TAG_LEN                 6
+#endif // end of ifndef URC_CMD_TAG_LEN
+
+// max. number of command classes in the statistics of the AT commands
+// (the last one collects the commands which did not fit to the others)
+#ifndef AT_CMD_STATS_LEN
+	#define AT_CMD_STATS_LEN                8
+#endif // end of ifndef AT_CMD_STATS_LEN
+
+// num. of buckets of the latency histograms
+// bucket 0: < 1 msec., bucket i: 2^(i-1) .. 2^i - 1 msec.,
+// the last bucket contains also all longer times
+#ifndef AT_CMD_HIST_LEN
+	#define AT_CMD_HIST_LEN                 14
+#endif // end of ifndef AT_CMD_HIST_LEN
+
+// num. of command classes with the learned timeouts
+// (the least used class is replaced when the table is full)
+#ifndef AT_ADAPT_EST_LEN
+	#define AT_ADAPT_EST_LEN                8
+#endif // end of ifndef AT_ADAPT_EST_LEN
+
+// num. of responses of the command class before the timeouts are adapted
+#ifndef AT_ADAPT_MIN_SAMPLES
+	#define AT_ADAPT_MIN_SAMPLES            4
+#endif // end of ifndef AT_ADAPT_MIN_SAMPLES
+
+// lower limits of the adapted timeouts in msec. (upper limits are
+// the timeouts given by the caller)
+#ifndef AT_ADAPT_MIN_START_TMOUT
+	#define AT_ADAPT_MIN_START_TMOUT        100
+#endif // end of ifndef AT_ADAPT_MIN_START_TMOUT
+
+#ifndef AT_ADAPT_MIN_INTERCHAR_TMOUT
+	#define AT_ADAPT_MIN_INTERCHAR_TMOUT    MAX_INTERCHAR_TMOUT
+#endif // end of ifndef AT_ADAPT_MIN_INTERCHAR_TMOUT
+
+// timeout in msec. of the response to "AT" when the baud rate is tested
+#ifndef AT_AUTOBAUD_PROBE_TMOUT
+	#define AT_AUTOBAUD_PROBE_TMOUT         100
+#endif // end of ifndef AT_AUTOBAUD_PROBE_TMOUT
+
+// num. of "AT" which must be answered by the clean "OK" after the baud rate
+// is changed
+#ifndef AT_BAUD_CHECK_CNT
+	#define AT_BAUD_CHECK_CNT               3
+#endif // end of ifndef AT_BAUD_CHECK_CNT
+
+// num. of consecutive commands with the line errors (damaged response,
+// errors reported by the transport) which return the raised baud rate
+// to the next lower one, commands without any response are not counted
+#ifndef AT_BAUD_FALLBACK_ERR_CNT
+	#define AT_BAUD_FALLBACK_ERR_CNT        3
+#endif // end of ifndef AT_BAUD_FALLBACK_ERR_CNT
+
+// tag of the sent command is needed by the URC dispatcher,
+// by the statistics of the AT commands and by the adaptive timeouts
+#if defined(URC_ENABLED) || defined(AT_CMD_STATS_ENABLED) || defined(AT_ADAPTIVE_TMOUT_ENABLED)
+	#define AT_CMD_TAG_ENABLED
+#endif
+
+// latency of the commands is measured for the statistics
+// and for the adaptive timeouts
+#if defined(AT_CMD_STATS_ENABLED) || defined(AT_ADAPTIVE_TMOUT_ENABLED)
+	#define AT_CMD_TIMING_ENABLED
+#endif
+
 
 enum comm_line_status_enum 
 {
@@ -132,8 +434,37 @@ enum rx_state_enum
 };
 
 
+enum final_result_code_enum
+{
+  FRC_NONE = 0,     // final result code was not received (yet)
+  FRC_OK,           // OK
+  FRC_ERROR,        // ERROR
+  FRC_CME_ERROR,    // +CME ERROR: <err>
+  FRC_CMS_ERROR,    // +CMS ERROR: <err>
+  FRC_NO_CARRIER,   // NO CARRIER
+  FRC_CONNECT,      // CONNECT [<text>]
+  FRC_BUSY,         // BUSY
+  FRC_NO_ANSWER,    // NO ANSWER
+  FRC_NO_DIALTONE,  // NO DIALTONE
+  FRC_PROMPT,       // "> " prompt (only in case it is expected)
+
+  FRC_LAST_ITEM
+};
+
+// SMS texts in the response (see CheckRxLine())
+enum rx_text_enum
+{
+  RX_TEXT_NONE = 0, // no +CMGR:/+CMGL: header received
+  RX_TEXT_LINE,     // the next line is the text of the SMS
+  RX_TEXT_LISTING,  // text was received, other lines are not URC
+
+  RX_TEXT_LAST_ITEM
+};
+
+
 enum at_resp_enum 
 {
+  AT_RESP_ERR_QUEUE_TMOUT = -2, // deadline expired before the command was sent
   AT_RESP_ERR_NO_RESP = -1,   // nothing received
   AT_RESP_ERR_DIF_RESP = 0,   // response_string is different from the response
   AT_RESP_OK = 1,             // response_string was included in the response
@@ -142,6 +473,213 @@ enum at_resp_enum
 };
 
 
+enum at_cmd_state_enum 
+{
+  ATCMD_IDLE = 0,       // command was not started yet
+  ATCMD_BUSY,           // command is in progress (sent, response or repetition is awaited)
+  ATCMD_FINISHED,       // command is finished, result is available
+  ATCMD_QUEUED,         // command waits in the queue for the comm. line
+
+  ATCMD_LAST_ITEM
+};
+
+
+// type of the AT command (see FindTmoutEst())
+enum at_cmd_type_enum
+{
+  AT_CMD_TYPE_EXEC = 0, // e.g. "ATD", "AT+CMGD" (also when the type is unknown)
+  AT_CMD_TYPE_SET,      // e.g. "AT+CREG=1"
+  AT_CMD_TYPE_QUERY,    // e.g. "AT+CREG?"
+  AT_CMD_TYPE_TEST,     // e.g. "AT+CREG=?"
+
+  AT_CMD_TYPE_LAST_ITEM
+};
+
+enum at_tmout_mode_enum
+{
+  AT_TMOUT_FIXED = 0,   // timeouts given by the caller are used
+  AT_TMOUT_ADAPTIVE,    // timeouts are derived from the observed latency
+
+  AT_TMOUT_LAST_ITEM
+};
+
+
+// timeouts of the AT command described by ATCmdDesc
+enum at_tmout_class_enum
+{
+  AT_TMOUT_CLASS_SHORT = 0,   // START_SHORT_COMM_TMOUT, MAX_INTERCHAR_TMOUT e.g. GPIO
+  AT_TMOUT_CLASS_LONG,        // START_LONG_COMM_TMOUT, MAX_MID_INTERCHAR_TMOUT e.g. settings
+  AT_TMOUT_CLASS_XLONG,       // START_XLONG_COMM_TMOUT, MAX_MID_INTERCHAR_TMOUT e.g. GPS
+  AT_TMOUT_CLASS_NET,         // 10 sec., 1 sec. e.g. GPRS context
+
+  AT_TMOUT_CLASS_LAST_ITEM
+};
+
+
+enum at_cmd_prio_enum 
+{
+  ATCMD_PRIO_HIGH = 0,  // e.g. call handling
+  ATCMD_PRIO_NORMAL,    // e.g. SMS, GPRS, telemetry
+  ATCMD_PRIO_LOW,       // e.g. housekeeping (GPIO, temperature, registration)
+
+  ATCMD_PRIO_LAST_ITEM
+};
+
+
+// retry policy of the AT commands (see SetRetryPolicy(), SetATCmdRetry())
+// - delay before the attempt n+1 is delay * backoff^(n-1) limited 
+//   by max_delay and extended by random 0..jitter % 
+struct ATRetryPolicy
+{
+  uint16_t delay;                 // delay before the second attempt in msec.
+  uint16_t max_delay;             // limit of the growing delay in msec.
+  byte backoff;                   // multiplier of the delay (1 - constant delay)
+  byte jitter;                    // max. random extension of the delay in %
+  byte retry_on;                  // ATRETRY_ON_xxx - failures which are retried
+};
+
+// predefined retry policies
+extern const ATRetryPolicy at_retry_fixed;    // AT_DELAY, everything is retried (default)
+extern const ATRetryPolicy at_retry_backoff;  // exponential backoff with jitter,
+                                              // permanent errors are not retried
+extern const ATRetryPolicy at_retry_tmout;    // AT_DELAY, only timeout is retried
+
+
+// AT command composed while it is sent (see ATCmdLine.h)
+class AT;
+class ATCmdBuilder
+{
+  public:
+    virtual void Send(AT *at) const = 0;
+};
+
+
+// descriptor of the AT command processed by the non-blocking engine
+// the descriptor must exist until the command is finished
+struct ATCmd;
+typedef void (*at_cmd_callback)(struct ATCmd *cmd);
+
+struct ATCmd
+{
+  // filled in by the user (see SetupATCmd())
+  const char *AT_cmd_string;      // AT command (NULL - only response is awaited)
+  const char *response_string;    // expected response (NULL - not checked)
+  uint16_t start_comm_tmout;      // max. waiting time for the first character in msec.
+  uint16_t max_interchar_tmout;   // max. tmout between incoming characters in msec.
+  byte no_of_attempts;            // how many times the command is sent
+  byte flags;                     // ATCMD_FLAG_xxx
+  at_cmd_callback callback;       // called when command is finished (can be NULL)
+  byte priority;                  // at_cmd_prio_enum (see SetATCmdPriority())
+  uint16_t deadline;              // max. waiting time in the queue in msec. (0 - no limit)
+  const ATRetryPolicy *retry;     // retry policy (NULL - policy of the AT class)
+  const ATCmdBuilder *line;       // AT command sent instead of AT_cmd_string (can be NULL)
+
+  // filled in by the engine
+  byte state;                     // at_cmd_state_enum
+  char result;                    // at_resp_enum
+  byte rx_status;                 // rx_state_enum of the last reception
+  unsigned long queue_time;       // time when the command was enqueued
+};
+
+
+// AT command described in the Flash memory (see RunATCmdDesc())
+// e.g. static const ATCmdDesc desc_gpsav PROGMEM = 
+//        {gps_cmd_gpsav, gps_resp_gpsav, AT_TMOUT_CLASS_XLONG, 1, AT::ParseDescNum};
+struct ATCmdDesc;
+// parser of the response of the command which has been finished by AT_RESP_OK
+// desc: copy of the descriptor in the RAM, resp: whole response, 
+// ctx: pointer given to RunATCmdDesc()
+// return: value returned by RunATCmdDesc() (usually 1 - OK, 0 - response is not valid)
+typedef char (*at_desc_parser)(const ATCmdDesc *desc, StrView *resp, void *ctx);
+
+struct ATCmdDesc
+{
+  PGM_P AT_cmd_string;            // AT command
+  PGM_P response_string;          // expected response (NULL - not checked)
+  byte tmout_class;               // at_tmout_class_enum
+  byte no_of_attempts;            // max. number of attempts
+  at_desc_parser parser;          // parser of the response (NULL - 1 is returned)
+};
+
+
+// handler of the unsolicited result code
+// line: whole URC line without <CR><LF>, e.g. "+CMTI: \"SM\",3"
+typedef void (*urc_handler)(const char *line);
+
+struct URCHandler
+{
+  PGM_P prefix;                   // e.g. PSTR("+CMTI:")
+  urc_handler handler;
+};
+
+
+// one AT command of the batch
+struct ATBatchItem
+{
+  const char *AT_cmd_string;      // whole AT command e.g. "AT+CMGF=1"
+  uint16_t start_comm_tmout;      // max. waiting time for the first character in msec.
+  byte flags;                     // ATCMD_FLAG_PGM
+};
+
+// batch of AT commands (see BatchRun())
+struct ATBatch
+{
+  ATBatchItem item[ATCMD_BATCH_LEN];
+  byte len;                       // num. of commands in the batch
+};
+
+
+// statistics of the comm. line usage for one priority
+struct ATCmdQueueStats
+{
+  uint16_t served;                // num. of requests which got the comm. line
+  uint16_t waited;                // num. of requests which had to wait for the comm. line
+  uint16_t rejected;              // num. of requests rejected (queue full, line occupied)
+  uint16_t expired;               // num. of requests with expired deadline
+  uint16_t max_wait;              // max. waiting time in msec.
+  unsigned long total_wait;       // sum of all waiting times in msec.
+};
+
+// statistics of the serial line (see GetLinkStats())
+struct ATLinkStats
+{
+  unsigned long tx_bytes;         // characters sent to the GSM module
+  unsigned long rx_bytes;         // characters read from the GSM module
+  unsigned long round_trips;      // num. of receptions (responses waited for)
+  unsigned long start_tmouts;     // receptions without any response
+  unsigned long tmout_wait;       // time spent by waiting for the timeouts in msec.
+};
+
+// statistics of one class of the AT commands (see GetCmdStats())
+// every attempt of the command is one sample, the latency is measured
+// from the beginning of the command line
+struct ATCmdClassStats
+{
+  char tag[URC_CMD_TAG_LEN+1];    // e.g. "+CREG", "" - plain AT, "*" - other commands
+  uint16_t count;                 // num. of commands
+  uint16_t retries;               // num. of repeated attempts
+  uint16_t tmouts;                // attempts without any response
+  uint16_t dif_resps;             // attempts with different response than expected
+  uint16_t first_hist[AT_CMD_HIST_LEN]; // time to the first character of the response
+  uint16_t done_hist[AT_CMD_HIST_LEN];  // time to the end of the reception
+};
+
+// learned latency of one class of the AT commands (see FindTmoutEst())
+// the values are scaled like in the TCP RTO estimator (RFC 6298)
+// query and set command with the same tag are different classes
+// (e.g. "AT#GPRS?" is answered at once, "AT#GPRS=1" after seconds)
+struct ATTmoutEst
+{
+  char tag[URC_CMD_TAG_LEN+1];    // e.g. "+CREG", "" - plain AT
+  byte type;                      // at_cmd_type_enum
+  byte samples;                   // num. of responses (saturated at 0xff)
+  unsigned long srtt8;            // smoothed time to the first character x 8 (msec.)
+  unsigned long rttvar4;          // its mean variation x 4 (msec.)
+  uint16_t gap8;                  // smoothed max. gap between characters x 8 (msec.)
+  uint16_t gapvar4;               // its mean variation x 4 (msec.)
+};
+
+
 
 class AT
 {
@@ -161,6 +699,12 @@ class AT
     void BlinkDebugLED (byte num_of_blink);
 #endif
 
+#ifdef AT_TRACE_ENABLED
+    // trace of the library events (NULL - no trace), see ATTrace.h
+    inline void SetTrace(ATTrace *new_trace) {trace = new_trace;};
+    inline ATTrace *GetTrace(void) {return trace;};
+#endif
+
 #ifdef DEBUG_PRINT
     void DebugPrint(const char *string_to_print, byte last_debug_print);
     void DebugPrintF(PGM_P string_to_print, byte last_debug_print);
@@ -169,10 +713,46 @@ class AT
 
     // serial line initialization
     void InitSerLine(long baud_rate);
+    inline long GetBaudRate(void) {return actual_baud_rate;};
+#ifdef AT_AUTOBAUD_ENABLED
+    // baud rate autodetection (max. baud rate must be set after InitSerLine())
+    inline void SetMaxBaudRate(long baud_rate) {max_baud_rate = baud_rate;};
+    inline long GetMaxBaudRate(void) {return max_baud_rate;};
+    inline byte GetBaudFallbackCnt(void) {return baud_fallback_cnt;};
+    long DetectBaudRate(void);
+    char ChangeBaudRate(long baud_rate);
+    long UpshiftBaudRate(void);
+#endif
+    // transport of the characters (must be set before InitSerLine())
+    inline void SetTransport(ATTransport *new_transport) {
+      transport = new_transport;
+      rx_ring = transport->GetRxRing();
+    };
+    inline ATTransport *GetTransport(void) {return transport;};
+    // RTS/CTS hardware flow control (must be set after InitSerLine() and
+    // before TurnOn() which sets the module by AT&K)
+    char SetFlowControl(byte on);
+    inline byte GetFlowControl(void) {return flow_control;};
+    // the reception is held whenever the library does not read (the module
+    // stops sending in case the flow control is on), HoldRx(0) releases it
+    // for the program which reads by Available() and Read() itself
+    inline void HoldRx(byte hold) {transport->HoldRx(hold);};
     // set comm. line status
-    inline void SetCommLineStatus(byte new_status) {comm_line_status = new_status;};
+    // (response classifier belongs to the owner of the comm. line so it is
+    // switched off when the comm. line is released)
+    inline void SetCommLineStatus(byte new_status) {
+      comm_line_status = new_status;
+      // the operation (see SetOpDeadline()) ends by release of the comm. line
+      if (new_status != CLS_ATCMD) op_active = 0;
+      if (new_status == CLS_FREE) ATMatchInit(&rx_match, NULL);
+    };
     // get comm. line status
     inline byte GetCommLineStatus(void) {return comm_line_status;};
+    // set/get the way how the reception of the response is finished
+    inline void SetRespFinishMode(byte new_mode) {resp_finish_mode = new_mode;};
+    inline byte GetRespFinishMode(void) {return resp_finish_mode;};
+    // final result code of the last response
+    inline byte GetFinalResultCode(void) {return rx_final_code;};
     
     
     
@@ -186,19 +766,28 @@ class AT
     void PrintlnF(PGM_P string);
     void Print(long long_value);
     void Println(long long_value);
+    void Println(const ATCmdBuilder &line);
     int  Read(void); // the same like read() in Serial
     void Flush(void); // the same like flush() in Serial
     int  Available(void); // the same like available() in Serial
 
-    bool FindUntil(char *target, char *terminator, unsigned long timeout); // the same like findUntil() + setTimeout() in serial
+    bool FindUntil(const char *target, const char *terminator, unsigned long timeout); // the same like findUntil() + setTimeout() in serial
     size_t ReadBytes(char *buffer, size_t length);
     int  ReadBytesUntil(char terminator, char *buffer, size_t length);
+    int  TimedRead(unsigned long timeout);
 
 
     void RxInit(uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
                 byte flush_before_read, byte read_when_buffer_full);
     byte IsRxFinished(void);
     byte IsStringReceived(char const *compare_string);
+    byte IsStringReceivedF(PGM_P compare_string);
+    // view of the received response for the parsing (see StrView.h)
+    inline void GetRespView(StrView *view) {SVInit(view, (const char *)comm_buf, comm_buf_len);};
+    // classification of the response by the pattern set (see ATMatch.h)
+    void SetRespClassifier(const ATMatchSet *set);
+    inline char GetRespClass(void) {return ATMatchBest(&rx_match);};
+    inline byte IsRespClass(byte pattern) {return ((rx_match.st.matched >> pattern) & 1);};
     byte WaitResp(uint16_t start_comm_tmout, uint16_t max_interchar_tmout);
     byte WaitResp(uint16_t start_comm_tmout, uint16_t max_interchar_tmout, 
                   char const *expected_resp_string);
@@ -212,8 +801,119 @@ class AT
                 char const *response_string,
                 byte no_of_attempts);
 
+    char SendATCmdWaitResp(const ATCmdBuilder &line,
+               uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
+               char const *response_string,
+               byte no_of_attempts);
+
+    // non-blocking AT command engine
+    void SetupATCmd(ATCmd *cmd, const char *AT_cmd_string, byte flags,
+                    uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
+                    const char *response_string, byte no_of_attempts,
+                    at_cmd_callback callback);
+    char SubmitATCmd(ATCmd *cmd);
+    char StartATCmd(ATCmd *cmd);
+    byte PollATCmd(void);
+    char RunATCmd(ATCmd *cmd);
+    inline byte IsATCmdBusy(void) {return (p_at_cmd != NULL);};
+    inline void SetATCmdPriority(ATCmd *cmd, byte priority, uint16_t deadline) 
+                  {cmd->priority = priority; cmd->deadline = deadline;};
+    inline void SetATCmdRetry(ATCmd *cmd, const ATRetryPolicy *policy) {cmd->retry = policy;};
+    // AT command composed while it is sent, the line must exist until
+    // the command is finished (see ATCmdLine.h)
+    inline void SetATCmdLine(ATCmd *cmd, const ATCmdBuilder *line) {cmd->line = line;};
+
+    // AT commands described in the Flash memory (ATCmdDesc)
+    void SetupATCmdDesc(ATCmd *cmd, const ATCmdDesc *desc, at_cmd_callback callback);
+    char ExecATCmdDesc(const ATCmdDesc *desc, void *ctx);
+    char RunATCmdDesc(const ATCmdDesc *desc, byte priority, void *ctx);
+    char RunATCmdSeq(const ATCmdDesc *seq, byte cnt, byte priority, void *ctx);
+    static char ParseDescNum(const ATCmdDesc *desc, StrView *resp, void *ctx);
+
+    // retry policy of the commands without their own policy
+    inline void SetRetryPolicy(const ATRetryPolicy *policy) {retry_policy = policy;};
+    inline const ATRetryPolicy *GetRetryPolicy(void) {return retry_policy;};
+    // max. duration of the operation in msec. (0 - no limit), the operation 
+    // is the library method which occupies the comm. line by AcquireCommLine()
+    // e.g. InitGPRS(), no attempt is started after the deadline
+    inline void SetOpDeadline(uint16_t deadline) {op_deadline = deadline;};
+    inline uint16_t GetOpDeadline(void) {return op_deadline;};
+    // error code of the +CME/+CMS ERROR in the last response (-1 - none)
+    int GetErrorCode(void);
+    byte IsPermanentError(void);
+
+    // batch of AT commands
+    void BatchInit(ATBatch *batch);
+    char BatchAdd(ATBatch *batch, char const *AT_cmd_string, uint16_t start_comm_tmout);
+    char BatchAddF(ATBatch *batch, PGM_P AT_cmd_string, uint16_t start_comm_tmout);
+    char BatchAddDesc(ATBatch *batch, const ATCmdDesc *desc);
+    byte BatchRun(ATBatch *batch, uint16_t max_interchar_tmout, byte no_of_attempts);
+
+#ifdef URC_ENABLED
+    // unsolicited result codes
+    char RegisterURCHandler(PGM_P prefix, urc_handler handler);
+    byte PollURC(void);
+    inline byte GetURCLostCnt(void) {return urc_lost_cnt;};
+    // called for every URC line before it is queued for PollURC()
+    // so the derived class can react immediately (e.g. GSM cache)
+    virtual void URCReceived(const char *, byte) {};
+#endif
+
+    // priority queue of the comm. line users
+    byte AcquireCommLine(byte priority);
+    inline byte GetATCmdQueueLen(void) {return at_cmd_queue_len;};
+    inline byte GetATCmdQueueMaxLen(void) {return at_cmd_queue_max_len;};
+    const ATCmdQueueStats *GetATCmdQueueStats(byte priority);
+    void ResetATCmdQueueStats(void);
+
+    // statistics of the serial line
+    inline const ATLinkStats *GetLinkStats(void) {return &link_stats;};
+    void ResetLinkStats(void);
+
+#ifdef AT_CMD_STATS_ENABLED
+    // statistics of the AT commands
+    inline byte GetCmdStatsCnt(void) {return cmd_stats_cnt;};
+    const ATCmdClassStats *GetCmdStats(byte index);
+    const ATCmdClassStats *FindCmdStats(const char *tag);
+    void ResetCmdStats(void);
+    void PrintCmdStats(::Print &out);
+    byte FormatCmdStats(char *buffer, uint16_t size, byte first_index);
+    static byte CmdHistPercentile(const uint16_t *hist, byte percent);
+    static unsigned long CmdHistLimit(byte bucket);
+#endif
+
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+    // adaptive timeouts
+    inline void SetTmoutMode(byte new_mode) {tmout_mode = new_mode;};
+    inline byte GetTmoutMode(void) {return tmout_mode;};
+    const ATTmoutEst *FindTmoutEst(const char *tag, byte type);
+    void ResetTmoutEst(void);
+    void GetAdaptedTmouts(const ATTmoutEst *est, uint16_t *start_comm_tmout,
+                          uint16_t *max_interchar_tmout);
+#endif
+
   private:
     byte comm_line_status;
+    ATTransport *transport;         // all characters go through the transport
+    ATRxRing *rx_ring;              // ring of the transport read directly (NULL - none)
+#ifdef AT_TRACE_ENABLED
+    ATTrace *trace;                 // events of the library are added to the trace
+    byte tx_trace_len;              // num. of characters in tx_trace_line
+    char tx_trace_line[AT_TRACE_DATA_LEN]; // beginning of the currently sent line
+
+    void TraceTx(const byte *data, size_t size);
+#endif
+    byte flow_control;              // 1 - RTS/CTS flow control is on
+    unsigned long read_tmout;       // timeout of ReadBytes() in msec.
+    byte tx_line_start;             // 1 - next sent character starts new line
+    byte rx_drained;                // 1 - rest of the previous response was read out
+                                    //     or the command was already sent
+    ATLinkStats link_stats;
+
+    void StartTx(void);
+    void TxWrite(byte ch);
+    void TxWrite(const byte *data, size_t size);
+    void DrainRx(void);
 
     // variables connected with communication buffer
     byte *p_comm_buf;               // pointer to the communication buffer   
@@ -222,6 +922,133 @@ class AT
     uint16_t interchar_tmout;       // previous time in msec.
     unsigned long prev_time;        // previous time in msec.
     byte  flag_read_when_buffer_full; // flag
+
+    // variables connected with the detection of final result codes
+    byte resp_finish_mode;          // RESP_FINISH_TMOUT or RESP_FINISH_RESULT_CODE
+    byte rx_finish_mode;            // mode used for the current reception
+    byte rx_prompt_expected;        // 1 - "> " is also taken as final result code
+    byte rx_final_code;             // received final result code
+    byte rx_line_len;               // num. of characters in the current line
+    char rx_line[RX_LINE_LEN+1];    // beginning of the current line +1 for 0x00
+    byte rx_text_payload;           // RX_TEXT_xxx - SMS texts of +CMGR/+CMGL
+
+    byte CheckRxLine(byte ch);
+
+    // variables connected with the response classifier
+    ATMatcher rx_match;             // classifier of the current response
+#ifdef URC_ENABLED
+    ATMatchState rx_match_line;     // classifier state at the beginning of the line
+#endif
+
+#ifdef URC_ENABLED
+    // variables connected with the URC dispatcher
+    byte rx_cmd_mode;               // 1 - reception of the command response
+    uint16_t rx_line_start;         // position of the current line in comm_buf
+    byte urc_line_len;              // num. of characters of the URC line received out of response
+    char urc_line[URC_LINE_LEN+1];  // URC line received out of response +1 for 0x00
+    byte urc_buf[URC_BUF_LEN];      // ring of pending URC lines (finished by 0x00)
+    byte urc_buf_head;              // position for the next written character
+    byte urc_buf_tail;              // position of the oldest pending line
+    byte urc_buf_used;              // num. of used bytes
+    byte urc_lost_cnt;              // num. of lost URC lines (ring was full)
+    URCHandler urc_handlers[URC_HANDLERS_LEN];
+
+    byte IsURCLine(void);
+    void PushURC(const char *line, byte len);
+    byte PopURC(char *line);
+    void ParseURCChar(byte ch);
+#endif
+
+#ifdef AT_CMD_TAG_ENABLED
+    byte tx_tag_pos;                // position in the currently sent command line
+    byte tx_cmd_line;               // 1 - the last sent line starts with "AT"
+    byte tx_cmd_type;               // at_cmd_type_enum of the last sent command
+    char tx_cmd_tag[URC_CMD_TAG_LEN+1]; // tag of the last sent command e.g. "+CREG"
+
+    void TrackCmdTag(char ch);
+    void TrackCmdTag(const char *string, byte pgm);
+#endif
+
+#ifdef AT_AUTOBAUD_ENABLED
+    // variables connected with the baud rate autodetection
+    long max_baud_rate;             // upper limit of UpshiftBaudRate()
+    long base_baud_rate;            // rate found by the detection (lower limit of the fallback)
+    unsigned long rx_err_cnt;       // last GetRxErrCnt() of the transport
+    byte rx_line_check;             // 1 - the response is checked for the line errors
+    byte line_err_cnt;              // num. of consecutive commands with the line errors
+    byte baud_fallback_cnt;         // num. of returns to the lower baud rate
+
+    void SetTransportBaudRate(long baud_rate);
+    byte CheckBaudRate(byte cnt);
+    long ProbeBaudRate(void);
+    char SwitchBaudRate(long baud_rate);
+    void CountLineErrors(byte rx_status);
+    void BaudFallback(void);
+#endif
+
+#ifdef AT_CMD_TIMING_ENABLED
+    // variables connected with the latency of the commands
+    byte cmd_new_line;              // 1 - command line was sent after the last sample
+    byte cmd_first_ok;              // 1 - cmd_first_us is valid
+    unsigned long cmd_start_us;     // start of the command line (or reception) in usec.
+    unsigned long cmd_first_us;     // time of the first received character in usec.
+
+    void CmdAttemptDone(byte attempt, byte rx_status);
+#endif
+
+#ifdef AT_CMD_STATS_ENABLED
+    // variables connected with the statistics of the AT commands
+    ATCmdClassStats cmd_stats[AT_CMD_STATS_LEN];
+    byte cmd_stats_cnt;             // num. of used classes
+
+    ATCmdClassStats *GetCmdClass(void);
+    void AddCmdSample(byte attempt, byte rx_status);
+#endif
+
+#ifdef AT_ADAPTIVE_TMOUT_ENABLED
+    // variables connected with the adaptive timeouts
+    byte tmout_mode;                // at_tmout_mode_enum
+    byte tmout_shortened;           // 1 - start tmout of the current reception was adapted
+    uint16_t rx_max_gap;            // max. gap between received characters in msec.
+    ATTmoutEst tmout_est[AT_ADAPT_EST_LEN];
+
+    ATTmoutEst *GetTmoutEst(byte create);
+    void AddTmoutSample(byte rx_status);
+#endif
+
+    // variables connected with the AT command engine
+    ATCmd *p_at_cmd;                // command in progress (NULL - engine is free)
+    byte at_cmd_step;               // ATCMD_STEP_xxx
+    byte at_cmd_attempt;            // num. of already made attempts
+    byte at_cmd_free_line;          // 1 - comm. line is released when command is finished
+    unsigned long at_cmd_time;      // start of the delay before next attempt
+    uint16_t at_cmd_delay;          // delay before next attempt in msec.
+
+    void FinishATCmd(char result, byte rx_status);
+
+    // variables connected with the retry policy
+    const ATRetryPolicy *retry_policy;
+    uint16_t op_deadline;           // max. duration of the operation in msec.
+    byte op_active;                 // 1 - operation with the deadline is in progress
+    unsigned long op_start;         // start of the operation
+
+    unsigned long GetOpTimeLeft(void);
+    byte IsRetryWanted(ATCmd *cmd);
+    byte IsRespReceived(ATCmd *cmd);
+    static uint16_t GetRetryDelay(const ATRetryPolicy *policy, byte attempt);
+
+    // variables connected with the queue of AT commands
+    ATCmd *at_cmd_queue[ATCMD_QUEUE_LEN]; // sorted by priority, FIFO inside of priority
+    byte at_cmd_queue_len;          // num. of commands in the queue
+    byte at_cmd_queue_max_len;      // max. num. of commands which were in the queue
+    ATCmdQueueStats at_cmd_stats[ATCMD_PRIO_LAST_ITEM];
+
+    byte BatchItemLen(ATBatchItem *item);
+    char BatchSendLine(ATBatch *batch, byte first, byte last, uint16_t max_interchar_tmout);
+
+    void ExpireATCmdQueue(void);
+    void StartQueuedATCmd(void);
+    void UpdateATCmdQueueStats(byte priority, unsigned long wait_time);
     
 };
 
@@ -0,0 +1,505 @@
+/*
+  ATCapture.cpp - recording of the serial traffic to the capture file and
+  its replay for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "ATCapture.h"
+
+extern "C" {
+  #include <stdlib.h>
+  #include <string.h>
+}
+
+static const byte cap_magic[5] = {'A', 'T', 'C', 'A', 'P'};
+
+
+/**********************************************************
+  Reader of the capture
+**********************************************************/
+ATCapReader::ATCapReader(void)
+{
+  buf = NULL;
+  buf_len = 0;
+  Rewind();
+}
+
+/**********************************************************
+Method checks the header of the capture
+
+return:
+        -1 - it is not the capture or the version is not supported
+         1 - OK, Next() returns the first record
+**********************************************************/
+char ATCapReader::Attach(const byte *capture, size_t size)
+{
+  buf = NULL;
+  buf_len = 0;
+  Rewind();
+  if ((size < AT_CAP_HEADER_LEN) || (memcmp(capture, cap_magic, sizeof(cap_magic)) != 0)
+      || (capture[5] != AT_CAP_VERSION)) return (-1);
+  buf = capture;
+  buf_len = size;
+  return (1);
+}
+
+void ATCapReader::Rewind(void)
+{
+  pos = AT_CAP_HEADER_LEN;
+  time_us = 0;
+}
+
+/**********************************************************
+Method reads the next record
+
+return:
+        -1 - capture is damaged (e.g. truncated file)
+         0 - end of the capture
+         1 - record is read
+**********************************************************/
+char ATCapReader::Next(ATCapRecord *record)
+{
+  unsigned long delta = 0;
+  byte shift = 0;
+  byte ch;
+
+  if (buf == NULL) return (-1);
+  if (pos >= buf_len) return (0);
+  record->type = buf[pos] >> 6;
+  record->len = (buf[pos] & 0x3f) + 1;
+  pos++;
+  do {
+    if ((pos >= buf_len) || (shift > 28)) return (-1);
+    ch = buf[pos++];
+    delta |= (unsigned long)(ch & 0x7f) << shift;
+    shift += 7;
+  } while (ch & 0x80);
+  if ((record->type >= AT_CAP_LAST_ITEM) || (buf_len - pos < record->len)) return (-1);
+  time_us += delta;
+  record->time_us = time_us;
+  record->data = buf + pos;
+  pos += record->len;
+  return (1);
+}
+
+
+#if defined(__unix__) || defined(__APPLE__)
+/**********************************************************
+  Capture file
+**********************************************************/
+ATFileSink::ATFileSink(void)
+{
+  file = NULL;
+}
+
+ATFileSink::~ATFileSink(void)
+{
+  Close();
+}
+
+/**********************************************************
+Method creates the file (the previous content is lost)
+
+return:
+        -1 - file can not be created
+         1 - file is opened
+**********************************************************/
+char ATFileSink::Open(const char *path)
+{
+  Close();
+  file = fopen(path, "wb");
+  return (file == NULL ? -1 : 1);
+}
+
+void ATFileSink::Close(void)
+{
+  if (file == NULL) return;
+  fclose(file);
+  file = NULL;
+}
+
+size_t ATFileSink::write(uint8_t ch)
+{
+  return (write(&ch, 1));
+}
+
+size_t ATFileSink::write(const uint8_t *buffer, size_t size)
+{
+  if (file == NULL) return (0);
+  return (fwrite(buffer, 1, size, file));
+}
+
+void ATFileSink::flush(void)
+{
+  if (file != NULL) fflush(file);
+}
+#endif // end of if defined(__unix__) || defined(__APPLE__)
+
+
+/**********************************************************
+  Recorder
+**********************************************************/
+ATRecordTransport::ATRecordTransport(ATTransport &transport) : inner(transport)
+{
+  sink = NULL;
+  record_cnt = 0;
+  pending_len = 0;
+}
+
+ATRecordTransport::~ATRecordTransport(void)
+{
+  Stop();
+}
+
+/**********************************************************
+Method writes the header of the capture to the sink,
+the time of the capture starts now
+
+sink: where the capture is written (e.g. File of the SD
+      library), it must be valid until Stop()
+**********************************************************/
+void ATRecordTransport::Start(Print &sink)
+{
+  byte header[AT_CAP_HEADER_LEN] = {0};
+
+  Stop();
+  memcpy(header, cap_magic, sizeof(cap_magic));
+  header[5] = AT_CAP_VERSION;
+  sink.write(header, sizeof(header));
+  this->sink = &sink;
+  record_cnt = 0;
+  pending_len = 0;
+  last_us = micros();
+}
+
+/**********************************************************
+Method writes the pending record and stops the recording
+(the sink is not closed)
+**********************************************************/
+void ATRecordTransport::Stop(void)
+{
+  if (sink == NULL) return;
+  WritePending();
+  sink->flush();
+  sink = NULL;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+/**********************************************************
+Method creates the capture file and starts the recording
+
+return:
+        -1 - file can not be created
+         1 - recording is started
+**********************************************************/
+char ATRecordTransport::Open(const char *path)
+{
+  Close();
+  if (file.Open(path) < 0) return (-1);
+  Start(file);
+  return (1);
+}
+
+void ATRecordTransport::Close(void)
+{
+  Stop();
+  file.Close();
+}
+#endif // end of if defined(__unix__) || defined(__APPLE__)
+
+void ATRecordTransport::WritePending(void)
+{
+  byte head[6];
+  byte head_len = 0;
+  unsigned long delta;
+
+  if ((sink == NULL) || (pending_len == 0)) return;
+  delta = pending_us - last_us;
+  head[head_len++] = (pending_type << 6) | (pending_len - 1);
+  do {
+    head[head_len] = delta & 0x7f;
+    delta >>= 7;
+    if (delta) head[head_len] |= 0x80;
+    head_len++;
+  } while (delta);
+  sink->write(head, head_len);
+  sink->write(pending, pending_len);
+  last_us = pending_us;
+  pending_len = 0;
+  record_cnt++;
+}
+
+/**********************************************************
+Method adds the characters to the pending record, the record
+is written when the direction changes, it is full or the
+characters are not coming one by one
+**********************************************************/
+void ATRecordTransport::Add(byte type, const byte *data, size_t size)
+{
+  unsigned long now;
+
+  if (sink == NULL) return;
+  now = micros();
+  while (size) {
+    if (pending_len && ((pending_type != type) || (pending_len == AT_CAP_MAX_DATA_LEN)
+                        || (now - pending_last_us > AT_CAP_MERGE_US))) {
+      WritePending();
+    }
+    if (pending_len == 0) {
+      pending_type = type;
+      pending_us = now;
+    }
+    pending_last_us = now;
+    pending[pending_len++] = *data++;
+    size--;
+  }
+}
+
+void ATRecordTransport::Begin(long baud_rate)
+{
+  byte data[4];
+
+  data[0] = baud_rate & 0xff;
+  data[1] = (baud_rate >> 8) & 0xff;
+  data[2] = (baud_rate >> 16) & 0xff;
+  data[3] = (baud_rate >> 24) & 0xff;
+  inner.Begin(baud_rate);
+  Add(AT_CAP_BEGIN, data, sizeof(data));
+  // baud rate is not merged with anything
+  WritePending();
+}
+
+size_t ATRecordTransport::Write(byte ch)
+{
+  size_t written = inner.Write(ch);
+
+  Add(AT_CAP_TX, &ch, written);
+  return (written);
+}
+
+size_t ATRecordTransport::Write(const byte *data, size_t size)
+{
+  size_t written = inner.Write(data, size);
+
+  Add(AT_CAP_TX, data, written);
+  return (written);
+}
+
+int ATRecordTransport::Available(void)
+{
+  return (inner.Available());
+}
+
+int ATRecordTransport::Read(void)
+{
+  int ch = inner.Read();
+  byte data;
+
+  if (ch >= 0) {
+    data = ch;
+    Add(AT_CAP_RX, &data, 1);
+  }
+  return (ch);
+}
+
+void ATRecordTransport::Flush(void)
+{
+  inner.Flush();
+  WritePending();
+  if (sink != NULL) sink->flush();
+}
+
+unsigned long ATRecordTransport::GetRxErrCnt(void)
+{
+  return (inner.GetRxErrCnt());
+}
+
+char ATRecordTransport::SetFlowControl(byte on)
+{
+  return (inner.SetFlowControl(on));
+}
+
+void ATRecordTransport::HoldRx(byte hold)
+{
+  inner.HoldRx(hold);
+}
+
+
+#if defined(__unix__) || defined(__APPLE__)
+/**********************************************************
+  Replay
+**********************************************************/
+ATReplayTransport::ATReplayTransport(void)
+{
+  owned_buf = NULL;
+  mode = AT_REPLAY_REALTIME;
+  cur.len = 0;
+  cur_pos = 0;
+}
+
+ATReplayTransport::~ATReplayTransport(void)
+{
+  Close();
+}
+
+/**********************************************************
+Method loads the whole capture file to the memory
+
+return:
+        -1 - file can not be read or it is not the capture
+         1 - replay is ready
+**********************************************************/
+char ATReplayTransport::Open(const char *path, byte replay_mode)
+{
+  FILE *f;
+  long size;
+  byte *capture;
+
+  Close();
+  f = fopen(path, "rb");
+  if (f == NULL) return (-1);
+  if ((fseek(f, 0, SEEK_END) != 0) || ((size = ftell(f)) < AT_CAP_HEADER_LEN)) {
+    fclose(f);
+    return (-1);
+  }
+  rewind(f);
+  capture = (byte *)malloc(size);
+  if ((capture == NULL) || (fread(capture, 1, size, f) != (size_t)size)) {
+    free(capture);
+    fclose(f);
+    return (-1);
+  }
+  fclose(f);
+  if (Attach(capture, size, replay_mode) < 0) {
+    free(capture);
+    return (-1);
+  }
+  owned_buf = capture;
+  return (1);
+}
+
+/**********************************************************
+Method replays the capture which is already in the memory
+(it must exist until Close())
+**********************************************************/
+char ATReplayTransport::Attach(const byte *capture, size_t size, byte replay_mode)
+{
+  Close();
+  if (reader.Attach(capture, size) < 0) return (-1);
+  mode = replay_mode;
+  Rewind();
+  return (1);
+}
+
+void ATReplayTransport::Close(void)
+{
+  reader.Attach(NULL, 0);
+  cur.len = 0;
+  if (owned_buf != NULL) free(owned_buf);
+  owned_buf = NULL;
+}
+
+void ATReplayTransport::Rewind(void)
+{
+  reader.Rewind();
+  tx_mismatch_cnt = 0;
+  rx_skipped_cnt = 0;
+  time_offset_us = micros();
+  NextRecord();
+}
+
+void ATReplayTransport::NextRecord(void)
+{
+  cur_pos = 0;
+  if (reader.Next(&cur) != 1) cur.len = 0;
+}
+
+/**********************************************************
+Method returns 1 if the current record can be received
+**********************************************************/
+byte ATReplayTransport::IsDue(void)
+{
+  if ((cur.len == 0) || (cur.type != AT_CAP_RX)) return (0);
+  if (mode == AT_REPLAY_FAST) return (1);
+  return ((long)(micros() - (cur.time_us + time_offset_us)) >= 0);
+}
+
+/**********************************************************
+Method re-synchronizes the time base and skips everything
+what was received in the capture before the baud rate was set
+**********************************************************/
+void ATReplayTransport::Begin(long)
+{
+  while ((cur.len != 0) && (cur.type == AT_CAP_RX)) {
+    rx_skipped_cnt += cur.len - cur_pos;
+    NextRecord();
+  }
+  if ((cur.len != 0) && (cur.type == AT_CAP_BEGIN)) {
+    time_offset_us = micros() - cur.time_us;
+    NextRecord();
+  }
+}
+
+/**********************************************************
+Method compares the sent character with the capture
+- characters which were received in the capture but not
+  read by the library are skipped
+- the first character of the sent record sets the time base
+**********************************************************/
+size_t ATReplayTransport::Write(byte ch)
+{
+  while ((cur.len != 0) && (cur.type != AT_CAP_TX)) {
+    if (cur.type == AT_CAP_RX) rx_skipped_cnt += cur.len - cur_pos;
+    NextRecord();
+  }
+  if (cur.len == 0) {
+    // library sends more than was recorded
+    tx_mismatch_cnt++;
+    return (1);
+  }
+  if (cur_pos == 0) time_offset_us = micros() - cur.time_us;
+  if (cur.data[cur_pos] != ch) tx_mismatch_cnt++;
+  if (++cur_pos >= cur.len) NextRecord();
+  return (1);
+}
+
+int ATReplayTransport::Available(void)
+{
+  ATCapRecord rec;
+  ATCapReader ahead;
+  int cnt;
+
+  if (!IsDue()) return (0);
+  cnt = cur.len - cur_pos;
+  if (mode != AT_REPLAY_FAST) return (cnt);
+  // all following received records are available too
+  ahead = reader;
+  while ((ahead.Next(&rec) == 1) && (rec.type == AT_CAP_RX)) cnt += rec.len;
+  return (cnt);
+}
+
+int ATReplayTransport::Read(void)
+{
+  int ch;
+
+  if (!IsDue()) return (-1);
+  ch = cur.data[cur_pos];
+  if (++cur_pos >= cur.len) NextRecord();
+  return (ch);
+}
+
+#endif // end of if defined(__unix__) || defined(__APPLE__)
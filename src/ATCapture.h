@@ -0,0 +1,251 @@
+/*
+  ATCapture.h - recording of the serial traffic to the capture file and
+  its replay for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATCAPTURE_h
+#define __ATCAPTURE_h
+
+#include "Arduino.h"
+#include "ATTransport.h"
+
+// files are available only on Linux and other POSIX systems (not on Arduino)
+#if defined(__unix__) || defined(__APPLE__)
+  #include <stdio.h>
+#endif
+
+/*
+    ATRecordTransport is put between the AT class and the real transport,
+    every character in both directions is written to the capture with
+    the time stamp (micros()). The capture is written to any Print
+    (e.g. the File of the SD library or SoftwareSerial on Arduino,
+    ATFileSink on Linux).
+
+    ATReplayTransport plays the capture back to the library instead
+    of the GSM module:
+    - AT_REPLAY_REALTIME - received characters come at the recorded time
+      relative to the last command sent by the library (the library
+      can be slower or faster than the recorded one, the time base
+      is re-synchronized by every sent command)
+    - AT_REPLAY_FAST - received characters are available as soon as
+      the library has sent everything what was sent before them
+
+    The replayed program must call the same API methods in the same
+    order as the recorded one, differences are counted
+    (see GetTxMismatchCnt(), GetRxSkippedCnt()).
+
+    ATFileSink and ATReplayTransport are only for Linux and other POSIX
+    systems.
+
+    an example of usage:
+        // Arduino - capture to the SD card
+        ATUartTransport uart;
+        ATRecordTransport rec(uart);
+        File cap = SD.open("session.atc", FILE_WRITE);
+
+        rec.Start(cap);
+        gsm.SetTransport(&rec);
+        gsm.InitSerLine(115200);
+        ...
+        rec.Stop();
+        cap.close();
+
+        // field unit on Linux
+        ATFdTransport tty;
+        ATRecordTransport rec(tty);
+
+        tty.Open("/dev/ttyUSB0");
+        rec.Open("session.atc");
+        gsm.SetTransport(&rec);
+        gsm.InitSerLine(115200);
+        ...
+        rec.Close();
+
+        // workstation
+        ATReplayTransport replay;
+
+        if (replay.Open("session.atc", AT_REPLAY_REALTIME) < 0) return (-1);
+        gsm.SetTransport(&replay);
+        gsm.InitSerLine(115200);
+        ...   // the same calls as on the field unit
+
+    capture file:
+        header:  "ATCAP" <version> 0x00 0x00
+        record:  <type:2 bits | len - 1:6 bits> <delta_us> <len characters>
+                 - type: AT_CAP_RX, AT_CAP_TX, AT_CAP_BEGIN (4 bytes baud rate LE)
+                 - delta_us: time from the previous record (LEB128 varint)
+*/
+
+#define AT_CAP_VERSION        1
+#define AT_CAP_HEADER_LEN     8
+#define AT_CAP_MAX_DATA_LEN   64
+
+// characters coming within this time are stored in one record
+// (one character takes 87 usec. at 115200 Bd)
+#ifndef AT_CAP_MERGE_US
+  #define AT_CAP_MERGE_US     200
+#endif // end of ifndef AT_CAP_MERGE_US
+
+
+enum at_cap_type_enum
+{
+  AT_CAP_RX = 0,          // GSM module -> library
+  AT_CAP_TX,              // library -> GSM module
+  AT_CAP_BEGIN,           // Begin() with the baud rate
+
+  AT_CAP_LAST_ITEM
+};
+
+enum at_replay_mode_enum
+{
+  AT_REPLAY_REALTIME = 0,
+  AT_REPLAY_FAST,
+
+  AT_REPLAY_LAST_ITEM
+};
+
+
+// one record of the capture
+struct ATCapRecord
+{
+  byte type;                        // at_cap_type_enum
+  byte len;
+  unsigned long time_us;            // time from the start of the capture
+  const byte *data;
+};
+
+// sequential reading of the capture in the memory
+class ATCapReader
+{
+  public:
+    ATCapReader(void);
+    char Attach(const byte *capture, size_t size);
+    char Next(ATCapRecord *record);   // 1 - record, 0 - end, -1 - damaged
+    void Rewind(void);
+
+  private:
+    const byte *buf;
+    size_t buf_len;
+    size_t pos;
+    unsigned long time_us;
+};
+
+
+#if defined(__unix__) || defined(__APPLE__)
+// capture file written by the stdio
+class ATFileSink : public Print
+{
+  public:
+    ATFileSink(void);
+    ~ATFileSink(void);
+    char Open(const char *path);
+    void Close(void);
+    inline byte IsOpen(void) {return (file != NULL);};
+
+    virtual size_t write(uint8_t ch);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual void flush(void);
+    using Print::write;
+
+  private:
+    FILE *file;
+};
+#endif // end of if defined(__unix__) || defined(__APPLE__)
+
+
+class ATRecordTransport : public ATTransport
+{
+  public:
+    ATRecordTransport(ATTransport &transport);
+    ~ATRecordTransport(void);
+    void Start(Print &sink);
+    void Stop(void);
+#if defined(__unix__) || defined(__APPLE__)
+    char Open(const char *path);
+    void Close(void);
+#endif
+    inline unsigned long GetRecordCnt(void) {return record_cnt;};
+
+    virtual void Begin(long baud_rate);
+    virtual size_t Write(byte ch);
+    virtual size_t Write(const byte *data, size_t size);
+    virtual int Available(void);
+    virtual int Read(void);
+    virtual void Flush(void);
+    virtual unsigned long GetRxErrCnt(void);
+    virtual char SetFlowControl(byte on);
+    virtual void HoldRx(byte hold);
+
+  private:
+    ATTransport &inner;
+    Print *sink;                    // NULL - recording is stopped
+#if defined(__unix__) || defined(__APPLE__)
+    ATFileSink file;                // sink opened by Open()
+#endif
+    unsigned long record_cnt;
+    unsigned long last_us;          // time of the last written record
+    unsigned long pending_us;       // time of the first character of the pending record
+    unsigned long pending_last_us;  // time of the last character of the pending record
+    byte pending_type;
+    byte pending_len;               // 0 - nothing is pending
+    byte pending[AT_CAP_MAX_DATA_LEN];
+
+    void Add(byte type, const byte *data, size_t size);
+    void WritePending(void);
+};
+
+
+#if defined(__unix__) || defined(__APPLE__)
+class ATReplayTransport : public ATTransport
+{
+  public:
+    ATReplayTransport(void);
+    ~ATReplayTransport(void);
+    char Open(const char *path, byte replay_mode);
+    char Attach(const byte *capture, size_t size, byte replay_mode);
+    void Close(void);
+    void Rewind(void);
+    inline byte IsEnd(void) {return (cur.len == 0);};
+    // sent characters which differ from the capture
+    inline unsigned long GetTxMismatchCnt(void) {return tx_mismatch_cnt;};
+    // received characters thrown away because the library sent
+    // the command before it read them
+    inline unsigned long GetRxSkippedCnt(void) {return rx_skipped_cnt;};
+
+    virtual void Begin(long baud_rate);
+    virtual size_t Write(byte ch);
+    virtual int Available(void);
+    virtual int Read(void);
+    // the recorded session could use the flow control
+    virtual char SetFlowControl(byte) {return 1;};
+
+  private:
+    ATCapReader reader;
+    byte *owned_buf;                // capture loaded by Open()
+    byte mode;
+    ATCapRecord cur;                // len == 0 - end of the capture
+    byte cur_pos;                   // next character of cur
+    long time_offset_us;            // micros() - capture time
+    unsigned long tx_mismatch_cnt;
+    unsigned long rx_skipped_cnt;
+
+    void NextRecord(void);
+    byte IsDue(void);
+};
+
+#endif // end of if defined(__unix__) || defined(__APPLE__)
+
+#endif
@@ -0,0 +1,153 @@
+/*
+  ATCmdLine.h - AT commands with parameters streamed to the GSM module
+  for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATCMDLINE_h
+#define __ATCMDLINE_h
+
+#include "AT.h"
+
+/*
+    ATLine() keeps the fragments of the AT command and its parameters,
+    the command is composed only while it is sent so no buffer for the
+    whole command is needed and nothing is copied
+    - ATF("...") - constant fragment placed in the Flash memory
+    - ATQuote(str) - string in the RAM enclosed in quotes
+    - const char * / char * - string in the RAM
+    - char - one character
+    - byte, short, int, long and their unsigned variants - decimal number
+    - max_len is the max. length of the command computed by the compiler
+      (without <CR><LF> and without the strings in the RAM whose
+      length is known only when the command is sent), the command longer
+      than AT_CMD_LINE_MAX_LEN is refused by the compiler
+    - repeated attempts stream the command again
+
+    an example of usage:
+        // AT#SD=1,0,80,"www.google.com",0,0
+        gsm.SendATCmdWaitResp(ATLine(ATF("AT#SD="), conn_id, ATF(","),
+                                     socket_type, ATF(","), remote_port,
+                                     ATF(","), ATQuote(remote_addr),
+                                     ATF(",0,0")),
+                              20000, 200, "CONNECT", 3);
+
+        // the line must exist until the non-blocking command is finished
+        auto line_cmgr = ATLine(ATF("AT+CMGR="), position);
+        gsm.SetupATCmd(&cmd, NULL, 0, 5000, 100, "OK", 1, NULL);
+        gsm.SetATCmdLine(&cmd, &line_cmgr);
+        gsm.RunATCmd(&cmd);
+*/
+
+// constant fragment in the Flash memory, N is its length
+template<uint16_t N> struct ATLit
+{
+  PGM_P str;
+};
+#define ATF(string_literal) (ATLit<sizeof(string_literal) - 1>{PSTR(string_literal)})
+
+// string in the RAM enclosed in quotes
+struct ATQuoted
+{
+  const char *str;
+};
+inline ATQuoted ATQuote(const char *str) {ATQuoted q = {str}; return (q);}
+
+
+// max. num. of characters of the decimal number
+constexpr uint16_t ATDecLen(byte size, byte is_signed)
+{
+  return ((size == 1) ? 3 : (size == 2) ? 5 : (size == 4) ? 10 : 20) + is_signed;
+}
+
+// max. length of the argument (unsupported types have no length)
+template<typename T> struct ATArgLen;
+template<uint16_t N> struct ATArgLen<ATLit<N> > {static constexpr uint16_t max_len = N;};
+template<> struct ATArgLen<ATQuoted> {static constexpr uint16_t max_len = 2;};
+template<> struct ATArgLen<const char *> {static constexpr uint16_t max_len = 0;};
+template<> struct ATArgLen<char *> {static constexpr uint16_t max_len = 0;};
+template<> struct ATArgLen<char> {static constexpr uint16_t max_len = 1;};
+template<> struct ATArgLen<byte> {static constexpr uint16_t max_len = ATDecLen(sizeof(byte), 0);};
+template<> struct ATArgLen<short> {static constexpr uint16_t max_len = ATDecLen(sizeof(short), 1);};
+template<> struct ATArgLen<unsigned short> {static constexpr uint16_t max_len = ATDecLen(sizeof(unsigned short), 0);};
+template<> struct ATArgLen<int> {static constexpr uint16_t max_len = ATDecLen(sizeof(int), 1);};
+template<> struct ATArgLen<unsigned int> {static constexpr uint16_t max_len = ATDecLen(sizeof(unsigned int), 0);};
+template<> struct ATArgLen<long> {static constexpr uint16_t max_len = ATDecLen(sizeof(long), 1);};
+template<> struct ATArgLen<unsigned long> {static constexpr uint16_t max_len = ATDecLen(sizeof(unsigned long), 0);};
+
+// sending of the argument
+template<uint16_t N> inline void ATArgWrite(AT *at, const ATLit<N> &lit) {at->PrintF(lit.str);}
+inline void ATArgWrite(AT *at, const ATQuoted &quoted)
+{
+  at->PrintChar('"');
+  at->Print(quoted.str);
+  at->PrintChar('"');
+}
+inline void ATArgWrite(AT *at, const char *str) {at->Print(str);}
+inline void ATArgWrite(AT *at, char ch) {at->PrintChar(ch);}
+inline void ATArgWrite(AT *at, byte value) {at->Print((long)value);}
+inline void ATArgWrite(AT *at, short value) {at->Print((long)value);}
+inline void ATArgWrite(AT *at, unsigned short value) {at->Print((long)value);}
+inline void ATArgWrite(AT *at, int value) {at->Print((long)value);}
+inline void ATArgWrite(AT *at, unsigned int value) {at->Print((long)value);}
+inline void ATArgWrite(AT *at, long value) {at->Print(value);}
+inline void ATArgWrite(AT *at, unsigned long value)
+{
+  char num_str[11]; // "4294967295"
+
+  at->Print(ultoa(value, num_str, 10));
+}
+
+
+// arguments of the AT command (recursive list, the first one is sent first)
+template<typename... Args> struct ATArgs;
+
+template<> struct ATArgs<>
+{
+  static constexpr uint16_t max_len = 0;
+  inline void Send(AT *) const {};
+};
+
+template<typename T, typename... Rest> struct ATArgs<T, Rest...>
+{
+  static constexpr uint16_t max_len = ATArgLen<T>::max_len + ATArgs<Rest...>::max_len;
+  T first;
+  ATArgs<Rest...> rest;
+
+  ATArgs(T arg, Rest... rest_args) : first(arg), rest{rest_args...} {};
+  inline void Send(AT *at) const {ATArgWrite(at, first); rest.Send(at);};
+};
+
+
+template<typename... Args> class ATCmdLine : public ATCmdBuilder
+{
+  public:
+    static constexpr uint16_t max_len = ATArgs<Args...>::max_len;
+    static_assert(max_len <= AT_CMD_LINE_MAX_LEN,
+                  "AT command line is longer than the module accepts (AT_CMD_LINE_MAX_LEN)");
+
+    ATCmdLine(Args... args) : cmd_args{args...} {};
+    virtual void Send(AT *at) const {cmd_args.Send(at);};
+
+  private:
+    ATArgs<Args...> cmd_args;
+};
+
+template<typename... Args> inline ATCmdLine<Args...> ATLine(Args... args)
+{
+  return (ATCmdLine<Args...>(args...));
+}
+
+#endif
@@ -0,0 +1,304 @@
+/*
+  ATFdTransport.cpp - transport of the AT commands through the POSIX file
+  descriptor for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "ATFdTransport.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#ifdef __linux__
+  #include <linux/serial.h>
+#endif
+
+
+ATFdTransport::ATFdTransport(void)
+{
+  fd = -1;
+  owner = 0;
+  rx_pos = 0;
+  rx_len = 0;
+  rx_thread_running = 0;
+}
+
+ATFdTransport::~ATFdTransport(void)
+{
+  Close();
+}
+
+/**********************************************************
+Method opens the tty (or pty) in the raw mode
+
+path: e.g. "/dev/ttyUSB0"
+
+return:
+        -1 - tty can not be opened
+         1 - tty is opened
+**********************************************************/
+char ATFdTransport::Open(const char *path)
+{
+  int new_fd;
+
+  Close();
+  new_fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (new_fd < 0) return (-1);
+  Attach(new_fd);
+  owner = 1;
+  return (1);
+}
+
+/**********************************************************
+Method uses already opened file descriptor
+(e.g. master side of the pty, pipe or socket)
+- fd is switched to the non-blocking mode
+- fd is not closed by Close()
+**********************************************************/
+void ATFdTransport::Attach(int new_fd)
+{
+  struct termios tio;
+
+  Close();
+  fd = new_fd;
+  owner = 0;
+  rx_pos = 0;
+  rx_len = 0;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  // raw mode in case it is a terminal
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+}
+
+void ATFdTransport::Close(void)
+{
+  StopRxThread();
+  if ((fd >= 0) && owner) close(fd);
+  fd = -1;
+  owner = 0;
+  rx_pos = 0;
+  rx_len = 0;
+}
+
+/**********************************************************
+Method sets the speed of the tty
+(it has no effect on the pty, pipe...)
+**********************************************************/
+void ATFdTransport::Begin(long baud_rate)
+{
+  struct termios tio;
+  speed_t speed;
+
+  if ((fd < 0) || (tcgetattr(fd, &tio) != 0)) return;
+  switch (baud_rate) {
+    case 1200: speed = B1200; break;
+    case 2400: speed = B2400; break;
+    case 4800: speed = B4800; break;
+    case 9600: speed = B9600; break;
+    case 19200: speed = B19200; break;
+    case 38400: speed = B38400; break;
+    case 57600: speed = B57600; break;
+    case 115200: speed = B115200; break;
+    default: return;
+  }
+  cfsetispeed(&tio, speed);
+  cfsetospeed(&tio, speed);
+  tcsetattr(fd, TCSANOW, &tio);
+}
+
+size_t ATFdTransport::Write(byte ch)
+{
+  return (Write(&ch, 1));
+}
+
+size_t ATFdTransport::Write(const byte *data, size_t size)
+{
+  size_t written = 0;
+  ssize_t n;
+
+  if (fd < 0) return (0);
+  while (written < size) {
+    n = write(fd, data + written, size - written);
+    if (n > 0) written += n;
+    else if ((n < 0) && (errno == EINTR)) continue;
+    else if ((n < 0) && (errno == EAGAIN)) {
+      // output buffer is full => wait until it is sent
+      tcdrain(fd);
+      usleep(100);
+    }
+    else break;
+  }
+  return (written);
+}
+
+/**********************************************************
+Method reads next block of the received characters
+(does not wait)
+**********************************************************/
+void ATFdTransport::Fill(void)
+{
+  ssize_t n;
+
+  if ((fd < 0) || (rx_pos < rx_len)) return;
+  rx_pos = 0;
+  rx_len = 0;
+  n = read(fd, rx_buf, AT_FD_RX_BUF_LEN);
+  if (n > 0) rx_len = n;
+}
+
+int ATFdTransport::Available(void)
+{
+  int pending = 0;
+
+  if (rx_thread_running) return (rx_ring.Available());
+  Fill();
+  if ((fd >= 0) && (ioctl(fd, FIONREAD, &pending) != 0)) pending = 0;
+  return ((rx_len - rx_pos) + pending);
+}
+
+int ATFdTransport::Read(void)
+{
+  if (rx_thread_running) return (rx_ring.Get());
+  Fill();
+  if (rx_pos >= rx_len) return (-1);
+  return (rx_buf[rx_pos++]);
+}
+
+void ATFdTransport::Flush(void)
+{
+  if (fd >= 0) tcdrain(fd);
+}
+
+/**********************************************************
+Method switches the RTS/CTS flow control of the tty
+(CRTSCTS), RTS is driven by the driver according to its
+receive buffer so HoldRx() is not needed
+
+return: -1 - not supported, 1 - OK
+**********************************************************/
+char ATFdTransport::SetFlowControl(byte on)
+{
+#ifdef CRTSCTS
+  struct termios tio;
+
+  if ((fd < 0) || (tcgetattr(fd, &tio) != 0)) return (-1);
+  if (on) tio.c_cflag |= CRTSCTS;
+  else tio.c_cflag &= ~CRTSCTS;
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) return (-1);
+  return (1);
+#else
+  return (on ? -1 : 1);
+#endif
+}
+
+/**********************************************************
+Method returns the num. of the receive errors counted
+by the serial driver (only on Linux and only real serial
+ports, the pty returns 0)
+**********************************************************/
+unsigned long ATFdTransport::GetRxErrCnt(void)
+{
+#if defined(__linux__) && defined(TIOCGICOUNT)
+  struct serial_icounter_struct icount;
+
+  if ((fd >= 0) && (ioctl(fd, TIOCGICOUNT, &icount) == 0)) {
+    return ((unsigned long)icount.frame + icount.parity + icount.overrun + icount.buf_overrun);
+  }
+#endif
+  return (0);
+}
+
+/**********************************************************
+Method starts the thread which reads the fd to the ring
+buffer (see GetRxRing())
+- characters read before are kept in the ring
+
+return:
+        -1 - fd is not opened or the thread can not be started
+         1 - thread is running
+**********************************************************/
+char ATFdTransport::StartRxThread(void)
+{
+  if (rx_thread_running) return (1);
+  if (fd < 0) return (-1);
+  rx_ring.Clear();
+  while (rx_pos < rx_len) rx_ring.Put(rx_buf[rx_pos++]);
+  rx_thread_running = 1;
+  if (pthread_create(&rx_thread, NULL, RxThreadMain, this) != 0) {
+    rx_thread_running = 0;
+    return (-1);
+  }
+  return (1);
+}
+
+/**********************************************************
+Method stops the reader thread, the characters which are 
+still in the ring are lost
+**********************************************************/
+void ATFdTransport::StopRxThread(void)
+{
+  if (!rx_thread_running) return;
+  __atomic_store_n(&rx_thread_running, 0, __ATOMIC_RELEASE);
+  pthread_join(rx_thread, NULL);
+  rx_ring.Clear();
+}
+
+void ATFdTransport::RxThreadPoll(void)
+{
+  struct pollfd pfd;
+  byte data[AT_FD_RX_BUF_LEN];
+  uint16_t free_len = rx_ring.Free();
+  ssize_t n;
+  ssize_t i;
+
+  if (free_len == 0) {
+    // ring is full => characters wait in the driver
+    usleep(1000);
+    return;
+  }
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  if (poll(&pfd, 1, AT_FD_RX_THREAD_TMOUT) <= 0) return;
+  if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+    // e.g. the other side of the pty is closed
+    usleep(AT_FD_RX_THREAD_TMOUT * 1000L);
+    if (!(pfd.revents & POLLIN)) return;
+  }
+  n = read(fd, data, (free_len < AT_FD_RX_BUF_LEN) ? free_len : AT_FD_RX_BUF_LEN);
+  for (i = 0; i < n; i++) rx_ring.Put(data[i]);
+}
+
+void *ATFdTransport::RxThreadMain(void *arg)
+{
+  ATFdTransport *transport = (ATFdTransport *)arg;
+
+  while (__atomic_load_n(&transport->rx_thread_running, __ATOMIC_ACQUIRE)) transport->RxThreadPoll();
+  return (NULL);
+}
+
+#endif // end of if defined(__unix__) || defined(__APPLE__)
@@ -0,0 +1,107 @@
+/*
+  ATFdTransport.h - transport of the AT commands through the POSIX file
+  descriptor for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATFDTRANSPORT_h
+#define __ATFDTRANSPORT_h
+
+// only for Linux and other POSIX systems (not for Arduino)
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <pthread.h>
+#include "ATTransport.h"
+
+/*
+    GSM module connected to the tty (e.g. /dev/ttyUSB0) or simulated
+    on the pty
+
+    an example of usage:
+        ATFdTransport tty;
+
+        if (tty.Open("/dev/ttyUSB0") < 0) return (-1);
+        gsm.SetTransport(&tty);
+        gsm.InitSerLine(115200);    // sets the tty speed
+
+    the reader thread started by StartRxThread() moves the characters 
+    from the fd to the ring buffer (see ATRxRing.h) which the AT class
+    reads directly, the characters wait in the driver when the ring 
+    is full
+    - the thread must be started before InitSerLine() (the AT class
+      looks for the ring there)
+
+        tty.Open("/dev/ttyUSB0");
+        tty.StartRxThread();
+        gsm.SetTransport(&tty);
+        gsm.InitSerLine(115200);
+        ...
+        printf("max. %u characters waiting\n", tty.GetRxRing()->GetHighWater());
+*/
+
+// size of the receive buffer (characters are read from the fd by blocks)
+#ifndef AT_FD_RX_BUF_LEN
+  #define AT_FD_RX_BUF_LEN      256
+#endif // end of ifndef AT_FD_RX_BUF_LEN
+
+// max. time in msec. the reader thread waits for the characters
+// (the thread checks whether it should stop after this time)
+#ifndef AT_FD_RX_THREAD_TMOUT
+  #define AT_FD_RX_THREAD_TMOUT 20
+#endif // end of ifndef AT_FD_RX_THREAD_TMOUT
+
+
+class ATFdTransport : public ATTransport
+{
+  public:
+    ATFdTransport(void);
+    ~ATFdTransport(void);
+    char Open(const char *path);
+    void Attach(int fd);
+    void Close(void);
+    inline int GetFd(void) {return fd;};
+
+    virtual void Begin(long baud_rate);
+    virtual size_t Write(byte ch);
+    virtual size_t Write(const byte *data, size_t size);
+    virtual int Available(void);
+    virtual int Read(void);
+    virtual void Flush(void);
+    virtual unsigned long GetRxErrCnt(void);
+    virtual char SetFlowControl(byte on);
+    virtual ATRxRing *GetRxRing(void) {return (rx_thread_running ? &rx_ring : NULL);};
+
+    // reader thread
+    char StartRxThread(void);
+    void StopRxThread(void);
+
+  private:
+    int fd;                         // -1 - closed
+    byte owner;                     // 1 - fd is closed by Close()
+    byte rx_buf[AT_FD_RX_BUF_LEN];
+    uint16_t rx_pos;                // next character to read
+    uint16_t rx_len;                // num. of characters in rx_buf
+    ATRxRing rx_ring;               // filled by the reader thread
+    pthread_t rx_thread;
+    volatile byte rx_thread_running;
+
+    void Fill(void);
+    void RxThreadPoll(void);
+    static void *RxThreadMain(void *arg);
+};
+
+#endif // end of if defined(__unix__) || defined(__APPLE__)
+
+#endif
@@ -0,0 +1,149 @@
+/*
+  ATMatch.cpp - multi-pattern response classifier for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "ATMatch.h"
+
+extern "C" {
+  #include <string.h>
+}
+
+
+/**********************************************************
+Method initializes the matcher
+
+set: pattern set placed in the Flash memory
+     NULL - matcher is disabled
+**********************************************************/
+void ATMatchInit(ATMatcher *matcher, const ATMatchSet *set)
+{
+  if (set != NULL) memcpy_P(&matcher->set, set, sizeof(ATMatchSet));
+  else memset(&matcher->set, 0, sizeof(ATMatchSet));
+  ATMatchReset(matcher);
+}
+
+/**********************************************************
+Method starts the classification of the new response
+(pattern set is kept)
+**********************************************************/
+void ATMatchReset(ATMatcher *matcher)
+{
+  matcher->st.state = 0;
+  matcher->st.matched = 0;
+  matcher->st.pos = 0;
+}
+
+/**********************************************************
+Method moves the automaton by one character
+
+ch: next character of the response
+
+return:
+      patterns which end by this character (bit mask)
+      0 - no pattern ends here or the matcher is disabled
+**********************************************************/
+uint16_t ATMatchFeed(ATMatcher *matcher, byte ch)
+{
+  byte cls;
+  uint16_t out;
+
+  if (matcher->set.delta == NULL) return (0);
+
+  // characters which are not used by any pattern are in the class 0
+  cls = (ch < ATMATCH_CLASSES) ? pgm_read_byte(&resp_match_class[ch]) : 0;
+  // and also the characters which are not used by this set
+  cls = pgm_read_byte(&matcher->set.classes[cls]);
+  matcher->st.state = pgm_read_byte(&matcher->set.delta[(uint16_t)matcher->st.state
+                                                        * matcher->set.n_classes + cls]);
+  matcher->st.pos++;
+  out = pgm_read_word(&matcher->set.out[matcher->st.state]);
+  matcher->st.matched |= out;
+  return (out);
+}
+
+/**********************************************************
+Method returns the pattern with the highest priority which
+was matched so far
+
+return:
+      -1 - no pattern was matched
+      index of the pattern
+**********************************************************/
+char ATMatchBest(const ATMatcher *matcher)
+{
+  char i;
+
+  for (i = 0; i < matcher->set.n_patterns; i++) {
+    if (matcher->st.matched & (1U << i)) return (i);
+  }
+  return (-1);
+}
+
+/**********************************************************
+Method classifies the buffer (one pass)
+
+set: pattern set placed in the Flash memory
+
+return:
+      -1 - no pattern was found
+      index of the pattern with the highest priority
+      which was found
+**********************************************************/
+char ATMatchFirst(const ATMatchSet *set, const char *buf, uint16_t len)
+{
+  ATMatcher matcher;
+
+  ATMatchInit(&matcher, set);
+  while (len--) ATMatchFeed(&matcher, *buf++);
+  return (ATMatchBest(&matcher));
+}
+
+/**********************************************************
+Method finds all occurrences of all patterns of the set
+in the buffer (one pass)
+
+set:      pattern set placed in the Flash memory
+hits:     found occurrences in the order of their end position
+max_hits: size of the hits array
+
+return:
+      num. of found occurrences (at most max_hits)
+**********************************************************/
+byte ATMatchAll(const ATMatchSet *set, const char *buf, uint16_t len,
+                ATMatchHit *hits, byte max_hits)
+{
+  ATMatcher matcher;
+  uint16_t out;
+  byte num_of_hits = 0;
+  byte i;
+
+  ATMatchInit(&matcher, set);
+  while (len-- && (num_of_hits < max_hits)) {
+    out = ATMatchFeed(&matcher, *buf++);
+    for (i = 0; out && (num_of_hits < max_hits); i++, out >>= 1) {
+      if (out & 1) {
+        hits[num_of_hits].pattern = i;
+        hits[num_of_hits].offset = matcher.st.pos
+                                   - pgm_read_byte(&matcher.set.pat_len[i]);
+        num_of_hits++;
+      }
+    }
+  }
+  return (num_of_hits);
+}
@@ -0,0 +1,97 @@
+/*
+  ATMatch.h - multi-pattern response classifier for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATMATCH_h
+#define __ATMATCH_h
+
+#include "Arduino.h"
+
+/*
+    ATMatch classifies the response against all patterns of the pattern
+    set in one pass (Aho-Corasick automaton)
+    - pattern sets are described in tools/resp_match.def and the tables
+      (ATRespMatch.h/.cpp) are generated by tools/gen_resp_match.py
+    - automaton is precomputed as the complete DFA so every received
+      character costs just a few table lookups in the Flash memory
+      (no backtracking, no rescanning of the buffer)
+    - matcher can be fed character by character while the response
+      is being received (see AT::SetRespClassifier()) so the result
+      is ready when the last character arrives
+    - patterns of the set are ordered by priority, the first pattern
+      of the set has the highest priority
+
+
+    an example of usage:
+        // one-shot classification of the buffer
+        switch (ATMatchFirst(&resp_match_gpio, buf, len)) {
+          case GPIO_HIGH: ...
+          case GPIO_LOW: ...
+          default: // no pattern was found
+        }
+*/
+
+#define ATMATCH_MAX_PATTERNS      16  // patterns are stored as bits of uint16_t
+#define ATMATCH_CLASSES          128  // only 7-bit characters are classified
+
+// pattern set placed in the Flash memory (generated)
+struct ATMatchSet
+{
+  const uint8_t  *classes;        // class of the set for the common character class
+  const uint8_t  *delta;          // next state [state * n_classes + class]
+  const uint16_t *out;            // patterns which end in the state (bit mask)
+  const uint8_t  *pat_len;        // length of the patterns
+  byte n_classes;                 // num. of character classes (columns of delta)
+  byte n_patterns;                // num. of patterns of the set
+};
+
+// state of the matcher which is restored when the URC line
+// is removed from the response
+struct ATMatchState
+{
+  byte state;                     // current state of the automaton
+  uint16_t matched;               // all patterns matched so far (bit mask)
+  uint16_t pos;                   // num. of characters fed so far
+};
+
+struct ATMatcher
+{
+  ATMatchSet set;                 // copy of the set descriptor (delta == NULL - disabled)
+  ATMatchState st;
+};
+
+// one occurrence of the pattern
+struct ATMatchHit
+{
+  byte pattern;                   // index of the pattern in the set
+  uint16_t offset;                // position of the first character
+};
+
+
+// character classes common for all pattern sets (generated)
+extern const uint8_t resp_match_class[ATMATCH_CLASSES] PROGMEM;
+
+
+void ATMatchInit(ATMatcher *matcher, const ATMatchSet *set);
+void ATMatchReset(ATMatcher *matcher);
+uint16_t ATMatchFeed(ATMatcher *matcher, byte ch);
+char ATMatchBest(const ATMatcher *matcher);
+char ATMatchFirst(const ATMatchSet *set, const char *buf, uint16_t len);
+byte ATMatchAll(const ATMatchSet *set, const char *buf, uint16_t len,
+                ATMatchHit *hits, byte max_hits);
+
+#endif
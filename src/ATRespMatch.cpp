@@ -0,0 +1,186 @@
+/*
+  ATRespMatch.cpp - generated by tools/gen_resp_match.py from tools/resp_match.def
+  DO NOT EDIT - change the definition file and run the generator again
+*/
+
+#include "Arduino.h"
+#include "ATRespMatch.h"
+
+
+const uint8_t resp_match_class[ATMATCH_CLASSES] PROGMEM = {
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   1,  0,  2,  3,  0,  0,  0,  0,  0,  0,  0,  4,  5,  0,  0,  0,
+   6,  7,  0,  8,  9,  0,  0,  0,  0,  0, 10,  0,  0,  0,  0,  0,
+   0, 11,  0, 12, 13, 14,  0, 15,  0, 16,  0, 17, 18,  0, 19, 20,
+  21,  0, 22, 23,  0, 24,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+
+// "+CLCC: 1,1,4,0,0", "+CLCC: 1,1,4,1,0", "+CLCC: 1,0,0,0,0", "+CLCC: 1,1,0,0,0", "+CLCC: 1,1,0,1,0", "+CLCC:", "OK"
+static const uint8_t resp_match_clcc_classes[] PROGMEM = {
+   0,  1,  0,  0,  2,  3,  4,  5,  0,  6,  7,  0,  8,  0,  0,  0,
+   0,  9, 10,  0, 11,  0,  0,  0,  0,
+};
+static const uint8_t resp_match_clcc_delta[] PROGMEM = {
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  2,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  3, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  4,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  5,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  6,  0,  0,  0, 35,
+   0,  7,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  8,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  9,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 20, 10,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 11,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 27,  0, 12,  0,  0,  0,  0, 35,
+   0,  0,  1, 13,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 14, 17,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 15,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 16,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 18,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 19,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 21,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 22,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 23,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 24,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 25,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 26,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 28,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 29, 32,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 30,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 31,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1, 33,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0, 34,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0, 36,  0, 35,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0, 35,
+};
+static const uint16_t resp_match_clcc_out[] PROGMEM = {
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0020, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0001, 0x0000, 0x0000, 0x0002, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0004, 0x0000, 0x0000, 0x0000, 0x0000, 0x0008,
+  0x0000, 0x0000, 0x0010, 0x0000, 0x0040,
+};
+static const uint8_t resp_match_clcc_pat_len[] PROGMEM = {
+  16, 16, 16, 16, 16, 6, 2,
+};
+const ATMatchSet resp_match_clcc PROGMEM = {
+  resp_match_clcc_classes, resp_match_clcc_delta, resp_match_clcc_out,
+  resp_match_clcc_pat_len, 12, 7
+};
+
+// "+CPAS: 0", "+CPAS: 3", "+CPAS: 4"
+static const uint8_t resp_match_cpas_classes[] PROGMEM = {
+   0,  1,  0,  0,  2,  0,  3,  0,  4,  5,  6,  7,  8,  0,  0,  0,
+   0,  0,  0,  0,  0,  9,  0, 10,  0,
+};
+static const uint8_t resp_match_cpas_delta[] PROGMEM = {
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  2,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  3,  0,
+   0,  0,  1,  0,  0,  0,  0,  4,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  5,
+   0,  0,  1,  0,  0,  0,  6,  0,  0,  0,  0,
+   0,  7,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  8,  9, 10,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+};
+static const uint16_t resp_match_cpas_out[] PROGMEM = {
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0001, 0x0002, 0x0004,
+};
+static const uint8_t resp_match_cpas_pat_len[] PROGMEM = {
+  8, 8, 8,
+};
+const ATMatchSet resp_match_cpas PROGMEM = {
+  resp_match_cpas_classes, resp_match_cpas_delta, resp_match_cpas_out,
+  resp_match_cpas_pat_len, 11, 3
+};
+
+// "\"REC UNREAD\"", "\"REC READ\"", "OK", "ERROR"
+static const uint8_t resp_match_cmgr_classes[] PROGMEM = {
+   0,  1,  2,  0,  0,  0,  0,  0,  0,  0,  0,  3,  4,  5,  6,  0,
+   0,  7,  0,  8,  9,  0, 10,  0, 11,
+};
+static const uint8_t resp_match_cmgr_delta[] PROGMEM = {
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18,  0,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18,  2,  0,
+   0,  0,  1,  0,  0,  0,  3,  0,  0, 18,  0,  0,
+   0,  0,  1,  0,  4,  0, 20,  0,  0, 18, 21,  0,
+   0,  5,  1,  0,  0,  0, 20,  0,  0, 18,  0,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18, 13,  6,
+   0,  0,  1,  0,  0,  0, 20,  0,  7, 18,  0,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18,  8,  0,
+   0,  0,  1,  0,  0,  0,  9,  0,  0, 18,  0,  0,
+   0,  0,  1, 10,  0,  0, 20,  0,  0, 18, 21,  0,
+   0,  0,  1,  0,  0, 11, 20,  0,  0, 18,  0,  0,
+   0,  0, 12,  0,  0,  0, 20,  0,  0, 18,  0,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18,  2,  0,
+   0,  0,  1,  0,  0,  0, 14,  0,  0, 18,  0,  0,
+   0,  0,  1, 15,  0,  0, 20,  0,  0, 18, 21,  0,
+   0,  0,  1,  0,  0, 16, 20,  0,  0, 18,  0,  0,
+   0,  0, 17,  0,  0,  0, 20,  0,  0, 18,  0,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18,  2,  0,
+   0,  0,  1,  0,  0,  0, 20, 19,  0, 18,  0,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18,  0,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18, 21,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18, 22,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 23,  0,  0,
+   0,  0,  1,  0,  0,  0, 20, 19,  0, 18, 24,  0,
+   0,  0,  1,  0,  0,  0, 20,  0,  0, 18,  0,  0,
+};
+static const uint16_t resp_match_cmgr_out[] PROGMEM = {
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0001, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0002, 0x0000, 0x0004, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0008,
+};
+static const uint8_t resp_match_cmgr_pat_len[] PROGMEM = {
+  12, 10, 2, 5,
+};
+const ATMatchSet resp_match_cmgr PROGMEM = {
+  resp_match_cmgr_classes, resp_match_cmgr_delta, resp_match_cmgr_out,
+  resp_match_cmgr_pat_len, 12, 4
+};
+
+// "#GPIO: 0,1", "#GPIO: 0,0"
+static const uint8_t resp_match_gpio_classes[] PROGMEM = {
+   0,  1,  0,  2,  0,  3,  4,  5,  0,  0,  6,  0,  0,  0,  0,  7,
+   8,  0,  0,  0,  9, 10,  0,  0,  0,
+};
+static const uint8_t resp_match_gpio_delta[] PROGMEM = {
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  2,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  3,
+   0,  0,  1,  0,  0,  0,  0,  0,  4,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  5,  0,
+   0,  0,  1,  0,  0,  0,  6,  0,  0,  0,  0,
+   0,  7,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  8,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  9,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  0, 11, 10,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+};
+static const uint16_t resp_match_gpio_out[] PROGMEM = {
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0001, 0x0002,
+};
+static const uint8_t resp_match_gpio_pat_len[] PROGMEM = {
+  10, 10,
+};
+const ATMatchSet resp_match_gpio PROGMEM = {
+  resp_match_gpio_classes, resp_match_gpio_delta, resp_match_gpio_out,
+  resp_match_gpio_pat_len, 11, 2
+};
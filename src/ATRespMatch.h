@@ -0,0 +1,53 @@
+/*
+  ATRespMatch.h - generated by tools/gen_resp_match.py from tools/resp_match.def
+  DO NOT EDIT - change the definition file and run the generator again
+*/
+
+#ifndef __ATRESPMATCH_h
+#define __ATRESPMATCH_h
+
+#include "ATMatch.h"
+
+// CLCC: 37 states, 550 bytes
+enum resp_match_clcc_enum
+{
+  CLCC_INCOM_VOICE = 0,           // "+CLCC: 1,1,4,0,0"
+  CLCC_INCOM_DATA = 1,            // "+CLCC: 1,1,4,1,0"
+  CLCC_ACTIVE_VOICE_CALLER = 2,   // "+CLCC: 1,0,0,0,0"
+  CLCC_ACTIVE_VOICE = 3,          // "+CLCC: 1,1,0,0,0"
+  CLCC_ACTIVE_DATA = 4,           // "+CLCC: 1,1,0,1,0"
+  CLCC_OTHERS = 5,                // "+CLCC:"
+  CLCC_NONE = 6,                  // "OK"
+};
+extern const ATMatchSet resp_match_clcc PROGMEM;
+
+// CPAS: 11 states, 171 bytes
+enum resp_match_cpas_enum
+{
+  CPAS_READY = 0,                 // "+CPAS: 0"
+  CPAS_RINGING = 1,               // "+CPAS: 3"
+  CPAS_CALL_IN_PROGRESS = 2,      // "+CPAS: 4"
+};
+extern const ATMatchSet resp_match_cpas PROGMEM;
+
+// CMGR: 25 states, 379 bytes
+enum resp_match_cmgr_enum
+{
+  CMGR_UNREAD = 0,                // "\"REC UNREAD\""
+  CMGR_READ = 1,                  // "\"REC READ\""
+  CMGR_OK = 2,                    // "OK"
+  CMGR_ERROR = 3,                 // "ERROR"
+};
+extern const ATMatchSet resp_match_cmgr PROGMEM;
+
+// GPIO: 12 states, 183 bytes
+enum resp_match_gpio_enum
+{
+  GPIO_HIGH = 0,                  // "#GPIO: 0,1"
+  GPIO_LOW = 1,                   // "#GPIO: 0,0"
+};
+extern const ATMatchSet resp_match_gpio PROGMEM;
+
+// total size of the tables in the Flash memory: 1411 bytes
+
+#endif
@@ -0,0 +1,140 @@
+/*
+  ATRxRing.h - receive ring buffer filled from the interrupt or thread
+  for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATRXRING_h
+#define __ATRXRING_h
+
+#include "Arduino.h"
+
+#ifdef __AVR__
+  #include <util/atomic.h>
+#endif
+
+/*
+    ATRxRing keeps the received characters between the producer
+    (UART receive interrupt or the reader thread) and the AT class
+    which is the only consumer
+    - Put() is called only by the producer, Available() and Get()
+      only by the consumer, no lock is needed
+    - the AT class reads the ring of the transport directly
+      (see ATTransport::GetRxRing()) so the characters are not
+      copied once more through the virtual Read()
+    - character which does not fit is lost and counted
+      (see GetOverflowCnt()), the max. num. of characters waiting
+      in the ring is kept as the high-water mark (see GetHighWater())
+      so the size of the ring can be tuned
+
+    transports with the ring:
+    ATUartTransport   - USART0 of the AVR with own receive interrupt
+                        (AT_UART_ISR_ENABLED in Setting.h, see ATUartTransport.h)
+    ATFdTransport     - reader thread started by StartRxThread()
+                        (only on POSIX systems, see ATFdTransport.h)
+*/
+
+// size of the ring in bytes (one byte is always free)
+#ifndef AT_RX_RING_LEN
+  #define AT_RX_RING_LEN        256
+#endif // end of ifndef AT_RX_RING_LEN
+
+
+class ATRxRing
+{
+  public:
+    ATRxRing(void) {
+      head = 0;
+      tail = 0;
+      ResetStats();
+    };
+
+    // producer side (interrupt or thread)
+    inline byte Put(byte ch) {
+      uint16_t pos = head;
+      uint16_t next = (pos + 1 < AT_RX_RING_LEN) ? pos + 1 : 0;
+      uint16_t used;
+
+      if (next == Load(&tail)) {
+        if (overflow_cnt < 0xffff) overflow_cnt++;
+        return (0);
+      }
+      buf[pos] = ch;
+      Store(&head, next);
+      used = Used(next, Load(&tail));
+      if (used > high_water) high_water = used;
+      return (1);
+    };
+    inline uint16_t Free(void) {
+      return (AT_RX_RING_LEN - 1 - Used(head, Load(&tail)));
+    };
+
+    // consumer side (AT class)
+    inline uint16_t Available(void) {
+      return (Used(Load(&head), tail));
+    };
+    inline int Get(void) {
+      uint16_t pos = tail;
+      byte ch;
+
+      if (pos == Load(&head)) return (-1);
+      ch = buf[pos];
+      Store(&tail, (pos + 1 < AT_RX_RING_LEN) ? pos + 1 : 0);
+      return (ch);
+    };
+    // throws away all received characters
+    inline void Clear(void) {Store(&tail, Load(&head));};
+
+    // statistics
+    inline uint16_t GetOverflowCnt(void) {return (Load(&overflow_cnt));};
+    inline uint16_t GetHighWater(void) {return (Load(&high_water));};
+    inline void ResetStats(void) {
+      Store(&overflow_cnt, 0);
+      Store(&high_water, 0);
+    };
+
+  private:
+    byte buf[AT_RX_RING_LEN];
+    volatile uint16_t head;         // next written position (producer)
+    volatile uint16_t tail;         // next read position (consumer)
+    volatile uint16_t overflow_cnt; // num. of lost characters
+    volatile uint16_t high_water;   // max. num. of characters in the ring
+
+    static inline uint16_t Used(uint16_t head_pos, uint16_t tail_pos) {
+      return ((head_pos >= tail_pos) ? head_pos - tail_pos : AT_RX_RING_LEN - tail_pos + head_pos);
+    };
+
+    // 16-bit access must not be split by the interrupt (AVR) and
+    // the character must be in the buffer before the index is moved
+    static inline uint16_t Load(volatile uint16_t *var) {
+#ifdef __AVR__
+      uint16_t value;
+
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {value = *var;}
+      return (value);
+#else
+      return (__atomic_load_n(var, __ATOMIC_ACQUIRE));
+#endif
+    };
+    static inline void Store(volatile uint16_t *var, uint16_t value) {
+#ifdef __AVR__
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {*var = value;}
+#else
+      __atomic_store_n(var, value, __ATOMIC_RELEASE);
+#endif
+    };
+};
+
+#endif
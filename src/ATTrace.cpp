@@ -0,0 +1,247 @@
+/*
+  ATTrace.cpp - trace of the library events for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "ATTrace.h"
+
+extern "C" {
+  #include <string.h>
+}
+
+// names of the events (at_trace_enum)
+static const char trace_name_text[] PROGMEM = "TEXT";
+static const char trace_name_num[] PROGMEM = "NUM";
+static const char trace_name_cmd[] PROGMEM = "CMD";
+static const char trace_name_result[] PROGMEM = "RESULT";
+static const char trace_name_urc[] PROGMEM = "URC";
+static const char trace_name_baud[] PROGMEM = "BAUD";
+
+static PGM_P const trace_names[AT_TRACE_USER] PROGMEM = {
+  trace_name_text,
+  trace_name_num,
+  trace_name_cmd,
+  trace_name_result,
+  trace_name_urc,
+  trace_name_baud,
+};
+
+
+ATTrace::ATTrace(void)
+{
+  sink = NULL;
+  add_time = 0;
+  Clear();
+}
+
+/**********************************************************
+Method throws away all records in the ring buffer
+**********************************************************/
+void ATTrace::Clear(void)
+{
+  head = 0;
+  used = 0;
+  lost_cnt = 0;
+  flush_time = add_time;
+}
+
+void ATTrace::Put(const byte *data, byte len)
+{
+  uint16_t pos = head + used;
+
+  while (len--) {
+    if (pos >= AT_TRACE_BUF_LEN) pos -= AT_TRACE_BUF_LEN;
+    buf[pos++] = *data++;
+    used++;
+  }
+}
+
+byte ATTrace::Get(void)
+{
+  byte ch = buf[head];
+
+  if (++head >= AT_TRACE_BUF_LEN) head = 0;
+  used--;
+  return (ch);
+}
+
+/**********************************************************
+Method adds the record to the ring buffer
+- data longer than AT_TRACE_DATA_LEN are cut
+- record which does not fit into the ring buffer is lost
+**********************************************************/
+void ATTrace::Add(byte id, const void *data, byte len)
+{
+  byte head_rec[2 + 5];
+  byte head_len = 0;
+  unsigned long now = millis();
+  unsigned long delta = now - add_time;
+
+  if (len > AT_TRACE_DATA_LEN) len = AT_TRACE_DATA_LEN;
+  head_rec[head_len++] = id;
+  head_rec[head_len++] = len;
+  do {
+    head_rec[head_len] = delta & 0x7f;
+    delta >>= 7;
+    if (delta) head_rec[head_len] |= 0x80;
+    head_len++;
+  } while (delta);
+  if ((uint16_t)(AT_TRACE_BUF_LEN - used) < (uint16_t)(head_len + len)) {
+    if (lost_cnt < 0xffff) lost_cnt++;
+    return;
+  }
+  Put(head_rec, head_len);
+  Put((const byte *)data, len);
+  add_time = now;
+}
+
+void ATTrace::AddStr(byte id, const char *str)
+{
+  size_t len = strlen(str);
+
+  Add(id, str, (len > AT_TRACE_DATA_LEN) ? AT_TRACE_DATA_LEN : len);
+}
+
+void ATTrace::AddStrF(byte id, PGM_P str)
+{
+  char data[AT_TRACE_DATA_LEN + 1];
+
+  strncpy_P(data, str, AT_TRACE_DATA_LEN);
+  data[AT_TRACE_DATA_LEN] = 0x00;
+  AddStr(id, data);
+}
+
+void ATTrace::AddNum(byte id, long value)
+{
+  byte data[4];
+
+  data[0] = value & 0xff;
+  data[1] = (value >> 8) & 0xff;
+  data[2] = (value >> 16) & 0xff;
+  data[3] = (value >> 24) & 0xff;
+  Add(id, data, sizeof(data));
+}
+
+/**********************************************************
+Method passes the oldest records to the sink
+(records are thrown away in case there is no sink)
+
+max_records: max. num. of passed records (the time spent
+             by the slow sink is limited)
+
+return: num. of passed records
+**********************************************************/
+byte ATTrace::Flush(byte max_records)
+{
+  ATTraceRecord record;
+  byte data[AT_TRACE_DATA_LEN];
+  unsigned long delta;
+  byte shift;
+  byte ch;
+  byte cnt = 0;
+  byte i;
+
+  while (used && (cnt < max_records)) {
+    record.id = Get();
+    record.len = Get();
+    delta = 0;
+    shift = 0;
+    do {
+      ch = Get();
+      delta |= (unsigned long)(ch & 0x7f) << shift;
+      shift += 7;
+    } while (ch & 0x80);
+    for (i = 0; i < record.len; i++) data[i] = Get();
+    flush_time += delta;
+    record.time = flush_time;
+    record.data = data;
+    if (sink != NULL) sink->Write(&record);
+    cnt++;
+  }
+  return (cnt);
+}
+
+/**********************************************************
+Method formats the record as the text line without <CR><LF>
+e.g. "12345 CMD AT+CREG?"
+
+line: buffer for AT_TRACE_LINE_LEN + 1 characters
+**********************************************************/
+void ATTrace::Format(const ATTraceRecord *record, char *line)
+{
+  char *p;
+  uint32_t value = 0;
+  byte i;
+
+  ultoa(record->time, line, 10);
+  strcat_P(line, PSTR(" "));
+  if (record->id < AT_TRACE_USER) {
+    strcat_P(line, (PGM_P)pgm_read_ptr(&trace_names[record->id]));
+  }
+  else {
+    strcat_P(line, PSTR("USER"));
+    utoa(record->id - AT_TRACE_USER, line + strlen(line), 10);
+  }
+  strcat_P(line, PSTR(" "));
+  p = line + strlen(line);
+
+  if ((record->id == AT_TRACE_NUM) || (record->id == AT_TRACE_BAUD)) {
+    for (i = 0; (i < 4) && (i < record->len); i++) value |= (uint32_t)record->data[i] << (8 * i);
+    ltoa((int32_t)value, p, 10);
+  }
+  else if ((record->id == AT_TRACE_RESULT) && (record->len == 4)) {
+    strcpy_P(p, PSTR("res="));
+    itoa((signed char)record->data[0], p + strlen(p), 10);
+    strcat_P(p, PSTR(" rx="));
+    itoa(record->data[1], p + strlen(p), 10);
+    strcat_P(p, PSTR(" att="));
+    itoa(record->data[2], p + strlen(p), 10);
+    strcat_P(p, PSTR(" frc="));
+    itoa(record->data[3], p + strlen(p), 10);
+  }
+  else {
+    // text, non-printable characters are replaced
+    for (i = 0; i < record->len; i++) {
+      *p++ = ((record->data[i] < 0x20) || (record->data[i] >= 0x7f)) ? '.' : record->data[i];
+    }
+    *p = 0x00;
+  }
+}
+
+
+/**********************************************************
+  Sinks
+**********************************************************/
+void ATTracePrintSink::Write(const ATTraceRecord *record)
+{
+  char line[AT_TRACE_LINE_LEN + 1];
+
+  ATTrace::Format(record, line);
+  out.print(line);
+  out.println();
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+void ATTraceFileSink::Write(const ATTraceRecord *record)
+{
+  char line[AT_TRACE_LINE_LEN + 1];
+
+  ATTrace::Format(record, line);
+  fprintf(f, "%s\n", line);
+}
+#endif // end of if defined(__unix__) || defined(__APPLE__)
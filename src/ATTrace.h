@@ -0,0 +1,174 @@
+/*
+  ATTrace.h - trace of the library events for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATTRACE_h
+#define __ATTRACE_h
+
+#include "Arduino.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <stdio.h>
+#endif
+
+/*
+    ATTrace keeps the events of the library (sent AT commands, results,
+    URCs, baud rate changes and DebugPrint() texts) as compact binary
+    records in the RAM ring buffer
+    - adding of the event only copies a few bytes, nothing is sent
+      so the timing of the library is the same as without the trace
+    - records are passed to the sink only by Flush() which is called
+      by the program when it has time (e.g. from the loop() when the
+      comm. line is free), the library itself never calls it
+    - in case the ring buffer is full the new events are lost and
+      counted (see GetLostCnt())
+
+    an example of usage:
+        // trace goes to the software serial port on pins 8 and 9
+        SoftwareSerial trace_serial(8, 9);
+        ATTracePrintSink trace_sink(trace_serial);
+        ATTrace trace;
+
+        void setup()
+        {
+          trace_serial.begin(57600);
+          trace.SetSink(&trace_sink);
+          gsm.SetTrace(&trace);
+          ...
+        }
+
+        void loop()
+        {
+          ...
+          if (gsm.GetCommLineStatus() == CLS_FREE) trace.Flush(4);
+        }
+
+    sinks:
+    ATTracePrintSink    - text lines to any Print (SoftwareSerial, second
+                          HardwareSerial...)
+    ATTraceEEPROMSink   - binary records to the EEPROM (see ATTraceEEPROM.h)
+    ATTraceFileSink     - text lines to the file e.g. stderr
+                          (only on Linux and other POSIX systems)
+
+    record in the ring buffer and in the EEPROM:
+        <id> <len> <delta_ms> <len bytes of data>
+        - delta_ms: time from the previous record (LEB128 varint)
+*/
+
+// size of the ring buffer in bytes
+#ifndef AT_TRACE_BUF_LEN
+  #define AT_TRACE_BUF_LEN      128
+#endif // end of ifndef AT_TRACE_BUF_LEN
+
+// max. num. of data bytes of one record (longer data are cut)
+#ifndef AT_TRACE_DATA_LEN
+  #define AT_TRACE_DATA_LEN     24
+#endif // end of ifndef AT_TRACE_DATA_LEN
+
+// max. length of the record formatted by ATTrace::Format()
+#define AT_TRACE_LINE_LEN       (AT_TRACE_DATA_LEN + 32)
+
+
+enum at_trace_enum
+{
+  AT_TRACE_TEXT = 0,    // text of DebugPrint()
+  AT_TRACE_NUM,         // number of DebugPrint() (long LE)
+  AT_TRACE_CMD,         // beginning of the sent AT command
+  AT_TRACE_RESULT,      // AT command is finished: result, rx_status, attempts
+                        // and final result code (4 bytes)
+  AT_TRACE_URC,         // beginning of the unsolicited result code
+  AT_TRACE_BAUD,        // baud rate was changed (long LE)
+
+  AT_TRACE_USER         // first id for the events of the program
+};
+
+
+// one record of the trace
+struct ATTraceRecord
+{
+  byte id;                          // at_trace_enum or >= AT_TRACE_USER
+  byte len;
+  unsigned long time;               // millis() when the record was added
+  const byte *data;
+};
+
+// destination of the trace records
+class ATTraceSink
+{
+  public:
+    virtual void Write(const ATTraceRecord *record) = 0;
+};
+
+
+class ATTrace
+{
+  public:
+    ATTrace(void);
+    inline void SetSink(ATTraceSink *new_sink) {sink = new_sink;};
+    void Clear(void);
+
+    void Add(byte id, const void *data, byte len);
+    void AddStr(byte id, const char *str);
+    void AddStrF(byte id, PGM_P str);
+    void AddNum(byte id, long value);
+
+    byte Flush(byte max_records);
+    inline uint16_t GetUsed(void) {return used;};
+    inline uint16_t GetLostCnt(void) {return lost_cnt;};
+
+    static void Format(const ATTraceRecord *record, char *line);
+
+  private:
+    ATTraceSink *sink;
+    byte buf[AT_TRACE_BUF_LEN];
+    uint16_t head;                  // first byte of the oldest record
+    uint16_t used;                  // num. of used bytes
+    uint16_t lost_cnt;              // num. of lost records
+    unsigned long add_time;         // time of the last added record
+    unsigned long flush_time;       // time of the last flushed record
+
+    void Put(const byte *data, byte len);
+    byte Get(void);
+};
+
+
+// text lines "<time> <event> <data>" to the Print
+class ATTracePrintSink : public ATTraceSink
+{
+  public:
+    ATTracePrintSink(::Print &print) : out(print) {};
+    virtual void Write(const ATTraceRecord *record);
+
+  private:
+    ::Print &out;
+};
+
+
+#if defined(__unix__) || defined(__APPLE__)
+// text lines "<time> <event> <data>" to the file
+class ATTraceFileSink : public ATTraceSink
+{
+  public:
+    ATTraceFileSink(FILE *file) {f = file;};
+    virtual void Write(const ATTraceRecord *record);
+
+  private:
+    FILE *f;
+};
+#endif // end of if defined(__unix__) || defined(__APPLE__)
+
+#endif
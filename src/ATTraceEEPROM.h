@@ -0,0 +1,103 @@
+/*
+  ATTraceEEPROM.h - EEPROM sink of the trace for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATTRACEEEPROM_h
+#define __ATTRACEEEPROM_h
+
+#include "Arduino.h"
+#include "ATTrace.h"
+#include <EEPROM.h>
+
+/*
+    ATTraceEEPROMSink stores the records of the trace to the EEPROM
+    area <start, end) so they survive the reset of the board
+    (e.g. the trace of the field unit is read out later)
+    - only this header includes EEPROM.h so the library does not
+      depend on the EEPROM library unless the sink is used
+    - records are stored in the same format as in the ring buffer
+      (see ATTrace.h) except delta_ms which is the time from
+      the previous stored record, the area is terminated by 0xff
+      (id which is not used)
+    - storing is stopped when the area is full (the oldest records
+      are kept), Rewind() starts again from the beginning
+    - one byte takes about 3.4 msec. so Flush() should pass only
+      a few records at a time
+
+    an example of usage:
+        ATTraceEEPROMSink trace_sink(0, 512);
+        ATTrace trace;
+
+        trace_sink.Rewind();
+        trace.SetSink(&trace_sink);
+        gsm.SetTrace(&trace);
+*/
+
+#define AT_TRACE_EEPROM_END     0xff
+
+
+class ATTraceEEPROMSink : public ATTraceSink
+{
+  public:
+    ATTraceEEPROMSink(int start, int end) {
+      area_start = start;
+      area_end = end;
+      pos = start;
+      last_time = 0;
+    };
+
+    // storing starts from the beginning of the area
+    void Rewind(void) {
+      pos = area_start;
+      last_time = 0;
+      if (pos < area_end) EEPROM.update(pos, AT_TRACE_EEPROM_END);
+    };
+    inline byte IsFull(void) {return (pos >= area_end);};
+
+    virtual void Write(const ATTraceRecord *record) {
+      byte head[2 + 5];
+      byte head_len = 0;
+      unsigned long delta = record->time - last_time;
+      byte i;
+
+      head[head_len++] = record->id;
+      head[head_len++] = record->len;
+      do {
+        head[head_len] = delta & 0x7f;
+        delta >>= 7;
+        if (delta) head[head_len] |= 0x80;
+        head_len++;
+      } while (delta);
+      // the record and the end mark must fit
+      if (pos + head_len + record->len + 1 > area_end) {
+        pos = area_end;
+        return;
+      }
+      for (i = 0; i < head_len; i++) EEPROM.update(pos++, head[i]);
+      for (i = 0; i < record->len; i++) EEPROM.update(pos++, record->data[i]);
+      EEPROM.update(pos, AT_TRACE_EEPROM_END);
+      last_time = record->time;
+    };
+
+  private:
+    int area_start;
+    int area_end;
+    int pos;                        // next record is stored here
+    unsigned long last_time;        // time of the last stored record
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*
+  ATTransport.cpp - transport of the AT commands for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "ATTransport.h"
+
+extern "C" {
+  #include <string.h>
+}
+
+
+/**********************************************************
+Method writes the buffer character by character
+(transports can send the whole buffer at once)
+
+return: num. of written characters
+**********************************************************/
+size_t ATTransport::Write(const byte *data, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++) {
+    if (!Write(data[i])) break;
+  }
+  return (i);
+}
+
+
+/**********************************************************
+  Loopback transport
+**********************************************************/
+ATLoopbackTransport::ATLoopbackTransport(void)
+{
+  echo = 0;
+  Clear();
+}
+
+/**********************************************************
+Method removes all characters in both directions
+**********************************************************/
+void ATLoopbackTransport::Clear(void)
+{
+  rx.head = 0;
+  rx.used = 0;
+  tx.head = 0;
+  tx.used = 0;
+  lost_cnt = 0;
+}
+
+byte ATLoopbackTransport::Put(Ring *ring, byte ch)
+{
+  if (ring->used >= AT_LOOPBACK_BUF_LEN) {
+    lost_cnt++;
+    return (0);
+  }
+  ring->buf[ring->head] = ch;
+  ring->head = (ring->head + 1) % AT_LOOPBACK_BUF_LEN;
+  ring->used++;
+  return (1);
+}
+
+int ATLoopbackTransport::Get(Ring *ring)
+{
+  byte ch;
+
+  if (ring->used == 0) return (-1);
+  ch = ring->buf[(ring->head + AT_LOOPBACK_BUF_LEN - ring->used) % AT_LOOPBACK_BUF_LEN];
+  ring->used--;
+  return (ch);
+}
+
+size_t ATLoopbackTransport::Write(byte ch)
+{
+  if (echo) Put(&rx, ch);
+  return (Put(&tx, ch));
+}
+
+int ATLoopbackTransport::Available(void)
+{
+  return (rx.used);
+}
+
+int ATLoopbackTransport::Read(void)
+{
+  return (Get(&rx));
+}
+
+/**********************************************************
+Methods for the other side of the loopback
+
+PeerWrite() returns num. of characters which were placed
+into the buffer (rest of the characters is lost, see GetLostCnt())
+**********************************************************/
+size_t ATLoopbackTransport::PeerWrite(const byte *data, size_t size)
+{
+  size_t written = 0;
+  size_t i;
+
+  for (i = 0; i < size; i++) written += Put(&rx, data[i]);
+  return (written);
+}
+
+size_t ATLoopbackTransport::PeerPrint(const char *string)
+{
+  return (PeerWrite((const byte *)string, strlen(string)));
+}
+
+int ATLoopbackTransport::PeerAvailable(void)
+{
+  return (tx.used);
+}
+
+int ATLoopbackTransport::PeerRead(void)
+{
+  return (Get(&tx));
+}
@@ -0,0 +1,232 @@
+/*
+  ATTransport.h - transport of the AT commands for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATTRANSPORT_h
+#define __ATTRANSPORT_h
+
+#include "Arduino.h"
+#include "ATRxRing.h"
+
+/*
+    All characters of the AT class go through the ATTransport
+    - by default the AT class uses AT_SERIAL_PORT (Serial)
+    - other transport can be set by AT::SetTransport() before
+      InitSerLine() is called
+
+    an example of usage:
+        // GSM module connected to the software serial port
+        SoftwareSerial gsm_serial(2, 3);
+        ATSerialTransport<SoftwareSerial> gsm_transport(gsm_serial);
+
+        void setup()
+        {
+          gsm.SetTransport(&gsm_transport);
+          gsm.InitSerLine(9600);
+          ...
+        }
+
+    transports:
+    ATSerialTransport<T>  - any Arduino serial port (HardwareSerial, SoftwareSerial...)
+    ATFlowSerialTransport<T> - Arduino serial port with the RTS/CTS hardware flow
+                            control on the digital pins (see AT::SetFlowControl())
+    ATUartTransport       - USART0 of the AVR with own receive interrupt and
+                            large ring buffer instead of HardwareSerial
+                            (AT_UART_ISR_ENABLED in Setting.h, see ATUartTransport.h)
+    ATLoopbackTransport   - in-memory transport, other side is simulated
+                            by the program itself (tests without hardware)
+    ATFdTransport         - POSIX file descriptor e.g. tty or pty, optionally
+                            read by the thread to the ring buffer
+                            (only on Linux and other POSIX systems, see ATFdTransport.h)
+    ATRecordTransport     - records the traffic of other transport to the capture
+                            written to any Print (e.g. the file on the SD card)
+    ATReplayTransport     - replays the capture instead of the GSM module
+                            (only on POSIX systems, see ATCapture.h)
+*/
+
+// RTS is deasserted when the receive buffer of the serial port contains
+// this num. of characters (the module sends a few characters more
+// before it stops, default Arduino buffer has 64 bytes)
+#ifndef AT_FLOW_RX_HIGH
+  #ifdef SERIAL_RX_BUFFER_SIZE
+    #define AT_FLOW_RX_HIGH     (SERIAL_RX_BUFFER_SIZE - 16)
+  #else
+    #define AT_FLOW_RX_HIGH     48
+  #endif
+#endif // end of ifndef AT_FLOW_RX_HIGH
+
+// max. time in msec. the character waits for CTS
+#ifndef AT_FLOW_CTS_TMOUT
+  #define AT_FLOW_CTS_TMOUT     1000
+#endif // end of ifndef AT_FLOW_CTS_TMOUT
+
+// size of the loopback buffers (for each direction)
+#ifndef AT_LOOPBACK_BUF_LEN
+  #define AT_LOOPBACK_BUF_LEN   64
+#endif // end of ifndef AT_LOOPBACK_BUF_LEN
+
+
+class ATTransport
+{
+  public:
+    virtual void Begin(long) {};
+    virtual size_t Write(byte ch) = 0;
+    virtual size_t Write(const byte *data, size_t size);
+    virtual int Available(void) = 0;
+    virtual int Read(void) = 0;           // -1 - nothing to read
+    virtual void Flush(void) {};          // waits until everything is sent
+    // num. of the receive errors (framing, parity, overrun) detected
+    // by the transport so far, 0 - errors are not detected
+    virtual unsigned long GetRxErrCnt(void) {return 0;};
+    // RTS/CTS hardware flow control: 1 - OK, -1 - not supported
+    virtual char SetFlowControl(byte on) {return (on ? -1 : 1);};
+    // 1 - the library does not read (default), the other side should
+    // stop sending (RTS is deasserted), 0 - the library reads now
+    virtual void HoldRx(byte) {};
+    // ring filled by the interrupt or thread which the AT class reads
+    // directly instead of Available() and Read(), NULL - no ring
+    virtual ATRxRing *GetRxRing(void) {return NULL;};
+};
+
+
+// Arduino serial port (everything what has begin(), write(), read()...)
+template <class T>
+class ATSerialTransport : public ATTransport
+{
+  public:
+    ATSerialTransport(T &serial_port) : port(serial_port) {};
+    virtual void Begin(long baud_rate) {port.begin(baud_rate);};
+    virtual size_t Write(byte ch) {return (port.write(ch));};
+    virtual size_t Write(const byte *data, size_t size) {return (port.write(data, size));};
+    virtual int Available(void) {return (port.available());};
+    virtual int Read(void) {return (port.read());};
+    virtual void Flush(void) {port.flush();};
+
+  private:
+    T &port;
+};
+
+
+// Arduino serial port with the RTS/CTS hardware flow control
+// - RTS (output, active LOW) is asserted only while the library reads
+//   (HoldRx(0) .. HoldRx(1), e.g. the reception of the response) and
+//   the receive buffer is not almost full, so the module does not send
+//   while the program is blocked elsewhere (delay(), its own code...)
+// - every character waits for CTS (input, active LOW)
+//   max. AT_FLOW_CTS_TMOUT msec.
+// - flow control is off until SetFlowControl(1) is called
+template <class T>
+class ATFlowSerialTransport : public ATTransport
+{
+  public:
+    ATFlowSerialTransport(T &serial_port, byte rts, byte cts) : port(serial_port) {
+      rts_pin = rts;
+      cts_pin = cts;
+      flow_on = 0;
+      held = 1;
+    };
+    virtual void Begin(long baud_rate) {
+      port.begin(baud_rate);
+      pinMode(cts_pin, INPUT);
+      pinMode(rts_pin, OUTPUT);
+      UpdateRTS(port.available());
+    };
+    virtual size_t Write(byte ch) {
+      unsigned long start_time = millis();
+
+      while (flow_on && (digitalRead(cts_pin) == HIGH)) {
+        if ((unsigned long)(millis() - start_time) >= AT_FLOW_CTS_TMOUT) return (0);
+      }
+      return (port.write(ch));
+    };
+    virtual int Available(void) {
+      int cnt = port.available();
+
+      UpdateRTS(cnt);
+      return (cnt);
+    };
+    virtual int Read(void) {
+      int ch = port.read();
+
+      UpdateRTS(port.available());
+      return (ch);
+    };
+    virtual void Flush(void) {port.flush();};
+    virtual char SetFlowControl(byte on) {
+      flow_on = on;
+      UpdateRTS(port.available());
+      return (1);
+    };
+    virtual void HoldRx(byte hold) {
+      held = hold;
+      UpdateRTS(port.available());
+    };
+
+  private:
+    T &port;
+    byte rts_pin;
+    byte cts_pin;
+    byte flow_on;
+    byte held;
+
+    // RTS is re-evaluated only here, the port has no interrupt hook
+    void UpdateRTS(int rx_cnt) {
+      // without the flow control RTS is always asserted
+      digitalWrite(rts_pin, (flow_on && (held || (rx_cnt >= AT_FLOW_RX_HIGH))) ? HIGH : LOW);
+    };
+};
+
+
+// in-memory transport
+// - characters written by the AT class are read by PeerRead()
+// - characters written by PeerWrite() are read by the AT class
+// - in the echo mode every written character is also read back
+//   by the AT class (like TX connected to RX)
+class ATLoopbackTransport : public ATTransport
+{
+  public:
+    ATLoopbackTransport(void);
+    virtual size_t Write(byte ch);
+    virtual int Available(void);
+    virtual int Read(void);
+
+    // the other side (simulated GSM module)
+    size_t PeerWrite(const byte *data, size_t size);
+    size_t PeerPrint(const char *string);
+    int PeerAvailable(void);
+    int PeerRead(void);
+    void Clear(void);
+    inline void SetEcho(byte echo_on) {echo = echo_on;};
+    // num. of characters lost because of the full buffer
+    inline uint16_t GetLostCnt(void) {return lost_cnt;};
+
+  private:
+    struct Ring {
+      byte buf[AT_LOOPBACK_BUF_LEN];
+      uint16_t head;                // position for the next written character
+      uint16_t used;                // num. of characters in the buffer
+    };
+    Ring rx;                        // other side -> AT class
+    Ring tx;                        // AT class -> other side
+    byte echo;
+    uint16_t lost_cnt;
+
+    byte Put(Ring *ring, byte ch);
+    int Get(Ring *ring);
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*
+  ATUartTransport.cpp - USART0 of the AVR with own receive interrupt
+  for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "ATUartTransport.h"
+
+#ifdef AT_UART_ISR_ENABLED
+
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#if defined(USART_RX_vect)
+  #define AT_UART_RX_VECT   USART_RX_vect     // ATmega328P (UNO)...
+#elif defined(USART0_RX_vect)
+  #define AT_UART_RX_VECT   USART0_RX_vect    // ATmega2560 (MEGA)...
+#else
+  #error "AT_UART_ISR_ENABLED: USART0 receive interrupt was not found"
+#endif
+
+
+ATUartTransport at_uart_transport;
+
+ISR(AT_UART_RX_VECT)
+{
+  at_uart_transport.RxInterrupt();
+}
+
+
+ATUartTransport::ATUartTransport(void)
+{
+  rx_err_cnt = 0;
+  written = 0;
+  rts_pin = 0xff;
+  cts_pin = 0xff;
+  flow_on = 0;
+  rts_high = 0;
+}
+
+/**********************************************************
+Method sets the baud rate (8N1) and enables the receive
+interrupt, the baud rate register is computed the same way
+like in the HardwareSerial
+**********************************************************/
+void ATUartTransport::Begin(long baud_rate)
+{
+  uint16_t baud_setting;
+
+  // waits for the characters which are sent by the old baud rate
+  Flush();
+  UCSR0B = 0;
+  // double speed mode is more precise except 57600 at 16 MHz
+  UCSR0A = _BV(U2X0);
+  baud_setting = (F_CPU / 4 / baud_rate - 1) / 2;
+  if (((F_CPU == 16000000UL) && (baud_rate == 57600)) || (baud_setting > 4095)) {
+    UCSR0A = 0;
+    baud_setting = (F_CPU / 8 / baud_rate - 1) / 2;
+  }
+  UBRR0H = baud_setting >> 8;
+  UBRR0L = baud_setting;
+  UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+  rx_ring.Clear();
+  UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+}
+
+size_t ATUartTransport::Write(byte ch)
+{
+  unsigned long start_time = millis();
+
+  while (flow_on && (digitalRead(cts_pin) == HIGH)) {
+    if ((unsigned long)(millis() - start_time) >= AT_FLOW_CTS_TMOUT) return (0);
+  }
+  while (!(UCSR0A & _BV(UDRE0)));
+  UDR0 = ch;
+  // TXC0 is cleared by writing 1 (U2X0 is kept)
+  UCSR0A = (UCSR0A & (_BV(U2X0) | _BV(MPCM0))) | _BV(TXC0);
+  written = 1;
+  return (1);
+}
+
+/**********************************************************
+Method waits until the last character is sent
+**********************************************************/
+void ATUartTransport::Flush(void)
+{
+  if (!written) return;
+  while (!(UCSR0A & _BV(TXC0)));
+  written = 0;
+}
+
+int ATUartTransport::Read(void)
+{
+  int ch = rx_ring.Get();
+
+  if (rts_high) ReleaseRTS();
+  return (ch);
+}
+
+/**********************************************************
+Method asserts RTS which was deasserted by the receive
+interrupt when the ring has room again
+**********************************************************/
+void ATUartTransport::ReleaseRTS(void)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (rts_high && (rx_ring.Free() > 2 * AT_UART_RTS_RESERVE)) {
+      digitalWrite(rts_pin, LOW);
+      rts_high = 0;
+    }
+  }
+}
+
+void ATUartTransport::SetFlowPins(byte rts, byte cts)
+{
+  rts_pin = rts;
+  cts_pin = cts;
+  pinMode(cts_pin, INPUT);
+  pinMode(rts_pin, OUTPUT);
+  digitalWrite(rts_pin, LOW);
+}
+
+/**********************************************************
+Method switches the RTS/CTS flow control
+
+return: -1 - pins are not set (see SetFlowPins())
+         1 - OK
+**********************************************************/
+char ATUartTransport::SetFlowControl(byte on)
+{
+  if (on && (rts_pin == 0xff)) return (-1);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    flow_on = on;
+    if (rts_pin != 0xff) {
+      // without the flow control RTS is always asserted
+      rts_high = on && (rx_ring.Free() <= AT_UART_RTS_RESERVE);
+      digitalWrite(rts_pin, rts_high ? HIGH : LOW);
+    }
+  }
+  return (1);
+}
+
+unsigned long ATUartTransport::GetRxErrCnt(void)
+{
+  unsigned long cnt;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {cnt = rx_err_cnt;}
+  return (cnt);
+}
+
+#endif // end of ifdef AT_UART_ISR_ENABLED
@@ -0,0 +1,114 @@
+/*
+  ATUartTransport.h - USART0 of the AVR with own receive interrupt
+  for the GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __ATUARTTRANSPORT_h
+#define __ATUARTTRANSPORT_h
+
+#include "Arduino.h"
+#include "Setting.h"
+#include "ATTransport.h"
+
+// only for the AVR with USART0 and only when it is enabled in Setting.h
+// (the interrupt of the HardwareSerial Serial would be defined twice)
+#ifdef AT_UART_ISR_ENABLED
+
+/*
+    ATUartTransport drives USART0 directly, the receive interrupt
+    puts the characters to the ring buffer of AT_RX_RING_LEN bytes
+    (see ATRxRing.h) which the AT class reads directly
+    - characters are not lost while the library waits by delay()
+      (TurnOn(), delay between attempts...) unless the ring is full
+    - it is the default transport of the AT class when
+      AT_UART_ISR_ENABLED is defined, the program must not use Serial
+      (its 64+64 bytes of buffers are not linked at all)
+    - framing, parity and overrun errors are counted (GetRxErrCnt()),
+      characters with the parity error are thrown away
+    - characters are sent without the interrupt (Write() waits
+      for the empty data register)
+    - RTS/CTS flow control (SetFlowPins(), SetFlowControl()): RTS is
+      deasserted by the receive interrupt when the ring is almost full
+      and asserted again by Read() when the ring has room, the interrupt
+      receives also while the library does not read so HoldRx() does
+      not deassert RTS, every sent character waits for CTS
+
+    an example of usage:
+        gsm.InitSerLine(115200);
+        ...
+        if (at_uart_transport.GetRxRing()->GetOverflowCnt()) {
+          // AT_RX_RING_LEN should be larger
+        }
+
+        // RTS on D8, CTS on D9
+        at_uart_transport.SetFlowPins(8, 9);
+        gsm.InitSerLine(115200);
+        gsm.SetFlowControl(1);
+*/
+
+// RTS is deasserted when only this num. of bytes is free in the ring
+// (the module sends a few characters more before it stops) and it is
+// asserted again when twice as much is free
+#ifndef AT_UART_RTS_RESERVE
+  #define AT_UART_RTS_RESERVE   16
+#endif // end of ifndef AT_UART_RTS_RESERVE
+
+class ATUartTransport : public ATTransport
+{
+  public:
+    ATUartTransport(void);
+    virtual void Begin(long baud_rate);
+    virtual size_t Write(byte ch);
+    virtual int Available(void) {return (rx_ring.Available());};
+    virtual int Read(void);
+    virtual void Flush(void);
+    virtual unsigned long GetRxErrCnt(void);
+    virtual char SetFlowControl(byte on);
+    virtual void HoldRx(byte) {ReleaseRTS();};
+    virtual ATRxRing *GetRxRing(void) {return (&rx_ring);};
+    // digital pins of RTS (output, active LOW) and CTS (input, active LOW)
+    void SetFlowPins(byte rts, byte cts);
+
+    // called only from the receive interrupt
+    inline void RxInterrupt(void) {
+      byte status = UCSR0A;
+      byte ch = UDR0;
+
+      if (status & (_BV(FE0) | _BV(DOR0) | _BV(UPE0))) rx_err_cnt++;
+      if (!(status & _BV(UPE0))) rx_ring.Put(ch);
+      if (flow_on && !rts_high && (rx_ring.Free() <= AT_UART_RTS_RESERVE)) {
+        digitalWrite(rts_pin, HIGH);
+        rts_high = 1;
+      }
+    };
+
+  private:
+    ATRxRing rx_ring;
+    volatile unsigned long rx_err_cnt;
+    byte written;                   // 1 - something was sent since the last Flush()
+    byte rts_pin;                   // 0xff - flow control pins are not set
+    byte cts_pin;
+    volatile byte flow_on;
+    volatile byte rts_high;         // 1 - RTS is deasserted by the interrupt
+
+    void ReleaseRTS(void);
+};
+
+extern ATUartTransport at_uart_transport;
+
+#endif // end of ifdef AT_UART_ISR_ENABLED
+
+#endif
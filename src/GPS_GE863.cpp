@@ -17,6 +17,7 @@
 */  
 
 #include "GPS_GE863.h"
+#include "ATCmdLine.h"
 
 
 
@@ -25,6 +26,48 @@ extern "C" {
 }
 
 
+static char ParseSwVers(const ATCmdDesc *, StrView *resp, void *ctx);
+
+/**********************************************************
+AT commands of the GPS part of the module (see RunATCmdDesc())
+**********************************************************/
+enum gps_cmd_enum
+{
+  GPS_CMD_SW_VERS = 0,
+  GPS_CMD_POWER_DOWN,
+  GPS_CMD_POWER_UP,
+  GPS_CMD_ANTENNA_OFF,
+  GPS_CMD_ANTENNA_ON,
+  GPS_CMD_ANTENNA_VOLTAGE,
+  GPS_CMD_ANTENNA_CURRENT,
+
+  GPS_CMD_LAST_ITEM
+};
+
+static const char gps_cmd_gpssw[] PROGMEM = "AT$GPSSW";
+static const char gps_cmd_gpsp0[] PROGMEM = "AT$GPSP=0";
+static const char gps_cmd_gpsp1[] PROGMEM = "AT$GPSP=1";
+static const char gps_cmd_gpsat0[] PROGMEM = "AT$GPSAT=0";
+static const char gps_cmd_gpsat1[] PROGMEM = "AT$GPSAT=1";
+static const char gps_cmd_gpsav[] PROGMEM = "AT$GPSAV";
+static const char gps_cmd_gpsai[] PROGMEM = "AT$GPSAI?";
+
+static const char gps_resp_ok[] PROGMEM = "OK";
+static const char gps_resp_gpssw[] PROGMEM = "$GPSSW";
+static const char gps_resp_gpsav[] PROGMEM = "$GPSAV";
+static const char gps_resp_gpsai[] PROGMEM = "$GPSAI";
+
+static const ATCmdDesc gps_cmds[GPS_CMD_LAST_ITEM] PROGMEM = {
+  {gps_cmd_gpssw, gps_resp_gpssw, AT_TMOUT_CLASS_XLONG, 1, ParseSwVers},
+  {gps_cmd_gpsp0, gps_resp_ok, AT_TMOUT_CLASS_XLONG, 1, NULL},
+  {gps_cmd_gpsp1, gps_resp_ok, AT_TMOUT_CLASS_XLONG, 1, NULL},
+  {gps_cmd_gpsat0, gps_resp_ok, AT_TMOUT_CLASS_XLONG, 1, NULL},
+  {gps_cmd_gpsat1, gps_resp_ok, AT_TMOUT_CLASS_XLONG, 1, NULL},
+  {gps_cmd_gpsav, gps_resp_gpsav, AT_TMOUT_CLASS_XLONG, 1, AT::ParseDescNum},
+  {gps_cmd_gpsai, gps_resp_gpsai, AT_TMOUT_CLASS_XLONG, 1, AT::ParseDescNum},
+};
+
+
 
 /**********************************************************
 Constructor
@@ -92,30 +135,11 @@ an example of usage:
 char GPS_GE863::ResetGPSModul(byte reset_type) 
 {
   char ret_val = -1;
-  char cmd[15];
 
 
-  if (CLS_FREE != gsm.GetCommLineStatus()) return (ret_val);
-  gsm.SetCommLineStatus(CLS_ATCMD);
-  // prepare command:  AT$GPSR=X ; X = "0" "1" "2" "3"
-  strcpy(cmd, "AT$GPSR=");
-
-  switch (reset_type) {
-    case GPS_RESET_HW:
-      strcat_P(cmd, PSTR("0")); // add character "0"
-      break;
-    case GPS_RESET_COLDSTART:
-      strcat_P(cmd, PSTR("1")); // add character "1"
-      break;
-    case GPS_RESET_WARMSTART:
-      strcat_P(cmd, PSTR("2")); // add character "2"
-      break;
-    case GPS_RESET_HOTSTART:
-      strcat_P(cmd, PSTR("3")); // add character "3"
-      break;
-  }
-
-  ret_val = gsm.SendATCmdWaitResp(cmd, 5000, 100, "OK", 1);
+  if (!gsm.AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+  // AT$GPSR=X ; X = "0" "1" "2" "3" is the value of the GPS_RESET_xxx
+  ret_val = gsm.SendATCmdWaitResp(ATLine(ATF("AT$GPSR="), reset_type), 5000, 100, "OK", 1);
   if (ret_val == AT_RESP_OK) {
     // OK response
     ret_val = 1;
@@ -148,28 +172,28 @@ an example of usage:
 **********************************************************/
 char GPS_GE863::GetGPSSwVers(char *sw_ver_string) 
 {
-  char ret_val = -1;
-  char *p_resp;
-  char *p_buf = (char*)&gsm.comm_buf[0];
-
-  if (CLS_FREE != gsm.GetCommLineStatus()) return (ret_val);
-  gsm.SetCommLineStatus(CLS_ATCMD);
-
+  sw_ver_string[0] = 0x00;
   // send command:  AT$GPSSW
-  ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSSW"), 5000, 100, "$GPSSW", 1);
-  if (ret_val == AT_RESP_OK) {
-    // OK response
-    // response example: {0D}{0A}$GPSSW: GSW3.2.4Ti_3.1.00.12-C23P1.00 {0D}{0A}{0D}{0A}OK{0D}{0A}
-    // copy firmware string to buffer
-    p_resp = gsm.Skip(p_buf, ':');                // Skip prolog 
-    p_resp = gsm.ReadToken(p_resp, sw_ver_string, '\r');     // until first {OD}
-    ret_val = 1;
-  }
-  else ret_val = 0;
+  return (gsm.RunATCmdDesc(&gps_cmds[GPS_CMD_SW_VERS], ATCMD_PRIO_NORMAL, sw_ver_string));
+}
+
+/**********************************************************
+Parser of the response to AT$GPSSW
+response example: {0D}{0A}$GPSSW: GSW3.2.4Ti_3.1.00.12-C23P1.00 {0D}{0A}{0D}{0A}OK{0D}{0A}
 
+ctx: buffer for GPS_SW_VERS_LEN characters 
+**********************************************************/
+static char ParseSwVers(const ATCmdDesc *, StrView *resp, void *ctx)
+{
+  StrView line;
 
-  gsm.SetCommLineStatus(CLS_FREE);
-  return (ret_val);
+  // copy firmware string to buffer
+  if (SVFindLineF(resp, PSTR("$GPSSW:"), &line)) {
+    SVSkipPast(&line, ':');                     // Skip prolog 
+    SVTrim(&line);                              // until first {OD}
+    SVCopy(&line, (char *)ctx, GPS_SW_VERS_LEN);
+  }
+  return (1);
 }
 
 /**********************************************************
@@ -197,28 +221,10 @@ an example of usage:
 **********************************************************/
 char GPS_GE863::GPSPowerUpOrDown(unsigned char command) 
 {
-  char ret_val = -1;
-
-
-  if (CLS_FREE != gsm.GetCommLineStatus()) return (ret_val);
-  gsm.SetCommLineStatus(CLS_ATCMD);
-
-  if (command == 0) {
-    // switch off the GPS module  
-    ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSP=0"), 5000, 100, "OK", 1);
-  }
-  else {
-    // switch on the GPS module(this is a default state)  
-    ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSP=1"), 5000, 100, "OK", 1);
-  }
-  if (ret_val == AT_RESP_OK) {
-    // OK response
-    ret_val = 1;
-  }
-  else ret_val = 0;
-
-  gsm.SetCommLineStatus(CLS_FREE);
-  return (ret_val);
+  // AT$GPSP=0 switches off the GPS module
+  // AT$GPSP=1 switches on the GPS module (this is a default state)
+  return (gsm.RunATCmdDesc(&gps_cmds[(command == 0) ? GPS_CMD_POWER_DOWN : GPS_CMD_POWER_UP], 
+                           ATCMD_PRIO_NORMAL, NULL));
 }
 
 /**********************************************************
@@ -247,28 +253,9 @@ an example of usage:
 **********************************************************/
 char GPS_GE863::ControlGPSAntenna(unsigned char command) 
 {
-  char ret_val = -1;
-
-
-  if (CLS_FREE != gsm.GetCommLineStatus()) return (ret_val);
-  gsm.SetCommLineStatus(CLS_ATCMD);
-
-  if (command == 0) {
-    // send command:  AT$GPSAT=0
-    ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSAT=0"), 5000, 100, "OK", 1);
-  }
-  else {
-    // send command:  AT$GPSAT=1
-    ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSAT=1"), 5000, 100, "OK", 1);
-  }
-  if (ret_val == AT_RESP_OK) {
-    // OK response
-    ret_val = 1;
-  }
-  else ret_val = 0;
-  
-  gsm.SetCommLineStatus(CLS_FREE);
-  return (ret_val);
+  // send command:  AT$GPSAT=0 or AT$GPSAT=1
+  return (gsm.RunATCmdDesc(&gps_cmds[(command == 0) ? GPS_CMD_ANTENNA_OFF : GPS_CMD_ANTENNA_ON], 
+                           ATCMD_PRIO_NORMAL, NULL));
 }
 
 /**********************************************************
@@ -296,30 +283,13 @@ an example of usage:
 **********************************************************/
 char GPS_GE863::GetGPSAntennaSupplyVoltage(unsigned short *redout_voltage) 
 {
-  char ret_val = -1;
-
-  char *p_resp;
-  char *p_buf = (char*)&gsm.comm_buf[0];
-  char val_str[5];
-
-  if (CLS_FREE != gsm.GetCommLineStatus()) return (ret_val);
-  gsm.SetCommLineStatus(CLS_ATCMD);
+  char ret_val;
+  long val;
 
-  *redout_voltage = 0; //until now
   // send command:  AT$GPSAV
-  ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSAV"), 5000, 100, "$GPSAV", 1);
-  if (ret_val == AT_RESP_OK) {
-    // OK response
-    // response example: {0D}{0A}$GPSAV: 3962{0D}{0A}{0D}{0A}OK{0D}{0A}
-    p_resp = gsm.Skip(p_buf, ':');                // Skip prolog 
-    p_resp = gsm.ReadToken(p_resp, val_str, '\r');     // until first {OD}
-    *redout_voltage = atoi(val_str);
-    ret_val = 1;
-  }
-  else ret_val = 0;
-
-
-  gsm.SetCommLineStatus(CLS_FREE);
+  // response example: {0D}{0A}$GPSAV: 3962{0D}{0A}{0D}{0A}OK{0D}{0A}
+  ret_val = gsm.RunATCmdDesc(&gps_cmds[GPS_CMD_ANTENNA_VOLTAGE], ATCMD_PRIO_NORMAL, &val);
+  if (ret_val >= 0) *redout_voltage = (ret_val == 1) ? val : 0;
   return (ret_val);
 }
 
@@ -348,31 +318,13 @@ an example of usage:
 **********************************************************/
 char GPS_GE863::GetGPSAntennaCurrent(unsigned short *redout_current) 
 {
-  char ret_val = -1;
-
-  char *p_resp;
-  char *p_buf = (char*)&gsm.comm_buf[0];
-  char val_str[5];
-
+  char ret_val;
+  long val;
 
-  if (CLS_FREE != gsm.GetCommLineStatus()) return (ret_val);
-  gsm.SetCommLineStatus(CLS_ATCMD);
-
-  *redout_current = 0; // until now
   // send command:  AT$GPSAI?
-  ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSAI?"), 5000, 100, "$GPSAI", 1);
-  if (ret_val == AT_RESP_OK) {
-    // OK response
-    // response example: {0D}{0A}$GPSAI: 0{0D}{0A}{0D}{0A}OK{0D}{0A}
-    p_resp = gsm.Skip(p_buf, ':');                // Skip prolog 
-    p_resp = gsm.ReadToken(p_resp, val_str, '\r');     // until first {OD}
-    *redout_current = atoi(val_str);
-    ret_val = 1;
-  }
-  else ret_val = 0;
-
-
-  gsm.SetCommLineStatus(CLS_FREE);
+  // response example: {0D}{0A}$GPSAI: 0{0D}{0A}{0D}{0A}OK{0D}{0A}
+  ret_val = gsm.RunATCmdDesc(&gps_cmds[GPS_CMD_ANTENNA_CURRENT], ATCMD_PRIO_NORMAL, &val);
+  if (ret_val >= 0) *redout_current = (ret_val == 1) ? val : 0;
   return (ret_val);
 }
 
@@ -407,18 +359,18 @@ an example of usage:
 char GPS_GE863::GetGPSData(Position *position, Time *time, Date *date)
 {
   char ret_val = -1;
-  char cmd[15];
+  StrView resp;
 
 
-  if (CLS_FREE != gsm.GetCommLineStatus()) return (ret_val);
-  gsm.SetCommLineStatus(CLS_ATCMD);
+  if (!gsm.AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
 
   ret_val = gsm.SendATCmdWaitRespF(PSTR("AT$GPSACP"), 5000, 100, "", 1);
   if (ret_val == AT_RESP_OK) {
     // there is some response
     // ----------------------
     actual_position.fix = 0;
-    ParseGPS((char *)&gsm.comm_buf[0], &actual_position, &actual_time, &actual_date);
+    gsm.GetRespView(&resp);
+    ParseGPS(&resp, &actual_position, &actual_time, &actual_date);
     if (actual_position.fix > 0) {
       // coordinates were read correctly
       // -------------------------------
@@ -450,10 +402,13 @@ char GPS_GE863::GetGPSData(Position *position, Time *time, Date *date)
 
 
 /**********************************************************
-Method parse the given "GPS" string into a position, time and date record
+Method parse the given "GPS" response into a position, time and date record
+The response is parsed in one pass directly in the comm. buffer
+(see StrView.h) so malformed or truncated response can not 
+overflow any buffer
 
 input:
- gpsMsg: pointer to "GPS" string like $GPSACP: 120631.999,5433.9472N,00954.8768E,1.0,46.5,3,167.28,0.36,0.19,130707,11\r
+ resp: view of the "GPS" response like $GPSACP: 120631.999,5433.9472N,00954.8768E,1.0,46.5,3,167.28,0.36,0.19,130707,11\r
 
 
 return: 
@@ -461,95 +416,78 @@ return:
         time: pointer to time structure where time is extracted from gpsMsg string
         date: pointer to date structure where date is extracted from gpsMsg string
  **********************************************************/
-void GPS_GE863::ParseGPS(char *gpsMsg, Position *pos, Time *time, Date *date) {
-
-  char time_str[7];
-  char lat_buf[12];
-  char lon_buf[12];
-  char alt_buf[7];
-  char fix;
-  char date_str[7];
-  char nr_sat[4];
+void GPS_GE863::ParseGPS(StrView *resp, Position *pos, Time *time, Date *date) {
+
+  StrView line;
+  StrView time_str;
+  StrView lat_str;
+  StrView lon_str;
+  StrView alt_str;
+  StrView fix_str;
+  StrView date_str;
+  StrView field;
+  char fix = '0';
 
 	//$GPSACP: 120631.999,5433.9472N,00954.8768E,1.0,46.5,3,167.28,0.36,0.19,130707,11\r
 
-  gpsMsg = gsm.Skip(gpsMsg, ':');                // Skip prolog
-  gpsMsg = gsm.ReadToken(gpsMsg, time_str, '.');     // time, hhmmss
-  gpsMsg = gsm.Skip(gpsMsg, ',');                // Skip ms
-  gpsMsg = gsm.ReadToken(gpsMsg, lat_buf, ',');  // latitude
-  gpsMsg = gsm.ReadToken(gpsMsg, lon_buf, ',');  // longitude
-  gpsMsg = gsm.Skip(gpsMsg, ',');                // hdop
-  gpsMsg = gsm.ReadToken(gpsMsg, alt_buf, ',');  // altitude
-  fix = *gpsMsg++;                           // fix, 0, 2d, 3d
-  gpsMsg++;
-  gpsMsg = gsm.Skip(gpsMsg, ',');                // cog, cource over ground
-  gpsMsg = gsm.Skip(gpsMsg, ',');                // speed [km]
-  gpsMsg = gsm.Skip(gpsMsg, ',');                // speed [kn]
-  gpsMsg = gsm.ReadToken(gpsMsg, date_str, ',');     // date ddmmyy
-  gpsMsg = gsm.ReadToken(gpsMsg, nr_sat, '\n');  // number of sats
-
-
-
-  if (fix != '0') {
-    ParseDateTime(time_str, date_str, time, date);
-    ParsePosition(lat_buf, lon_buf, alt_buf, pos);
+  pos->fix = 0;
+  if (!SVFindLineF(resp, PSTR("$GPSACP:"), &line)) return;
+  SVSkipPast(&line, ':');                       // Skip prolog
+  if (!SVNextField(&line, &time_str, ',')) return; // time, hhmmss.sss
+  if (!SVNextField(&line, &lat_str, ',')) return;  // latitude
+  if (!SVNextField(&line, &lon_str, ',')) return;  // longitude
+  SVNextField(&line, &field, ',');              // hdop
+  if (!SVNextField(&line, &alt_str, ',')) return;  // altitude
+  if (!SVNextField(&line, &fix_str, ',')) return;  // fix, 0, 2d, 3d
+  SVNextField(&line, &field, ',');              // cog, cource over ground
+  SVNextField(&line, &field, ',');              // speed [km]
+  SVNextField(&line, &field, ',');              // speed [kn]
+  if (!SVNextField(&line, &date_str, ',')) return; // date ddmmyy
+  //SVNextField(&line, &field, ',');            // number of sats
+
+  if (fix_str.len) fix = fix_str.ptr[0];
+  if ((fix > '0') && (fix <= '9')) {
+    ParseDateTime(&time_str, &date_str, time, date);
+    ParsePosition(&lat_str, &lon_str, &alt_str, pos);
     pos->fix = fix - '0';
   }
-  else {
-    pos->fix = 0;
-  }
-
 }
 
 
 
 /*
- * Parse and convert the position tokens. 
+ * Parse and convert the time "hhmmss.sss" and date "ddmmyy" tokens. 
  */
-void GPS_GE863::ParseDateTime(char *time_str, char *date_str, Time *time, Date *date) {
-  char buf[3];
+void GPS_GE863::ParseDateTime(StrView *time_str, StrView *date_str, Time *time, Date *date) {
+  long val;
 
   // time string "hhmmss"
-  // hours
-  memcpy(&buf[0], &time_str[0], 2);
-  buf[2] = 0x00;
-  time->hours = atoi(buf);
-  // min
-  memcpy(&buf[0], &time_str[2], 2);
-  buf[2] = 0x00;
-  time->min = atoi(buf);
-  // sec
-  memcpy(&buf[0], &time_str[4], 2);
-  buf[2] = 0x00;
-  time->sec = atoi(buf);
+  if (SVToFixed(time_str, 0, &val)) {
+    time->hours = val / 10000;
+    time->min = (val / 100) % 100;
+    time->sec = val % 100;
+  }
 
   // date string "ddmmyy"
-  // day
-  memcpy(&buf[0], &date_str[0], 2);
-  buf[2] = 0x00;
-  date->day = atoi(buf);
-  // month
-  memcpy(&buf[0], &date_str[2], 2);
-  buf[2] = 0x00;
-  date->month = atoi(buf);
-  // year
-  memcpy(&buf[0], &date_str[4], 2);
-  buf[2] = 0x00;
-  date->year = atoi(buf);
-  date->year += 2000;
+  if (SVToLong(date_str, &val)) {
+    date->day = val / 10000;
+    date->month = (val / 100) % 100;
+    date->year = (val % 100) + 2000;
+  }
 }
 
 
 /*
  * Parse and convert the position tokens. 
  */
-void GPS_GE863::ParsePosition(char *lat_str, char *lon_str, char *alt_str, Position *pos) {
-  char buf[10];
+void GPS_GE863::ParsePosition(StrView *lat_str, StrView *lon_str, StrView *alt_str, Position *pos) {
+  long val;
 
   ParseRawPosition(lat_str, &pos->latitude_raw, &pos->latitude_dir);
   ParseRawPosition(lon_str, &pos->longitude_raw, &pos->longitude_dir);
-  gsm.ReadToken(alt_str, buf, '.');
-  pos->altitude = atol(buf);
+  // only whole meters
+  if (SVToFixed(alt_str, 0, &val)) pos->altitude = val;
+  else pos->altitude = 0;
 }
 
 
@@ -561,7 +499,7 @@ void GPS_GE863::ParsePosition(char *lat_str, char *lon_str, char *alt_str, Posit
  * converted to: 53339472
   */
 void GPS_GE863::ParseRawPosition(
-char *pos_str,  // latitute/longitude string in formats
+StrView *pos_str, // latitute/longitude string in formats
                 // latitude:   "ddmm.mmmmX"   where dd - degrees(00.90), 
                 //                                  mm.mmmm - minutes(00.0000..59.9999)
                 //                                  X = N or S
@@ -576,20 +514,20 @@ char *direction_char          // for latitude:  "N" or "S"
                               // for longitude: "E" or "W"
 ) 
 {
-  char *parseptr;
-  unsigned long local_raw_pos;
-
-  parseptr = pos_str;
-  local_raw_pos = atol(parseptr);
-  if (local_raw_pos != 0) {
-    local_raw_pos *= 10000;
-    parseptr = strchr(parseptr, '.')+1;
-    local_raw_pos += atol(parseptr);
-  }
-  *raw_position = local_raw_pos;
+  StrView num_str;
+  long local_raw_pos;
+
+  *raw_position = 0;
+  *direction_char = 0;
+  if (pos_str->len < 2) return;
 
   // read latitude N/S or longitude E/W data
-  *direction_char = parseptr[4]; 
+  *direction_char = pos_str->ptr[pos_str->len - 1];
+  // 4 decimal places of minutes
+  SVInit(&num_str, pos_str->ptr, pos_str->len - 1);
+  if (SVToFixed(&num_str, 4, &local_raw_pos) && (local_raw_pos > 0)) {
+    *raw_position = local_raw_pos;
+  }
 }
 
 
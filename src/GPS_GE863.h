@@ -21,14 +21,25 @@
 #include "GSM_GE863.h"
 
 
-#define GPS_LIB_VERSION 100 // library version X.YY (e.g. 1.00)
+#define GPS_LIB_VERSION 102 // library version X.YY (e.g. 1.00)
 /*
     Version
     --------------------------------------------------------------------------
     100       Initial version
     --------------------------------------------------------------------------
+    101       methods wait for the comm. line occupied by the AT command engine
+              (see AcquireCommLine() in AT library 107)
+    --------------------------------------------------------------------------
+    102       AT commands are described by the table in the Flash memory
+              and run by RunATCmdDesc() (see AT library 122)
+    --------------------------------------------------------------------------
 */
 
+// max. length of the GPS firmware string (including 0x00)
+#ifndef GPS_SW_VERS_LEN
+  #define GPS_SW_VERS_LEN       50
+#endif
+
 enum reset_type_enum
 {
   GPS_RESET_HW = 0,
@@ -102,10 +113,10 @@ class GPS_GE863
 
 
   private:
-    void ParseGPS(char *gpsMsg, Position *pos, Time *time, Date *date);
-    void ParseDateTime(char *time_str, char *date_str, Time *time, Date *date);
-    void ParsePosition(char *lat_str, char *lon_str, char *alt_str, Position *pos);
-    void ParseRawPosition(char *pos_str,
+    void ParseGPS(StrView *resp, Position *pos, Time *time, Date *date);
+    void ParseDateTime(StrView *time_str, StrView *date_str, Time *time, Date *date);
+    void ParsePosition(StrView *lat_str, StrView *lon_str, StrView *alt_str, Position *pos);
+    void ParseRawPosition(StrView *pos_str,
                           unsigned long *raw_position,
                           char *direction_char); 
     Position actual_position;
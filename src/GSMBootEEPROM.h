@@ -0,0 +1,79 @@
+/*
+  GSMBootEEPROM.h - EEPROM store of the fast boot record for the GSM
+  Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __GSMBOOTEEPROM_h
+#define __GSMBOOTEEPROM_h
+
+#include "Arduino.h"
+#include "GSM_GE863.h"
+#include <EEPROM.h>
+
+/*
+    GSMBootEEPROMStore keeps the record of the stored module
+    configuration (see GSM::SetBootStore()) in the EEPROM
+    - only this header includes EEPROM.h so the library does not
+      depend on the EEPROM library unless the store is used
+    - the record takes GSM_BOOT_EEPROM_LEN bytes from the address:
+      magic word followed by the GSMBootRecord
+    - the record is written once after the full initialization,
+      unchanged bytes are not written again (EEPROM.update())
+
+    an example of usage:
+        GSMBootEEPROMStore boot_store(0);
+
+        gsm.SetBootStore(&boot_store);
+        gsm.TurnOn();
+        ...
+        // the whole initialization is forced at the next boot
+        boot_store.Clear();
+*/
+
+#define GSM_BOOT_EEPROM_MAGIC   0x4742
+#define GSM_BOOT_EEPROM_LEN     (sizeof(uint16_t) + sizeof(GSMBootRecord))
+
+
+class GSMBootEEPROMStore : public GSMBootStore
+{
+  public:
+    GSMBootEEPROMStore(int addr) {address = addr;};
+
+    virtual byte Load(GSMBootRecord *record) {
+      uint16_t magic;
+
+      EEPROM.get(address, magic);
+      if (magic != GSM_BOOT_EEPROM_MAGIC) return (0);
+      EEPROM.get(address + sizeof(magic), *record);
+      return (1);
+    };
+    virtual void Save(const GSMBootRecord *record) {
+      uint16_t magic = GSM_BOOT_EEPROM_MAGIC;
+
+      EEPROM.put(address + sizeof(magic), *record);
+      EEPROM.put(address, magic);
+    };
+    // record is not valid any more
+    void Clear(void) {
+      EEPROM.update(address, 0xff);
+      EEPROM.update(address + 1, 0xff);
+    };
+
+  private:
+    int address;                    // first byte of the record
+};
+
+#endif
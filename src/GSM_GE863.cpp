@@ -34,6 +34,75 @@ extern "C" {
 GSM gsm;
 
 
+/**********************************************************
+AT commands of the GSM part (see RunATCmdDesc())
+**********************************************************/
+enum gsm_cmd_enum
+{
+  GSM_CMD_SPEAKER_OFF = 0,
+  GSM_CMD_SPEAKER_ON,
+  GSM_CMD_LED_OFF,
+  GSM_CMD_LED_ON,
+
+  GSM_CMD_LAST_ITEM
+};
+
+static const char gsm_cmd_speaker_off[] PROGMEM = "AT#GPIO=5,0,2";
+static const char gsm_cmd_speaker_on[] PROGMEM = "AT#GPIO=5,1,2";
+static const char gsm_cmd_led_off[] PROGMEM = "AT#GPIO=8,0,1";
+static const char gsm_cmd_led_on[] PROGMEM = "AT#GPIO=8,1,1";
+
+static const char gsm_resp_gpio[] PROGMEM = "#GPIO:";
+
+static const ATCmdDesc gsm_cmds[GSM_CMD_LAST_ITEM] PROGMEM = {
+  {gsm_cmd_speaker_off, gsm_resp_gpio, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  {gsm_cmd_speaker_on, gsm_resp_gpio, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  {gsm_cmd_led_off, gsm_resp_gpio, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  {gsm_cmd_led_on, gsm_resp_gpio, AT_TMOUT_CLASS_SHORT, 1, NULL},
+};
+
+/**********************************************************
+Parameters sent by InitParam() which are not kept in the 
+module profile (see BatchAddDesc())
+**********************************************************/
+enum gsm_init_cmd_enum
+{
+  GSM_INIT_LED_ON = 0,
+  GSM_INIT_BUTTON_INPUT,
+  GSM_INIT_SPEAKER_CTRL,
+  GSM_INIT_CREG,
+  GSM_INIT_LED_OFF,
+  GSM_INIT_CPBS,
+  GSM_INIT_CSCS,
+
+  GSM_INIT_LAST_ITEM
+};
+
+static const char gsm_init_button_input[] PROGMEM = "AT#GPIO=9,0,0";
+static const char gsm_init_creg[] PROGMEM = "AT+CREG=1";
+static const char gsm_init_cpbs[] PROGMEM = "AT+CPBS=\"SM\"";
+static const char gsm_init_cscs[] PROGMEM = "AT+CSCS=\"8859-1\"";
+
+static const char gsm_resp_ok[] PROGMEM = "OK";
+
+static const ATCmdDesc gsm_init_cmds[GSM_INIT_LAST_ITEM] PROGMEM = {
+  // Switch ON User LED - just as signalization we are here
+  {gsm_cmd_led_on, gsm_resp_ok, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  // Sets GPIO9 as an input = user button
+  {gsm_init_button_input, gsm_resp_ok, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  // allow audio amplifier control
+  {gsm_cmd_speaker_off, gsm_resp_ok, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  // +CREG: <stat> URC is sent when the registration is changed
+  {gsm_init_creg, gsm_resp_ok, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  // Switch OFF User LED- just as signalization we are finished
+  {gsm_cmd_led_off, gsm_resp_ok, AT_TMOUT_CLASS_SHORT, 1, NULL},
+  // select phonebook memory storage
+  {gsm_init_cpbs, gsm_resp_ok, AT_TMOUT_CLASS_LONG, 1, NULL},
+  // set character set ISO 8859
+  {gsm_init_cscs, gsm_resp_ok, AT_TMOUT_CLASS_LONG, 1, NULL},
+};
+
+
 
 
 /**********************************************************
@@ -66,8 +135,29 @@ GSM::GSM(void)
   
   // initialization of speaker volume
   last_speaker_volume = 0;
+  // all parameters are sent until the boot store is set
+  boot_store = NULL;
+  boot_fast = 0;
   // until now IP address has not been assigned
   strcpy(IP_address, "0.0.0.0");
+  // socket closing is detected in the received data, no delimiter so far
+  SSInitF(&rcv_close_search, PSTR("\r\nNO CARRIER\r\n"));
+  SSInit(&rcv_delimiter_search, "");
+  rcv_delimiter_pos = -1;
+  // switching on is not in progress
+  turnon_step = TURNON_STEP_IDLE;
+  turnon_attempt = 0;
+  turnon_max_attempts = 0;
+  turnon_time = 0;
+#ifdef GSM_CACHE_ENABLED
+  // default TTLs
+  SetCacheTTL(GSM_CACHE_REG, GSM_CACHE_TTL_REG);
+  SetCacheTTL(GSM_CACHE_TEMP, GSM_CACHE_TTL_TEMP);
+  SetCacheTTL(GSM_CACHE_BUTTON, GSM_CACHE_TTL_BUTTON);
+  for (byte i = GSM_CACHE_GPIO10; i <= GSM_CACHE_GPIO13; i++) SetCacheTTL(i, GSM_CACHE_TTL_GPIO);
+  for (byte i = GSM_CACHE_SOCKET1; i <= GSM_CACHE_SOCKET6; i++) SetCacheTTL(i, GSM_CACHE_TTL_SOCKET);
+  InvalidateCache(GSM_CACHE_ALL);
+#endif
 }
 
 
@@ -95,135 +185,437 @@ byte GSM::IsInitialized(void)
   Checks if the GSM module is responding 
   to the AT command
   - if YES  nothing is made 
-  - if NO   switch on sequence is repeated until there is a response
-            from GSM module
+  - if NO   the module is looked for at the other baud rates
+            (AT_AUTOBAUD_ENABLED) and then switch on sequence 
+            is repeated until there is a response from GSM module
+  - baud rate is raised to the rate given to InitSerLine() 
+    or SetMaxBaudRate() (AT_AUTOBAUD_ENABLED)
+
+  - blocking variant of StartTurnOn() and PollTurnOn(), 
+    the number of attempts is not limited
 **********************************************************/
 void GSM::TurnOn(void)
 {
+  StartTurnOn(0);
+  while (PollTurnOn() == TURNON_BUSY);
+}
+
+/**********************************************************
+Method starts the switching on of the GSM module which is
+then processed by PollTurnOn() called regularly e.g. from 
+the loop(), other things can be done meanwhile
+(e.g. warm-up of the sensors, start of the GPS)
+
+- the sequence is the same like in TurnOn(): "AT" check, 
+  switch on pulse, reset pulse (not for GE836_GPS), waiting 
+  and next "AT" check...
+- the comm. line is occupied until the switching on is 
+  finished (other methods return their "comm. line is busy" 
+  values)
+- baud rate detection (AT_AUTOBAUD_ENABLED) and sending of 
+  the initialization parameters block for a while
+
+max_attempts: max. num. of the switch on sequences 
+              (0 - not limited)
+
+an example of usage:
+        void setup()
+        {
+          gsm.InitSerLine(115200);
+          gsm.StartTurnOn(5);
+          ...
+        }
+
+        void loop()
+        {
+          switch (gsm.PollTurnOn()) {
+            case TURNON_BUSY:
+              // e.g. gsm.GetTurnOnStep(), gsm.GetTurnOnAttempt()
+              break;
+            case TURNON_OK:
+              // module is on
+              break;
+            case TURNON_FAILED:
+              // module does not respond e.g. power supply problem
+              break;
+          }
+          ...
+        }
+**********************************************************/
+void GSM::StartTurnOn(byte max_attempts)
+{
+#ifdef GSM_CACHE_ENABLED
+  // module could be reset
+  InvalidateCache(GSM_CACHE_ALL);
+#endif
   SetCommLineStatus(CLS_ATCMD);
+  turnon_attempt = 0;
+  turnon_max_attempts = max_attempts;
+  StartTurnOnCheck();
+}
 
+void GSM::StartTurnOnCheck(void)
+{
+  SetupATCmd(&turnon_cmd, PSTR("AT"), ATCMD_FLAG_PGM, 500, 20, "OK", 5, NULL);
+  SetTurnOnStep(TURNON_STEP_CHECK);
+  // command is started by PollTurnOn() in case the engine is busy
+  StartATCmd(&turnon_cmd);
+}
 
-  while (AT_RESP_ERR_NO_RESP == SendATCmdWaitRespF(PSTR("AT"), 500, 20, "OK", 5)) {
-    // there is no response => turn on the module
-      
-    // generate switch on pulse
-    digitalWrite(GSM_ON, HIGH);
-    delay(1200);
-    digitalWrite(GSM_ON, LOW);
-    delay(1200);
+/**********************************************************
+Method processes the switching on started by StartTurnOn()
+- it never waits except the baud rate detection and sending
+  of the initialization parameters
 
-#ifdef DEBUG_PRINT
-    // parameter 0 - because module is off so it is not necessary 
-    // to send finish AT<CR> here
-    DebugPrintF(PSTR("DEBUG: GSM module is off\r\n"), 0);
+return: 
+        TURNON_IDLE   - switching on is not in progress
+        TURNON_BUSY   - switching on is in progress
+        TURNON_OK     - module has just responded
+        TURNON_FAILED - module has not responded after 
+                        max_attempts switch on sequences
+**********************************************************/
+byte GSM::PollTurnOn(void)
+{
+  unsigned long elapsed = millis() - turnon_time;
+
+  switch (turnon_step) {
+    case TURNON_STEP_IDLE:
+      return (TURNON_IDLE);
+
+    case TURNON_STEP_CHECK:
+      if (turnon_cmd.state == ATCMD_IDLE) {
+        // previous command must be finished first
+        if (StartATCmd(&turnon_cmd) < 0) PollATCmd();
+        break;
+      }
+      PollATCmd();
+      if (turnon_cmd.state != ATCMD_FINISHED) break;
+      if (turnon_cmd.result != AT_RESP_ERR_NO_RESP) return (FinishTurnOn());
+#ifdef AT_AUTOBAUD_ENABLED
+      // module can be on but it uses other baud rate
+      // (DetectBaudRate() acquires the comm. line itself)
+      SetCommLineStatus(CLS_FREE);
+      if (DetectBaudRate() > 0) return (FinishTurnOn());
+      SetCommLineStatus(CLS_ATCMD);
 #endif
+      if (turnon_max_attempts && (turnon_attempt >= turnon_max_attempts)) {
+        turnon_step = TURNON_STEP_IDLE;
+        SetCommLineStatus(CLS_FREE);
+        return (TURNON_FAILED);
+      }
+      // there is no response => turn on the module
+      // generate switch on pulse
+      turnon_attempt++;
+      digitalWrite(GSM_ON, HIGH);
+      SetTurnOnStep(TURNON_STEP_ON_PULSE);
+      break;
+
+    case TURNON_STEP_ON_PULSE:
+      if (elapsed < TURNON_ON_PULSE) break;
+      digitalWrite(GSM_ON, LOW);
+      SetTurnOnStep(TURNON_STEP_ON_PAUSE);
+      break;
 
+    case TURNON_STEP_ON_PAUSE:
+      if (elapsed < TURNON_ON_PAUSE) break;
+#ifdef DEBUG_PRINT
+      DebugPrintF(PSTR("DEBUG: GSM module is off\r\n"), 0);
+#endif
 #ifndef GE836_GPS
-    // Be aware: reset pin on the new GE836-GPS module has different functionionlity:
-    // it does not mean reset(as for GE836 without GPS) but "Hardware Unconditional Shutdown"
-
-    // reset the module GE836 just for sure
-    // this is helpful mainly in situation when GSM Playground+Arduino board are reseted
-    // (and not switched-off and switched-on)during development
-    digitalWrite(GSM_RESET, HIGH);
-    delay(400);
-    digitalWrite(GSM_RESET, LOW);
-    delay(500);
+      // Be aware: reset pin on the new GE836-GPS module has different functionionlity:
+      // it does not mean reset(as for GE836 without GPS) but "Hardware Unconditional Shutdown"
+
+      // reset the module GE836 just for sure
+      // this is helpful mainly in situation when GSM Playground+Arduino board are reseted
+      // (and not switched-off and switched-on)during development
+      digitalWrite(GSM_RESET, HIGH);
+      SetTurnOnStep(TURNON_STEP_RESET_PULSE);
+#else
+      SetTurnOnStep(TURNON_STEP_WAIT);
 #endif
-   
+      break;
+
+    case TURNON_STEP_RESET_PULSE:
+      if (elapsed < TURNON_RESET_PULSE) break;
+      digitalWrite(GSM_RESET, LOW);
+      SetTurnOnStep(TURNON_STEP_RESET_PAUSE);
+      break;
+
+    case TURNON_STEP_RESET_PAUSE:
+      if (elapsed < TURNON_RESET_PAUSE) break;
+      SetTurnOnStep(TURNON_STEP_WAIT);
+      break;
 
-    delay(3000); // wait before next try
+    case TURNON_STEP_WAIT:
+      // wait before next try
+      if (elapsed < TURNON_NEXT_CHECK) break;
+      StartTurnOnCheck();
+      break;
   }
+  return (TURNON_BUSY);
+}
+
+/**********************************************************
+Method sends the first initialization parameters when
+the module responds
+**********************************************************/
+byte GSM::FinishTurnOn(void)
+{
+  turnon_step = TURNON_STEP_IDLE;
   SetCommLineStatus(CLS_FREE);
 
   // send collection of first initialization parameters for the GSM module    
   InitParam(PARAM_SET_0);
+#ifdef AT_AUTOBAUD_ENABLED
+  if (GetBaudRate() < GetMaxBaudRate()) UpshiftBaudRate();
+#endif
+  return (TURNON_OK);
 }
 
 
 /**********************************************************
-  Sends parameters for initialization of GSM module
+  Adds parameters which are kept in the module profile
+  (see SetBootStore()) to the batch
 
-  group:  0 - parameters of group 0 - not necessary to be registered in the GSM
-          1 - parameters of group 1 - it is necessary to be registered
+  group:  PARAM_SET_0 or PARAM_SET_1
+  string: buffer for 20 characters which must be valid
+          until the batch is run
 **********************************************************/
-void GSM::InitParam(byte group)
+void GSM::AddProfileParams(ATBatch *batch, byte group, char *string)
 {
-  char string[20];
-
   switch (group) {
     case PARAM_SET_0:
-      // check comm line
-      if (CLS_FREE != GetCommLineStatus()) return;
-      SetCommLineStatus(CLS_ATCMD);
-
       // Reset to the factory settings
-      SendATCmdWaitRespF(PSTR("AT&F1"), 1000, 20, "OK", 5);      
+      BatchAddF(batch, PSTR("AT&F1"), 1000);
       // switch off echo
-      SendATCmdWaitRespF(PSTR("ATE0"), 500, 20, "OK", 5);
+      BatchAddF(batch, PSTR("ATE0"), 500);
+      // RTS/CTS flow control of the module according to the transport
+      if (GetFlowControl()) BatchAddF(batch, PSTR("AT&K3"), 500);
+      else BatchAddF(batch, PSTR("AT&K0"), 500);
       // setup fixed baud rate
-      //      SendATCmdWaitRespF(PSTR("AT+IPR=115200"), 500, 20, "OK", 5);
+      //      BatchAddF(batch, PSTR("AT+IPR=115200"), 500);
       sprintf(string, "AT+IPR=%li", actual_baud_rate);
-      SendATCmdWaitResp(string, 500, 20, "OK", 5);
+      BatchAdd(batch, string, 500);
       // setup communication mode
 #ifndef GE836_GPS
-      SendATCmdWaitRespF(PSTR("AT#SELINT=1"), 500, 20, "OK", 5);
+      BatchAddF(batch, PSTR("AT#SELINT=1"), 500);
 #else
-      SendATCmdWaitRespF(PSTR("AT#SELINT=2"), 500, 20, "OK", 5);
+      BatchAddF(batch, PSTR("AT#SELINT=2"), 500);
 #endif
-      // Switch ON User LED - just as signalization we are here
-      SendATCmdWaitRespF(PSTR("AT#GPIO=8,1,1"), 500, 20, "OK", 5);
-      // Sets GPIO9 as an input = user button
-      SendATCmdWaitRespF(PSTR("AT#GPIO=9,0,0"), 500, 20, "OK", 5);
-      // allow audio amplifier control
-      SendATCmdWaitRespF(PSTR("AT#GPIO=5,0,2"), 500, 20, "OK", 5);
-      // Switch OFF User LED- just as signalization we are finished
-      SendATCmdWaitRespF(PSTR("AT#GPIO=8,0,1"), 500, 20, "OK", 5);
-      // set character set 8859-1 - ISO 8859 Latin 1    
-      //SendATCmdWaitRespF(PSTR("AT+CSCS=\"8859-1\""), 500, 20, "OK", 5);
-      SetCommLineStatus(CLS_FREE);
       break;
 
     case PARAM_SET_1:
-      // check comm line
-      if (CLS_FREE != GetCommLineStatus()) return;
-      SetCommLineStatus(CLS_ATCMD);
-
       // Audio codec - Full Rate (for DTMF usage)
-      SendATCmdWaitRespF(PSTR("AT#CODEC=1"), 500, 20, "OK", 5);
+      BatchAddF(batch, PSTR("AT#CODEC=1"), 500);
       // Hands free audio path
-      SendATCmdWaitRespF(PSTR("AT#CAP=1"), 500, 20, "OK", 5);
-      // Echo canceller enabled 
-      SendATCmdWaitRespF(PSTR("AT#SHFEC=1"), 500, 20, "OK", 5);
+      BatchAddF(batch, PSTR("AT#CAP=1"), 500);
+      // Echo canceller enabled
+      BatchAddF(batch, PSTR("AT#SHFEC=1"), 500);
       // Ringer tone select (0 to 32)
-      SendATCmdWaitRespF(PSTR("AT#SRS=26,0"), 500, 20, "OK", 5);
-      // Microphone gain (0 to 7) - response here sometimes takes 
+      BatchAddF(batch, PSTR("AT#SRS=26,0"), 500);
+      // Microphone gain (0 to 7) - response here sometimes takes
       // more than 500msec. so 1000msec. is more safety
-      SendATCmdWaitRespF(PSTR("AT#HFMICG=7"), 1000, 20, "OK", 5);
-      // set the SMS mode to text 
-      SendATCmdWaitRespF(PSTR("AT+CMGF=1"), 500, 20, "OK", 5);
+      BatchAddF(batch, PSTR("AT#HFMICG=7"), 1000);
+      // set the SMS mode to text
+      BatchAddF(batch, PSTR("AT+CMGF=1"), 500);
       // Auto answer after first ring enabled
       // auto answer is not used
-      //SendATCmdWaitRespF(PSTR("ATS0=1"), 500, 20, "OK", 5);
+      //BatchAddF(batch, PSTR("ATS0=1"), 500);
 
       // select ringer path to handsfree
-      SendATCmdWaitRespF(PSTR("AT#SRP=1"), 500, 20, "OK", 5);
+      BatchAddF(batch, PSTR("AT#SRP=1"), 500);
       // select ringer sound level
-      SendATCmdWaitRespF(PSTR("AT+CRSL=2"), 500, 20, "OK", 5);
-      // we must release comm line because SetSpeakerVolume()
-      // checks comm line if it is free
+      BatchAddF(batch, PSTR("AT+CRSL=2"), 500);
+      break;
+  }
+}
+
+
+/**********************************************************
+  Sends parameters for initialization of GSM module
+
+  group:  0 - parameters of group 0 - not necessary to be registered in the GSM
+          1 - parameters of group 1 - it is necessary to be registered
+
+  parameters kept in the module profile are not sent in case
+  the stored profile is valid (see SetBootStore())
+**********************************************************/
+void GSM::InitParam(byte group)
+{
+  char string[20];
+  ATBatch batch;
+
+  // commands of the group are concatenated into as few command lines
+  // as possible (see BatchRun()) to minimize the num. of round trips
+  BatchInit(&batch);
+  switch (group) {
+    case PARAM_SET_0:
+      // check comm line
+      if (!AcquireCommLine(ATCMD_PRIO_LOW)) return;
+
+      // fast boot - only the fingerprint of the stored profile is read
+      boot_fast = 0;
+      if (boot_store != NULL) boot_fast = IsBootProfileValid();
+      if (!boot_fast) AddProfileParams(&batch, PARAM_SET_0, string);
+      // LED, user button and audio amplifier
+      BatchAddDesc(&batch, &gsm_init_cmds[GSM_INIT_LED_ON]);
+      BatchAddDesc(&batch, &gsm_init_cmds[GSM_INIT_BUTTON_INPUT]);
+      BatchAddDesc(&batch, &gsm_init_cmds[GSM_INIT_SPEAKER_CTRL]);
+#ifdef URC_ENABLED
+      // the URC invalidates the cached registration (see URCReceived())
+      BatchAddDesc(&batch, &gsm_init_cmds[GSM_INIT_CREG]);
+#endif
+      BatchAddDesc(&batch, &gsm_init_cmds[GSM_INIT_LED_OFF]);
+      BatchRun(&batch, 20, 5);
+      // set character set 8859-1 - ISO 8859 Latin 1    
+      //SendATCmdWaitRespF(PSTR("AT+CSCS=\"8859-1\""), 500, 20, "OK", 5);
       SetCommLineStatus(CLS_FREE);
-      // select speaker volume (0 to 14)
-      SetSpeakerVolume(9);
+      break;
+
+    case PARAM_SET_1:
+      // check comm line
+      if (!AcquireCommLine(ATCMD_PRIO_LOW)) return;
+
+      if (!boot_fast) {
+        AddProfileParams(&batch, PARAM_SET_1, string);
+        BatchRun(&batch, 20, 5);
+        // we must release comm line because SetSpeakerVolume()
+        // checks comm line if it is free
+        SetCommLineStatus(CLS_FREE);
+        // select speaker volume (0 to 14)
+        SetSpeakerVolume(GSM_INIT_SPEAKER_VOLUME);
+      }
+      else {
+        // SMS mode is not stored by AT&W in all firmware versions
+        SendATCmdWaitRespF(PSTR("AT+CMGF=1"), 500, 20, "OK", 5);
+        SetCommLineStatus(CLS_FREE);
+        // volume is kept in the profile
+        last_speaker_volume = GSM_INIT_SPEAKER_VOLUME;
+      }
       // init SMS storage
       InitSMSMemory();
-      // select phonebook memory storage
-      SendATCmdWaitRespF(PSTR("AT+CPBS=\"SM\""), 1000, 20, "OK", 5);
-      // set character set ISO 8859
-      SendATCmdWaitRespF(PSTR("AT+CSCS=\"8859-1\""), 1000, 20, "OK", 5);
+      // phonebook memory storage and character set
+      BatchInit(&batch);
+      BatchAddDesc(&batch, &gsm_init_cmds[GSM_INIT_CPBS]);
+      BatchAddDesc(&batch, &gsm_init_cmds[GSM_INIT_CSCS]);
+      BatchRun(&batch, 20, 5);
+      // profile is stored for the next boot
+      if ((boot_store != NULL) && !boot_fast) SaveBootProfile();
       break;
   }
-  
+
+}
+
+
+/**********************************************************
+  Fast boot
+**********************************************************/
+// CRC-16/CCITT (polynomial 0x1021)
+static uint16_t BootCrc(uint16_t crc, byte ch)
+{
+  byte i;
+
+  crc ^= (uint16_t)ch << 8;
+  for (i = 0; i < 8; i++) {
+    if (crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+    else crc <<= 1;
+  }
+  return (crc);
+}
+
+/**********************************************************
+Method returns CRC of the parameters which are kept
+in the module profile (see AddProfileParams()), other
+parameters of this program (e.g. new firmware) cause
+the full initialization
+**********************************************************/
+uint16_t GSM::GetProfileCrc(void)
+{
+  char string[20];
+  ATBatch batch;
+  ATBatchItem *item;
+  const char *p;
+  uint16_t crc = 0xffff;
+  byte group;
+  byte i;
+  char ch;
+
+  for (group = PARAM_SET_0; group <= PARAM_SET_1; group++) {
+    BatchInit(&batch);
+    AddProfileParams(&batch, group, string);
+    for (i = 0; i < batch.len; i++) {
+      item = &batch.item[i];
+      p = item->AT_cmd_string;
+      // terminating 0x00 separates the commands
+      do {
+        ch = (item->flags & ATCMD_FLAG_PGM) ? pgm_read_byte(p) : *p;
+        crc = BootCrc(crc, ch);
+        p++;
+      } while (ch != 0x00);
+    }
+  }
+  return (BootCrc(crc, GSM_INIT_SPEAKER_VOLUME));
+}
+
+/**********************************************************
+Method reads the parameters of the module profile which
+differ from the factory settings and returns CRC of the
+response (the comm. line must be acquired)
+- listing of AT&V has several hundreds of characters so it
+  does not fit into the comm. buffer, the parameters are
+  read by the short queries instead
+- echo of the command (the module was not switched on with
+  the stored profile) changes the CRC too
+
+return: 1 - OK, 0 - no response
+**********************************************************/
+byte GSM::GetConfigFingerprint(uint16_t *crc)
+{
+  StrView resp;
+  uint16_t i;
+
+  if (AT_RESP_OK != SendATCmdWaitRespF(PSTR("AT+IPR?;+IFC?;#SELINT?;#CAP?;+CRSL?"),
+                                       START_LONG_COMM_TMOUT, MAX_INTERCHAR_TMOUT,
+                                       "OK", 2)) return (0);
+  GetRespView(&resp);
+  *crc = 0xffff;
+  for (i = 0; i < resp.len; i++) *crc = BootCrc(*crc, resp.ptr[i]);
+  return (1);
+}
+
+/**********************************************************
+Method returns 1 in case the module uses the profile
+stored by this program (the comm. line must be acquired)
+**********************************************************/
+byte GSM::IsBootProfileValid(void)
+{
+  GSMBootRecord record;
+  uint16_t crc;
+
+  if (!boot_store->Load(&record)) return (0);
+  if (record.profile_crc != GetProfileCrc()) return (0);
+  if (!GetConfigFingerprint(&crc)) return (0);
+  return (crc == record.fingerprint_crc);
+}
+
+/**********************************************************
+Method stores the profile in the module (profile 0 is loaded
+after the power on) and saves the record of it
+- CRC is computed for the current baud rate (the baud rate
+  can be upshifted after InitParam(PARAM_SET_0))
+**********************************************************/
+void GSM::SaveBootProfile(void)
+{
+  GSMBootRecord record;
+
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return;
+  if ((AT_RESP_OK == SendATCmdWaitRespF(PSTR("AT&W0&P0"), START_LONG_COMM_TMOUT,
+                                        MAX_INTERCHAR_TMOUT, "OK", 2))
+      && GetConfigFingerprint(&record.fingerprint_crc)) {
+    record.profile_crc = GetProfileCrc();
+    boot_store->Save(&record);
+  }
+  SetCommLineStatus(CLS_FREE);
 }
 
 /**********************************************************
@@ -284,15 +676,7 @@ off_on: 0 - off
 **********************************************************/
 void GSM::SetSpeaker(byte off_on)
 {
-  if (CLS_FREE != GetCommLineStatus()) return;
-  SetCommLineStatus(CLS_ATCMD);
-  if (off_on) {
-    SendATCmdWaitRespF(PSTR("AT#GPIO=5,1,2"), 500, 20, "#GPIO:", 1);
-  }
-  else {
-    SendATCmdWaitRespF(PSTR("AT#GPIO=5,0,2"), 500, 20, "#GPIO:", 1);
-  }
-  SetCommLineStatus(CLS_FREE);
+  RunATCmdDesc(&gsm_cmds[off_on ? GSM_CMD_SPEAKER_ON : GSM_CMD_SPEAKER_OFF], ATCMD_PRIO_HIGH, NULL);
 }
 
 
@@ -317,9 +701,17 @@ byte GSM::CheckRegistration(void)
 {
   byte status;
   byte ret_val = REG_NOT_REGISTERED;
+  StrView resp;
+  StrView line;
+  StrView field;
+  long stat = 0;
+#ifdef GSM_CACHE_ENABLED
+  int cached;
+
+  if (GetCached(GSM_CACHE_REG, &cached)) return (cached);
+#endif
 
-  if (CLS_FREE != GetCommLineStatus()) return (REG_COMM_LINE_BUSY);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return (REG_COMM_LINE_BUSY);
   Println("AT+CREG?");
   // 5 sec. for initial comm tmout
   // 20 msec. for inter character timeout
@@ -327,9 +719,17 @@ byte GSM::CheckRegistration(void)
 
   if (status == RX_FINISHED) {
     // something was received but what was received?
+    // "+CREG: <n>,<stat>[,<lac>,<ci>]" - <stat> is the second
+    // field whatever <n> (URC mode) is set
     // ---------------------------------------------
-    if(IsStringReceived("+CREG: 0,1") 
-      || IsStringReceived("+CREG: 0,5")) {
+    GetRespView(&resp);
+    while (SVFindLineF(&resp, PSTR("+CREG:"), &line) && SVSkipPast(&line, ':')) {
+      // URC "+CREG: <stat>" received meanwhile has no <n>
+      SVNextField(&line, &field, ',');
+      if (SVNextField(&line, &field, ',') && SVToLong(&field, &stat)) break;
+    }
+    if ((stat == 1) || (stat == 5)) {
+      // 1 - home network or 5 - roaming
       // it means module is registered
       // ----------------------------
       module_status |= STATUS_REGISTERED;
@@ -360,6 +760,9 @@ byte GSM::CheckRegistration(void)
     ret_val = REG_NO_RESPONSE;
   }
   SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  if (ret_val != REG_NO_RESPONSE) PutCached(GSM_CACHE_REG, ret_val);
+#endif
  
 
   return (ret_val);
@@ -395,8 +798,7 @@ char GSM::SendSMS(char *number_str, char *message_str)
   char ret_val = -1;
   byte i;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   ret_val = 0; // still not send
   // try to send SMS 3 times in case there is some problem
   for (i = 0; i < 3; i++) {
@@ -498,8 +900,7 @@ char GSM::InitSMSMemory(void)
 {
   char ret_val = -1;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return (ret_val);
   ret_val = 0; // not initialized yet
   
   // Disable messages about new SMS from the GSM module 
@@ -561,11 +962,13 @@ an example of use:
 char GSM::IsSMSPresent(byte required_status) 
 {
   char ret_val = -1;
-  char *p_char;
-  byte status;
+  ATCmd cmd;
+  StrView resp;
+  StrView line;
+  StrView field;
+  long val;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   ret_val = 0; // still not present
 
   switch (required_status) {
@@ -582,45 +985,38 @@ char GSM::IsSMSPresent(byte required_status)
 
   // 5 sec. for initial comm tmout
   // and max. 1500 msec. for inter character timeout
-  RxInit(START_XLONG_COMM_TMOUT, MAX__LONG_INTERCHAR_TMOUT, 1, 1); 
-  // wait response is finished
-  do {
-    if (IsStringReceived("OK")) { 
-      // perfect - we have some response, but what:
-
-      // there is either NO SMS:
-      // <CR><LF>OK<CR><LF>
-
-      // or there is at least 1 SMS
-      // +CMGL: <index>,<stat>,<oa/da>,,[,<tooa/toda>,<length>]
-      // <CR><LF> <data> <CR><LF>OK<CR><LF>
-      status = RX_FINISHED;
-      break; // so finish receiving immediately and let's go to 
-             // to check response 
-    }
-    status = IsRxFinished();
-  } while (status == RX_NOT_FINISHED);
-
-  
-
-
-  switch (status) {
+  // there is either NO SMS:
+  // <CR><LF>OK<CR><LF>
+  // or there is at least 1 SMS
+  // +CMGL: <index>,<stat>,<oa/da>,,[,<tooa/toda>,<length>]
+  // <CR><LF> <data> <CR><LF>OK<CR><LF>
+  // so in the RESP_FINISH_TMOUT mode finish receiving immediately when "OK" 
+  // is received (in the RESP_FINISH_RESULT_CODE mode receiving is finished
+  // by the final OK anyway)
+  SetupATCmd(&cmd, NULL, 
+             (GetRespFinishMode() == RESP_FINISH_TMOUT) ? ATCMD_FLAG_FINISH_ON_RESP : 0, 
+             START_XLONG_COMM_TMOUT, MAX__LONG_INTERCHAR_TMOUT, "OK", 1, NULL);
+  RunATCmd(&cmd);
+
+  switch (cmd.rx_status) {
     case RX_TMOUT_ERR:
       // response was not received in specific time
       ret_val = -2;
       break;
 
-    case RX_FINISHED:
+    case RX_FINISHED_STR_RECV:
+    case RX_FINISHED_STR_NOT_RECV:
       // something was received but what was received?
       // ---------------------------------------------
-      if(IsStringReceived("+CMGL:")) { 
+      GetRespView(&resp);
+      if (SVFindLineF(&resp, PSTR("+CMGL:"), &line)) { 
         // there is some SMS with status => get its position
         // response is:
         // +CMGL: <index>,<stat>,<oa/da>,,[,<tooa/toda>,<length>]
         // <CR><LF> <data> <CR><LF>OK<CR><LF>
-        p_char = strchr((char *)comm_buf,':');
-        if (p_char != NULL) {
-          ret_val = atoi(p_char+1);
+        SVSkipPast(&line, ':');
+        if (SVNextField(&line, &field, ',') && SVToLong(&field, &val)) {
+          ret_val = val;
         }
       }
       else {
@@ -630,7 +1026,10 @@ char GSM::IsSMSPresent(byte required_status)
 
       // here we have WaitResp() just for generation tmout 20msec. in case OK was detected
       // not due to receiving
-      WaitResp(START_TINY_COMM_TMOUT, MAX_INTERCHAR_TMOUT); 
+      // (not necessary when the final result code was detected in IsRxFinished())
+      if (GetRespFinishMode() == RESP_FINISH_TMOUT) {
+        WaitResp(START_TINY_COMM_TMOUT, MAX_INTERCHAR_TMOUT); 
+      }
       break;
   }
 
@@ -645,6 +1044,7 @@ Method reads SMS from specified memory(SIM) position
 position:     SMS position <1..20>
 phone_number: a pointer where the phone number string of received SMS will be placed
               so the space for the phone number string must be reserved - see example
+              (min. PHONE_NUMBER_LEN characters)
 SMS_text  :   a pointer where SMS text will be placed
 max_SMS_len:  maximum length of SMS text excluding also string terminating 0x00 character
               
@@ -684,17 +1084,17 @@ an example of usage:
 char GSM::GetSMS(byte position, char *phone_number, char *SMS_text, byte max_SMS_len) 
 {
   char ret_val = -1;
-  char *p_char; 
-  char *p_char1;
-  byte len;
+  StrView resp;
+  StrView line;
+  StrView field;
 
   if (position == 0) return (-3);
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   phone_number[0] = 0;  // end of string for now
   ret_val = GETSMS_NO_SMS; // still no SMS
   
   //send "AT+CMGR=X" - where X = position
+  SetRespClassifier(&resp_match_cmgr);
   PrintF(PSTR("AT+CMGR="));
   Print((int)position);  
   PrintF(PSTR("\r"));
@@ -709,12 +1109,12 @@ char GSM::GetSMS(byte position, char *phone_number, char *SMS_text, byte max_SMS
 
     case RX_FINISHED_STR_NOT_RECV:
       // OK was received => there is NO SMS stored in this position
-      if(IsStringReceived("OK")) {
+      if (IsRespClass(CMGR_OK)) {
         // there is only response <CR><LF>OK<CR><LF> 
         // => there is NO SMS
         ret_val = GETSMS_NO_SMS;
       }
-      else if(IsStringReceived("ERROR")) {
+      else if (IsRespClass(CMGR_ERROR)) {
         // error should not be here but for sure
         ret_val = GETSMS_NO_SMS;
       }
@@ -726,7 +1126,7 @@ char GSM::GetSMS(byte position, char *phone_number, char *SMS_text, byte max_SMS
       //response for new SMS:
       //<CR><LF>+CMGR: "REC UNREAD","+XXXXXXXXXXXX",,"02/03/18,09:54:28+40"<CR><LF>
 		  //There is SMS text<CR><LF>OK<CR><LF>
-      if(IsStringReceived("\"REC UNREAD\"")) { 
+      if (IsRespClass(CMGR_UNREAD)) { 
         // get phone number of received SMS: parse phone number string 
         // +XXXXXXXXXXXX
         // -------------------------------------------------------
@@ -735,7 +1135,7 @@ char GSM::GetSMS(byte position, char *phone_number, char *SMS_text, byte max_SMS
       //response for already read SMS = old SMS:
       //<CR><LF>+CMGR: "REC READ","+XXXXXXXXXXXX",,"02/03/18,09:54:28+40"<CR><LF>
 		  //There is SMS text<CR><LF>
-      else if(IsStringReceived("\"REC READ\"")) {
+      else if (IsRespClass(CMGR_READ)) {
         // get phone number of received SMS
         // --------------------------------
         ret_val = GETSMS_READ_SMS;
@@ -747,52 +1147,26 @@ char GSM::GetSMS(byte position, char *phone_number, char *SMS_text, byte max_SMS
 
       // extract phone number string
       // ---------------------------
-      p_char = strchr((char *)(comm_buf),',');
-      p_char1 = p_char+2; // we are on the first phone number character
-      p_char = strchr((char *)(p_char1),'"');
-      if (p_char != NULL) {
-        *p_char = 0; // end of string
-        strcpy(phone_number, (char *)(p_char1));
-      }
-
-
-      // get SMS text and copy this text to the SMS_text buffer
-      // ------------------------------------------------------
-      p_char = strchr(p_char+1, 0x0a);  // find <LF>
-      if (p_char != NULL) {
-        // next character after <LF> is the first SMS character
-        p_char++; // now we are on the first SMS character 
-
-        // find <CR> as the end of SMS string
-        p_char1 = strchr((char *)(p_char), 0x0d);  
-        if (p_char1 != NULL) {
-          // finish the SMS text string 
-          // because string must be finished for right behaviour 
-          // of next strcpy() function
-          *p_char1 = 0; 
-        }
-        // in case there is not finish sequence <CR><LF> because the SMS is
-        // too long (more then 130 characters) sms text is finished by the 0x00
-        // directly in the WaitResp() routine
-
-        // find out length of the SMS (excluding 0x00 termination character)
-        len = strlen(p_char);
-
-        if (len < max_SMS_len) {
-          // buffer SMS_text has enough place for copying all SMS text
-          // so copy whole SMS text
-          // from the beginning of the text(=p_char position) 
-          // to the end of the string(= p_char1 position)
-          strcpy(SMS_text, (char *)(p_char));
-        }
-        else {
-          // buffer SMS_text doesn't have enough place for copying all SMS text
-          // so cut SMS text to the (max_SMS_len-1)
-          // (max_SMS_len-1) because we need 1 position for the 0x00 as finish 
-          // string character
-          memcpy(SMS_text, (char *)(p_char), (max_SMS_len-1));
-          SMS_text[max_SMS_len] = 0; // finish string
+      GetRespView(&resp);
+      if (SVFindLineF(&resp, PSTR("+CMGR:"), &line)) {
+        SVSkipPast(&line, ':');
+        SVNextField(&line, &field, ',');  // "REC UNREAD"
+        if (SVNextField(&line, &field, ',')) {
+          // we are on the "+XXXXXXXXXXXX"
+          SVUnquote(&field);
+          SVCopy(&field, phone_number, PHONE_NUMBER_LEN);
         }
+
+        // get SMS text and copy this text to the SMS_text buffer
+        // ------------------------------------------------------
+        // next line is the SMS text, it is finished by <CR><LF>
+        // or by the end of the buffer in case the SMS is
+        // too long (more then 130 characters)
+        // SMS text is cut to the (max_SMS_len-1) because we need 
+        // 1 position for the 0x00 as finish string character
+        SVTakeLine(&resp, &line);   // <CR><LF> of the +CMGR: line
+        SVTakeLine(&resp, &line);
+        SVCopy(&line, SMS_text, max_SMS_len);
       }
       break;
   }
@@ -944,8 +1318,7 @@ char GSM::DeleteSMS(byte position)
   char ret_val = -1;
 
   if (position == 0) return (-3);
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   ret_val = 0; // not deleted yet
   
   //send "AT+CMGD=XY" - where XY = position
@@ -997,7 +1370,7 @@ return:
         1 - phone number was found
         phone_number is filled by the phone number string finished by 0x00
                      so it is necessary to define string with at least
-                     15 bytes(including also 0x00 termination character)
+                     PHONE_NUMBER_LEN bytes(including also 0x00 termination character)
 
 an example of usage:
         GSM gsm;
@@ -1021,13 +1394,10 @@ an example of usage:
 char GSM::GetPhoneNumber(byte position, char *phone_number)
 {
   char ret_val = -1;
-
-  char *p_char; 
-  char *p_char1;
+  StrView resp, line, field;
 
   if (position == 0) return (-3);
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   ret_val = 0; // not found yet
   phone_number[0] = 0; // phone number not found yet => empty string
   
@@ -1051,18 +1421,17 @@ char GSM::GetPhoneNumber(byte position, char *phone_number)
 
       // response in case there is not phone number:
       // <CR><LF>OK<CR><LF>
-      p_char = strchr((char *)(comm_buf),'"');
-      if (p_char != NULL) {
-        p_char++;       // we are on the first phone number character
-        // find out '"' as finish character of phone number string
-        p_char1 = strchr((char *)(p_char),'"');
-        if (p_char1 != NULL) {
-          *p_char1 = 0; // end of string
+      GetRespView(&resp);
+      if (SVFindLineF(&resp, PSTR("+CPBR:"), &line)) {
+        SVSkipPast(&line, ':');
+        SVNextField(&line, &field, ',');   // <index>
+        SVNextField(&line, &field, ',');   // <number>
+        if (SVUnquote(&field)) {
+          // extract phone number string (max. PHONE_NUMBER_LEN - 1 chars.)
+          SVCopy(&field, phone_number, PHONE_NUMBER_LEN);
+          // output value = we have found out phone number string
+          ret_val = 1;
         }
-        // extract phone number string
-        strcpy(phone_number, (char *)(p_char));
-        // output value = we have found out phone number string
-        ret_val = 1;
       }
       break;
 
@@ -1099,8 +1468,7 @@ char GSM::WritePhoneNumber(byte position, char *phone_number)
   char ret_val = -1;
 
   if (position == 0) return (-3);
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   ret_val = 0; // phone number was not written yet
   
   //send: AT+CPBW=XY,"00420123456789"
@@ -1213,8 +1581,8 @@ byte GSM::CallStatus(void)
 {
   byte ret_val = CALL_NONE;
 
-  if (CLS_FREE != GetCommLineStatus()) return (CALL_COMM_LINE_BUSY);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return (CALL_COMM_LINE_BUSY);
+  SetRespClassifier(&resp_match_cpas);
   Println("AT+CPAS");
 
   // 5 sec. for initial comm tmout
@@ -1237,20 +1605,22 @@ byte GSM::CallStatus(void)
     // <CR><LF>+CPAS: 3<CR><LF> <CR><LF>OK<CR><LF> - NO CALL
     // call in progress
     // <CR><LF>+CPAS: 4<CR><LF> <CR><LF>OK<CR><LF> - NO CALL
-    if(IsStringReceived("0")) { 
-      // ready - there is no call
-      // ------------------------
-      ret_val = CALL_NONE;
-    }
-    else if(IsStringReceived("3")) { 
-      // incoming call
-      // --------------
-      ret_val = CALL_INCOM_VOICE;
-    }
-    else if(IsStringReceived("4")) { 
-      // active call
-      // -----------
-      ret_val = CALL_ACTIVE_VOICE;
+    switch (GetRespClass()) {
+      case CPAS_READY:
+        // ready - there is no call
+        // ------------------------
+        ret_val = CALL_NONE;
+        break;
+      case CPAS_RINGING:
+        // incoming call
+        // --------------
+        ret_val = CALL_INCOM_VOICE;
+        break;
+      case CPAS_CALL_IN_PROGRESS:
+        // active call
+        // -----------
+        ret_val = CALL_ACTIVE_VOICE;
+        break;
     }
   }
 
@@ -1265,6 +1635,7 @@ and makes authorization with specified SIM positions range
 
 phone_number: a pointer where the tel. number string of current call will be placed
               so the space for the phone number string must be reserved - see example
+              (PHONE_NUMBER_LEN characters including 0x00)
 first_authorized_pos: initial SIM phonebook position where the authorization process
                       starts
 last_authorized_pos:  last SIM phonebook position where the authorization process
@@ -1293,84 +1664,78 @@ byte GSM::CallStatusWithAuth(char *phone_number,
   byte ret_val = CALL_NONE;
   byte search_phone_num = 0;
   byte i;
-  byte status;
-  char *p_char; 
-  char *p_char1;
+  StrView resp, line, field;
+  ATCmd cmd;
 
   phone_number[0] = 0x00;  // no phone number so far
-  if (CLS_FREE != GetCommLineStatus()) return (CALL_COMM_LINE_BUSY);
-  SetCommLineStatus(CLS_ATCMD);
-  Println("AT+CLCC");
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return (CALL_COMM_LINE_BUSY);
 
   // 5 sec. for initial comm tmout
   // and max. 1500 msec. for inter character timeout
-  RxInit(5000, 1500, 1, 1);
-  // wait response is finished
-  do {
-    if (IsStringReceived("OK\r\n")) { 
-      // perfect - we have some response, but what:
-
-      // there is either NO call:
-      // <CR><LF>OK<CR><LF>
-
-      // or there is at least 1 call
-      // +CLCC: 1,1,4,0,0,"+420XXXXXXXXX",145<CR><LF>
-      // <CR><LF>OK<CR><LF>
-      status = RX_FINISHED;
-      break; // so finish receiving immediately and let's go to 
-             // to check response 
-    }
-    status = IsRxFinished();
-  } while (status == RX_NOT_FINISHED);
+  // there is either NO call:
+  // <CR><LF>OK<CR><LF>
+  // or there is at least 1 call
+  // +CLCC: 1,1,4,0,0,"+420XXXXXXXXX",145<CR><LF>
+  // <CR><LF>OK<CR><LF>
+  // so finish receiving immediately when "OK<CR><LF>" is received
+  SetupATCmd(&cmd, PSTR("AT+CLCC"), ATCMD_FLAG_PGM | ATCMD_FLAG_FINISH_ON_RESP, 
+             5000, 1500, "OK\r\n", 1, NULL);
+  // response is classified while it is being received
+  SetRespClassifier(&resp_match_clcc);
+  RunATCmd(&cmd);
 
   // generate tmout 30msec. before next AT command
+  // (the module must not send anything meanwhile)
+  HoldRx(1);
   delay(30);
 
-  if (status == RX_FINISHED) {
+  if (cmd.rx_status != RX_TMOUT_ERR) {
     // something was received but what was received?
     // example: //+CLCC: 1,1,4,0,0,"+420XXXXXXXXX",145
     // ---------------------------------------------
-    if(IsStringReceived("+CLCC: 1,1,4,0,0")) { 
-      // incoming VOICE call - not authorized so far
-      // -------------------------------------------
-      search_phone_num = 1;
-      ret_val = CALL_INCOM_VOICE_NOT_AUTH;
-    }
-    else if(IsStringReceived("+CLCC: 1,1,4,1,0")) { 
-      // incoming DATA call - not authorized so far
-      // ------------------------------------------
-      search_phone_num = 1;
-      ret_val = CALL_INCOM_DATA_NOT_AUTH;
-    }
-    else if(IsStringReceived("+CLCC: 1,0,0,0,0")) { 
-      // active VOICE call - GSM is caller
-      // ----------------------------------
-      search_phone_num = 1;
-      ret_val = CALL_ACTIVE_VOICE;
-    }
-    else if(IsStringReceived("+CLCC: 1,1,0,0,0")) { 
-      // active VOICE call - GSM is listener
-      // -----------------------------------
-      search_phone_num = 1;
-      ret_val = CALL_ACTIVE_VOICE;
-    }
-    else if(IsStringReceived("+CLCC: 1,1,0,1,0")) { 
-      // active DATA call - GSM is listener
-      // ----------------------------------
-      search_phone_num = 1;
-      ret_val = CALL_ACTIVE_DATA;
-    }
-    else if(IsStringReceived("+CLCC:")){ 
-      // other string is not important for us - e.g. GSM module activate call
-      // etc.
-      // IMPORTANT - each +CLCC:xx response has also at the end
-      // string <CR><LF>OK<CR><LF>
-      ret_val = CALL_OTHERS;
-    }
-    else if(IsStringReceived("OK")){ 
-      // only "OK" => there is NO call activity
-      // --------------------------------------
-      ret_val = CALL_NONE;
+    switch (GetRespClass()) {
+      case CLCC_INCOM_VOICE:
+        // incoming VOICE call - not authorized so far
+        // -------------------------------------------
+        search_phone_num = 1;
+        ret_val = CALL_INCOM_VOICE_NOT_AUTH;
+        break;
+      case CLCC_INCOM_DATA:
+        // incoming DATA call - not authorized so far
+        // ------------------------------------------
+        search_phone_num = 1;
+        ret_val = CALL_INCOM_DATA_NOT_AUTH;
+        break;
+      case CLCC_ACTIVE_VOICE_CALLER:
+        // active VOICE call - GSM is caller
+        // ----------------------------------
+        search_phone_num = 1;
+        ret_val = CALL_ACTIVE_VOICE;
+        break;
+      case CLCC_ACTIVE_VOICE:
+        // active VOICE call - GSM is listener
+        // -----------------------------------
+        search_phone_num = 1;
+        ret_val = CALL_ACTIVE_VOICE;
+        break;
+      case CLCC_ACTIVE_DATA:
+        // active DATA call - GSM is listener
+        // ----------------------------------
+        search_phone_num = 1;
+        ret_val = CALL_ACTIVE_DATA;
+        break;
+      case CLCC_OTHERS:
+        // other string is not important for us - e.g. GSM module activate call
+        // etc.
+        // IMPORTANT - each +CLCC:xx response has also at the end
+        // string <CR><LF>OK<CR><LF>
+        ret_val = CALL_OTHERS;
+        break;
+      case CLCC_NONE:
+        // only "OK" => there is NO call activity
+        // --------------------------------------
+        ret_val = CALL_NONE;
+        break;
     }
 
     
@@ -1378,12 +1743,12 @@ byte GSM::CallStatusWithAuth(char *phone_number,
     if (search_phone_num) {
       // extract phone number string
       // ---------------------------
-      p_char = strchr((char *)(comm_buf),'"');
-      p_char1 = p_char+1; // we are on the first phone number character
-      p_char = strchr((char *)(p_char1),'"');
-      if (p_char != NULL) {
-        *p_char = 0; // end of string
-        strcpy(phone_number, (char *)(p_char1));
+      // +CLCC: <id>,<dir>,<stat>,<mode>,<mpty>,<number>,<type>
+      GetRespView(&resp);
+      if (SVFindLineF(&resp, PSTR("+CLCC:"), &line)) {
+        SVSkipPast(&line, ':');
+        for (i = 0; i < 6; i++) SVNextField(&line, &field, ',');
+        if (SVUnquote(&field)) SVCopy(&field, phone_number, PHONE_NUMBER_LEN);
       }
       
       if ( (ret_val == CALL_INCOM_VOICE_NOT_AUTH) 
@@ -1431,8 +1796,7 @@ return:
 **********************************************************/
 void GSM::PickUp(void)
 {
-  if (CLS_FREE != GetCommLineStatus()) return;
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return;
   Println("ATA");
   SetCommLineStatus(CLS_FREE);
 }
@@ -1444,8 +1808,7 @@ return:
 **********************************************************/
 void GSM::HangUp(void)
 {
-  if (CLS_FREE != GetCommLineStatus()) return;
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return;
   Println("ATH");
   SetCommLineStatus(CLS_FREE);
 }
@@ -1459,8 +1822,7 @@ number_string: pointer to the phone number string
 **********************************************************/
 void GSM::Call(char *number_string)
 {
-  if (CLS_FREE != GetCommLineStatus()) return;
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return;
   // ATDxxxxxx;<CR>
   PrintF(PSTR("ATD"));
   Print(number_string);    
@@ -1479,8 +1841,7 @@ sim_position: position in the SIM <1...>
 **********************************************************/
 void GSM::Call(int sim_position)
 {
-  if (CLS_FREE != GetCommLineStatus()) return;
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return;
   // ATD>"SM" 1;<CR>
   PrintF(PSTR("ATD>\"SM\" "));
   Print(sim_position);    
@@ -1514,8 +1875,7 @@ char GSM::SetSpeakerVolume(byte speaker_volume)
   
   char ret_val = -1;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return (ret_val);
   // remember set value as last value
   if (speaker_volume > 14) speaker_volume = 14;
   // select speaker volume (0 to 14)
@@ -1619,8 +1979,7 @@ char GSM::SendDTMFSignal(byte dtmf_tone)
 {
   char ret_val = -1;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_HIGH)) return (ret_val);
   // e.g. AT+VTS=5<CR>
   PrintF(PSTR("AT+VTS="));
   Print((int)dtmf_tone);    
@@ -1652,13 +2011,32 @@ return: 0 - not pushed = released
 byte GSM::IsUserButtonPushed(void)
 {
   byte ret_val = 0;
-  if (CLS_FREE != GetCommLineStatus()) return(0);
-  SetCommLineStatus(CLS_ATCMD);
-  if (AT_RESP_OK == SendATCmdWaitRespF(PSTR("AT#GPIO=9,2"), 2000, MAX_MID_INTERCHAR_TMOUT, "#GPIO: 0,0", 1)) {
+  char resp;
+#ifdef GSM_CACHE_ENABLED
+  StrView view;
+  StrView line;
+  StrView field;
+  long value;
+  int cached;
+
+  if (GetCached(GSM_CACHE_BUTTON, &cached)) return (cached);
+#endif
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return(0);
+  resp = SendATCmdWaitRespF(PSTR("AT#GPIO=9,2"), 2000, MAX_MID_INTERCHAR_TMOUT, "#GPIO: 0,0", 1);
+  if (AT_RESP_OK == resp) {
     // user button is pushed
     ret_val = 1;
   }
   else ret_val = 0;
+#ifdef GSM_CACHE_ENABLED
+  // only the state really read from the module "#GPIO: <dir>,<stat>"
+  // (not ERROR nor other response)
+  GetRespView(&view);
+  if (SVFindLineF(&view, PSTR("#GPIO:"), &line) && SVSkipPast(&line, ',')
+      && SVNextField(&line, &field, ',') && SVToLong(&field, &value)) {
+    PutCached(GSM_CACHE_BUTTON, ret_val);
+  }
+#endif
   SetCommLineStatus(CLS_FREE);
   return (ret_val);
 }
@@ -1668,11 +2046,8 @@ Turns on the user LED
 **********************************************************/
 void GSM::TurnOnLED(void)
 {
-  if (CLS_FREE != GetCommLineStatus()) return;
-  SetCommLineStatus(CLS_ATCMD);
   // response here is not important
-  SendATCmdWaitRespF(PSTR("AT#GPIO=8,1,1"), 500, 20, "#GPIO:", 1);
-  SetCommLineStatus(CLS_FREE);
+  RunATCmdDesc(&gsm_cmds[GSM_CMD_LED_ON], ATCMD_PRIO_LOW, NULL);
 }
 
 /**********************************************************
@@ -1680,11 +2055,8 @@ Turns off the user LED
 **********************************************************/
 void GSM::TurnOffLED(void)
 {
-  if (CLS_FREE != GetCommLineStatus()) return;
-  SetCommLineStatus(CLS_ATCMD);
   // response here is not important
-  SendATCmdWaitRespF(PSTR("AT#GPIO=8,0,1"), 500, 20, "#GPIO:", 1);
-  SetCommLineStatus(CLS_FREE);
+  RunATCmdDesc(&gsm_cmds[GSM_CMD_LED_OFF], ATCMD_PRIO_LOW, NULL);
 }
 
 
@@ -1712,8 +2084,7 @@ char GSM::SetGPIODir(byte GPIO_pin, byte direction)
 {
   char ret_val = -1;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return (ret_val);
 
   // e.g. AT#GPIO=9,0,0 - sets as INPUT
   // e.g. AT#GPIO=9,0,1 - sets as OUTPUT and value is "0" - LOW
@@ -1739,6 +2110,9 @@ char GSM::SetGPIODir(byte GPIO_pin, byte direction)
   }
 
   SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  InvalidateCache(GPIOCacheItem(GPIO_pin));
+#endif
   return (ret_val);
 }
 
@@ -1768,8 +2142,7 @@ char GSM::SetGPIOVal(byte GPIO_pin, byte value)
 {
   char ret_val = -1;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return (ret_val);
 
 
   // e.g. AT#GPIO=9,0,1 - set to "0" - LOW
@@ -1795,6 +2168,9 @@ char GSM::SetGPIOVal(byte GPIO_pin, byte value)
   }
 
   SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  InvalidateCache(GPIOCacheItem(GPIO_pin));
+#endif
   return (ret_val);
 }
 
@@ -1821,12 +2197,18 @@ return:
 char GSM::GetGPIOVal(byte GPIO_pin)
 {
   char ret_val = -1;
+#ifdef GSM_CACHE_ENABLED
+  byte item = GPIOCacheItem(GPIO_pin);
+  int cached;
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if ((item < GSM_CACHE_LAST_ITEM) && GetCached(item, &cached)) return (cached);
+#endif
+
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return (ret_val);
 
 
   //e.g. AT#GPIO=9,2
+  SetRespClassifier(&resp_match_gpio);
   PrintF(PSTR("AT#GPIO="));
   // pin number
   Print((int)GPIO_pin);  
@@ -1842,16 +2224,23 @@ char GSM::GetGPIOVal(byte GPIO_pin)
   else {
     // there is response but which one..
     // ---------------------------------
-    if(IsStringReceived("#GPIO: 0,1")) {
-      ret_val = 1; // OK and 1 as HIGH
-    }
-    else if(IsStringReceived("#GPIO: 0,0")) {
-      ret_val = 0; // OK and 0 as LOW
+    switch (GetRespClass()) {
+      case GPIO_HIGH:
+        ret_val = 1; // OK and 1 as HIGH
+        break;
+      case GPIO_LOW:
+        ret_val = 0; // OK and 0 as LOW
+        break;
+      default:
+        ret_val = -3; // else response ERROR
+        break;
     }
-    else ret_val = -3; // else response ERROR
   }
 
   SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  if ((item < GSM_CACHE_LAST_ITEM) && (ret_val >= 0)) PutCached(item, ret_val);
+#endif
   return (ret_val);
 }
 
@@ -1877,10 +2266,15 @@ return:
 int GSM::GetTemp(void)
 {
   int ret_val = -1000;
-  char *pos;
+  StrView resp, line;
+  long val;
+#ifdef GSM_CACHE_ENABLED
+  int cached;
 
-  if (CLS_FREE != GetCommLineStatus()) return(ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (GetCached(GSM_CACHE_TEMP, &cached)) return (cached);
+#endif
+
+  if (!AcquireCommLine(ATCMD_PRIO_LOW)) return(ret_val);
   ret_val = -2000; // we do not have right value yet
 
   // response is in the format: #ADC: 885
@@ -1892,19 +2286,120 @@ int GSM::GetTemp(void)
   if (AT_RESP_OK == SendATCmdWaitRespF(PSTR("AT#ADC=2,2,0"), 2000, 20, "#ADC", 1)) {
 #endif
     // parse the received string
-    pos = strchr((char *)comm_buf, ' ');
-    if (pos != NULL) {
-      // we are in front of the number
-      ret_val = atoi(pos);
-      ret_val = ret_val - 600;
+    GetRespView(&resp);
+    if (SVFindLineF(&resp, PSTR("#ADC:"), &line)
+        && SVSkipPast(&line, ':')) {
+      SVTrim(&line);
+      if (SVToLong(&line, &val)) ret_val = (int)val - 600;
     }
   }
  
   SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  if (ret_val != -2000) PutCached(GSM_CACHE_TEMP, ret_val);
+#endif
   return (ret_val);
 }
 
 
+#ifdef GSM_CACHE_ENABLED
+/**********************************************************
+Cache of the query results
+
+- CheckRegistration(), GetTemp(), GetGPIOVal(), IsUserButtonPushed()
+  and IPEasyExt_GetSocketStatus() return the value stored not later
+  than TTL msec. ago without any communication with the GSM module
+- only valid values are stored (no response, busy comm. line
+  and errors are not cached)
+- values are invalidated by the related writes (SetGPIOVal(),
+  IPEasyExt_CloseSocket()...), by TurnOn() and by the URCs
+  (+CREG:, #GPIO:, SRING:)
+
+item: gsm_cache_enum or GSM_CACHE_ALL
+ttl:  time to live in msec. (0 - the result is not cached)
+
+an example of usage:
+        // registration is checked in the module max. once per 30 sec.
+        // unless +CREG URC is received
+        gsm.SetCacheTTL(GSM_CACHE_REG, 30000);
+        // every call of GetTemp() reads the temperature from the module
+        gsm.SetCacheTTL(GSM_CACHE_TEMP, 0);
+**********************************************************/
+void GSM::SetCacheTTL(byte item, uint16_t ttl)
+{
+  byte i;
+
+  for (i = 0; i < GSM_CACHE_LAST_ITEM; i++) {
+    if ((item == GSM_CACHE_ALL) || (item == i)) cache_ttl[i] = ttl;
+  }
+}
+
+void GSM::InvalidateCache(byte item)
+{
+  if (item == GSM_CACHE_ALL) cache_valid = 0;
+  else if (item < GSM_CACHE_LAST_ITEM) cache_valid &= ~(1 << item);
+}
+
+void GSM::InvalidateSocketCache(byte connection_id)
+{
+  byte i;
+
+  if (connection_id) InvalidateCache(SocketCacheItem(connection_id));
+  else for (i = GSM_CACHE_SOCKET1; i <= GSM_CACHE_SOCKET6; i++) InvalidateCache(i);
+}
+
+/**********************************************************
+Method reads the cached value
+
+return: 0 - value is not valid or it is older than TTL
+        1 - value is valid
+**********************************************************/
+byte GSM::GetCached(byte item, int *value)
+{
+  if (!(cache_valid & (1 << item))) return (0);
+  if ((millis() - cache_time[item]) >= cache_ttl[item]) {
+    cache_valid &= ~(1 << item);
+    return (0);
+  }
+  *value = cache_value[item];
+  return (1);
+}
+
+void GSM::PutCached(byte item, int value)
+{
+  if (cache_ttl[item] == 0) return;
+  cache_value[item] = value;
+  cache_time[item] = millis();
+  cache_valid |= (1 << item);
+}
+
+#ifdef URC_ENABLED
+/**********************************************************
+Method invalidates the values related to the URC
+
+line: URC line without <CR><LF> (not finished by 0x00)
+len:  length of the line
+**********************************************************/
+void GSM::URCReceived(const char *line, byte len)
+{
+  byte i;
+
+  if ((len >= 6) && !strncmp_P(line, PSTR("+CREG:"), 6)) {
+    InvalidateCache(GSM_CACHE_REG);
+  }
+  else if ((len >= 6) && !strncmp_P(line, PSTR("#GPIO:"), 6)) {
+    InvalidateCache(GSM_CACHE_BUTTON);
+    for (i = GSM_CACHE_GPIO10; i <= GSM_CACHE_GPIO13; i++) InvalidateCache(i);
+  }
+  else if ((len >= 5) && !strncmp_P(line, PSTR("SRING"), 5)) {
+    // SRING: <connId>
+    InvalidateSocketCache((len == 8) ? line[7] - '0' : 0);
+  }
+}
+#endif // end of ifdef URC_ENABLED
+#endif // end of ifdef GSM_CACHE_ENABLED
+
+
 /**********************************************************
 Functions for manipulation with strings
 **********************************************************/
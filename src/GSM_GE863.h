@@ -23,7 +23,7 @@
 
 #include "Arduino.h"
 
-#define GSM_LIB_VERSION 108 // library version X.YY (e.g. 1.00)
+#define GSM_LIB_VERSION 116 // library version X.YY (e.g. 1.00)
 /*
     Version
     --------------------------------------------------------------------------
@@ -53,6 +53,36 @@
     --------------------------------------------------------------------------
     108       - character set ISO 8859 activated during initialization
     --------------------------------------------------------------------------
+    109       - all methods finish reception immediately when the final result
+                code is received (see AT library 105)
+              - IsSMSPresent() does not wait for additional tmout after OK
+    --------------------------------------------------------------------------
+    110       - IsSMSPresent() and CallStatusWithAuth() use the AT command
+                engine (see AT library 106)
+    --------------------------------------------------------------------------
+    111       - methods wait for the comm. line occupied by the AT command 
+                engine instead of immediate return (see AcquireCommLine()), 
+                call handling has the highest priority, housekeeping 
+                (GPIO, temperature, registration) the lowest one
+    --------------------------------------------------------------------------
+    112       - InitParam() sends the parameters as concatenated command lines
+                (see AT library 108), commands are sent one by one only
+                in case of error
+    --------------------------------------------------------------------------
+    113       - SetSpeaker(), TurnOnLED() and TurnOffLED() use the AT commands
+                described in the Flash memory (see AT library 122)
+    --------------------------------------------------------------------------
+    114       - cache of the query results with TTL (GSM_CACHE_ENABLED in
+                Setting.h), see SetCacheTTL() and InvalidateCache()
+    --------------------------------------------------------------------------
+    115       - non-blocking switching on of the module by StartTurnOn() and
+                PollTurnOn() with the max. num. of attempts, TurnOn() is 
+                the blocking wrapper
+    --------------------------------------------------------------------------
+    116       - fast boot: the parameters are stored in the module profile
+                (AT&W, AT&P) and InitParam() sends them again only when
+                the stored configuration differs (see SetBootStore())
+    --------------------------------------------------------------------------
 */
 
 
@@ -61,8 +91,15 @@
 // length for the internal communication buffer
 #define COMM_BUF_LEN        200
 
+// min. size of the buffer for the phone number string (including 0x00)
+// longer phone numbers are truncated
+#ifndef PHONE_NUMBER_LEN
+  #define PHONE_NUMBER_LEN  20
+#endif
+
 #include "AT.h"
 #include "GSM_GPRS.h"
+#include "StreamSearch.h"
 
 
 
@@ -111,6 +148,49 @@
 #define AT_DELAY                    500
 
 
+// timing of the switching on sequence in msec.
+#ifndef TURNON_ON_PULSE
+  #define TURNON_ON_PULSE           1200  // GSM_ON is HIGH
+#endif // end of ifndef TURNON_ON_PULSE
+#ifndef TURNON_ON_PAUSE
+  #define TURNON_ON_PAUSE           1200  // GSM_ON is LOW after the pulse
+#endif // end of ifndef TURNON_ON_PAUSE
+#ifndef TURNON_RESET_PULSE
+  #define TURNON_RESET_PULSE        400   // GSM_RESET is HIGH
+#endif // end of ifndef TURNON_RESET_PULSE
+#ifndef TURNON_RESET_PAUSE
+  #define TURNON_RESET_PAUSE        500   // GSM_RESET is LOW after the pulse
+#endif // end of ifndef TURNON_RESET_PAUSE
+#ifndef TURNON_NEXT_CHECK
+  #define TURNON_NEXT_CHECK         3000  // wait before the next check
+#endif // end of ifndef TURNON_NEXT_CHECK
+
+
+// progress of the switching on (see GetTurnOnStep())
+enum turnon_step_enum
+{
+  TURNON_STEP_IDLE = 0,     // switching on is not in progress
+  TURNON_STEP_CHECK,        // "AT" is sent, response is awaited
+  TURNON_STEP_ON_PULSE,     // switch on pulse on GSM_ON
+  TURNON_STEP_ON_PAUSE,     // pause after the switch on pulse
+  TURNON_STEP_RESET_PULSE,  // reset pulse on GSM_RESET
+  TURNON_STEP_RESET_PAUSE,  // pause after the reset pulse
+  TURNON_STEP_WAIT,         // waiting before the next check
+
+  TURNON_STEP_LAST_ITEM
+};
+
+enum turnon_ret_val_enum
+{
+  TURNON_IDLE = 0,          // switching on was not started (or it is already finished)
+  TURNON_BUSY,              // switching on is in progress
+  TURNON_OK,                // module responds, initialization parameters were sent
+  TURNON_FAILED,            // module did not respond after the max. num. of attempts
+
+  TURNON_LAST_ITEM
+};
+
+
 enum registration_ret_val_enum 
 {
   REG_NOT_REGISTERED = 0,
@@ -164,6 +244,93 @@ enum call_ret_val_enum
 };
 
 
+#ifdef GSM_CACHE_ENABLED
+// cached query results
+enum gsm_cache_enum
+{
+  GSM_CACHE_REG = 0,      // CheckRegistration()
+  GSM_CACHE_TEMP,         // GetTemp()
+  GSM_CACHE_BUTTON,       // IsUserButtonPushed()
+  GSM_CACHE_GPIO10,       // GetGPIOVal(GPIO10) .. GetGPIOVal(GPIO13)
+  GSM_CACHE_GPIO11,
+  GSM_CACHE_GPIO12,
+  GSM_CACHE_GPIO13,
+  GSM_CACHE_SOCKET1,      // IPEasyExt_GetSocketStatus(1) .. (6)
+  GSM_CACHE_SOCKET2,
+  GSM_CACHE_SOCKET3,
+  GSM_CACHE_SOCKET4,
+  GSM_CACHE_SOCKET5,
+  GSM_CACHE_SOCKET6,
+
+  GSM_CACHE_LAST_ITEM
+};
+// all items for SetCacheTTL() and InvalidateCache()
+#define GSM_CACHE_ALL       GSM_CACHE_LAST_ITEM
+
+// default TTLs in msec. (0 - the result is not cached)
+#ifndef GSM_CACHE_TTL_REG
+  #define GSM_CACHE_TTL_REG       5000
+#endif // end of ifndef GSM_CACHE_TTL_REG
+#ifndef GSM_CACHE_TTL_TEMP
+  #define GSM_CACHE_TTL_TEMP      10000
+#endif // end of ifndef GSM_CACHE_TTL_TEMP
+#ifndef GSM_CACHE_TTL_BUTTON
+  #define GSM_CACHE_TTL_BUTTON    250
+#endif // end of ifndef GSM_CACHE_TTL_BUTTON
+#ifndef GSM_CACHE_TTL_GPIO
+  #define GSM_CACHE_TTL_GPIO      1000
+#endif // end of ifndef GSM_CACHE_TTL_GPIO
+#ifndef GSM_CACHE_TTL_SOCKET
+  #define GSM_CACHE_TTL_SOCKET    1000
+#endif // end of ifndef GSM_CACHE_TTL_SOCKET
+#endif // end of ifdef GSM_CACHE_ENABLED
+
+
+// speaker volume set by InitParam(PARAM_SET_1) (0 to 14)
+#ifndef GSM_INIT_SPEAKER_VOLUME
+  #define GSM_INIT_SPEAKER_VOLUME   9
+#endif // end of ifndef GSM_INIT_SPEAKER_VOLUME
+
+/*
+    fast boot - InitParam() sends the parameters which are kept
+    in the module profile (factory settings, echo, flow control, baud
+    rate, SELINT, audio, ringer, SMS mode) only when it is necessary
+    - after the whole initialization the profile is stored in the module
+      (AT&W0 and AT&P0) and the record is saved by the GSMBootStore:
+      CRC of the parameters sent by this program and CRC of the
+      parameters read back by the short queries (fingerprint, see
+      GetConfigFingerprint())
+    - next InitParam(PARAM_SET_0) reads the fingerprint only, the whole
+      sequence is sent again when there is no record, the program sends
+      other parameters (e.g. new firmware) or the configuration
+      of the module differs (e.g. the module was replaced)
+    - parameters which are not kept in the profile (GPIOs, SMS storage,
+      phonebook, character set...) are sent always
+
+    an example of usage (see GSMBootEEPROM.h):
+        GSMBootEEPROMStore boot_store(0);
+
+        gsm.SetBootStore(&boot_store);
+        gsm.TurnOn();
+*/
+
+// record of the stored module configuration
+struct GSMBootRecord
+{
+  uint16_t profile_crc;           // CRC of the parameters sent by InitParam()
+  uint16_t fingerprint_crc;       // CRC of the response of the profile queries
+};
+
+// storage of the GSMBootRecord (e.g. EEPROM)
+class GSMBootStore
+{
+  public:
+    // return: 1 - record was read, 0 - there is no valid record
+    virtual byte Load(GSMBootRecord *record) = 0;
+    virtual void Save(const GSMBootRecord *record) = 0;
+};
+
+
 class GSM : public AT
 {
   public:
@@ -179,8 +346,17 @@ class GSM : public AT
     int GSMLibVer(void);
     // turns on GSM module
     void TurnOn(void);
+    // non-blocking switching on
+    void StartTurnOn(byte max_attempts);
+    byte PollTurnOn(void);
+    inline byte GetTurnOnStep(void) {return turnon_step;};
+    inline byte GetTurnOnAttempt(void) {return turnon_attempt;};
     // sends some initialization parameters
     void InitParam (byte group);
+    // fast boot (NULL - all parameters are sent always)
+    inline void SetBootStore(GSMBootStore *store) {boot_store = store;};
+    // 1 - last InitParam(PARAM_SET_0) kept the stored profile
+    inline byte IsFastBoot(void) {return boot_fast;};
     // enables DTMF decoder
     void EnableDTMF(void);
     // gets DTMF value
@@ -255,8 +431,20 @@ class GSM : public AT
     // Method for reading a temperature 
     int GetTemp(void);
 
+#ifdef GSM_CACHE_ENABLED
+    // cache of the query results (gsm_cache_enum or GSM_CACHE_ALL)
+    void SetCacheTTL(byte item, uint16_t ttl);
+    inline uint16_t GetCacheTTL(byte item) {return cache_ttl[item];};
+    void InvalidateCache(byte item);
+#ifdef URC_ENABLED
+    // URCs invalidate the related values
+    virtual void URCReceived(const char *line, byte len);
+#endif
+#endif
+
 
     // Support functions
+    // (kept for compatibility, new code should use StrView.h)
     char *ReadToken(char *str, char *buf, char delimiter);
     char *Skip(char *str, char match);
 
@@ -310,6 +498,9 @@ class GSM : public AT
     void SendDataF(PGM_P str_data);
     void SendData(byte* data_buffer, unsigned short size);
     uint16_t RcvData(uint16_t start_comm_tmout, uint16_t max_interchar_tmout, byte** ptr_to_rcv_data);
+    char SetRcvDataDelimiterF(PGM_P delimiter);
+    // position behind the delimiter in the last received data (-1 - not found)
+    inline signed short GetRcvDataDelimiterPos(void) {return rcv_delimiter_pos;};
     signed short StrInBin(byte* p_bin_data, char* p_string_to_search, unsigned short size);
 
 
@@ -323,6 +514,58 @@ class GSM : public AT
     byte last_speaker_volume;
     // current IP_address as a string - now we support only one IP address in one time
     char IP_address[15+1]; // "XXX.XXX.XXX.XXX"
+
+    // switching on (see StartTurnOn())
+    ATCmd turnon_cmd;                   // "AT" check
+    byte turnon_step;                   // turnon_step_enum
+    byte turnon_attempt;                // num. of the switch on sequences so far
+    byte turnon_max_attempts;           // 0 - not limited
+    unsigned long turnon_time;          // beginning of the step
+
+    inline void SetTurnOnStep(byte step) {turnon_step = step; turnon_time = millis();};
+    void StartTurnOnCheck(void);
+    byte FinishTurnOn(void);
+
+    // fast boot (see SetBootStore())
+    GSMBootStore *boot_store;
+    byte boot_fast;                     // 1 - profile of the module is used
+
+    void AddProfileParams(ATBatch *batch, byte group, char *string);
+    uint16_t GetProfileCrc(void);
+    byte GetConfigFingerprint(uint16_t *crc);
+    byte IsBootProfileValid(void);
+    void SaveBootProfile(void);
+
+#ifdef GSM_CACHE_ENABLED
+    // cached query results
+    int cache_value[GSM_CACHE_LAST_ITEM];
+    unsigned long cache_time[GSM_CACHE_LAST_ITEM]; // millis() of the stored value
+    uint16_t cache_ttl[GSM_CACHE_LAST_ITEM];
+    uint16_t cache_valid;               // bit per item
+
+    byte GetCached(byte item, int *value);
+    void PutCached(byte item, int value);
+    // cache item of the pin or socket (GSM_CACHE_LAST_ITEM - not cached)
+    inline byte GPIOCacheItem(byte GPIO_pin) {
+      return (((GPIO_pin >= GPIO10) && (GPIO_pin <= GPIO13)) ? GSM_CACHE_GPIO10 + GPIO_pin - GPIO10 : GSM_CACHE_LAST_ITEM);
+    };
+    inline byte SocketCacheItem(byte connection_id) {
+      return (((connection_id >= 1) && (connection_id <= 6)) ? GSM_CACHE_SOCKET1 + connection_id - 1 : GSM_CACHE_LAST_ITEM);
+    };
+    // connection_id: 1..6, 0 - all sockets
+    void InvalidateSocketCache(byte connection_id);
+#endif
+
+    //=================================================================
+    // Private section for GPRS
+    //=================================================================
+    // searches in the received data stream, the state is kept between
+    // RcvData() calls so strings split between two chunks are found too
+    StreamSearch rcv_close_search;      // "<CR><LF>NO CARRIER<CR><LF>"
+    StreamSearch rcv_delimiter_search;  // delimiter set by SetRcvDataDelimiterF()
+    signed short rcv_delimiter_pos;     // delimiter position in the last chunk
+
+    void StartDataMode(void);
 };
 
 
@@ -18,13 +18,46 @@
 #include <avr/pgmspace.h>
 #include "GSM_GPRS.h"
 #include "GSM_GE863.h"
+#include "ATCmdLine.h"
 
 
 extern "C" {
   #include <string.h>
+  #include <stdlib.h>
 }
 
 
+/**********************************************************
+AT commands of the GPRS part (see RunATCmdDesc())
+**********************************************************/
+enum gprs_cmd_enum
+{
+  GPRS_CMD_IS_OFF = 0,          // "#GPRS: 0" - context is not activated
+  GPRS_CMD_REOPEN_OFF,          // GPRS_CMD_REOPEN_OFF and GPRS_CMD_ON
+  GPRS_CMD_ON,                  // is the reopen sequence
+  GPRS_CMD_OFF,
+  GPRS_CMD_ESC_PROMPT_DELAY,    // min. time before "+++" to 20*1/50sec. = 400msec.
+
+  GPRS_CMD_LAST_ITEM
+};
+
+static const char gprs_cmd_gprs_query[] PROGMEM = "AT#GPRS?";
+static const char gprs_cmd_gprs0[] PROGMEM = "AT#GPRS=0";
+static const char gprs_cmd_gprs1[] PROGMEM = "AT#GPRS=1";
+static const char gprs_cmd_s12[] PROGMEM = "ATS12=20";
+
+static const char gprs_resp_ok[] PROGMEM = "OK";
+static const char gprs_resp_gprs0[] PROGMEM = "#GPRS: 0";
+
+static const ATCmdDesc gprs_cmds[GPRS_CMD_LAST_ITEM] PROGMEM = {
+  {gprs_cmd_gprs_query, gprs_resp_gprs0, AT_TMOUT_CLASS_LONG, 2, NULL},
+  {gprs_cmd_gprs0, gprs_resp_ok, AT_TMOUT_CLASS_NET, 3, NULL},
+  {gprs_cmd_gprs1, gprs_resp_ok, AT_TMOUT_CLASS_NET, 1, NULL},
+  {gprs_cmd_gprs0, gprs_resp_ok, AT_TMOUT_CLASS_LONG, 2, NULL},
+  {gprs_cmd_s12, gprs_resp_ok, AT_TMOUT_CLASS_SHORT, 3, NULL},
+};
+
+
 /**********************************************************
 Method returns GPRS library version
 
@@ -66,27 +99,19 @@ an example of usage:
 char GSM::InitGPRS(char* apn, char* login, char* password)
 {
   char ret_val = -1;
-  char cmd[100];
-
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-  // prepare command:  AT+CGDCONT=1,"IP","apn"
-  strcpy_P(cmd, PSTR("AT+CGDCONT=1,\"IP\",\""));
-  strcat(cmd, apn);
-  strcat_P(cmd, PSTR("\"")); // add character "
-  ret_val = SendATCmdWaitResp(cmd, 1000, 100, "OK", 2);
+
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+  // AT+CGDCONT=1,"IP","apn"
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT+CGDCONT=1,\"IP\","), ATQuote(apn)),
+                              1000, 100, "OK", 2);
   if (ret_val == AT_RESP_OK) {
-    // prepare command:  AT#USERID="login"
-    strcpy_P(cmd, PSTR("AT#USERID=\""));
-    strcat(cmd, login);
-    strcat_P(cmd, PSTR("\"")); // add character "
-    ret_val = SendATCmdWaitResp(cmd, 1000, 100, "OK", 2);
+    // AT#USERID="login"
+    ret_val = SendATCmdWaitResp(ATLine(ATF("AT#USERID="), ATQuote(login)),
+                                1000, 100, "OK", 2);
     if (ret_val == AT_RESP_OK) {
-      // prepare command:  AT#PASSW="password"
-      strcpy_P(cmd, PSTR("AT#PASSW=\""));
-      strcat(cmd, password);
-      strcat_P(cmd, PSTR("\"")); // add character "
-      ret_val = SendATCmdWaitResp(cmd, 1000, 100, "OK", 2);
+      // AT#PASSW="password"
+      ret_val = SendATCmdWaitResp(ATLine(ATF("AT#PASSW="), ATQuote(password)),
+                                  1000, 100, "OK", 2);
       if (ret_val == AT_RESP_OK) ret_val = 1;
       else ret_val = 0;
     }
@@ -133,42 +158,24 @@ an example of usage:
 char GSM::EnableGPRS(byte open_mode)
 {
   char ret_val = -1;
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(0); // all sockets
+#endif
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-
-  if (open_mode == CHECK_AND_OPEN) {
-    // first try if the GPRS context has not been already initialized
-    ret_val = SendATCmdWaitRespF(PSTR("AT#GPRS?"), 1000, 100, "#GPRS: 0", 2);
-    if (ret_val == AT_RESP_OK) {
-      // context is not initialized => init the context
-      //Enable GPRS
-      ret_val = SendATCmdWaitRespF(PSTR("AT#GPRS=1"), 10000, 1000, "OK", 1);
-      if (ret_val == AT_RESP_OK) {
-        // context was activated
-        ret_val = 1;
-      }
-      else ret_val = 0; // not activated
-    }
-    else ret_val = 1; // context has been already activated
-  }
-  else {
+  if (open_mode != CHECK_AND_OPEN) {
     // CLOSE_AND_REOPEN mode
-    //disable GPRS context
-    ret_val = SendATCmdWaitRespF(PSTR("AT#GPRS=0"), 10000, 1000, "OK", 3);
-    if (ret_val == AT_RESP_OK) {
-      // context is dactivated
-      // => activate GPRS context again
-      ret_val = SendATCmdWaitRespF(PSTR("AT#GPRS=1"), 10000, 1000, "OK", 1);
-      if (ret_val == AT_RESP_OK) {
-        // context was activated
-        ret_val = 1;
-      }
-      else ret_val = 0; // not activated
-    }
-    else ret_val = 0; // not activated
+    // disable GPRS context and activate it again
+    return (RunATCmdSeq(&gprs_cmds[GPRS_CMD_REOPEN_OFF], 2, ATCMD_PRIO_NORMAL, NULL));
   }
 
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+  // first try if the GPRS context has not been already initialized
+  if (ExecATCmdDesc(&gprs_cmds[GPRS_CMD_IS_OFF], NULL) == 1) {
+    // context is not initialized => activate the context
+    ret_val = ExecATCmdDesc(&gprs_cmds[GPRS_CMD_ON], NULL);
+  }
+  else ret_val = 1; // context has been already activated
+
   SetCommLineStatus(CLS_FREE);
   return (ret_val);
 }
@@ -196,19 +203,10 @@ an example of usage:
 **********************************************************/
 char GSM::DisableGPRS(void)
 {
-  char ret_val = -1;
-
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-  ret_val = SendATCmdWaitRespF(PSTR("AT#GPRS=0"), 1000, 100, "OK", 2);
-  if (ret_val == AT_RESP_OK) {
-    // context was disabled
-    ret_val = 1;
-  }
-  else ret_val = 0; // context was not disabled
-
-  SetCommLineStatus(CLS_FREE);
-  return (ret_val);
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(0); // all sockets
+#endif
+  return (RunATCmdDesc(&gprs_cmds[GPRS_CMD_OFF], ATCMD_PRIO_NORMAL, NULL));
 }
 
 /**********************************************************
@@ -250,34 +248,23 @@ char GSM::OpenSocket(byte socket_type, uint16_t remote_port, char* remote_addr,
                      byte closure_type, uint16_t local_port)
 {
   char ret_val = -1;
-  char cmd[100];
-  char tmp_str[10];
-
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-  // prepare command:  AT+CGDCONT=1,"IP","apn"
-  // AT#SKTD=0,80,"www.telit.net", 0, 0
-  strcpy_P(cmd, PSTR("AT#SKTD="));
-  // add socket type
-  strcat(cmd, itoa(socket_type, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // add remote_port
-  strcat(cmd, itoa(remote_port, tmp_str, 10));
-  strcat_P(cmd, PSTR(",\"")); // add characters ,"
-  // add remote addr
-  strcat(cmd, remote_addr);
-  strcat_P(cmd, PSTR("\",")); // add characters ",
-  // add closure type
-  strcat(cmd, itoa(closure_type, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // add local port
-  strcat(cmd, itoa(local_port, tmp_str, 10));
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(0); // all sockets
+#endif
 
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+  // AT#SKTD=0,80,"www.telit.net",0,0
+  // (socket type, remote port, remote addr, closure type, local port)
   // send AT command and waits for the response "CONNECT" - max. 3 times
-  ret_val = SendATCmdWaitResp(cmd, 20000, 200, "CONNECT", 3);
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SKTD="), socket_type, 
+                                     ATF(","), remote_port,
+                                     ATF(","), ATQuote(remote_addr),
+                                     ATF(","), closure_type,
+                                     ATF(","), local_port),
+                              20000, 200, "CONNECT", 3);
   if (ret_val == AT_RESP_OK) {
     ret_val = 1;
-    SetCommLineStatus(CLS_DATA);
+    StartDataMode();
   }
   else {
     ret_val = 0;
@@ -319,33 +306,20 @@ an example of usage:
 char GSM::IPEasyExt_InitGPRS(byte PDP_contect_identifier, char* apn, char* login, char* password)
 {
   char ret_val = -1;
-  char tmp_str[10];
-  char cmd[100];
-
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-  // prepare command:  AT+CGDCONT=1,"IP","apn"
-  strcpy_P(cmd, PSTR("AT+CGDCONT="));
-  // connection ID
-  strcat(cmd, itoa(PDP_contect_identifier, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  strcat_P(cmd, PSTR("\"IP\""));
-  strcat_P(cmd, PSTR(",\"")); // add character ,
-  strcat(cmd, apn);
-  strcat_P(cmd, PSTR("\"")); // add character "
-  ret_val = SendATCmdWaitResp(cmd, 1000, 100, "OK", 2);
+
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+  // AT+CGDCONT=1,"IP","apn" (1 here is PDP_contect_identifier)
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT+CGDCONT="), PDP_contect_identifier,
+                                     ATF(",\"IP\","), ATQuote(apn)),
+                              1000, 100, "OK", 2);
   if (ret_val == AT_RESP_OK) {
-    // prepare command:  AT#USERID="login"
-    strcpy_P(cmd, PSTR("AT#USERID=\""));
-    strcat(cmd, login);
-    strcat_P(cmd, PSTR("\"")); // add character "
-    ret_val = SendATCmdWaitResp(cmd, 1000, 100, "OK", 2);
+    // AT#USERID="login"
+    ret_val = SendATCmdWaitResp(ATLine(ATF("AT#USERID="), ATQuote(login)),
+                                1000, 100, "OK", 2);
     if (ret_val == AT_RESP_OK) {
-      // prepare command:  AT#PASSW="password"
-      strcpy_P(cmd, PSTR("AT#PASSW=\""));
-      strcat(cmd, password);
-      strcat_P(cmd, PSTR("\"")); // add character "
-      ret_val = SendATCmdWaitResp(cmd, 1000, 100, "OK", 2);
+      // AT#PASSW="password"
+      ret_val = SendATCmdWaitResp(ATLine(ATF("AT#PASSW="), ATQuote(password)),
+                                  1000, 100, "OK", 2);
       if (ret_val == AT_RESP_OK) ret_val = 1;
       else ret_val = 0;
     }
@@ -385,22 +359,16 @@ an example of usage:
 char GSM::IPEasyExt_EnableOrDisableGPRS(byte PDP_contect_identifier, byte enable_disable)
 {
   char ret_val = -1;
-  char cmd[100];
-  char tmp_str[10];
   char num_of_bytes;
   byte* rx_data;
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(0); // all sockets
+#endif
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-
-  // AT#SD=0,80,"remote_addr(e.g. www.telit.net)", 0, 0
-  strcpy_P(cmd, PSTR("AT#SGACT="));
-  // context ID
-  strcat(cmd, itoa(PDP_contect_identifier, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // anable/disable
-  strcat(cmd, itoa(enable_disable, tmp_str, 10));
-  Println(cmd);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+
+  // AT#SGACT=1,1 (context ID, enable/disable)
+  Println(ATLine(ATF("AT#SGACT="), PDP_contect_identifier, ATF(","), enable_disable));
   
   //wait for response
   /*
@@ -433,20 +401,12 @@ char GSM::IPEasyExt_EnableOrDisableGPRS(byte PDP_contect_identifier, byte enable
   
   if (ret_val == 0) {
     // ERROR response => try to reopen connection => close and open again
-    strcpy_P(cmd, PSTR("AT#SGACT="));
-    // context ID
-    strcat(cmd, itoa(PDP_contect_identifier, tmp_str, 10));
-    strcat_P(cmd, PSTR(",0")); // add character , and 0 = DISABLE
-    ret_val = SendATCmdWaitResp(cmd, 20000, 200, "OK", 3);
+    // (,0 = DISABLE)
+    ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SGACT="), PDP_contect_identifier, ATF(",0")),
+                                20000, 200, "OK", 3);
 
     // and now try anyway 
-    strcpy_P(cmd, PSTR("AT#SGACT="));
-    // context ID
-    strcat(cmd, itoa(PDP_contect_identifier, tmp_str, 10));
-    strcat_P(cmd, PSTR(",")); // add character ,
-    // anable/disable
-    strcat(cmd, itoa(enable_disable, tmp_str, 10));
-    Println(cmd);
+    Println(ATLine(ATF("AT#SGACT="), PDP_contect_identifier, ATF(","), enable_disable));
     if (FindUntil("#SGACT: ", "ERROR", 20000)) {
       // #SGACT: "    string was found
       num_of_bytes = ReadBytesUntil('\r', IP_address, 17/*max XXX.XXX.XXX.XXX + CR LF */);
@@ -531,39 +491,27 @@ char GSM::IPEasyExt_OpenSocket(byte connection_id, byte socket_type, uint16_t re
                      byte closure_type, uint16_t local_port)
 {
   char ret_val = -1;
-  char cmd[100];
-  char tmp_str[10];
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(connection_id);
+#endif
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   // set Escape Prompt Delay = minimum time before "+++" to 20*1/50sec. = 20*20msec. = 400msec.
-  SendATCmdWaitRespF(PSTR("ATS12=20"), 500, 20, "OK", 3);
-
-  // AT#SD=0,80,"remote_addr(e.g. www.telit.net)", 0, 0
-  strcpy_P(cmd, PSTR("AT#SD="));
-  // connection ID
-  strcat(cmd, itoa(connection_id, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // add socket type
-  strcat(cmd, itoa(socket_type, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // add remote_port
-  strcat(cmd, itoa(remote_port, tmp_str, 10));
-  strcat_P(cmd, PSTR(",\"")); // add characters ,"
-  // add remote addr
-  strcat(cmd, remote_addr);
-  strcat_P(cmd, PSTR("\",")); // add characters ",
-  // add closure type
-  strcat(cmd, itoa(closure_type, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // add local port
-  strcat(cmd, itoa(local_port, tmp_str, 10));
+  ExecATCmdDesc(&gprs_cmds[GPRS_CMD_ESC_PROMPT_DELAY], NULL);
 
+  // AT#SD=1,0,80,"remote_addr(e.g. www.telit.net)",0,0
+  // (connection ID, socket type, remote port, remote addr, closure type, local port)
   // send AT command and waits for the response "CONNECT" - max. 3 times
-  ret_val = SendATCmdWaitResp(cmd, 20000, 200, "CONNECT", 3);
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SD="), connection_id,
+                                     ATF(","), socket_type,
+                                     ATF(","), remote_port,
+                                     ATF(","), ATQuote(remote_addr),
+                                     ATF(","), closure_type,
+                                     ATF(","), local_port),
+                              20000, 200, "CONNECT", 3);
   if (ret_val == AT_RESP_OK) {
     ret_val = 1;
-    SetCommLineStatus(CLS_DATA);
+    StartDataMode();
   }
   else {
     ret_val = 0;
@@ -609,24 +557,17 @@ an example of usage:
 char GSM::IPEasyExt_OpenSocketInListenMode(byte connection_id, byte listen_state, uint16_t listen_port)
 {
   char ret_val = -1;
-  char cmd[50];
-  char tmp_str[10];
-
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-  // AT#SL = 1, 1, 6543
-  strcpy_P(cmd, PSTR("AT#SL="));
-  // connection ID
-  strcat(cmd, itoa(connection_id, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // add listen state
-  strcat(cmd, itoa(listen_state, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-  // add listen port
-  strcat(cmd, itoa(listen_port, tmp_str, 10));
-
-  // send AT command and waits for the response "CONNECT" - max. 3 times
-  ret_val = SendATCmdWaitResp(cmd, 20000, 200, "OK", 3);
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(connection_id);
+#endif
+
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+  // AT#SL=1,1,6543 (connection ID, listen state, listen port)
+  // send AT command and waits for the response "OK" - max. 3 times
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SL="), connection_id,
+                                     ATF(","), listen_state,
+                                     ATF(","), listen_port),
+                              20000, 200, "OK", 3);
   if (ret_val == AT_RESP_OK) {
     ret_val = 1;
   }
@@ -667,20 +608,17 @@ an example of usage:
 char GSM::IPEasyExt_AcceptSocket(byte connection_id)
 {
   char ret_val = -1;
-  char cmd[50];
-  char tmp_str[10];
-
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
-  // AT#SL = 1, 1, 6543
-  strcpy_P(cmd, PSTR("AT#SA="));
-  // connection ID
-  strcat(cmd, itoa(connection_id, tmp_str, 10));
-  
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(connection_id);
+#endif
+
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
+  // AT#SA=1 (1 here is connection_id = 1)
   // send AT command and waits for the response "CONNECT" - max. 3 times
-  ret_val = SendATCmdWaitResp(cmd, 20000, 200, "CONNECT", 3);
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SA="), connection_id),
+                              20000, 200, "CONNECT", 3);
   if (ret_val == AT_RESP_OK) {
-    SetCommLineStatus(CLS_DATA);
+    StartDataMode();
     ret_val = 1;
   }
   else {
@@ -741,42 +679,22 @@ char GSM::IPEasyExt_ConfigSocket(byte socket_id,
 )
 {
   char ret_val = -1;
-  char cmd[100];
-  char tmp_str[10];
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   // set Escape Prompt Delay = minimum time before "+++" to 20*1/50sec. = 20*20msec. = 400msec.
-  SendATCmdWaitRespF(PSTR("ATS12=20"), 500, 20, "OK", 3);
-
-  // AT#SCFG = 2, 3, 512, 30, 300,100
-  strcpy_P(cmd, PSTR("AT#SCFG="));
-  // connection ID  = socket id in rANGE 1..6
-  strcat(cmd, itoa(socket_id, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-
-  // add CONTEXT id
-  strcat(cmd, itoa(context_id, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add character ,
-
-  // add Pkt sz -the minimum data packet sent to the net
-  strcat(cmd, itoa(min_pkt_size, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add characters ,"
-
-  // add inactivity tmout
-  strcat(cmd, itoa(inactivity_tmout, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add characters ,"
-
-  // add connection_tmout
-  strcat(cmd, itoa(connection_tmout, tmp_str, 10));
-  strcat_P(cmd, PSTR(",")); // add characters ,"
-
-  // add data_sending_tmout
-  strcat(cmd, itoa(data_sending_tmout, tmp_str, 10));
- 
-
-  // send AT command and waits for the response "CONNECT" - max. 3 times
-  ret_val = SendATCmdWaitResp(cmd, 20000, 200, "OK", 3);
+  ExecATCmdDesc(&gprs_cmds[GPRS_CMD_ESC_PROMPT_DELAY], NULL);
+
+  // AT#SCFG=2,3,512,30,300,100
+  // (socket id in range 1..6, context id, min. packet size sent to the net,
+  // inactivity tmout, connection tmout, data sending tmout)
+  // send AT command and waits for the response "OK" - max. 3 times
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SCFG="), socket_id,
+                                     ATF(","), context_id,
+                                     ATF(","), min_pkt_size,
+                                     ATF(","), inactivity_tmout,
+                                     ATF(","), connection_tmout,
+                                     ATF(","), data_sending_tmout),
+                              20000, 200, "OK", 3);
   if (ret_val == AT_RESP_OK) {
     ret_val = 1;
   }
@@ -814,6 +732,9 @@ char GSM::IPEasyExt_SuspendSocket(byte connection_id)
 {
   char ret_val = -1;
   byte* rx_data;
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(connection_id);
+#endif
 
   // sequence "+++" will be sent but this sequence must be sent with some delay before "+++"
   // 
@@ -860,24 +781,20 @@ an example of usage:
 char GSM::IPEasyExt_ResumeSocket(byte connection_id)
 {
   char ret_val = -1;
-  char cmd[10];
-  char tmp_str[5];
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(connection_id);
+#endif
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
   // AT#SO=1 (1 here is connection_id = 1)
-  strcpy_P(cmd, PSTR("AT#SO="));
-  // connection ID
-  strcat(cmd, itoa(connection_id, tmp_str, 10));
-  // send the string
-  Println(cmd);
+  Println(ATLine(ATF("AT#SO="), connection_id));
   
   //wait for response
   // here we can not use SendATCmdWaitResp becuase we need finish immediatelly CONNECT
   // is received
   if (FindUntil("CONNECT", "NO CARRIER", 5000)) {
     // CONNECT was found
-    SetCommLineStatus(CLS_DATA);
+    StartDataMode();
     ret_val = 1;
   }
   else {
@@ -916,8 +833,9 @@ char GSM::IPEasyExt_CloseSocket(byte connection_id, byte send_ESC_seq_before)
 {
   char ret_val = -1;
   byte* rx_data;
-  char cmd[10];
-  char tmp_str[5];
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(connection_id);
+#endif
 
 
   // socket can be closed any time so we can not check the state of the line
@@ -953,11 +871,8 @@ char GSM::IPEasyExt_CloseSocket(byte connection_id, byte send_ESC_seq_before)
     }
   }
 
-  // AT#SH=1 1 (1 here is connection_id = 1)
-  strcpy_P(cmd, PSTR("AT#SH="));
-  // connection ID
-  strcat(cmd, itoa(connection_id, tmp_str, 10));
-  ret_val = SendATCmdWaitResp(cmd, 500, 20, "OK", 3);
+  // AT#SH=1 (1 here is connection_id = 1)
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SH="), connection_id), 500, 20, "OK", 3);
 
   SetCommLineStatus(CLS_FREE);
   return (1);
@@ -993,23 +908,24 @@ an example of usage:
 char GSM::IPEasyExt_GetSocketStatus(byte connection_id)
 {
   signed short ret_val = -1;
-  char cmd[10];
-  char tmp_str[5];
-  char *p_resp;
-  char *p_buf = (char*)&gsm.comm_buf[0];
+  StrView resp;
+  StrView line;
+  StrView field;
+  long val;
+#ifdef GSM_CACHE_ENABLED
+  byte item = SocketCacheItem(connection_id);
+  int cached;
+
+  if ((item < GSM_CACHE_LAST_ITEM) && GetCached(item, &cached)) return (cached);
+#endif
 
 
-  if (CLS_FREE != GetCommLineStatus()) return (ret_val);
-  SetCommLineStatus(CLS_ATCMD);
+  if (!AcquireCommLine(ATCMD_PRIO_NORMAL)) return (ret_val);
 
   // AT#SI=1 (1 here is connection_id = 1)
 
   // better is AT#SS=1
-  strcpy_P(cmd, PSTR("AT#SS="));
-  // connection ID
-  strcat(cmd, itoa(connection_id, tmp_str, 10));
-
-  ret_val = SendATCmdWaitResp(cmd, 500, 20, "OK", 3);
+  ret_val = SendATCmdWaitResp(ATLine(ATF("AT#SS="), connection_id), 500, 20, "OK", 3);
 
   if (ret_val == AT_RESP_OK) {
     // response example to SI: #SI: 1,123,400,10,50 OK
@@ -1034,15 +950,24 @@ char GSM::IPEasyExt_GetSocketStatus(byte connection_id)
 
     // 
 
-    p_resp = gsm.Skip(p_buf, ',');                // first ","
-    // we are on the <Status>
-    ret_val = strtol(p_resp, NULL, 10);
+    GetRespView(&resp);
+    ret_val = 10; // an error response until the status is read
+    if (SVFindLineF(&resp, PSTR("#SS:"), &line)
+        && SVSkipPast(&line, ':')
+        && SVNextField(&line, &field, ',')        // <ConnId>
+        && SVNextField(&line, &field, ',')        // we are on the <Status>
+        && SVToLong(&field, &val)) {
+      ret_val = val;
+    }
   }
   else {
     ret_val = 10; // an error response
   }
 
   SetCommLineStatus(CLS_FREE);
+#ifdef GSM_CACHE_ENABLED
+  if ((item < GSM_CACHE_LAST_ITEM) && (ret_val >= 0) && (ret_val != 10)) PutCached(item, ret_val);
+#endif
   return (ret_val);
 }
 
@@ -1098,6 +1023,11 @@ void GSM::SendData(byte* data_buffer, unsigned short size)
 /**********************************************************
 Methods receives data from the serial port
 
+- "<CR><LF>NO CARRIER<CR><LF>" (socket was closed) and the delimiter
+  set by SetRcvDataDelimiterF() are searched in the whole data stream
+  so they are found also in case they are split between two 
+  RcvData() calls
+
 return: 
         number of received bytes
 
@@ -1115,22 +1045,38 @@ an example of usage:
 **********************************************************/
 uint16_t  GSM::RcvData(uint16_t start_comm_tmout, uint16_t max_interchar_tmout, byte** ptr_to_rcv_data)
 {
-  byte status;
-
-  RxInit(start_comm_tmout, max_interchar_tmout, 0, 0); 
+  ATCmd cmd;
+  uint16_t pos;
+  signed short found;
+
+  // data reception - rx buffer is not flushed and reading 
+  // is finished when the comm. buffer is full
+  SetupATCmd(&cmd, NULL, ATCMD_FLAG_DATA, start_comm_tmout, max_interchar_tmout, 
+             NULL, 1, NULL);
   // wait until response is not finished
-
-  do {
-    status = IsRxFinished();
-  } while (status == RX_NOT_FINISHED);
+  RunATCmd(&cmd);
 
   if (comm_buf_len) *ptr_to_rcv_data = comm_buf;
   else *ptr_to_rcv_data = NULL;
 
-  // check <CR><LF>NO CARRIER<CR><LF>
-  // in case this string was received => socked is closed
+  rcv_delimiter_pos = -1;
   if (comm_buf_len) { 
-    if (StrInBin(comm_buf, "\r\nNO CARRIER\r\n", comm_buf_len) != -1) {
+    // only the first delimiter is reported but the rest of data
+    // must be also passed to keep the state for the next data
+    rcv_delimiter_pos = SSFind(&rcv_delimiter_search, comm_buf, comm_buf_len);
+    if (rcv_delimiter_pos != -1) {
+      // search stops behind every occurrence
+      pos = rcv_delimiter_pos;
+      while (pos < comm_buf_len) {
+        found = SSFind(&rcv_delimiter_search, comm_buf + pos, comm_buf_len - pos);
+        if (found == -1) break;
+        pos += found;
+      }
+    }
+
+    // check <CR><LF>NO CARRIER<CR><LF>
+    // in case this string was received => socked is closed
+    if (SSFind(&rcv_close_search, comm_buf, comm_buf_len) != -1) {
       // NO CARRIER was received => socket was closed from the host side
       // we can set the communication line to the FREE state
       SetCommLineStatus(CLS_FREE);
@@ -1140,6 +1086,43 @@ uint16_t  GSM::RcvData(uint16_t start_comm_tmout, uint16_t max_interchar_tmout,
   return (comm_buf_len);
 }
 
+/**********************************************************
+Method sets the delimiter which is searched in the data
+received by RcvData() e.g. end of the HTTP header
+- delimiter is searched in the whole data stream of the 
+  connection so it is found also in case it is split between 
+  two RcvData() calls
+- search is started again when the next connection is opened
+
+delimiter: delimiter placed in the Flash memory
+           (max. STREAM_SEARCH_LEN characters)
+           NULL - delimiter is not searched
+
+return: 
+        -1 - delimiter is too long (delimiter is not searched)
+         1 - delimiter was set
+
+
+an example of usage:
+        byte *rx_data;
+        uint16_t len;
+
+        gsm.SetRcvDataDelimiterF(PSTR("\r\n\r\n"));
+        len = gsm.RcvData(5000, 100, &rx_data);
+        if (gsm.GetRcvDataDelimiterPos() != -1) {
+          // HTTP body starts at rx_data + gsm.GetRcvDataDelimiterPos()
+        }
+**********************************************************/
+char GSM::SetRcvDataDelimiterF(PGM_P delimiter)
+{
+  rcv_delimiter_pos = -1;
+  if (delimiter == NULL) {
+    SSInit(&rcv_delimiter_search, "");
+    return (1);
+  }
+  return (SSInitF(&rcv_delimiter_search, delimiter));
+}
+
 /**********************************************************
 Method closes previously opened socket
 
@@ -1164,6 +1147,9 @@ char GSM::CloseSocket(void)
   char ret_val = -1;
   byte i;
   byte* rx_data;
+#ifdef GSM_CACHE_ENABLED
+  InvalidateSocketCache(0); // all sockets
+#endif
 
   if (CLS_FREE == GetCommLineStatus()) {
     ret_val = 1; // socket was already closed
@@ -1205,37 +1191,58 @@ char GSM::CloseSocket(void)
 
 /**********************************************************
 Method used for finding string in the binary data buffer
+(every byte of the buffer is checked only once, see StreamSearch.h,
+the failure function of strings longer than STREAM_SEARCH_LEN
+characters is placed temporarily in the heap)
 
 p_bin_data: pointer to the binary "buffer" where a string should be find
 p_string_to_search: pointer to the string which is supposed to be find
 size: size of the binary "buffer"
 
 return: 
-        -1    - string was not found
+        -1    - string was not found (or it is empty or there is
+                not enough memory for the longer string)
         > -1  - first position in the buffer where string which was found started
 **********************************************************/
 signed short GSM::StrInBin(byte* p_bin_data, char* p_string_to_search, unsigned short size)
 {
-  uint16_t pos_1, pos_2, pos_before_match;
-
-  pos_1 = 0;
-  pos_2 = 0;
-  pos_before_match = 0;
-  if (size) {
-    while (pos_1 < size) {
-      if (p_string_to_search[pos_2] == p_bin_data[pos_1]) {
-        pos_2++;
-        pos_1++;
-        if (p_string_to_search[pos_2] == 0) return (pos_before_match);
-      }
-      else {
-        pos_2 = 0; // from the start of p_string_to_search
-        pos_before_match++;
-        pos_1 = pos_before_match;
-      }
-    }
-    return (-1);
+  StreamSearch search;
+  signed short pos;
+  size_t len;
+  uint16_t *fail;
+
+  len = strlen(p_string_to_search);
+  if (len == 0) return (-1);
+  if (len <= STREAM_SEARCH_LEN) {
+    SSInit(&search, p_string_to_search);
+    pos = SSFind(&search, p_bin_data, size);
+    if (pos == -1) return (-1);
+    return (pos - search.len);
+  }
+
+  // string is too long for the table in the StreamSearch
+  if (len > size) return (-1);
+  fail = (uint16_t *)malloc(len * sizeof(uint16_t));
+  if (fail == NULL) return (-1);
+  pos = -1;
+  if (SSInitExt(&search, p_string_to_search, fail, len) > 0) {
+    pos = SSFind(&search, p_bin_data, size);
+    if (pos != -1) pos -= search.len;
   }
-  else return (-1);
+  free(fail);
+  return (pos);
+}
+
+/**********************************************************
+Method switches the comm. line to the data state and starts
+the searches in the received data stream again 
+(the new connection was opened)
+**********************************************************/
+void GSM::StartDataMode(void)
+{
+  SSReset(&rcv_close_search);
+  SSReset(&rcv_delimiter_search);
+  rcv_delimiter_pos = -1;
+  SetCommLineStatus(CLS_DATA);
 }
 
@@ -19,7 +19,7 @@
 #define __GSM_GPRS
 
 
-#define GPRS_LIB_VERSION 104 // library version X.YY (e.g. 1.00)
+#define GPRS_LIB_VERSION 108 // library version X.YY (e.g. 1.00)
 /*
     Version
     --------------------------------------------------------------------------
@@ -35,6 +35,19 @@
     --------------------------------------------------------------------------
     103       SendDataF() function added
     --------------------------------------------------------------------------
+    105       RcvData() uses the AT command engine (see AT library 106)
+    --------------------------------------------------------------------------
+    106       methods wait for the comm. line occupied by the AT command engine
+              (see AcquireCommLine())
+    --------------------------------------------------------------------------
+    107       "NO CARRIER" is searched in the whole received data stream
+              (StreamSearch.h) so it is detected also when it is split between
+              two RcvData() calls, SetRcvDataDelimiterF() added,
+              StrInBin() checks every byte only once
+    --------------------------------------------------------------------------
+    108       EnableGPRS(), DisableGPRS() and the escape prompt delay use 
+              the AT commands described in the Flash memory (see AT library 122)
+    --------------------------------------------------------------------------
 */
 
 // type of the socket
@@ -29,13 +29,26 @@
 
 
 // Simple debug print
-// Keep in mind that DEBUG PRINT has only very limited functionality
-// and can not be 100% guaranteed becuase all debug strings are sent also to the 
-// GSM module and thus can be interpreted as AT commands.
+// debug strings are added to the trace (see AT_TRACE_ENABLED below and 
+// AT::SetTrace()), nothing is sent to the GSM module
 // -------------------------------------------------------------
 //#define DEBUG_PRINT
 
 
+// if defined - sent AT commands, their results, URCs, baud rate changes and 
+// debug prints are added as compact binary records to the RAM ring buffer
+// (AT_TRACE_BUF_LEN bytes) and passed to the sink (SoftwareSerial, EEPROM...)
+// only by ATTrace::Flush() so the timing of the library is not changed,
+// see ATTrace.h
+// -------------------------------------------------------------
+//#define AT_TRACE_ENABLED
+
+#if defined(DEBUG_PRINT) && !defined(AT_TRACE_ENABLED)
+  // debug print goes to the trace
+  #define AT_TRACE_ENABLED
+#endif
+
+
 // if defined - debug LED is enabled, otherwise debug LED is disabled
 // -------------------------------------------------------------
 //#define DEBUG_LED_ENABLED
@@ -49,6 +62,60 @@
 //#define DEBUG_SMS_ENABLED
 
 
+// if defined - unsolicited result codes(RING, +CMTI, SRING...) are separated 
+// from the responses and dispatched to the registered handlers (see PollURC())
+// otherwise they are discarded as before
+// -------------------------------------------------------------
+#define URC_ENABLED
+
+
+// if defined - TurnOn() looks for the baud rate of the GSM module when it does 
+// not respond (before it is switched off and on) and raises the baud rate
+// up to the rate given to InitSerLine() or SetMaxBaudRate(),
+// see AT::DetectBaudRate(), AT::UpshiftBaudRate()
+// -------------------------------------------------------------
+//#define AT_AUTOBAUD_ENABLED
+
+
+// if defined - AT commands are counted by the command class (+CREG, #SGACT...)
+// incl. retries, timeouts and latency histograms (see AT::GetCmdStats())
+// tables have fixed size (about 70 bytes of RAM per class with the default
+// AT_CMD_STATS_LEN and AT_CMD_HIST_LEN)
+// -------------------------------------------------------------
+//#define AT_CMD_STATS_ENABLED
+
+
+// if defined - timeouts of the AT commands can be derived from the observed
+// latency of the command class (see AT::SetTmoutMode(AT_TMOUT_ADAPTIVE)),
+// the timeouts in the library are used as upper limits
+// (about 24 bytes of RAM per class with the default AT_ADAPT_EST_LEN)
+// -------------------------------------------------------------
+//#define AT_ADAPTIVE_TMOUT_ENABLED
+
+
+// if defined - results of the periodic queries (CheckRegistration(), GetTemp(),
+// GetGPIOVal(), IsUserButtonPushed(), IPEasyExt_GetSocketStatus()) are kept
+// for the time given by SetCacheTTL() and the query is answered without
+// the AT command, related writes and URCs invalidate the values
+// (about 100 bytes of RAM)
+// -------------------------------------------------------------
+//#define GSM_CACHE_ENABLED
+
+
+// if defined - USART0 of the AVR is driven by the library itself (instead of
+// the HardwareSerial Serial), the receive interrupt puts the characters
+// to the ring buffer of AT_RX_RING_LEN bytes so nothing is lost while
+// the library waits by delay(), the program must not use Serial,
+// see ATUartTransport.h
+// -------------------------------------------------------------
+//#define AT_UART_ISR_ENABLED
+
+#if defined(AT_UART_ISR_ENABLED) && !defined(__AVR__)
+  // only for the AVR
+  #undef AT_UART_ISR_ENABLED
+#endif
+
+
 
 
 #endif // end of ifndef __SETTING_h
@@ -0,0 +1,325 @@
+/*
+  StrView.cpp - zero-copy tokenizer of the responses for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "StrView.h"
+
+extern "C" {
+  #include <string.h>
+}
+
+
+/**********************************************************
+Method initializes the view
+
+view: view to be initialized
+ptr:  first character
+len:  num. of characters
+**********************************************************/
+void SVInit(StrView *view, const char *ptr, uint16_t len)
+{
+  view->ptr = ptr;
+  view->len = len;
+}
+
+/**********************************************************
+Method returns next non-empty line of the buffer
+- <CR> and <LF> are not part of the line
+- buf is moved behind the returned line
+
+return:
+      0 - there is no other line (line is empty)
+      1 - line was found
+**********************************************************/
+byte SVNextLine(StrView *buf, StrView *line)
+{
+  uint16_t i = 0;
+
+  // skip <CR><LF> sequences (empty lines)
+  while (buf->len && ((*buf->ptr == 0x0d) || (*buf->ptr == 0x0a))) {
+    buf->ptr++;
+    buf->len--;
+  }
+
+  while ((i < buf->len) && (buf->ptr[i] != 0x0d) && (buf->ptr[i] != 0x0a)) i++;
+  line->ptr = buf->ptr;
+  line->len = i;
+  buf->ptr += i;
+  buf->len -= i;
+  return (i != 0);
+}
+
+/**********************************************************
+Method returns the line at the current position of the buffer
+(it can be also empty e.g. empty SMS text)
+- <CR> and <LF> are not part of the line
+- buf is moved behind <CR><LF> of the returned line
+
+return:
+      0 - buffer is empty
+      1 - line was returned
+**********************************************************/
+byte SVTakeLine(StrView *buf, StrView *line)
+{
+  uint16_t i = 0;
+
+  if (buf->len == 0) {
+    SVInit(line, buf->ptr, 0);
+    return (0);
+  }
+
+  while ((i < buf->len) && (buf->ptr[i] != 0x0d) && (buf->ptr[i] != 0x0a)) i++;
+  line->ptr = buf->ptr;
+  line->len = i;
+  // skip the line and its <CR><LF>
+  if ((i < buf->len) && (buf->ptr[i] == 0x0d)) i++;
+  if ((i < buf->len) && (buf->ptr[i] == 0x0a)) i++;
+  buf->ptr += i;
+  buf->len -= i;
+  return (1);
+}
+
+/**********************************************************
+Method finds next line which starts with the prefix
+- buf is moved behind the found line (or to the end)
+
+prefix: prefix placed in the Flash memory e.g. PSTR("+CMGR:")
+
+return:
+      0 - line was not found
+      1 - line was found
+**********************************************************/
+byte SVFindLineF(StrView *buf, PGM_P prefix, StrView *line)
+{
+  while (SVNextLine(buf, line)) {
+    if (SVStartsWithF(line, prefix)) return (1);
+  }
+  return (0);
+}
+
+/**********************************************************
+Method returns next field of the line
+- delimiter inside of the quoted string is not taken
+  as delimiter e.g. "02/10/11,09:47:01+08"
+- spaces around the field are removed, quotes are not
+  removed (see SVUnquote())
+- line is moved behind the delimiter
+
+return:
+      0 - there is no other field
+      1 - field was found (can be also empty e.g. ,,)
+**********************************************************/
+byte SVNextField(StrView *line, StrView *field, char delimiter)
+{
+  uint16_t i = 0;
+  byte quoted = 0;
+
+  // line was already exhausted by the last field
+  if (line->ptr == NULL) return (0);
+
+  while (i < line->len) {
+    if (line->ptr[i] == '"') quoted = !quoted;
+    else if ((line->ptr[i] == delimiter) && !quoted) break;
+    i++;
+  }
+
+  field->ptr = line->ptr;
+  field->len = i;
+  SVTrim(field);
+
+  if (i < line->len) {
+    // skip also the delimiter
+    line->ptr += i + 1;
+    line->len -= i + 1;
+  }
+  else {
+    // it was the last field
+    line->ptr = NULL;
+    line->len = 0;
+  }
+  return (1);
+}
+
+/**********************************************************
+Method moves the view behind the first occurrence of ch
+(e.g. behind ':' of the "+CMGL: 1,...")
+
+return:
+      0 - ch was not found (view is empty)
+      1 - view starts behind ch
+**********************************************************/
+byte SVSkipPast(StrView *view, char ch)
+{
+  const char *p_char;
+
+  if (view->ptr == NULL) return (0);
+  p_char = (const char *)memchr(view->ptr, ch, view->len);
+  if (p_char == NULL) {
+    view->ptr += view->len;
+    view->len = 0;
+    return (0);
+  }
+  view->len -= (p_char - view->ptr) + 1;
+  view->ptr = p_char + 1;
+  return (1);
+}
+
+/**********************************************************
+Method removes spaces from the beginning and the end
+of the view
+**********************************************************/
+void SVTrim(StrView *view)
+{
+  while (view->len && (*view->ptr == ' ')) {
+    view->ptr++;
+    view->len--;
+  }
+  while (view->len && (view->ptr[view->len - 1] == ' ')) view->len--;
+}
+
+/**********************************************************
+Method removes quotes around the field
+
+return:
+      0 - field was not quoted
+      1 - quotes were removed
+**********************************************************/
+byte SVUnquote(StrView *field)
+{
+  if ((field->len < 2) || (field->ptr[0] != '"')
+      || (field->ptr[field->len - 1] != '"')) return (0);
+  field->ptr++;
+  field->len -= 2;
+  return (1);
+}
+
+/**********************************************************
+Method checks whether the view starts with the prefix
+
+prefix: prefix placed in the Flash memory
+
+return:
+      0 - view does not start with the prefix
+      1 - view starts with the prefix
+**********************************************************/
+byte SVStartsWithF(const StrView *view, PGM_P prefix)
+{
+  uint16_t i = 0;
+  char ch;
+
+  while ((ch = pgm_read_byte(prefix + i)) != 0x00) {
+    if ((i >= view->len) || (view->ptr[i] != ch)) return (0);
+    i++;
+  }
+  return (1);
+}
+
+/**********************************************************
+Method converts the field to the integer number
+- field must contain only optional sign and digits
+
+value: converted number (not changed in case of error)
+
+return:
+      0 - field is not a valid number (or it is out of range)
+      1 - conversion is OK
+**********************************************************/
+byte SVToLong(const StrView *field, long *value)
+{
+  return (SVToFixed(field, 0, value));
+}
+
+/**********************************************************
+Method converts the field with the decimal point to the
+fixed-point integer number with the required num.
+of decimal places
+e.g. "46.5" with decimals = 2 is converted to 4650
+     "5433.9472" with decimals = 4 is converted to 54339472
+     "120631.999" with decimals = 0 is converted to 120631
+- other decimal places are truncated
+
+value: converted number (not changed in case of error)
+
+return:
+      0 - field is not a valid number (or it is out of range)
+      1 - conversion is OK
+**********************************************************/
+byte SVToFixed(const StrView *field, byte decimals, long *value)
+{
+  unsigned long result = 0;
+  uint16_t i = 0;
+  byte negative = 0;
+  byte digits = 0;
+  byte point = 0;
+  byte ch;
+
+  if (field->len && ((field->ptr[0] == '-') || (field->ptr[0] == '+'))) {
+    negative = (field->ptr[0] == '-');
+    i++;
+  }
+
+  for (; i < field->len; i++) {
+    ch = field->ptr[i];
+    if ((ch == '.') && !point) {
+      point = 1;
+      continue;
+    }
+    if ((ch < '0') || (ch > '9')) return (0);
+    digits++;
+    if (point) {
+      // truncate other decimal places
+      if (decimals == 0) continue;
+      decimals--;
+    }
+    if (result > (0x7FFFFFFFUL - (ch - '0')) / 10) return (0);
+    result = result * 10 + (ch - '0');
+  }
+  if (digits == 0) return (0);
+
+  // missing decimal places
+  while (decimals--) {
+    if (result > 0x7FFFFFFFUL / 10) return (0);
+    result *= 10;
+  }
+
+  *value = (negative) ? -(long)result : (long)result;
+  return (1);
+}
+
+/**********************************************************
+Method copies the view to the string buffer
+- at most buf_size - 1 characters are copied and the string
+  is always finished by 0x00
+
+buf:      destination buffer
+buf_size: size of the destination buffer (including 0x00)
+
+return:
+      num. of copied characters
+**********************************************************/
+uint16_t SVCopy(const StrView *view, char *buf, uint16_t buf_size)
+{
+  uint16_t len = view->len;
+
+  if (buf_size == 0) return (0);
+  if (len > buf_size - 1) len = buf_size - 1;
+  memcpy(buf, view->ptr, len);
+  buf[len] = 0x00;
+  return (len);
+}
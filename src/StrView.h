@@ -0,0 +1,69 @@
+/*
+  StrView.h - zero-copy tokenizer of the responses for the GSM Playground
+  - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __STRVIEW_h
+#define __STRVIEW_h
+
+#include "Arduino.h"
+
+/*
+    StrView is a pointer + length view into the received buffer (comm_buf)
+    - nothing is copied and the buffer is not modified (no 0x00 is written)
+    - every function checks the length so malformed or truncated response
+      can not cause reading or writing out of the buffer
+    - view is consumed from the beginning so the response is parsed
+      in one linear pass
+
+
+    an example of usage:
+        // response: <CR><LF>+CMGR: "REC UNREAD","+420123456789",,"02/10/11,09:47:01+08"<CR><LF>Hello<CR><LF><CR><LF>OK<CR><LF>
+        StrView resp, line, field;
+        long val;
+
+        gsm.GetRespView(&resp);
+        if (SVFindLineF(&resp, PSTR("+CMGR:"), &line)) {
+          SVSkipPast(&line, ':');
+          SVNextField(&line, &field, ',');   // "REC UNREAD"
+          SVNextField(&line, &field, ',');   // "+420123456789"
+          SVUnquote(&field);
+          SVCopy(&field, phone_number, sizeof(phone_number));
+          SVNextLine(&resp, &line);          // Hello
+        }
+*/
+
+struct StrView
+{
+  const char *ptr;                // first character (not finished by 0x00)
+  uint16_t len;                   // num. of characters
+};
+
+
+void SVInit(StrView *view, const char *ptr, uint16_t len);
+byte SVNextLine(StrView *buf, StrView *line);
+byte SVTakeLine(StrView *buf, StrView *line);
+byte SVFindLineF(StrView *buf, PGM_P prefix, StrView *line);
+byte SVNextField(StrView *line, StrView *field, char delimiter);
+byte SVSkipPast(StrView *view, char ch);
+void SVTrim(StrView *view);
+byte SVUnquote(StrView *field);
+byte SVStartsWithF(const StrView *view, PGM_P prefix);
+byte SVToLong(const StrView *field, long *value);
+byte SVToFixed(const StrView *field, byte decimals, long *value);
+uint16_t SVCopy(const StrView *view, char *buf, uint16_t buf_size);
+
+#endif
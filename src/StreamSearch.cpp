@@ -0,0 +1,191 @@
+/*
+  StreamSearch.cpp - streaming search of the string in the data for the
+  GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include "StreamSearch.h"
+
+extern "C" {
+  #include <string.h>
+}
+
+
+/**********************************************************
+Method returns the character of the searched string
+**********************************************************/
+static char SSChar(const StreamSearch *search, uint16_t pos)
+{
+  if (search->pgm) return (pgm_read_byte(search->str + pos));
+  return (search->str[pos]);
+}
+
+/**********************************************************
+Method returns the failure function of the string
+for the first pos+1 characters
+**********************************************************/
+static uint16_t SSFail(const StreamSearch *search, uint16_t pos)
+{
+  if (search->ext_fail != NULL) return (search->ext_fail[pos]);
+  return (search->fail[pos]);
+}
+
+/**********************************************************
+Method prepares the failure function of the string
+(length of the longest proper prefix which is also
+suffix of the first pos+1 characters)
+
+ext_fail: table of the caller for the failure function
+          (NULL - table in the StreamSearch is used)
+ext_len:  num. of items in ext_fail
+**********************************************************/
+static char SSPrepare(StreamSearch *search, const char *str, byte pgm,
+                      uint16_t *ext_fail, uint16_t ext_len)
+{
+  size_t len;
+  uint16_t pos;
+  uint16_t k = 0;
+
+  search->str = str;
+  search->pgm = pgm;
+  search->len = 0;
+  search->matched = 0;
+  search->ext_fail = ext_fail;
+  len = pgm ? strlen_P(str) : strlen(str);
+  if (len == 0) return (-1);
+  if (len > (ext_fail != NULL ? ext_len : STREAM_SEARCH_LEN)) return (-1);
+
+  for (pos = 0; pos < len; pos++) {
+    if (pos) {
+      while (k && (SSChar(search, pos) != SSChar(search, k))) k = SSFail(search, k - 1);
+      if (SSChar(search, pos) == SSChar(search, k)) k++;
+    }
+    if (ext_fail != NULL) ext_fail[pos] = k;
+    else search->fail[pos] = k;
+  }
+  search->len = len;
+  return (1);
+}
+
+/**********************************************************
+Method initializes the search
+
+str: searched string placed in RAM (max. STREAM_SEARCH_LEN
+     characters)
+
+return:
+      -1 - string is empty or too long (search is disabled)
+       1 - search is initialized
+**********************************************************/
+char SSInit(StreamSearch *search, const char *str)
+{
+  return (SSPrepare(search, str, 0, NULL, 0));
+}
+
+/**********************************************************
+Method initializes the search
+
+str: searched string placed in the Flash memory
+     e.g. PSTR("\r\nNO CARRIER\r\n")
+
+return:
+      -1 - string is empty or too long (search is disabled)
+       1 - search is initialized
+**********************************************************/
+char SSInitF(StreamSearch *search, PGM_P str)
+{
+  return (SSPrepare(search, str, 1, NULL, 0));
+}
+
+/**********************************************************
+Method initializes the search of the string which can be
+longer than STREAM_SEARCH_LEN characters
+
+str:      searched string placed in RAM
+fail:     table for the failure function of the string
+          (min. strlen(str) items, it must be valid during
+          the search)
+fail_len: num. of items in the table
+
+return:
+      -1 - string is empty or too long for the table
+           (search is disabled)
+       1 - search is initialized
+**********************************************************/
+char SSInitExt(StreamSearch *search, const char *str, uint16_t *fail, uint16_t fail_len)
+{
+  return (SSPrepare(search, str, 0, fail, fail_len));
+}
+
+/**********************************************************
+Method starts the search again from the beginning
+of the string (e.g. for the new connection)
+**********************************************************/
+void SSReset(StreamSearch *search)
+{
+  search->matched = 0;
+}
+
+/**********************************************************
+Method passes next byte of the stream to the search
+
+return:
+      0 - string was not found
+      1 - ch is the last character of the found string
+          (search continues so overlapping occurrences
+          are found too)
+**********************************************************/
+byte SSFeed(StreamSearch *search, byte ch)
+{
+  uint16_t k = search->matched;
+
+  if (search->len == 0) return (0);
+
+  while (k && ((char)ch != SSChar(search, k))) k = SSFail(search, k - 1);
+  if ((char)ch == SSChar(search, k)) k++;
+  if (k == search->len) {
+    search->matched = SSFail(search, k - 1);
+    return (1);
+  }
+  search->matched = k;
+  return (0);
+}
+
+/**********************************************************
+Method searches the string in the next chunk of the stream
+- beginning of the string can be in the previous chunks
+- search is stopped behind the first found occurrence so
+  the rest of the chunk can be searched by the next call
+  SSFind(search, data + pos, size - pos)
+
+data: next chunk of the stream
+size: size of the chunk
+
+return:
+        -1    - string was not found (yet)
+        > -1  - position in the chunk behind the last
+                character of the found string
+**********************************************************/
+signed short SSFind(StreamSearch *search, const byte *data, uint16_t size)
+{
+  uint16_t pos;
+
+  for (pos = 0; pos < size; pos++) {
+    if (SSFeed(search, data[pos])) return (pos + 1);
+  }
+  return (-1);
+}
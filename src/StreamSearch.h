@@ -0,0 +1,74 @@
+/*
+  StreamSearch.h - streaming search of the string in the data for the
+  GSM Playground - GSM Shield for Arduino
+  www.hwkitchen.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __STREAMSEARCH_h
+#define __STREAMSEARCH_h
+
+#include "Arduino.h"
+
+/*
+    StreamSearch finds the string in the stream of binary data which is
+    received by chunks (Knuth-Morris-Pratt algorithm)
+    - state of the search is kept between the chunks so the string
+      split between two chunks is also found
+    - every byte of the stream is checked only once and the data
+      is never read again (linear time, no backtracking)
+    - searched string is not copied, it must be valid during the search
+    - strings longer than STREAM_SEARCH_LEN need the failure function
+      table supplied by the caller (SSInitExt())
+
+
+    an example of usage:
+        StreamSearch search;
+        byte *rx_data;
+        uint16_t len;
+        signed short pos;
+
+        SSInitF(&search, PSTR("\r\n\r\n"));   // end of the HTTP header
+        while ((len = gsm.RcvData(5000, 100, &rx_data)) != 0) {
+          pos = SSFind(&search, rx_data, len);
+          if (pos != -1) {
+            // rx_data + pos is the first byte behind the header
+          }
+        }
+*/
+
+// max. length of the searched string
+#ifndef STREAM_SEARCH_LEN
+  #define STREAM_SEARCH_LEN     16
+#endif // end of ifndef STREAM_SEARCH_LEN
+
+struct StreamSearch
+{
+  const char *str;                // searched string (RAM or Flash memory)
+  byte pgm;                       // 1 - str is placed in the Flash memory
+  uint16_t len;                   // length of the string (0 - search is disabled)
+  uint16_t matched;               // num. of characters matched so far
+  uint16_t *ext_fail;             // KMP failure function of the caller (NULL - fail[] is used)
+  byte fail[STREAM_SEARCH_LEN];   // KMP failure function
+};
+
+
+char SSInit(StreamSearch *search, const char *str);
+char SSInitF(StreamSearch *search, PGM_P str);
+char SSInitExt(StreamSearch *search, const char *str, uint16_t *fail, uint16_t fail_len);
+void SSReset(StreamSearch *search);
+byte SSFeed(StreamSearch *search, byte ch);
+signed short SSFind(StreamSearch *search, const byte *data, uint16_t size);
+
+#endif
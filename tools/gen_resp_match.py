@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+gen_resp_match.py - generator of the response classifier tables
+for the GSM Playground - GSM Shield for Arduino
+
+Reads the pattern sets from tools/resp_match.def, builds the Aho-Corasick
+automaton of every set, resolves the failure links into the complete DFA
+and writes the PROGMEM tables into src/ATRespMatch.h and src/ATRespMatch.cpp
+(see src/ATMatch.h).
+
+usage:
+    python3 tools/gen_resp_match.py [definition_file] [output_dir]
+"""
+
+import os
+import re
+import sys
+from collections import deque
+
+MAX_PATTERNS = 16   # ATMATCH_MAX_PATTERNS
+MAX_STATES = 256    # states are stored as uint8_t
+CLASSES = 128       # ATMATCH_CLASSES
+
+
+def parse_def(path):
+    sets = []
+    line_re = re.compile(r'^([A-Z_][A-Z0-9_]*)\s+"((?:[^"\\]|\\.)*)"\s*$')
+    with open(path) as f:
+        for no, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            if line.startswith('[') and line.endswith(']'):
+                sets.append((line[1:-1], []))
+                continue
+            m = line_re.match(line)
+            if m is None or not sets:
+                sys.exit('%s:%d: syntax error' % (path, no))
+            pattern = re.sub(r'\\(.)', r'\1', m.group(2))
+            if not pattern or any(ord(ch) >= CLASSES for ch in pattern):
+                sys.exit('%s:%d: empty pattern or non 7-bit character' % (path, no))
+            sets[-1][1].append((m.group(1), pattern))
+    for name, patterns in sets:
+        if not patterns or len(patterns) > MAX_PATTERNS:
+            sys.exit('set %s: 1..%d patterns expected' % (name, MAX_PATTERNS))
+    return sets
+
+
+def build_dfa(patterns, classes, n_classes):
+    # classes is the class of the set for every character of the set
+    # trie
+    goto = [{}]
+    out = [0]
+    for i, (_, pattern) in enumerate(patterns):
+        state = 0
+        for ch in pattern:
+            cls = classes[ch]
+            if cls not in goto[state]:
+                goto.append({})
+                out.append(0)
+                goto[state][cls] = len(goto) - 1
+            state = goto[state][cls]
+        out[state] |= 1 << i
+    if len(goto) > MAX_STATES:
+        sys.exit('too many states (%d)' % len(goto))
+
+    # failure links in BFS order resolved directly into the DFA
+    delta = [[0] * n_classes for _ in goto]
+    fail = [0] * len(goto)
+    queue = deque()
+    for cls in range(n_classes):
+        nxt = goto[0].get(cls)
+        if nxt is not None:
+            delta[0][cls] = nxt
+            queue.append(nxt)
+    while queue:
+        state = queue.popleft()
+        out[state] |= out[fail[state]]
+        for cls in range(n_classes):
+            nxt = goto[state].get(cls)
+            if nxt is None:
+                delta[state][cls] = delta[fail[state]][cls]
+            else:
+                fail[nxt] = delta[fail[state]][cls]
+                delta[state][cls] = nxt
+                queue.append(nxt)
+    # unknown character (class 0) always returns to the root
+    for row in delta:
+        row[0] = 0
+    return delta, out
+
+
+def c_string(s):
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def rows(values, width, fmt):
+    lines = []
+    for i in range(0, len(values), width):
+        lines.append('  ' + ', '.join(fmt % v for v in values[i:i + width]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    def_file = sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, 'tools', 'resp_match.def')
+    out_dir = sys.argv[2] if len(sys.argv) > 2 else os.path.join(root, 'src')
+    sets = parse_def(def_file)
+
+    # character classes common for all sets, class 0 = unused character
+    alphabet = sorted(set(ch for _, patterns in sets for _, p in patterns for ch in p))
+    common = dict((ch, i + 1) for i, ch in enumerate(alphabet))
+    class_map = [common.get(chr(i), 0) for i in range(CLASSES)]
+
+    banner = ('/*\n'
+              '  %s - generated by tools/gen_resp_match.py from tools/resp_match.def\n'
+              '  DO NOT EDIT - change the definition file and run the generator again\n'
+              '*/\n')
+
+    h = [banner % 'ATRespMatch.h',
+         '#ifndef __ATRESPMATCH_h',
+         '#define __ATRESPMATCH_h',
+         '',
+         '#include "ATMatch.h"',
+         '']
+    c = [banner % 'ATRespMatch.cpp',
+         '#include "Arduino.h"',
+         '#include "ATRespMatch.h"',
+         '',
+         '',
+         'const uint8_t resp_match_class[ATMATCH_CLASSES] PROGMEM = {',
+         rows(class_map, 16, '%2d'),
+         '};',
+         '']
+    total = CLASSES
+
+    for name, patterns in sets:
+        lname = name.lower()
+        # every set has its own (smaller) alphabet so the rows of the DFA
+        # are as short as possible
+        set_alphabet = sorted(set(ch for _, p in patterns for ch in p))
+        classes = dict((ch, i + 1) for i, ch in enumerate(set_alphabet))
+        n_classes = len(set_alphabet) + 1
+        set_classes = [0] + [classes.get(ch, 0) for ch in alphabet]
+        delta, out = build_dfa(patterns, classes, n_classes)
+        size = len(set_classes) + len(delta) * n_classes + len(out) * 2 + len(patterns)
+        total += size
+
+        h.append('// %s: %d states, %d bytes' % (name, len(delta), size))
+        h.append('enum resp_match_%s_enum' % lname)
+        h.append('{')
+        for i, (symbol, pattern) in enumerate(patterns):
+            h.append('  %s = %d,%s// %s' % (symbol, i, ' ' * max(1, 28 - len(symbol) - len(str(i))),
+                                            c_string(pattern)))
+        h.append('};')
+        h.append('extern const ATMatchSet resp_match_%s PROGMEM;' % lname)
+        h.append('')
+
+        flat = [v for row in delta for v in row]
+        c.append('')
+        c.append('// %s' % ', '.join(c_string(p) for _, p in patterns))
+        c.append('static const uint8_t resp_match_%s_classes[] PROGMEM = {' % lname)
+        c.append(rows(set_classes, 16, '%2d'))
+        c.append('};')
+        c.append('static const uint8_t resp_match_%s_delta[] PROGMEM = {' % lname)
+        c.append(rows(flat, n_classes, '%2d'))
+        c.append('};')
+        c.append('static const uint16_t resp_match_%s_out[] PROGMEM = {' % lname)
+        c.append(rows(out, 8, '0x%04x'))
+        c.append('};')
+        c.append('static const uint8_t resp_match_%s_pat_len[] PROGMEM = {' % lname)
+        c.append(rows([len(p) for _, p in patterns], 16, '%d'))
+        c.append('};')
+        c.append('const ATMatchSet resp_match_%s PROGMEM = {' % lname)
+        c.append('  resp_match_%s_classes, resp_match_%s_delta, resp_match_%s_out,'
+                 % (lname, lname, lname))
+        c.append('  resp_match_%s_pat_len, %d, %d' % (lname, n_classes, len(patterns)))
+        c.append('};')
+
+    h.append('// total size of the tables in the Flash memory: %d bytes' % total)
+    h.append('')
+    h.append('#endif')
+
+    with open(os.path.join(out_dir, 'ATRespMatch.h'), 'w') as f:
+        f.write('\n'.join(h) + '\n')
+    with open(os.path.join(out_dir, 'ATRespMatch.cpp'), 'w') as f:
+        f.write('\n'.join(c) + '\n')
+
+
+if __name__ == '__main__':
+    main()